@@ -1,11 +1,21 @@
 #include "hr_algorithm.h"
-#include "motion_correction.h"
+#include "sensor_source.h"
+#include "wear_detect.h"
+#include "resampler.h"
+#include "../system/timebase.h"
 
-// 低RAM优化：使用int16_t代替int32_t（MAX30102 18-bit右对齐后范围-32768~32767，int16_t足够）
-static int16_t ir_buffer[HR_BUFFER_SIZE];   // 主通道缓冲（IR对心率敏感）
+// 缓冲只存去直流后的交流分量（int16_t足够，18位原始值直接截断会溢出），直流由跟踪器单独保存供SpO2使用
+static int16_t ir_buffer[HR_BUFFER_SIZE];   // 主通道缓冲（IR对心率敏感），环形
 static int16_t red_buffer[HR_BUFFER_SIZE];  // 辅助通道（用于质量检查）
-static uint8_t buffer_pos = 0;              // uint8_t足够（HR_BUFFER_SIZE=64）
+static uint16_t buffer_pos = 0;             // 下一个写入位置 = 最旧样本
 static bool buffer_filled = false;
+static int32_t ir_dc_q8 = 0;                // 直流跟踪（Q8）
+static int32_t red_dc_q8 = 0;
+static bool dc_valid = false;               // 基线重置后以第一个样本为初值
+// 分析工作区：环形缓冲按时间顺序展开后带通滤波，不修改采集缓冲
+static int16_t ir_work[HR_BUFFER_SIZE];
+static int16_t red_work[HR_BUFFER_SIZE];
+static bool work_ready = false;             // 工作区与缓冲一致（BPM与SpO2共用一次展开）
 // 低RAM优化：BPM用uint8_t（40-180范围），SNR用uint8_t（0-255，实际SNR约0-30dB）
 static uint8_t last_bpm = 0;               // 0表示无效，40-180表示实际BPM
 static uint8_t last_spo2 = 0;              // 0表示无效，70-100表示实际SpO2
@@ -15,23 +25,21 @@ static uint8_t last_correlation = 0;       // 红外/红光相关性（0-100）
 // 前向声明：某些构建配置会把多个算法源合并到同一翻译单元，
 // 导致在函数定义出现之前使用这些静态辅助函数而编译失败。
 // 在文件顶部添加前向声明以确保可见性。
-static uint8_t calculate_correlation(int16_t* signal1, int16_t* signal2);
-static uint8_t calculate_bpm_from_red_channel(int* status);
+static uint8_t calculate_correlation(const int16_t* signal1, const int16_t* signal2);
+static uint8_t calculate_bpm_from_window(int16_t* signal, uint8_t* snr, int* status);
 
-// 运动干扰校正状态
-static KalmanState kalman_ir_state;        // IR通道Kalman滤波器
-static KalmanState kalman_red_state;       // Red通道Kalman滤波器
-static TssdState tssd_ir_state;            // IR通道TSSD滤波器
-static TssdState tssd_red_state;           // Red通道TSSD滤波器
-static uint8_t use_kalman = 1;             // 使用Kalman滤波（1）或TSSD（0）
+// 运动干扰：相关性低时改用红光通道；BPM输出的Kalman/TSSD在算法管理器中
+// （Q8.8 定点滤波器只适用于BPM量级的数值，不能逐样本处理PPG计数）
+static uint32_t sample_period_us = HR_SAMPLE_INTERVAL_MS * 1000UL;  // 实测采样周期（见 timebase）
+static ResamplerState poll_resampler;      // hr_algorithm_update() 轮询路径：按读取时刻重采样到均匀网格
 
 // ─── 私有函数 ──────────────────────────────────────────────
 
-// 快速整数平方根（16位）
-static uint16_t fast_sqrt16(uint16_t x) {
+// 快速整数平方根（32位输入，结果≤65535）
+static uint16_t fast_sqrt32(uint32_t x) {
     if (x == 0) return 0;
-    uint16_t res = 0;
-    uint16_t bit = 1 << 14;  // 最高位
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;  // 最高位
     while (bit > x) bit >>= 2;
     while (bit != 0) {
         if (x >= res + bit) {
@@ -42,14 +50,35 @@ static uint16_t fast_sqrt16(uint16_t x) {
         }
         bit >>= 2;
     }
-    return res;
+    return (uint16_t)res;
+}
+
+// 窗口均值与标准差（64位累加：运动伪影幅度大时平方和超出32位）
+static int32_t window_mean_std(const int16_t* signal, uint16_t* std_dev) {
+    int64_t sum = 0, sum_sq = 0;
+    for (uint16_t i = 0; i < HR_BUFFER_SIZE; i++) {
+        sum += signal[i];
+        sum_sq += (int32_t)signal[i] * signal[i];
+    }
+    int32_t mean = (int32_t)(sum / HR_BUFFER_SIZE);
+    int64_t variance = sum_sq / HR_BUFFER_SIZE - (int64_t)mean * mean;
+    if (variance < 0) variance = 0;
+    if (variance > 0xFFFFFFFFLL) variance = 0xFFFFFFFFLL;
+    *std_dev = fast_sqrt32((uint32_t)variance);
+    return mean;
+}
+
+static int16_t clamp_i16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
 }
 
 // 高通滤波（简单一阶IIR，截止≈0.5Hz，去基线漂移）
 // 低RAM优化：使用int16_t，alpha用定点数（243/256 ≈ 0.95）
 static void high_pass_filter(int16_t* signal) {
     int16_t y_prev = signal[0];
-    for (uint8_t i = 1; i < HR_BUFFER_SIZE; i++) {
+    for (uint16_t i = 1; i < HR_BUFFER_SIZE; i++) {
         // 定点运算：alpha=243/256，避免float
         int16_t y = (int16_t)(((int32_t)243 * (y_prev + signal[i] - signal[i-1])) >> 8);
         y_prev = y;
@@ -58,15 +87,9 @@ static void high_pass_filter(int16_t* signal) {
 }
 
 // 低通滤波（滑动平均，截止≈5Hz）
-// 低RAM优化：原地滤波，避免临时数组（节省128 bytes）
+// 低RAM优化：原地滤波，避免临时数组
 static void low_pass_filter(int16_t* signal) {
-    // 使用滑动窗口，原地更新（需要反向遍历避免覆盖）
-    int16_t prev_values[HR_MOVING_AVG_WINDOW];
-    for (uint8_t i = 0; i < HR_MOVING_AVG_WINDOW; i++) {
-        prev_values[i] = signal[i];
-    }
-    
-    for (uint8_t i = HR_MOVING_AVG_WINDOW/2; i < HR_BUFFER_SIZE - HR_MOVING_AVG_WINDOW/2; i++) {
+    for (uint16_t i = HR_MOVING_AVG_WINDOW/2; i < HR_BUFFER_SIZE - HR_MOVING_AVG_WINDOW/2; i++) {
         int32_t sum = 0;
         for (int8_t k = -HR_MOVING_AVG_WINDOW/2; k <= HR_MOVING_AVG_WINDOW/2; k++) {
             sum += signal[i + k];
@@ -75,22 +98,28 @@ static void low_pass_filter(int16_t* signal) {
     }
 }
 
+// 环形缓冲按时间顺序展开到工作区（buffer_pos 处为最旧样本）并带通滤波；
+// 直接在环形缓冲上滤波会跨越新旧样本的接缝，且滤波结果会混进之后的采集数据
+static void prepare_window() {
+    if (work_ready) return;
+    for (uint16_t i = 0; i < HR_BUFFER_SIZE; i++) {
+        uint16_t idx = (uint16_t)((buffer_pos + i) % HR_BUFFER_SIZE);
+        ir_work[i] = ir_buffer[idx];
+        red_work[i] = red_buffer[idx];
+    }
+    high_pass_filter(ir_work);   // 去基线
+    low_pass_filter(ir_work);    // 去高频噪声
+    high_pass_filter(red_work);
+    low_pass_filter(red_work);
+    work_ready = true;
+}
+
 // 计算信噪比（SNR = 20 * log10(信号幅度 / 噪声幅度)）
 // 低RAM优化：返回uint8_t（SNR*10），避免float
-static uint8_t calculate_snr(int16_t* signal) {
-    int32_t sum = 0, sum_sq = 0;
-    for (uint8_t i = 0; i < HR_BUFFER_SIZE; i++) {
-        sum += signal[i];
-        sum_sq += (int32_t)signal[i] * signal[i];
-    }
-    // 定点运算：mean = sum / HR_BUFFER_SIZE
-    int32_t mean = sum / HR_BUFFER_SIZE;
-    // variance = sum_sq/HR_BUFFER_SIZE - mean^2
-    int32_t variance = (sum_sq / HR_BUFFER_SIZE) - (mean * mean);
-    if (variance < 0) variance = 0;
-    
+static uint8_t calculate_snr(const int16_t* signal) {
     // 计算信号幅度（标准差）
-    uint16_t signal_amp = fast_sqrt16((uint16_t)variance);
+    uint16_t signal_amp;
+    window_mean_std(signal, &signal_amp);
     
     // 估计噪声幅度：使用高频分量（原始信号与滤波后信号的差值）
     // 简化：噪声幅度 ≈ 信号幅度的1/10（经验值）
@@ -101,7 +130,7 @@ static uint8_t calculate_snr(int16_t* signal) {
     // 使用定点数近似：log10(x) ≈ (x-1)/2.3（线性近似，适用于x接近1）
     // 更精确的近似：SNR ≈ 20 * (signal/noise - 1) / 2.3
     // 转换为整数运算：SNR*10 ≈ 200 * (signal/noise - 1) / 2.3 ≈ 87 * (signal/noise - 1)
-    uint16_t ratio = (signal_amp * 100) / noise_amp;  // signal/noise * 100
+    uint32_t ratio = ((uint32_t)signal_amp * 100) / noise_amp;  // signal/noise * 100
     if (ratio <= 100) return 0;  // 信号小于等于噪声，SNR为0
     
     // SNR*10 = 87 * (ratio/100 - 1) = 87 * (ratio - 100) / 100
@@ -114,24 +143,19 @@ static uint8_t calculate_snr(int16_t* signal) {
 }
 
 // 峰值检测（自适应阈值：阈值 = mean + factor * std_dev）
-// 低RAM优化：使用int16_t和定点运算
-static uint8_t find_peaks(int16_t* signal, uint8_t* peak_indices, uint8_t max_peaks) {
-    int32_t sum = 0, sum_sq = 0;
-    for (uint8_t i = 0; i < HR_BUFFER_SIZE; i++) {
-        sum += signal[i];
-        sum_sq += (int32_t)signal[i] * signal[i];
-    }
-    int32_t mean = sum / HR_BUFFER_SIZE;
-    int32_t variance = (sum_sq / HR_BUFFER_SIZE) - (mean * mean);
-    if (variance < 0) variance = 0;
-    uint16_t std_dev = fast_sqrt16((uint16_t)variance);
+// 相距不足 HR_MIN_PEAK_DISTANCE 的两个峰只保留较高者（重搏波、残余噪声）
+static uint8_t find_peaks(const int16_t* signal, uint16_t* peak_indices, uint8_t max_peaks) {
+    uint16_t std_dev;
+    int32_t mean = window_mean_std(signal, &std_dev);
     // threshold = mean + 0.5 * std_dev（HR_PEAK_THRESHOLD_BASE=0.5）
-    int16_t threshold = (int16_t)mean + (std_dev / 2);
+    int32_t threshold = mean + (std_dev / 2);
 
     uint8_t count = 0;
-    for (uint8_t i = 1; i < HR_BUFFER_SIZE - 1; i++) {
-        if (signal[i] > signal[i-1] && signal[i] > signal[i+1] && signal[i] > threshold) {
-            if (count < max_peaks) {
+    for (uint16_t i = 1; i < HR_BUFFER_SIZE - 1; i++) {
+        if (signal[i] > signal[i-1] && signal[i] >= signal[i+1] && signal[i] > threshold) {
+            if (count > 0 && (i - peak_indices[count - 1]) < HR_MIN_PEAK_DISTANCE) {
+                if (signal[i] > signal[peak_indices[count - 1]]) peak_indices[count - 1] = i;
+            } else if (count < max_peaks) {
                 peak_indices[count++] = i;
             } else {
                 break;
@@ -141,6 +165,14 @@ static uint8_t find_peaks(int16_t* signal, uint8_t* peak_indices, uint8_t max_pe
     return count;
 }
 
+// 峰间隔 → BPM：用实测采样周期换算，intervals 个间隔共 total_samples 个样本
+// bpm = 60e6 × intervals / (total_samples × period_us)，四舍五入
+static uint16_t intervals_to_bpm(uint16_t total_samples, uint8_t intervals) {
+    uint64_t denom = (uint64_t)total_samples * sample_period_us;
+    if (denom == 0) return 0;
+    return (uint16_t)((60000000ULL * intervals + denom / 2) / denom);
+}
+
 // ─── 公开接口 ──────────────────────────────────────────────
 
 void hr_algorithm_init() {
@@ -148,47 +180,68 @@ void hr_algorithm_init() {
     memset(red_buffer, 0, sizeof(red_buffer));
     buffer_pos = 0;
     buffer_filled = false;
+    dc_valid = false;
+    work_ready = false;
     last_bpm = 0;  // 0表示无效
     last_snr = 0;
     
-    // 初始化运动干扰校正滤波器
-    kalman_init(&kalman_ir_state, 0);
-    kalman_init(&kalman_red_state, 0);
-    tssd_init(&tssd_ir_state);
-    tssd_init(&tssd_red_state);
-    
-    // 默认使用Kalman滤波
-    use_kalman = 1;
+    // 轮询时刻抖动大（调度器被BLE/显示拖慢），用线性插值
+    resampler_init(&poll_resampler, HR_SAMPLE_INTERVAL_MS * 1000UL, RESAMPLER_LINEAR);
+}
+
+// LED电流/ADC量程变化后，直流电平跳变会污染缓冲与直流跟踪，
+// 因此整体重新开始填充；last_bpm/last_spo2 保留，输出不中断
+void hr_algorithm_reset_baseline() {
+    buffer_pos = 0;
+    buffer_filled = false;
+    dc_valid = false;
+    work_ready = false;
 }
 
 int hr_algorithm_update() {
+    if (!wear_detect_is_on_wrist()) {
+        return HR_OFF_WRIST;  // 离腕：传感器处于接近模式，不读取不滤波
+    }
+    
     int32_t red, ir;
-    if (!hr_read_latest(&red, &ir)) {
+    if (!sensor_source_ppg_read(&red, &ir)) {
         return HR_READ_FAILED;
     }
     
-    // 转换int32_t到int16_t（MAX30102数据右对齐后范围适合int16_t）
-    int16_t ir_raw = (int16_t)(ir >> 2);   // 保留高16位
-    int16_t red_raw = (int16_t)(red >> 2);
+    // 调度器调用间隔不均匀：以读取时刻为时间戳重采样，间隙（长时间未调用）时重置基线
+    ResampledSample grid[RESAMPLER_MAX_OUT];
+    uint8_t gap = 0;
+    uint8_t n = resampler_push(&poll_resampler, timebase_now_us(), red, ir, grid, RESAMPLER_MAX_OUT, &gap);
+    if (gap) {
+        hr_algorithm_reset_baseline();
+    }
     
-    // 应用运动干扰校正
-    int16_t ir_filtered, red_filtered;
+    int status = HR_SUCCESS;  // 样本已接收（可能尚未到达下一个网格点）
+    for (uint8_t i = 0; i < n; i++) {
+        status = hr_algorithm_push_sample(grid[i].red, grid[i].ir);
+    }
+    return status;
+}
+
+int hr_algorithm_push_sample(int32_t red, int32_t ir) {
+    if (!wear_detect_is_on_wrist()) {
+        return HR_OFF_WRIST;
+    }
     
-    if (use_kalman) {
-        // 使用Kalman滤波
-        ir_filtered = kalman_update(&kalman_ir_state, ir_raw);
-        red_filtered = kalman_update(&kalman_red_state, red_raw);
-    } else {
-        // 使用TSSD滤波
-        ir_filtered = tssd_update(&tssd_ir_state, ir_raw);
-        red_filtered = tssd_update(&tssd_red_state, red_raw);
+    // 直流跟踪（一阶，时间常数 2^HR_DC_SHIFT 个样本）；缓冲存交流分量
+    if (!dc_valid) {
+        ir_dc_q8 = ir << 8;
+        red_dc_q8 = red << 8;
+        dc_valid = true;
     }
+    ir_dc_q8 += ((ir << 8) - ir_dc_q8) >> HR_DC_SHIFT;
+    red_dc_q8 += ((red << 8) - red_dc_q8) >> HR_DC_SHIFT;
     
-    // 存储滤波后的数据
-    ir_buffer[buffer_pos] = ir_filtered;
-    red_buffer[buffer_pos] = red_filtered;
+    ir_buffer[buffer_pos] = clamp_i16(ir - (ir_dc_q8 >> 8));
+    red_buffer[buffer_pos] = clamp_i16(red - (red_dc_q8 >> 8));
+    work_ready = false;
     
-    buffer_pos = (buffer_pos + 1) % HR_BUFFER_SIZE;
+    buffer_pos = (uint16_t)((buffer_pos + 1) % HR_BUFFER_SIZE);
     if (buffer_pos == 0) {
         buffer_filled = true;
     }
@@ -201,106 +254,58 @@ uint8_t hr_calculate_bpm(int* status) {
         if (status) *status = HR_BUFFER_NOT_FULL;
         return 0;
     }
+    prepare_window();
 
     // 计算信号相关性
-    last_correlation = calculate_correlation(ir_buffer, red_buffer);
+    last_correlation = calculate_correlation(ir_work, red_work);
     
     // 检查相关性，如果<65则使用红光通道fallback
     if (last_correlation < 65) {
-        // 使用红光通道作为fallback计算心率
-        uint8_t bpm = calculate_bpm_from_red_channel(status);
+        uint8_t red_snr = 0;
+        uint8_t bpm = calculate_bpm_from_window(red_work, &red_snr, status);
         if (bpm > 0) {
             last_bpm = bpm;
             // 降权SNR*0.7（运动干扰时信号质量下降）
-            last_snr = (uint8_t)(last_snr * 0.7);
+            last_snr = (uint8_t)(red_snr * 0.7);
             if (status) *status = HR_SUCCESS_WITH_MOTION;
-            return bpm;
-        } else {
-            // 红光通道也失败，返回错误
-            if (status) *status = HR_POOR_SIGNAL;
-            return 0;
         }
+        return bpm;
     }
 
     // 相关性足够，使用红外通道计算心率
-    // 低RAM优化：直接使用ir_buffer，避免拷贝（节省128 bytes）
-    // 注意：这会修改原始数据，但计算后立即使用，不影响后续采集
-    high_pass_filter(ir_buffer);  // 去基线
-    low_pass_filter(ir_buffer);   // 去高频噪声
-
-    last_snr = calculate_snr(ir_buffer);
-    if (last_snr < (uint8_t)(HR_SNR_THRESHOLD * 10)) {
-        if (status) *status = HR_POOR_SIGNAL;
-        return 0;
-    }
-
-    // 低RAM优化：最多8个峰（64样本通常2-4个峰）
-    uint8_t peaks[8];
-    uint8_t peak_count = find_peaks(ir_buffer, peaks, 8);
-
-    if (peak_count < HR_MIN_PEAKS_REQUIRED) {
-        if (status) *status = HR_POOR_SIGNAL;
-        return 0;
-    }
-
-    uint16_t total_interval = 0;
-    for (uint8_t i = 1; i < peak_count; i++) {
-        total_interval += peaks[i] - peaks[i-1];
+    uint8_t bpm = calculate_bpm_from_window(ir_work, &last_snr, status);
+    if (bpm > 0) {
+        last_bpm = bpm;
     }
-    // 定点运算：avg_interval_samples = total_interval / (peak_count - 1)
-    uint16_t avg_interval_samples = total_interval / (peak_count - 1);
-    // avg_interval_sec = avg_interval_samples * 0.01 (HR_SAMPLE_INTERVAL_MS=10ms)
-    // bpm = 60 / avg_interval_sec = 60 * 100 / avg_interval_samples
-    uint16_t bpm = (6000 / avg_interval_samples);
-
-    if (bpm < HR_MIN_BPM || bpm > HR_MAX_BPM) {
-        if (status) *status = HR_OUT_OF_RANGE;
-        return 0;
-    }
-
-    last_bpm = (uint8_t)bpm;
-    if (status) *status = HR_SUCCESS;
-    return (uint8_t)bpm;
+    return bpm;
 }
 
-// 使用红光通道作为fallback计算心率（当相关性低时）
-static uint8_t calculate_bpm_from_red_channel(int* status) {
-    // 使用红光通道数据
-    int16_t red_copy[HR_BUFFER_SIZE];
-    memcpy(red_copy, red_buffer, sizeof(red_copy));
-    
-    high_pass_filter(red_copy);  // 去基线
-    low_pass_filter(red_copy);   // 去高频噪声
-
-    // 计算红光通道的SNR
-    uint8_t red_snr = calculate_snr(red_copy);
-    if (red_snr < (uint8_t)(HR_SNR_THRESHOLD * 10)) {
+// 已滤波窗口 → BPM（SNR检查 + 峰值检测），snr 输出该通道的SNR*10
+static uint8_t calculate_bpm_from_window(int16_t* signal, uint8_t* snr, int* status) {
+    *snr = calculate_snr(signal);
+    if (*snr < (uint8_t)(HR_SNR_THRESHOLD * 10)) {
         if (status) *status = HR_POOR_SIGNAL;
         return 0;
     }
 
-    // 峰值检测
-    uint8_t peaks[8];
-    uint8_t peak_count = find_peaks(red_copy, peaks, 8);
+    uint16_t peaks[8];
+    uint8_t peak_count = find_peaks(signal, peaks, 8);
 
     if (peak_count < HR_MIN_PEAKS_REQUIRED) {
         if (status) *status = HR_POOR_SIGNAL;
         return 0;
     }
 
-    uint16_t total_interval = 0;
-    for (uint8_t i = 1; i < peak_count; i++) {
-        total_interval += peaks[i] - peaks[i-1];
-    }
-    
-    uint16_t avg_interval_samples = total_interval / (peak_count - 1);
-    uint16_t bpm = (6000 / avg_interval_samples);
+    uint16_t total_interval = peaks[peak_count - 1] - peaks[0];
+    // 按实测采样周期换算（不再假设严格10ms间隔，也不先截断平均间隔）
+    uint16_t bpm = intervals_to_bpm(total_interval, peak_count - 1);
 
     if (bpm < HR_MIN_BPM || bpm > HR_MAX_BPM) {
         if (status) *status = HR_OUT_OF_RANGE;
         return 0;
     }
 
+    if (status) *status = HR_SUCCESS;
     return (uint8_t)bpm;
 }
 
@@ -308,15 +313,20 @@ uint8_t hr_get_latest_bpm() {
     return last_bpm;  // 0表示无效
 }
 
+void hr_algorithm_set_sample_period_us(uint32_t period_us) {
+    if (period_us > 0) sample_period_us = period_us;
+}
+
 uint8_t hr_get_signal_quality() {
     return last_snr;  // SNR*10，例如15.3dB返回153
 }
 
 // 计算红外/红光信号相关性（用于运动干扰检测）
-static uint8_t calculate_correlation(int16_t* signal1, int16_t* signal2) {
-    int32_t sum1 = 0, sum2 = 0, sum12 = 0, sum1_sq = 0, sum2_sq = 0;
+// 64位累加；两路方差之积超出整数范围，开方用浮点
+static uint8_t calculate_correlation(const int16_t* signal1, const int16_t* signal2) {
+    int64_t sum1 = 0, sum2 = 0, sum12 = 0, sum1_sq = 0, sum2_sq = 0;
     
-    for (uint8_t i = 0; i < HR_BUFFER_SIZE; i++) {
+    for (uint16_t i = 0; i < HR_BUFFER_SIZE; i++) {
         sum1 += signal1[i];
         sum2 += signal2[i];
         sum12 += (int32_t)signal1[i] * signal2[i];
@@ -324,91 +334,65 @@ static uint8_t calculate_correlation(int16_t* signal1, int16_t* signal2) {
         sum2_sq += (int32_t)signal2[i] * signal2[i];
     }
     
-    // 计算均值
-    int32_t mean1 = sum1 / HR_BUFFER_SIZE;
-    int32_t mean2 = sum2 / HR_BUFFER_SIZE;
-    
-    // 计算协方差和方差
-    int32_t cov = (sum12 / HR_BUFFER_SIZE) - (mean1 * mean2);
-    int32_t var1 = (sum1_sq / HR_BUFFER_SIZE) - (mean1 * mean1);
-    int32_t var2 = (sum2_sq / HR_BUFFER_SIZE) - (mean2 * mean2);
-    
-    if (var1 <= 0 || var2 <= 0) return 0;
+    // n²倍的协方差与方差（省去除法，比值不变）
+    int64_t cov = HR_BUFFER_SIZE * sum12 - sum1 * sum2;
+    int64_t var1 = HR_BUFFER_SIZE * sum1_sq - sum1 * sum1;
+    int64_t var2 = HR_BUFFER_SIZE * sum2_sq - sum2 * sum2;
     
-    // 计算相关系数 r = cov / sqrt(var1 * var2)
-    // 使用定点数运算：先计算 var1 * var2
-    uint32_t var_product = (uint32_t)var1 * (uint32_t)var2;
-    uint32_t sqrt_var_product = fast_sqrt16((uint16_t)(var_product >> 16)) << 8; // 近似平方根
-    
-    if (sqrt_var_product == 0) return 0;
+    if (var1 <= 0 || var2 <= 0 || cov <= 0) return 0;
     
     // 计算相关系数 * 100（0-100范围）
-    int32_t correlation_x100 = (cov * 100) / (int32_t)sqrt_var_product;
+    float correlation = (float)cov / sqrtf((float)var1 * (float)var2);
+    int32_t correlation_x100 = (int32_t)(correlation * 100.0f + 0.5f);
     
     // 限制范围 0-100
-    if (correlation_x100 < 0) correlation_x100 = 0;
     if (correlation_x100 > 100) correlation_x100 = 100;
     
     return (uint8_t)correlation_x100;
 }
 
 // 计算 SpO2（标准 ratio-of-ratios 算法）
+// AC：带通后窗口的平均绝对偏差；DC：直流跟踪器的当前值
 uint8_t hr_calculate_spo2(int* status) {
     if (!buffer_filled) {
         if (status) *status = HR_BUFFER_NOT_FULL;
         return 0;
     }
+    prepare_window();
     
     // 检查信号相关性（运动干扰检测）
-    last_correlation = calculate_correlation(ir_buffer, red_buffer);
+    last_correlation = calculate_correlation(ir_work, red_work);
     if (last_correlation < (uint8_t)(SPO2_CORRELATION_THRESHOLD * 100)) {
         if (status) *status = HR_POOR_SIGNAL;
         return 0;
     }
     
-    // 计算 AC 和 DC 分量（使用绝对值计算AC分量）
-    int32_t ir_dc_sum = 0, red_dc_sum = 0;
-    int32_t ir_ac_sum = 0, red_ac_sum = 0;
-    
-    // 计算DC分量（平均值）
-    for (uint8_t i = 0; i < HR_BUFFER_SIZE; i++) {
-        ir_dc_sum += ir_buffer[i];
-        red_dc_sum += red_buffer[i];
+    int32_t ir_dc = ir_dc_q8 >> 8;
+    int32_t red_dc = red_dc_q8 >> 8;
+    if (red_dc <= 0 || ir_dc <= 0) {
+        if (status) *status = HR_POOR_SIGNAL;
+        return 0;
     }
     
-    int32_t ir_dc = ir_dc_sum / HR_BUFFER_SIZE;
-    int32_t red_dc = red_dc_sum / HR_BUFFER_SIZE;
-    
-    // 计算AC分量（信号减去DC的绝对值）
-    for (uint8_t i = 0; i < HR_BUFFER_SIZE; i++) {
-        int32_t ir_ac = ir_buffer[i] - ir_dc;
-        int32_t red_ac = red_buffer[i] - red_dc;
+    // 计算AC分量（信号减去均值的绝对值）
+    uint16_t unused_std;
+    int32_t ir_mean = window_mean_std(ir_work, &unused_std);
+    int32_t red_mean = window_mean_std(red_work, &unused_std);
+    int64_t ir_ac_sum = 0, red_ac_sum = 0;
+    for (uint16_t i = 0; i < HR_BUFFER_SIZE; i++) {
+        int32_t ir_ac = ir_work[i] - ir_mean;
+        int32_t red_ac = red_work[i] - red_mean;
         ir_ac_sum += ir_ac > 0 ? ir_ac : -ir_ac;  // 绝对值
         red_ac_sum += red_ac > 0 ? red_ac : -red_ac;
     }
     
-    int32_t ir_ac_avg = ir_ac_sum / HR_BUFFER_SIZE;
-    int32_t red_ac_avg = red_ac_sum / HR_BUFFER_SIZE;
-    
-    if (red_dc == 0 || ir_dc == 0) {
-        if (status) *status = HR_POOR_SIGNAL;
-        return 0;
-    }
-    
-    // 计算 R 值 = (red_ac / red_dc) / (ir_ac / ir_dc)
-    // 使用定点数运算避免浮点
-    // 先计算 red_ac/red_dc * 1000
-    uint32_t red_ratio = (red_ac_avg * 1000) / red_dc;
-    // 计算 ir_ac/ir_dc * 1000
-    uint32_t ir_ratio = (ir_ac_avg * 1000) / ir_dc;
-    
-    if (ir_ratio == 0) {
+    if (ir_ac_sum == 0) {
         if (status) *status = HR_POOR_SIGNAL;
         return 0;
     }
     
-    // 计算 R = (red_ratio / ir_ratio) * 1000
-    uint32_t r_value_x1000 = (red_ratio * 1000) / ir_ratio;  // R * 1000
+    // R = (red_ac / red_dc) / (ir_ac / ir_dc)，64位定点（AC/DC 约千分之几，先各自×1000会只剩个位数精度）
+    int64_t r_value_x1000 = (red_ac_sum * ir_dc * 1000) / (ir_ac_sum * red_dc);  // R * 1000
     
     // 限制 R 值范围（经验值：0.4-1.2）
     if (r_value_x1000 < 400) {  // 0.4 * 1000
@@ -418,9 +402,8 @@ uint8_t hr_calculate_spo2(int* status) {
         r_value_x1000 = 1200;
     }
     
-    // 使用经验公式：SpO2 = 110 - 25 * R
-    // 转换为整数运算：SpO2 = 110 - (25 * R * 1000) / 1000
-    int32_t spo2 = 110 - (25 * (int32_t)r_value_x1000) / 1000;
+    // 使用经验公式：SpO2 = 110 - 25 * R（四舍五入）
+    int32_t spo2 = 110 - (25 * (int32_t)r_value_x1000 + 500) / 1000;
     
     // 限制范围 70-100%
     if (spo2 < 70) spo2 = 70;
@@ -6,12 +6,14 @@
 
 // ──────────────────────────────────────────────
 // 配置参数（低RAM优化版本）
-// 原值500占用4000 bytes，改为128占用1024 bytes（仍节省内存）
+// 原值500占用4000 bytes；窗口须容纳最低心率的3个峰（40bpm 峰距150样本）
 #ifndef HR_BUFFER_SIZE
-#define HR_BUFFER_SIZE          128     // ≈1.28秒 @100Hz（提高低心率检测可靠性）
+#define HR_BUFFER_SIZE          320     // ≈3.2秒 @100Hz（两通道缓冲+分析工作区共 2560 bytes）
 #endif
 #define HR_SAMPLE_INTERVAL_MS   10      // 与 hr_driver 采样率匹配
-#define HR_MIN_PEAKS_REQUIRED   3       // 至少需要几个峰才计算（128样本约4-6个峰）
+#define HR_MIN_PEAKS_REQUIRED   3       // 至少需要几个峰才计算（320样本：40bpm 3个峰，180bpm 约9个）
+#define HR_MIN_PEAK_DISTANCE    (60000 / (HR_MAX_BPM * HR_SAMPLE_INTERVAL_MS))  // 峰间最小样本数（33）
+#define HR_DC_SHIFT             7       // 直流跟踪时间常数 2^7 样本 ≈1.28秒
 #define HR_MOVING_AVG_WINDOW    9       // 滑动平均窗口（奇数，噪声抑制）
 #define HR_PEAK_THRESHOLD_BASE  0.5     // 自适应阈值基础倍数（信号标准差）
 #define HR_MIN_BPM              40      // 合理心率下限
@@ -33,15 +35,19 @@
 #define HR_POOR_SIGNAL         -2       // 信号质量差（噪声大/无峰）
 #define HR_OUT_OF_RANGE        -3       // BPM 超出合理范围
 #define HR_READ_FAILED         -4       // 驱动读取失败
+#define HR_OFF_WRIST           -5       // 离腕暂停（见 wear_detect）
 
 // ──────────────────────────────────────────────
 // 函数声明
 void hr_algorithm_init();               // 初始化缓冲区
 int hr_algorithm_update();              // 每 SAMPLE_INTERVAL_MS 调用：采集 + 缓冲更新，返回状态
+int hr_algorithm_push_sample(int32_t red, int32_t ir);  // 由外部（样本总线）送入一个样本：滤波 + 缓冲更新
 uint8_t hr_calculate_bpm(int* status);  // 计算BPM，返回uint8_t（0=无效，40-180=BPM值）；status输出详细码
 uint8_t hr_calculate_spo2(int* status); // 计算SpO2，返回uint8_t（0=无效，70-100=SpO2值）；status输出详细码
 uint8_t hr_get_latest_bpm();            // 获取最近有效BPM（0=无效，40-180=BPM值）
 uint8_t hr_get_latest_spo2();           // 获取最近有效SpO2（0=无效，70-100=SpO2值）
+void hr_algorithm_reset_baseline();     // 丢弃缓冲与滤波器状态（LED/量程变化后调用），保留最近结果
+void hr_algorithm_set_sample_period_us(uint32_t period_us);  // 实测采样周期（默认 HR_SAMPLE_INTERVAL_MS）
 
 // 可选调试：获取当前信号质量（SNR*10，例如15.3dB返回153）
 uint8_t hr_get_signal_quality();
@@ -0,0 +1,137 @@
+#include "resampler.h"
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+// Farrow 系数：y(mu) = ((c[3]·mu + c[2])·mu + c[1])·mu + c[0]，mu ∈ [0,1) 为区间内位置
+static void farrow_linear(int32_t y0, int32_t y1, float* c) {
+    c[0] = (float)y0;
+    c[1] = (float)(y1 - y0);
+    c[2] = 0.0f;
+    c[3] = 0.0f;
+}
+
+// 3阶 Lagrange（节点 -1,0,1,2，插值区间 [0,1)）
+static void farrow_cubic(int32_t ym1, int32_t y0, int32_t y1, int32_t y2, float* c) {
+    float a = (float)ym1, b = (float)y0, d1 = (float)y1, d2 = (float)y2;
+    c[0] = b;
+    c[1] = -a / 3.0f - b / 2.0f + d1 - d2 / 6.0f;
+    c[2] = (a + d1) / 2.0f - b;
+    c[3] = (d2 - a) / 6.0f + (b - d1) / 2.0f;
+}
+
+static int32_t farrow_eval(const float* c, float mu) {
+    float y = ((c[3] * mu + c[2]) * mu + c[1]) * mu + c[0];
+    return (int32_t)(y >= 0.0f ? y + 0.5f : y - 0.5f);
+}
+
+// 新段：只保留当前样本，网格从该样本时刻开始
+static void start_segment(ResamplerState* rs, uint64_t t, int32_t red, int32_t ir) {
+    rs->hist_t[RESAMPLER_HISTORY - 1] = t;
+    rs->hist_red[RESAMPLER_HISTORY - 1] = red;
+    rs->hist_ir[RESAMPLER_HISTORY - 1] = ir;
+    rs->count = 1;
+    rs->next_out_us = t;
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void resampler_init(ResamplerState* rs, uint32_t period_us, ResamplerMode mode) {
+    memset(rs, 0, sizeof(ResamplerState));
+    rs->mode = mode;
+    rs->period_us = period_us ? period_us : 1;
+    rs->gap_us = rs->period_us * RESAMPLER_GAP_PERIODS;
+}
+
+void resampler_reset(ResamplerState* rs) {
+    rs->count = 0;
+}
+
+uint8_t resampler_push(ResamplerState* rs, uint64_t timestamp_us, int32_t red, int32_t ir,
+                       ResampledSample* out, uint8_t max_out, uint8_t* gap) {
+    if (gap) *gap = 0;
+
+    if (rs->count == 0) {
+        rs->stats.inputs++;
+        start_segment(rs, timestamp_us, red, ir);
+        return 0;
+    }
+
+    const uint8_t last = RESAMPLER_HISTORY - 1;
+    if (timestamp_us <= rs->hist_t[last]) {
+        rs->stats.dropped++;
+        return 0;
+    }
+    rs->stats.inputs++;
+
+    uint64_t interval = timestamp_us - rs->hist_t[last];
+    if (interval > rs->stats.max_interval_us) {
+        rs->stats.max_interval_us = (uint32_t)(interval > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : interval);
+    }
+    if (interval > rs->gap_us) {
+        rs->stats.gaps++;
+        if (gap) *gap = 1;
+        start_segment(rs, timestamp_us, red, ir);
+        return 0;
+    }
+
+    // 历史左移，追加新样本
+    for (uint8_t i = 0; i < last; i++) {
+        rs->hist_t[i] = rs->hist_t[i + 1];
+        rs->hist_red[i] = rs->hist_red[i + 1];
+        rs->hist_ir[i] = rs->hist_ir[i + 1];
+    }
+    rs->hist_t[last] = timestamp_us;
+    rs->hist_red[last] = red;
+    rs->hist_ir[last] = ir;
+    if (rs->count < RESAMPLER_HISTORY) rs->count++;
+
+    // 选择插值区间 [lo, lo+1] 并计算本区间的 Farrow 系数
+    float c_red[4], c_ir[4];
+    uint8_t lo;
+    if (rs->mode == RESAMPLER_CUBIC) {
+        if (rs->count < 3) return 0;                 // 至少需要区间两端 + 右侧一点
+        lo = last - 2;
+        uint8_t left = (rs->count == 3) ? lo : lo - 1;  // 段首区间左侧缺点，用端点代替
+        farrow_cubic(rs->hist_red[left], rs->hist_red[lo], rs->hist_red[lo + 1], rs->hist_red[lo + 2], c_red);
+        farrow_cubic(rs->hist_ir[left], rs->hist_ir[lo], rs->hist_ir[lo + 1], rs->hist_ir[lo + 2], c_ir);
+    } else {
+        lo = last - 1;
+        farrow_linear(rs->hist_red[lo], rs->hist_red[lo + 1], c_red);
+        farrow_linear(rs->hist_ir[lo], rs->hist_ir[lo + 1], c_ir);
+    }
+
+    uint64_t t_lo = rs->hist_t[lo];
+    uint64_t t_hi = rs->hist_t[lo + 1];
+    float inv_span = 1.0f / (float)(t_hi - t_lo);
+
+    // 输出落在 [t_lo, t_hi) 内的网格点
+    uint8_t n = 0;
+    while (rs->next_out_us < t_hi) {
+        if (n < max_out && out != NULL) {
+            uint64_t t = rs->next_out_us;
+            float mu = (t > t_lo) ? (float)(t - t_lo) * inv_span : 0.0f;
+            out[n].timestamp_us = t;
+            out[n].red = farrow_eval(c_red, mu);
+            out[n].ir = farrow_eval(c_ir, mu);
+            n++;
+        } else {
+            rs->stats.truncated++;
+        }
+        rs->next_out_us += rs->period_us;
+    }
+    rs->stats.outputs += n;
+    return n;
+}
+
+uint32_t resampler_get_period_us(const ResamplerState* rs) {
+    return rs->period_us;
+}
+
+void resampler_get_stats(const ResamplerState* rs, ResamplerStats* stats) {
+    if (stats) *stats = rs->stats;
+}
@@ -0,0 +1,71 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+// ──────────────────────────────────────────────
+// 均匀网格重采样（流式，红光/红外双通道）
+// ──────────────────────────────────────────────
+// 输入：带时间戳（微秒）的样本，间隔可以抖动（调度器被BLE/显示拖慢）
+// 输出：严格等间隔 period_us 的样本，DSP 可以按均匀采样处理
+// - Farrow 结构插值：每个输入区间计算一次多项式系数，每个输出样本只做 Horner 求值，
+//   单个输出样本的开销恒定
+//   线性：1阶，无额外延迟；三次：3阶 Lagrange，延迟1个输入样本
+// - 间隙检测：相邻输入间隔超过 RESAMPLER_GAP_PERIODS 个输出周期（FIFO溢出、任务长时间阻塞）
+//   不做插值，丢弃历史并从新样本重新起网格，同时置 gap 标志，调用方应重置下游滤波器
+
+#define RESAMPLER_GAP_PERIODS        5       // 间隙阈值（输出周期数，50ms @100Hz）
+#define RESAMPLER_MAX_OUT            (RESAMPLER_GAP_PERIODS + 1)  // 单个输入最多产生的输出数
+#define RESAMPLER_HISTORY            4       // 三次插值所需的输入点数
+
+typedef enum {
+    RESAMPLER_LINEAR = 0,
+    RESAMPLER_CUBIC
+} ResamplerMode;
+
+typedef struct {
+    uint64_t timestamp_us;           // 网格时刻
+    int32_t red;
+    int32_t ir;
+} ResampledSample;
+
+typedef struct {
+    uint32_t inputs;                 // 输入样本数
+    uint32_t outputs;                // 输出样本数
+    uint32_t gaps;                   // 检测到的间隙次数
+    uint32_t dropped;                // 时间戳不递增而丢弃的输入
+    uint32_t truncated;              // 输出缓冲不足而丢弃的网格点
+    uint32_t max_interval_us;        // 最大输入间隔（含间隙）
+} ResamplerStats;
+
+typedef struct {
+    ResamplerMode mode;
+    uint32_t period_us;
+    uint32_t gap_us;
+
+    // 输入历史（[0]最旧 .. [3]最新）
+    uint64_t hist_t[RESAMPLER_HISTORY];
+    int32_t hist_red[RESAMPLER_HISTORY];
+    int32_t hist_ir[RESAMPLER_HISTORY];
+    uint8_t count;                   // 当前段内有效输入点数（最多 RESAMPLER_HISTORY）
+
+    uint64_t next_out_us;            // 下一个网格时刻
+
+    ResamplerStats stats;
+} ResamplerState;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+void resampler_init(ResamplerState* rs, uint32_t period_us, ResamplerMode mode);
+void resampler_reset(ResamplerState* rs);   // 丢弃历史，下一个输入重新起网格（保留统计）
+
+// 送入一个输入样本，输出落在新区间内的网格样本（按时间先后），返回输出数；
+// 若本样本前检测到间隙，*gap 置1（调用方应先重置下游滤波器再处理输出）
+uint8_t resampler_push(ResamplerState* rs, uint64_t timestamp_us, int32_t red, int32_t ir,
+                       ResampledSample* out, uint8_t max_out, uint8_t* gap);
+
+uint32_t resampler_get_period_us(const ResamplerState* rs);
+void resampler_get_stats(const ResamplerState* rs, ResamplerStats* stats);
+
+#endif // RESAMPLER_H
@@ -0,0 +1,131 @@
+#include "wear_detect.h"
+#include "hr_driver.h"
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 私有状态
+// ──────────────────────────────────────────────
+
+typedef struct {
+    volatile WearState state;    // 只由采集任务修改
+    // 采集任务
+    uint32_t ir_acc;             // 直流窗口累加
+    uint8_t acc_count;
+    uint8_t low_windows;         // 连续低直流窗口数
+    uint32_t last_poll_ms;
+    // DSP任务
+    uint32_t poor_since_ms;      // 质量开始变差的时间（0=质量正常）
+    uint32_t sqi_epoch;          // 质量计时对应的佩戴次数（重新佩戴后重新计时）
+    volatile uint8_t off_requested;  // DSP任务判定质量差，等待采集任务执行离腕
+    WearStats stats;
+} WearDetectState;
+
+static WearDetectState g_wear = {WEAR_STATE_ON_WRIST};
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+static void enter_off_wrist() {
+    g_wear.state = WEAR_STATE_OFF_WRIST;
+    g_wear.stats.off_events++;
+    g_wear.stats.off_since_ms = millis();
+    g_wear.last_poll_ms = g_wear.stats.off_since_ms;
+    hr_enter_proximity_mode();
+
+#ifdef DEBUG_MODE
+    Serial.printf("[WEAR] 离腕 (IR DC:%ld)\n", (long)g_wear.stats.last_ir_dc);
+#endif
+}
+
+static void enter_on_wrist() {
+    g_wear.state = WEAR_STATE_ON_WRIST;
+    g_wear.stats.on_events++;
+    g_wear.ir_acc = 0;
+    g_wear.acc_count = 0;
+    g_wear.low_windows = 0;
+    hr_exit_proximity_mode();
+
+#ifdef DEBUG_MODE
+    Serial.printf("[WEAR] 重新佩戴 (离腕 %lu ms)\n",
+        (unsigned long)(millis() - g_wear.stats.off_since_ms));
+#endif
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void wear_detect_init() {
+    memset(&g_wear, 0, sizeof(g_wear));
+    g_wear.state = WEAR_STATE_ON_WRIST;  // 上电先按在腕处理，由直流判定
+}
+
+void wear_detect_feed_ppg(int32_t ir) {
+    if (g_wear.state != WEAR_STATE_ON_WRIST) return;
+
+    g_wear.ir_acc += (uint32_t)(ir > 0 ? ir : 0);
+    if (++g_wear.acc_count < WEAR_DC_WINDOW) return;
+
+    int32_t dc = (int32_t)(g_wear.ir_acc / WEAR_DC_WINDOW);
+    g_wear.ir_acc = 0;
+    g_wear.acc_count = 0;
+    g_wear.stats.last_ir_dc = dc;
+
+    if (dc < WEAR_OFF_DC) {
+        if (++g_wear.low_windows >= WEAR_OFF_WINDOWS) {
+            enter_off_wrist();
+        }
+    } else {
+        g_wear.low_windows = 0;
+    }
+}
+
+void wear_detect_feed_sqi(uint8_t snr_x10, uint8_t correlation) {
+    if (g_wear.state != WEAR_STATE_ON_WRIST) return;
+    if (g_wear.sqi_epoch != g_wear.stats.on_events) {
+        g_wear.sqi_epoch = g_wear.stats.on_events;
+        g_wear.poor_since_ms = 0;
+    }
+
+    if (snr_x10 > 0 || correlation >= WEAR_POOR_CORRELATION) {
+        g_wear.poor_since_ms = 0;
+        return;
+    }
+
+    uint32_t now = millis();
+    if (g_wear.poor_since_ms == 0) {
+        g_wear.poor_since_ms = now ? now : 1;
+    } else if ((now - g_wear.poor_since_ms) >= WEAR_POOR_SQI_MS) {
+        g_wear.off_requested = 1;    // 由采集任务执行
+    }
+}
+
+void wear_detect_poll(uint32_t now_ms) {
+    if (g_wear.state == WEAR_STATE_ON_WRIST) {
+        if (g_wear.off_requested) {
+            g_wear.off_requested = 0;
+            enter_off_wrist();
+        }
+        return;
+    }
+    g_wear.off_requested = 0;
+    if ((now_ms - g_wear.last_poll_ms) < WEAR_PROX_POLL_MS) return;
+    g_wear.last_poll_ms = now_ms;
+
+    if (hr_proximity_triggered()) {
+        enter_on_wrist();
+    }
+}
+
+WearState wear_detect_get_state() {
+    return g_wear.state;
+}
+
+uint8_t wear_detect_is_on_wrist() {
+    return (g_wear.state == WEAR_STATE_ON_WRIST) ? 1 : 0;
+}
+
+void wear_detect_get_stats(WearStats* stats) {
+    if (stats) *stats = g_wear.stats;
+}
@@ -0,0 +1,57 @@
+#ifndef WEAR_DETECT_H
+#define WEAR_DETECT_H
+
+#include <Arduino.h>
+
+// ──────────────────────────────────────────────
+// 佩戴检测（离腕时关停整条PPG处理链）
+// ──────────────────────────────────────────────
+// 判定依据：
+//   1. IR直流电平：连续 WEAR_OFF_WINDOWS 个窗口低于 WEAR_OFF_DC → 离腕
+//   2. 信号质量（SQI）：直流正常但 SNR=0 且相关性低持续 WEAR_POOR_SQI_MS → 离腕（如放在桌面）
+//   3. 离腕后 MAX30102 进入接近模式（低电流IR脉冲 + 阈值中断），中断触发 → 重新佩戴
+// 离腕期间采集器不再读FIFO，算法管理器暂停；重新佩戴后热启动（保留最近BPM作为滤波初值）。
+// 状态切换（MAX30102 模式切换走I2C）只在采集任务的 wear_detect_poll() 中执行：
+// 算法管理器（DSP任务）判定质量差时只置请求标志；HR算法基线由算法管理器热启动时重置。
+
+#ifndef WEAR_OFF_DC
+#define WEAR_OFF_DC              5000    // IR直流低于此值视为无接触（与 HR_AGC_MIN_CONTACT_DC 一致）
+#endif
+#define WEAR_DC_WINDOW           50      // 直流统计窗口（样本数，0.5秒 @100Hz）
+#define WEAR_OFF_WINDOWS         4       // 连续低直流窗口数（2秒）
+#define WEAR_POOR_SQI_MS         15000   // 质量持续差的判定时间
+#define WEAR_POOR_CORRELATION    20      // 相关性低于此值且SNR为0视为质量差
+#define WEAR_PROX_POLL_MS        250     // 离腕时查询接近中断的周期
+
+typedef enum {
+    WEAR_STATE_ON_WRIST = 0,
+    WEAR_STATE_OFF_WRIST
+} WearState;
+
+typedef struct {
+    uint32_t off_events;         // 离腕次数
+    uint32_t on_events;          // 重新佩戴次数
+    uint32_t off_since_ms;       // 最近一次离腕时间
+    int32_t last_ir_dc;          // 最近窗口IR直流
+} WearStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+void wear_detect_init();
+
+// 在线时每个PPG样本调用（采集器）
+void wear_detect_feed_ppg(int32_t ir);
+
+// 每次心率/血氧计算后调用（算法管理器）
+void wear_detect_feed_sqi(uint8_t snr_x10, uint8_t correlation);
+
+// 采集任务每周期调用：执行DSP任务请求的离腕；离腕时轮询接近中断，触发则恢复在线
+// （接近中断查询按 WEAR_PROX_POLL_MS 限速）
+void wear_detect_poll(uint32_t now_ms);
+
+WearState wear_detect_get_state();
+uint8_t wear_detect_is_on_wrist();
+void wear_detect_get_stats(WearStats* stats);
+
+#endif // WEAR_DETECT_H
@@ -20,21 +20,90 @@
 #define BLE_ADV_INTERVAL_MIN    800   // 500ms (800 * 0.625ms)
 #define BLE_ADV_INTERVAL_MAX    1600  // 1000ms (1600 * 0.625ms)
 
-// 连接参数
-#define BLE_CONN_INTERVAL_MIN   6     // 7.5ms (6 * 1.25ms)
+// 连接参数档位（间隔单位 1.25ms，超时单位 10ms），按当前用途经连接参数更新过程请求，中心可调整或拒绝
+// 取值满足 iOS 要求：间隔上限×(延迟+1) ≤ 2s，超时 > 间隔上限×(延迟+1)×3
+// 空闲摘要：几秒一条遥测，长间隔 + 从机延迟（无数据时外设跳过连接事件）
+#define BLE_CONN_IDLE_INTERVAL_MIN   160   // 200ms
+#define BLE_CONN_IDLE_INTERVAL_MAX   200   // 250ms
+#define BLE_CONN_IDLE_LATENCY        4     // 最长 1.25s 不应答（中心写入的响应也随之变慢）
+#define BLE_CONN_IDLE_TIMEOUT        500   // 5秒
+// 波形流：每 200ms 一帧，短间隔让帧在下一个连接事件发出
+#define BLE_CONN_STREAM_INTERVAL_MIN 24    // 30ms
+#define BLE_CONN_STREAM_INTERVAL_MAX 40    // 50ms
+#define BLE_CONN_STREAM_LATENCY      0
+#define BLE_CONN_STREAM_TIMEOUT      400   // 4秒
+// 历史批量：最短间隔（DLE 在连接时已请求）
+#define BLE_CONN_INTERVAL_MIN   6     // 7.5ms (6 * 1.25ms)，iOS 最短接受 15ms
 #define BLE_CONN_INTERVAL_MAX   12    // 15ms (12 * 1.25ms)
 #define BLE_CONN_LATENCY        0     // 无延迟
 #define BLE_CONN_TIMEOUT        400   // 4秒 (400 * 10ms)
+#define BLE_CONN_HOLD_MS        3000  // 需求下降后保持原档位的时间（避免反复更新）
+#define BLE_CONN_RETRY_MS       10000 // 中心未采用请求的参数时重试的间隔
+#define BLE_CONN_MAX_RETRIES    2
+
+// 能耗估算模型（无电流计，用于比较各档位的每字节能耗；按实测电流校准）
+#define BLE_ENERGY_EVENT_UJ     150   // 一次连接事件：唤醒 + 收发空包（约 2ms × 25mA × 3.3V）
+#define BLE_ENERGY_BYTE_NJ      2600  // 1M PHY 每字节空中时间 8µs × 约 100mA × 3.3V（2M 减半）
 
 // 特征值属性
 #define BLE_CHAR_PROPERTIES     (NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY)
 
+// ==================== 吞吐配置（MTU / DLE / PHY）====================
+// 外设只能声明期望的 MTU，交换由中心发起（Android requestMtu，iOS 自动协商 185）；
+// 协商结果到达前按默认 MTU 发送。单次通知负载 = ATT MTU - 3。
+#define BLE_DEFAULT_ATT_MTU     23    // 协商前（BLE 4.0 最小值）
+#define BLE_PREFERRED_MTU       247   // 251字节链路层包减 L2CAP 头（NimBLE 上限 517）
+#define BLE_ATT_NOTIFY_OVERHEAD 3     // opcode + handle
+#define BLE_DLE_TX_OCTETS       251   // LE Data Length Extension 最大链路层负载
+#define BLE_PREFER_2M_PHY       1     // 中心支持时切到 2M PHY（射频时间减半）
+
+// ==================== 原始PPG波形流 ====================
+// 订阅波形特征值后按连接间隔攒批推送 100Hz 红光/红外（帧格式见 src/ppg_stream_packet.h）
+// 每批时长取连接间隔的整数倍（帧与连接事件对齐），不短于 MIN（摊薄帧头与首样本，≥20样本时低于3字节/对）
+#define BLE_PPG_MIN_BATCH_MS    200
+#define BLE_PPG_MAX_BATCH_MS    500   // 上限（波形显示延迟）
+#define BLE_PPG_TX_MIN_FREE_MBUFS 8   // 协议栈空闲缓冲低于此值时暂停波形流（高于遥测的保留数，避免挤占）
+
+// ==================== 离线历史同步 ====================
+#define BLE_HISTORY_TX_MIN_FREE_MBUFS 6  // 批量拉取：空闲缓冲低于此值时暂停（介于遥测与波形流之间）
+#define BLE_HISTORY_MTU_WAIT_MS 2000  // 拉取时 MTU 装不下一条记录：等待中心交换 MTU 的时长，超时则拒绝
+
+// ==================== 无连接广播 ====================
+// 厂商数据 = 公司ID（小端）+ 遥测帧（src/telemetry_packet.h）；广播间隔用上面的 BLE_ADV_INTERVAL_MIN/MAX
+#ifndef BLE_BROADCAST_COMPANY_ID
+#define BLE_BROADCAST_COMPANY_ID 0xFFFF  // 蓝牙SIG保留的测试ID（量产需替换为已分配ID）
+#endif
+#define BLE_BROADCAST_REFRESH_MS 5000    // 没有新结果时也按此周期检查电量/佩戴变化
+
+// ==================== 检测模块链路（腕带作为中心）====================
+// 连接检测模块并合并其 HR/SpO2/丙酮（src/detector_link_final.h），build_flags 加 -DDETECTOR_LINK_ENABLE=1 启用
+#ifndef DETECTOR_LINK_ENABLE
+#define DETECTOR_LINK_ENABLE          0
+#endif
+#define BLE_DETECTOR_SCAN_MS          3000   // 单次被动扫描时长
+#define BLE_DETECTOR_SCAN_INTERVAL_MS 300    // 扫描占空比10%（检测模块广播间隔 20~40ms，几个窗口内即可收到）
+#define BLE_DETECTOR_SCAN_WINDOW_MS   30
+#define BLE_DETECTOR_RETRY_MIN_MS     5000   // 未找到/连接失败后的重扫间隔，连续失败翻倍
+#define BLE_DETECTOR_RETRY_MAX_MS     120000
+#define BLE_DETECTOR_CONNECT_TIMEOUT_MS 2000 // 异步连接：超时由协议栈以连接失败事件上报，通信任务不等待
+#define BLE_DETECTOR_SETUP_TIMEOUT_MS  5000  // 连上后发现服务、订阅、读取初值的总时限（逐步推进，超时断开重扫）
+
 // ==================== 数据格式配置 ====================
 // JSON数据最大长度
 #define BLE_JSON_MAX_LENGTH     128
 
-// 数据发送间隔（毫秒）
+// 数据发送间隔（毫秒）：按需通知，结果变化超过死区才发，不快于 INTERVAL，最长 KEEPALIVE 发一次
 #define BLE_NOTIFY_INTERVAL_MS  4000  // 4秒
+#define BLE_NOTIFY_KEEPALIVE_MS 30000
+
+// 变化死区（遥测帧单位，变化量不超过死区视为未变；风险/佩戴任何变化都通知）
+// 汇总特征值与分字段特征值共用；出现/消失（如HR未得出）总算变化
+#define BLE_DEADBAND_HR         1     // bpm
+#define BLE_DEADBAND_SPO2       1     // %
+#define BLE_DEADBAND_ACETONE    2     // 0.1ppm
+#define BLE_DEADBAND_BATTERY    1     // %
+#define BLE_DEADBAND_SNR        10    // 信号质量（只在汇总中）
+#define BLE_FIELD_CHECK_MS      1000  // 分字段特征值的检查周期（即最短通知间隔）
 
 // ==================== 低功耗配置 ====================
 // ESP32-S3功耗等级（ESP_PWR_LVL_P3为最低功耗）
@@ -49,7 +49,7 @@
 // BLE通信配置
 #define BLE_ADVERTISE_INTERVAL_MS 100   // BLE广播间隔
 #define BLE_CONNECT_TIMEOUT_MS   10000  // BLE连接超时
-#define BLE_MTU_SIZE             23     // BLE MTU大小
+#define BLE_MTU_SIZE             23     // 协商前的默认ATT MTU（协商见 ble_config.h BLE_PREFERRED_MTU）
 
 // 运动校正配置
 #define MOTION_SAMPLE_RATE       50     // 运动传感器采样率（Hz）
@@ -24,6 +24,7 @@
 #include <esp_sleep.h>
 #include "algorithm/hr_algorithm.h"
 #include "drivers/gas_driver.h"
+#include "system/timer_wheel.h"
 #include "config/pin_config.h"  // 统一引脚配置
 
 // ==================== 引脚定义（ESP32-C3） ====================
@@ -96,10 +97,10 @@ BLECharacteristic* pCharError = nullptr;
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
 
-// 分时状态机
+// 分时状态机：阶段切换（含加热器关断）由时间轮单次定时器触发，不依赖 loop() 的轮询时机
 enum Phase { PHASE_HR_SPO2, PHASE_HEAT, PHASE_ACETONE, PHASE_SLEEP };
 Phase curPhase = PHASE_HR_SPO2;
-uint32_t phaseStartMs = 0;
+static TimerWheelTimer phaseTimer;
 
 // 当前测量值（0xFF、0xFFFF 表示无效）
 uint8_t lastHR = 0;           // 0 或 1–254 有效
@@ -357,6 +358,40 @@ void enter_light_sleep(uint64_t sleep_us) {
   Serial.println("[低功耗] 唤醒");
 }
 
+// ==================== 阶段切换（单次定时器回调）====================
+static void on_acetone_phase_done() {
+  curPhase = PHASE_SLEEP;
+  Serial.println("[分时] 丙酮采集阶段结束，准备进入低功耗睡眠");
+}
+
+static void on_heat_phase_done() {
+  // 60秒加热结束，进入丙酮采集阶段
+  gas_heater_off();
+  curPhase = PHASE_ACETONE;
+  timer_wheel_start_oneshot(&phaseTimer, "phase_acetone", PHASE_ACETONE_MS, on_acetone_phase_done);
+  Serial.println("[分时] SnO₂加热完成，开始采集丙酮浓度");
+}
+
+static void on_hr_phase_done() {
+  // 30秒采集结束，进入加热阶段
+  curPhase = PHASE_HEAT;
+  gas_heater_on();
+  timer_wheel_start_oneshot(&phaseTimer, "heater_off", PHASE_HEAT_MS, on_heat_phase_done);
+  Serial.println("[分时] MAX30102采集完成，开始加热SnO₂");
+  
+  // 发送最后一次心率血氧数据
+  if (hrBufFilled) {
+    lastHR = compute_bpm_simple(irBuf, HR_BUF_SIZE);
+    lastSpO2 = compute_spo2_simple(redBuf, irBuf, HR_BUF_SIZE);
+    send_ble_data();
+  }
+}
+
+static void start_hr_phase() {
+  curPhase = PHASE_HR_SPO2;
+  timer_wheel_start_oneshot(&phaseTimer, "phase_hr", PHASE_HR_SPO2_MS, on_hr_phase_done);
+}
+
 // ==================== 检测模块专用函数声明 ====================
 // 这些函数在main.cpp中被调用
 
@@ -426,8 +461,7 @@ void detector_setup() {
   Serial.println("[detection_sensor] BLE 广播已启动，设备名: " BLE_DEVICE_NAME);
   
   // 初始化状态
-  curPhase = PHASE_HR_SPO2;
-  phaseStartMs = millis();
+  start_hr_phase();
   memset(irBuf, 0, sizeof(irBuf));
   memset(redBuf, 0, sizeof(redBuf));
   hrBufIdx = 0;
@@ -441,8 +475,8 @@ void detector_setup() {
 
 // ==================== loop：分时状态机 ====================
 void loop() {
-  uint32_t now = millis();
-  uint32_t elapsed = now - phaseStartMs;
+  // 执行到期的阶段切换
+  timer_wheel_advance(millis());
   
   // 处理BLE连接状态变化
   if (!deviceConnected && oldDeviceConnected) {
@@ -455,22 +489,6 @@ void loop() {
   
   switch (curPhase) {
     case PHASE_HR_SPO2: {
-      if (elapsed >= PHASE_HR_SPO2_MS) {
-        // 30秒采集结束，进入加热阶段
-        curPhase = PHASE_HEAT;
-        phaseStartMs = now;
-        gas_heater_on();
-        Serial.println("[分时] MAX30102采集完成，开始加热SnO₂");
-        
-        // 发送最后一次心率血氧数据
-        if (hrBufFilled) {
-          lastHR = compute_bpm_simple(irBuf, HR_BUF_SIZE);
-          lastSpO2 = compute_spo2_simple(redBuf, irBuf, HR_BUF_SIZE);
-          send_ble_data();
-        }
-        break;
-      }
-      
       // 持续采集MAX30102数据
       int32_t red, ir;
       if (max30102_read_sample(&red, &ir)) {
@@ -491,13 +509,6 @@ void loop() {
     }
     
     case PHASE_HEAT: {
-      if (elapsed >= PHASE_HEAT_MS) {
-        // 60秒加热结束，进入丙酮采集阶段
-        curPhase = PHASE_ACETONE;
-        phaseStartMs = now;
-        gas_heater_off();
-        Serial.println("[分时] SnO₂加热完成，开始采集丙酮浓度");
-      }
       delay(100);  // 加热阶段不需要高频操作
       break;
     }
@@ -510,15 +521,8 @@ void loop() {
       Serial.printf("[分时] 丙酮采集完成: %.1f mV -> %.1f ppm\n", 
                     voltage_mv, lastAcetonePpm);
       
-      // 发送丙酮数据
+      // 发送丙酮数据（稳定时间到后由定时器切到睡眠阶段）
       send_ble_data();
-      
-      // 等待稳定时间
-      if (elapsed >= PHASE_ACETONE_MS) {
-        // 进入睡眠阶段
-        curPhase = PHASE_SLEEP;
-        Serial.println("[分时] 丙酮采集阶段结束，准备进入低功耗睡眠");
-      }
       break;
     }
     
@@ -538,8 +542,7 @@ void loop() {
       enter_light_sleep(SLEEP_DURATION_US);
       
       // 唤醒后重新开始采集
-      curPhase = PHASE_HR_SPO2;
-      phaseStartMs = millis();
+      start_hr_phase();
       Serial.println("[分时] 睡眠结束，开始新一轮采集");
       break;
     }
@@ -24,6 +24,7 @@
 #include "algorithm/hr_algorithm.h"
 #include "drivers/gas_driver.h"
 #include "config/pin_config.h"  // 使用统一的引脚配置
+#include "src/json_writer.h"     // 定长缓冲流式JSON（不用 String 拼接）
 
 // ==================== 引脚定义（ESP32-C3） ====================
 #ifndef PIN_SDA
@@ -47,6 +48,7 @@
 #define BLE_SERVICE_UUID      "a1b2c3d4-e5f6-4789-abcd-ef0123456789"
 #define BLE_CHAR_DATA_UUID    "a1b2c3d4-e5f6-4789-abcd-ef012345678a"  // JSON数据
 #define BLE_CHAR_ERROR_UUID   "a1b2c3d4-e5f6-4789-abcd-ef012345678e"  // 错误码
+#define JSON_BUF_LEN          96      // JSON数据缓冲（栈上，最长约60字节）
 
 // ==================== 分时阶段配置 ====================
 #define PHASE_HR_SPO2_MS      30000   // 阶段1：MAX30102 采集 30 秒
@@ -105,26 +107,28 @@ class MyServerCallbacks : public BLEServerCallbacks {
 // ==================== 辅助函数 ====================
 
 // 创建JSON格式数据
-String createJsonData() {
-  // 构建JSON字符串：{"hr":xx, "spo2":xx, "acetone":xx.x, "note":"仅供参考"}
-  String json = "{";
-  json += "\"hr\":";
-  json += (heartRate == 0) ? "null" : String(heartRate);
-  json += ",\"spo2\":";
-  json += (spO2 == 0) ? "null" : String(spO2);
-  json += ",\"acetone\":";
-  json += (acetonePpm <= 0) ? "null" : String(acetonePpm, 1);
-  json += ",\"note\":\"仅供参考\"";
-  json += "}";
-  return json;
+uint16_t createJsonData(char* out, uint16_t capacity) {
+  // 构建JSON：{"hr":xx,"spo2":xx,"acetone":xx.x,"note":"仅供参考"}，无效值为 null
+  JsonWriter w;
+  json_begin(&w, out, capacity);
+  json_key(&w, JSON_KEY("hr"));
+  if (heartRate == 0) json_null(&w); else json_uint(&w, heartRate);
+  json_key(&w, JSON_KEY("spo2"));
+  if (spO2 == 0) json_null(&w); else json_uint(&w, spO2);
+  json_key(&w, JSON_KEY("acetone"));
+  if (acetonePpm <= 0) json_null(&w); else json_fixed(&w, (int32_t)(acetonePpm * 10.0f + 0.5f), 1);
+  json_key(&w, JSON_KEY("note"));
+  json_raw(&w, JSON_CONST_STR("仅供参考"));
+  return json_end(&w);
 }
 
 // 通过BLE发送JSON数据
 void sendJsonData() {
   if (!deviceConnected) return;
   
-  String jsonData = createJsonData();
-  pCharData->setValue(jsonData.c_str());
+  char jsonData[JSON_BUF_LEN];
+  uint16_t len = createJsonData(jsonData, sizeof(jsonData));
+  pCharData->setValue((uint8_t*)jsonData, len);
   pCharData->notify();
   
   Serial.print("[BLE] JSON数据已发送: ");
@@ -0,0 +1,37 @@
+#include "adc_calib.h"
+
+#if defined(ESP32)
+#include <esp_adc_cal.h>
+#endif
+
+// ADC默认衰减（Arduino-ESP32 analogRead 默认 11dB）与无eFuse时的默认Vref
+#define ADC_CALIB_DEFAULT_VREF_MV   1100
+
+void adc_calib_build_lut(AdcCalibLut* lut, uint16_t ref_mv, uint16_t resolution) {
+    if (lut == NULL || resolution == 0) return;
+
+    lut->efuse_calibrated = 0;
+
+#if defined(ESP32)
+    // 读取eFuse中的出厂标定值；仅在确有eFuse标定时使用，否则保持原线性换算
+    esp_adc_cal_characteristics_t chars;
+    esp_adc_cal_value_t src = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11,
+                                                       ADC_WIDTH_BIT_12,
+                                                       ADC_CALIB_DEFAULT_VREF_MV, &chars);
+    if (src != ESP_ADC_CAL_VAL_DEFAULT_VREF) {
+        for (uint16_t i = 0; i < ADC_CALIB_LUT_SIZE; i++) {
+            uint32_t raw = (uint32_t)i << ADC_CALIB_LUT_SHIFT;
+            if (raw > ADC_CALIB_MAX_RAW) raw = ADC_CALIB_MAX_RAW;
+            lut->knot_mv[i] = (uint16_t)esp_adc_cal_raw_to_voltage(raw, &chars);
+        }
+        lut->efuse_calibrated = 1;
+        return;
+    }
+#endif
+
+    // 理想线性：mv = raw * ref_mv / resolution（节点处取整，插值误差 < 1mV）
+    for (uint16_t i = 0; i < ADC_CALIB_LUT_SIZE; i++) {
+        uint32_t raw = (uint32_t)i << ADC_CALIB_LUT_SHIFT;
+        lut->knot_mv[i] = (uint16_t)((raw * ref_mv) / resolution);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef ADC_CALIB_H
+#define ADC_CALIB_H
+
+#include <Arduino.h>
+
+// ──────────────────────────────────────────────
+// ADC原始值→mV 查找表（标定时生成，读数时查表+线性插值）
+// ──────────────────────────────────────────────
+// 12位ADC每64个码值一个节点，共65个节点（130 bytes）
+// 有eFuse标定（Vref/Two Point）时节点取 esp_adc_cal 结果，否则按理想线性换算
+
+#define ADC_CALIB_LUT_SHIFT      6                                         // 节点间隔 = 64 码值
+#define ADC_CALIB_MAX_RAW        4095                                      // 12位ADC最大码值
+#define ADC_CALIB_LUT_SIZE       (((ADC_CALIB_MAX_RAW + 1) >> ADC_CALIB_LUT_SHIFT) + 1)  // 65
+
+typedef struct {
+    uint16_t knot_mv[ADC_CALIB_LUT_SIZE];   // 各节点电压（mV）
+    uint8_t efuse_calibrated;               // 1=使用eFuse标定，0=理想线性
+} AdcCalibLut;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+// 生成查找表（ref_mv/resolution 为无eFuse时的理想换算参数）
+void adc_calib_build_lut(AdcCalibLut* lut, uint16_t ref_mv, uint16_t resolution);
+
+// 查表换算：两节点间线性插值，纯整数运算
+static inline uint16_t adc_calib_raw_to_mv(const AdcCalibLut* lut, uint16_t raw) {
+    if (raw > ADC_CALIB_MAX_RAW) raw = ADC_CALIB_MAX_RAW;
+    uint16_t idx = raw >> ADC_CALIB_LUT_SHIFT;
+    uint16_t frac = raw & ((1 << ADC_CALIB_LUT_SHIFT) - 1);
+    int32_t y0 = lut->knot_mv[idx];
+    int32_t y1 = lut->knot_mv[idx + 1];
+    return (uint16_t)(y0 + (((y1 - y0) * (int32_t)frac) >> ADC_CALIB_LUT_SHIFT));
+}
+
+#endif // ADC_CALIB_H
@@ -1,4 +1,5 @@
 #include "gas_driver.h"
+#include "adc_calib.h"
 #include <math.h>
 
 // ================= 私有变量 =================
@@ -6,13 +7,24 @@ static unsigned long warmup_start_ms = 0;
 static bool warmup_complete = false;
 static uint8_t heater_duty_cycle = GAS_HEATER_PREHEAT_DUTY;
 
+// 标定参数（运行时可由 gas_set_calibration() 更新，更新后重建查找表）
+static float calib_a = GAS_CALIB_A;
+static float calib_b = GAS_CALIB_B;
+static float calib_vair_mv = GAS_SUPPLY_VOLTAGE_MV / 2.0f;  // 清洁空气中电压（默认取Vcc/2典型值）
+
+// 查找表：ADC原始值→mV，mV→ppm×100（标定时生成，读数时查表）
+static AdcCalibLut adc_lut;
+static uint32_t ppm_lut_x100[GAS_PPM_LUT_SIZE];
+
 // ================= 私有函数声明 =================
 static uint16_t read_adc_raw();
-static float adc_raw_to_mv(uint16_t raw);
-static float calculate_variance(uint16_t* samples, uint8_t n);
+static uint16_t adc_raw_to_mv(uint16_t raw);
+static float calculate_variance(const uint16_t* samples_mv, uint8_t n);
 static uint16_t median_filter(uint16_t* samples, uint8_t n);
 static float calculate_resistance(float voltage_mv);
-static float voltage_to_ppm(float voltage_mv);
+static float model_voltage_to_ppm(float voltage_mv, float r0);
+static void build_ppm_lut();
+static float voltage_to_ppm(uint16_t voltage_mv);
 static void update_heater_control();
 
 // ================= 公共函数实现 =================
@@ -48,6 +60,12 @@ bool gas_init() {
     warmup_start_ms = millis();
     warmup_complete = false;
     heater_duty_cycle = GAS_HEATER_PREHEAT_DUTY;
+
+    // 生成换算查找表（eFuse标定在此读取一次）
+    adc_calib_build_lut(&adc_lut, GAS_ADC_REF_MV, GAS_ADC_RESOLUTION);
+    build_ppm_lut();
+    GAS_DEBUG_PRINTF("[GAS] 查找表已生成，ADC标定来源: %s\n",
+                     adc_lut.efuse_calibrated ? "eFuse" : "线性");
     
     GAS_DEBUG_PRINTLN("[GAS] 气体传感器初始化完成，开始预热");
     return true;
@@ -78,15 +96,17 @@ bool gas_read(float* voltage_mv, float* conc_ppm) {
         GAS_DEBUG_PRINTF("[GAS] 预热完成，切换加热占空比至: %d%%\n", heater_duty_cycle);
     }
 
-    // 采集20个样本（间隔5ms，总采集时间100ms）
+    // 采集20个样本（间隔5ms，总采集时间100ms），每个样本只查表换算一次
     uint16_t samples[GAS_SAMPLE_COUNT];
+    uint16_t samples_mv[GAS_SAMPLE_COUNT];
     for (uint8_t i = 0; i < GAS_SAMPLE_COUNT; i++) {
         samples[i] = read_adc_raw();
+        samples_mv[i] = adc_raw_to_mv(samples[i]);
         delay(GAS_SAMPLE_INTERVAL_MS);
     }
 
     // 计算方差判断是否有运动干扰
-    float variance = calculate_variance(samples, GAS_SAMPLE_COUNT);
+    float variance = calculate_variance(samples_mv, GAS_SAMPLE_COUNT);
     uint16_t processed_sample;
     
     if (variance > GAS_VARIANCE_THRESHOLD) {
@@ -103,11 +123,10 @@ bool gas_read(float* voltage_mv, float* conc_ppm) {
         GAS_DEBUG_PRINTF("[GAS] 正常采集，使用平均值，方差: %.1f mV²\n", variance);
     }
 
-    // 转换为电压（mV）
-    *voltage_mv = adc_raw_to_mv(processed_sample);
-    
-    // 转换为浓度（ppm）
-    *conc_ppm = voltage_to_ppm(*voltage_mv);
+    // 转换为电压（mV）与浓度（ppm），均为查表
+    uint16_t processed_mv = adc_raw_to_mv(processed_sample);
+    *voltage_mv = processed_mv;
+    *conc_ppm = voltage_to_ppm(processed_mv);
 
     GAS_DEBUG_PRINTF("[GAS] 采集完成: %.1f mV -> %.2f ppm\n", *voltage_mv, *conc_ppm);
     return true;
@@ -136,6 +155,15 @@ uint32_t gas_get_warmup_remaining() {
     return GAS_WARMUP_MS - elapsed;
 }
 
+void gas_set_calibration(float a, float b, float vair_mv) {
+    calib_a = a;
+    calib_b = b;
+    if (vair_mv > 0.0f && vair_mv < GAS_SUPPLY_VOLTAGE_MV) {
+        calib_vair_mv = vair_mv;
+    }
+    build_ppm_lut();
+}
+
 #ifdef PIN_AO3400_GATE
 // 控制AO3400门控引脚的状态，传入true设置高电平（开启），false设置低电平（关闭）
 void gas_set_ao3400_gate(bool on) {
@@ -159,31 +187,27 @@ static uint16_t read_adc_raw() {
 #endif
 }
 
-// ADC原始值转换为电压（mV）
-static float adc_raw_to_mv(uint16_t raw) {
-    return (raw / (float)GAS_ADC_RESOLUTION) * GAS_ADC_REF_MV;
+// ADC原始值转换为电压（mV）：查表+插值
+static uint16_t adc_raw_to_mv(uint16_t raw) {
+    return adc_calib_raw_to_mv(&adc_lut, raw);
 }
 
-// 计算样本方差（mV²）
-static float calculate_variance(uint16_t* samples, uint8_t n) {
+// 计算样本方差（mV²），输入为已换算的mV样本
+// 整数累加：var = (n*Σx² - (Σx)²) / (n*(n-1))
+static float calculate_variance(const uint16_t* samples_mv, uint8_t n) {
     if (n < 2) return 0.0f;
     
-    // 计算平均值
-    float sum = 0.0f;
+    uint32_t sum = 0;
+    uint64_t sum_sq = 0;
     for (uint8_t i = 0; i < n; i++) {
-        sum += adc_raw_to_mv(samples[i]);
+        sum += samples_mv[i];
+        sum_sq += (uint32_t)samples_mv[i] * samples_mv[i];
     }
-    float mean = sum / n;
     
-    // 计算方差
-    float variance = 0.0f;
-    for (uint8_t i = 0; i < n; i++) {
-        float diff = adc_raw_to_mv(samples[i]) - mean;
-        variance += diff * diff;
-    }
-    variance /= (n - 1);
+    int64_t num = (int64_t)n * (int64_t)sum_sq - (int64_t)sum * (int64_t)sum;
+    if (num < 0) num = 0;
     
-    return variance;
+    return (float)num / (float)((uint32_t)n * (n - 1));
 }
 
 // 中值滤波（冒泡排序取中间值）
@@ -230,39 +254,54 @@ static float calculate_resistance(float voltage_mv) {
     return rs;
 }
 
-// 电压转换为浓度（ppm）
-// 对数模型：ppm = a * ln(Rs/R0) + b
-// 其中：Rs/R0 = ratio = Rs / R0
-// 使用基线比率：在清洁空气中，Rs/R0 = GAS_BASELINE_RATIO
-static float voltage_to_ppm(float voltage_mv) {
+// 对数模型：ppm = a * ln(Rs/R0) + b（仅在生成查找表时调用）
+// 其中：R0 = Rs_air / GAS_BASELINE_RATIO，Rs_air 为清洁空气电压下的电阻
+static float model_voltage_to_ppm(float voltage_mv, float r0) {
     float rs = calculate_resistance(voltage_mv);
-    if (rs <= 0) return 0.0f;
-    
-    // 计算清洁空气中的电阻R0
-    // 根据基线比率：Rs_air = R0 * GAS_BASELINE_RATIO
-    // 需要知道清洁空气中的电压Vair来计算Rs_air
-    // 简化：假设清洁空气中电压为Vair = GAS_SUPPLY_VOLTAGE_MV / 2（典型值）
-    // 实际应用中应通过校准获得准确的Vair
-    
-    float vair_mv = GAS_SUPPLY_VOLTAGE_MV / 2.0f;  // 假设清洁空气中电压
-    float rs_air = calculate_resistance(vair_mv);
-    if (rs_air <= 0) return 0.0f;
-    
-    // 计算R0
-    float r0 = rs_air / GAS_BASELINE_RATIO;
-    if (r0 <= 0) return 0.0f;
+    if (rs <= 0 || r0 <= 0) return 0.0f;
     
     // 计算Rs/R0比率
     float ratio = rs / r0;
     if (ratio <= 0) return 0.0f;
     
-    // 对数模型转换
-    float ppm = GAS_CALIB_A * log(ratio) + GAS_CALIB_B;
+    float ppm = calib_a * logf(ratio) + calib_b;
     
     // 限制有效范围
     if (ppm < 0) ppm = 0.0f;
-    
-    GAS_DEBUG_PRINTF("[GAS] 浓度转换: Rs=%.0fΩ, R0=%.0fΩ, ratio=%.3f, ppm=%.2f\n", 
-                     rs, r0, ratio, ppm);
+    if (ppm > GAS_CONC_MAX_PPM) ppm = GAS_CONC_MAX_PPM;
     return ppm;
 }
+
+// 生成 mV→ppm×100 查找表（每 2^GAS_PPM_LUT_SHIFT mV 一个节点）
+// Rs_air 与 R0 只在此处计算一次，不再随每次读数重复计算
+static void build_ppm_lut() {
+    float rs_air = calculate_resistance(calib_vair_mv);
+    float r0 = rs_air / GAS_BASELINE_RATIO;
+    
+    for (uint16_t i = 0; i < GAS_PPM_LUT_SIZE; i++) {
+        // 0mV节点取1mV处的值，保证低电压段插值连续（0mV本身在查表时单独返回0）
+        float mv = (i == 0) ? 1.0f : (float)((uint32_t)i << GAS_PPM_LUT_SHIFT);
+        float ppm_x100 = model_voltage_to_ppm(mv, r0) * 100.0f + 0.5f;
+        ppm_lut_x100[i] = (uint32_t)ppm_x100;
+    }
+    
+    GAS_DEBUG_PRINTF("[GAS] ppm查找表: Vair=%.0fmV, Rs_air=%.0fΩ, R0=%.0fΩ, %u节点\n",
+                     calib_vair_mv, rs_air, r0, (unsigned)GAS_PPM_LUT_SIZE);
+}
+
+// 电压转换为浓度（ppm）：查表+定点线性插值
+static float voltage_to_ppm(uint16_t voltage_mv) {
+    if (voltage_mv == 0) return 0.0f;
+    
+    uint16_t idx = voltage_mv >> GAS_PPM_LUT_SHIFT;
+    if (idx >= GAS_PPM_LUT_SIZE - 1) {
+        return ppm_lut_x100[GAS_PPM_LUT_SIZE - 1] / 100.0f;
+    }
+    
+    uint16_t frac = voltage_mv & ((1 << GAS_PPM_LUT_SHIFT) - 1);
+    int32_t y0 = ppm_lut_x100[idx];
+    int32_t y1 = ppm_lut_x100[idx + 1];
+    int32_t ppm_x100 = y0 + (((y1 - y0) * (int32_t)frac) >> GAS_PPM_LUT_SHIFT);
+    
+    return ppm_x100 / 100.0f;
+}
@@ -68,6 +68,16 @@
 #define GAS_CALIB_B              -2.0f   // 对数模型参数b
 #endif
 
+#ifndef GAS_CONC_MAX_PPM
+#define GAS_CONC_MAX_PPM         10000   // 浓度上限（SnO₂ 丙酮量程 50~5000ppm，留余量）
+#endif
+
+// 查找表参数（mV→ppm，每 2^GAS_PPM_LUT_SHIFT mV 一个节点，ppm×100 以 uint32 存储，覆盖到 GAS_CONC_MAX_PPM）
+#ifndef GAS_PPM_LUT_SHIFT
+#define GAS_PPM_LUT_SHIFT        5       // 32mV/节点
+#endif
+#define GAS_PPM_LUT_SIZE         ((GAS_SUPPLY_VOLTAGE_MV >> GAS_PPM_LUT_SHIFT) + 2)
+
 // ──────────────────────────────────────────────
 // 加热控制参数
 #ifndef GAS_HEATER_PREHEAT_DUTY
@@ -85,6 +95,7 @@ bool gas_read(float* voltage_mv, float* conc_ppm); // 读取：返回true=有效
 bool gas_is_warmed_up();                           // 检查预热是否完成
 float gas_get_heater_duty_cycle();                 // 获取当前加热PWM占空比（0-100%）
 uint32_t gas_get_warmup_remaining();               // 获取剩余预热时间（ms）
+void gas_set_calibration(float a, float b, float vair_mv);  // 更新对数模型参数与清洁空气电压，并重建查找表
 
 #ifdef PIN_AO3400_GATE
 // 使用AO3400门控时的辅助接口
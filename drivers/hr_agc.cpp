@@ -0,0 +1,105 @@
+#include "hr_agc.h"
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+// 单通道LED调整：按 target/dc 比例缩放，单步限制在 [1/4, 4] 倍且至少变化1档
+// 返回：0=无需调整或已调整；+1=LED已到上限仍偏低；-1=LED已到下限仍偏高
+static int8_t adjust_led(uint8_t* led, int32_t dc, bool* changed) {
+    *changed = false;
+    if (dc >= HR_AGC_DC_LOW && dc <= HR_AGC_DC_HIGH) {
+        return 0;  // 滞回带内不动作
+    }
+
+    uint32_t cur = *led;
+    uint32_t next;
+    if (dc < HR_AGC_DC_LOW) {
+        if (cur >= HR_AGC_LED_MAX) return +1;
+        uint32_t safe_dc = (dc > 0) ? (uint32_t)dc : 1;
+        next = (cur * HR_AGC_DC_TARGET) / safe_dc;
+        if (next > cur * HR_AGC_MAX_GAIN_STEP) next = cur * HR_AGC_MAX_GAIN_STEP;
+        if (next <= cur) next = cur + 1;
+        if (next > HR_AGC_LED_MAX) next = HR_AGC_LED_MAX;
+    } else {
+        if (cur <= HR_AGC_LED_MIN) return -1;
+        next = (cur * HR_AGC_DC_TARGET) / (uint32_t)dc;
+        if (next < cur / HR_AGC_MAX_GAIN_STEP) next = cur / HR_AGC_MAX_GAIN_STEP;
+        if (next >= cur) next = cur - 1;
+        if (next < HR_AGC_LED_MIN) next = HR_AGC_LED_MIN;
+    }
+
+    *led = (uint8_t)next;
+    *changed = true;
+    return 0;
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void hr_agc_init(HrAgcState* agc, uint8_t led_red, uint8_t led_ir, uint8_t range_idx) {
+    agc->led_red = led_red;
+    agc->led_ir = led_ir;
+    agc->range_idx = (range_idx < HR_AGC_RANGE_COUNT) ? range_idx : HR_AGC_RANGE_DEFAULT;
+    agc->enabled = true;
+    agc->red_acc = 0;
+    agc->ir_acc = 0;
+    agc->acc_count = 0;
+    agc->settle = HR_AGC_SETTLE_SAMPLES;
+    agc->step_count = 0;
+    agc->last_red_dc = 0;
+    agc->last_ir_dc = 0;
+}
+
+uint8_t hr_agc_process(HrAgcState* agc, int32_t red, int32_t ir) {
+    if (!agc->enabled) return 0;
+
+    if (agc->settle > 0) {
+        agc->settle--;
+        return 0;
+    }
+
+    agc->red_acc += (uint32_t)(red > 0 ? red : 0);
+    agc->ir_acc += (uint32_t)(ir > 0 ? ir : 0);
+    if (++agc->acc_count < HR_AGC_WINDOW) {
+        return 0;
+    }
+
+    int32_t red_dc = (int32_t)(agc->red_acc / HR_AGC_WINDOW);
+    int32_t ir_dc = (int32_t)(agc->ir_acc / HR_AGC_WINDOW);
+    agc->red_acc = 0;
+    agc->ir_acc = 0;
+    agc->acc_count = 0;
+    agc->last_red_dc = red_dc;
+    agc->last_ir_dc = ir_dc;
+
+    // 未接触皮肤：保持当前设置（由佩戴检测处理）
+    if (ir_dc < HR_AGC_MIN_CONTACT_DC) {
+        return 0;
+    }
+
+    uint8_t mask = 0;
+    bool changed;
+
+    int8_t red_need = adjust_led(&agc->led_red, red_dc, &changed);
+    if (changed) mask |= HR_AGC_CHANGED_RED;
+
+    int8_t ir_need = adjust_led(&agc->led_ir, ir_dc, &changed);
+    if (changed) mask |= HR_AGC_CHANGED_IR;
+
+    // LED已到极限：任一通道仍饱和则放大量程；两通道都偏暗才缩小量程（LSB变细，计数增大）
+    if ((red_need < 0 || ir_need < 0) && agc->range_idx < HR_AGC_RANGE_COUNT - 1) {
+        agc->range_idx++;
+        mask |= HR_AGC_CHANGED_RANGE;
+    } else if (red_need > 0 && ir_need > 0 && agc->range_idx > 0) {
+        agc->range_idx--;
+        mask |= HR_AGC_CHANGED_RANGE;
+    }
+
+    if (mask) {
+        agc->step_count++;
+        agc->settle = HR_AGC_SETTLE_SAMPLES;
+    }
+    return mask;
+}
@@ -0,0 +1,78 @@
+#ifndef HR_AGC_H
+#define HR_AGC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ──────────────────────────────────────────────
+// MAX30102 LED电流 / ADC量程 自动增益控制（AGC）
+// ──────────────────────────────────────────────
+// 每 HR_AGC_WINDOW 个样本统计一次红光/红外直流电平：
+//   - 超出 [DC_LOW, DC_HIGH] 滞回带才调整，调整目标为 DC_TARGET
+//   - 红光、红外LED电流各自独立调整
+//   - 某通道LED已到上/下限仍不够时，再调整两通道共用的ADC量程
+// 每次调整后等待 HR_AGC_SETTLE_SAMPLES 个样本再统计，避免用旧设置的FIFO数据判断。
+// 纯逻辑模块，不访问硬件；由驱动层把结果写入寄存器。
+
+// 直流目标带（18位计数）。上限受 hr_algorithm 的 int16 缓冲限制：
+// (x >> 2) 必须 < 32768，故 DC 不能超过约 131000
+#ifndef HR_AGC_DC_LOW
+#define HR_AGC_DC_LOW            30000
+#endif
+#ifndef HR_AGC_DC_HIGH
+#define HR_AGC_DC_HIGH           110000
+#endif
+#ifndef HR_AGC_DC_TARGET
+#define HR_AGC_DC_TARGET         70000
+#endif
+
+// 低于此IR直流认为无接触（未佩戴），不做调整，避免把LED推到最大
+#ifndef HR_AGC_MIN_CONTACT_DC
+#define HR_AGC_MIN_CONTACT_DC    5000
+#endif
+
+#define HR_AGC_WINDOW            32      // 统计窗口（样本数，≈320ms @100Hz）
+#define HR_AGC_SETTLE_SAMPLES    8       // 调整后丢弃的样本数
+#define HR_AGC_LED_MIN           0x02    // LED电流下限（约0.4mA）
+#define HR_AGC_LED_MAX           0x7F    // LED电流上限（约25mA，兼顾功耗）
+#define HR_AGC_MAX_GAIN_STEP     4       // 单次调整最大倍数
+
+// ADC量程档位（与 SparkFun setADCRange 的 2048/4096/8192/16384 nA 对应）
+#define HR_AGC_RANGE_COUNT       4
+#define HR_AGC_RANGE_DEFAULT     1       // 4096nA（与原固定配置一致）
+
+// hr_agc_process 返回的调整掩码
+#define HR_AGC_CHANGED_RED       0x01
+#define HR_AGC_CHANGED_IR        0x02
+#define HR_AGC_CHANGED_RANGE     0x04
+
+typedef struct {
+    uint8_t led_red;             // 当前红光LED电流档位
+    uint8_t led_ir;              // 当前红外LED电流档位
+    uint8_t range_idx;           // 当前ADC量程档位（0~3）
+    bool enabled;
+
+    uint32_t red_acc;            // 窗口累加
+    uint32_t ir_acc;
+    uint8_t acc_count;
+    uint8_t settle;              // 剩余需丢弃的样本
+
+    uint16_t step_count;         // 累计调整次数
+    int32_t last_red_dc;         // 最近一次窗口直流
+    int32_t last_ir_dc;
+} HrAgcState;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+void hr_agc_init(HrAgcState* agc, uint8_t led_red, uint8_t led_ir, uint8_t range_idx);
+
+// 输入一个样本，返回本次调整掩码（0=无调整）
+uint8_t hr_agc_process(HrAgcState* agc, int32_t red, int32_t ir);
+
+// 量程档位 → nA（2048 << idx）
+static inline uint16_t hr_agc_range_na(uint8_t range_idx) {
+    return (uint16_t)(2048U << range_idx);
+}
+
+#endif // HR_AGC_H
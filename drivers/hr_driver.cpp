@@ -1,6 +1,6 @@
 #include "hr_driver.h"
 #include <Wire.h>
-#include <SparkFun_MAX3010x.h>  // SparkFun MAX3010x库
+#include <MAX30105.h>  // SparkFun MAX3010x 库的主头文件（MAX30105）
 
 // ──────────────────────────────────────────────
 // 使用SparkFun_MAX3010x库的MAX30102驱动
@@ -8,6 +8,26 @@
 static MAX30105 max30102;  // 使用MAX30105类，兼容MAX30102
 static bool sensor_initialized = false;
 
+// 自动增益控制
+static HrAgcState agc;
+static HrAgcStepCallback agc_callback = NULL;
+static const uint8_t agc_range_reg[HR_AGC_RANGE_COUNT] = {
+    MAX30105_ADCRANGE_2048, MAX30105_ADCRANGE_4096,
+    MAX30105_ADCRANGE_8192, MAX30105_ADCRANGE_16384
+};
+
+// 将AGC结果写入寄存器，并通知算法重置基线
+static void apply_agc(int32_t red, int32_t ir) {
+    uint8_t changed = hr_agc_process(&agc, red, ir);
+    if (changed == 0) return;
+
+    if (changed & HR_AGC_CHANGED_RED) max30102.setPulseAmplitudeRed(agc.led_red);
+    if (changed & HR_AGC_CHANGED_IR) max30102.setPulseAmplitudeIR(agc.led_ir);
+    if (changed & HR_AGC_CHANGED_RANGE) max30102.setADCRange(agc_range_reg[agc.range_idx]);
+
+    if (agc_callback) agc_callback();
+}
+
 bool hr_driver_init() {
     Wire.begin();
     
@@ -17,8 +37,8 @@ bool hr_driver_init() {
         return false;
     }
     
-    // 配置传感器参数
-    max30102.setup();  // 使用默认配置
+    // 配置传感器参数（默认配置的FIFO平均为4次，按 HR_SAMPLE_AVERAGE 覆盖）
+    max30102.setup(0x1F, HR_SAMPLE_AVERAGE);
     
     // 设置采样率100Hz
     max30102.setSampleRate(HR_SAMPLE_RATE);
@@ -26,16 +46,25 @@ bool hr_driver_init() {
     // 设置脉宽411us（推荐值）
     max30102.setPulseWidth(HR_PULSE_WIDTH);
     
-    // 设置LED电流（0x0A = 约10mA）
-    max30102.setPulseAmplitudeRed(HR_LED_CURRENT);  // 红光LED电流
-    max30102.setPulseAmplitudeIR(HR_LED_CURRENT);   // 红外LED电流
+    // 设置LED电流初值（0x0A = 约10mA），之后由AGC闭环调整
+    hr_agc_init(&agc, HR_LED_CURRENT, HR_LED_CURRENT, HR_AGC_RANGE_DEFAULT);
+    max30102.setPulseAmplitudeRed(agc.led_red);     // 红光LED电流
+    max30102.setPulseAmplitudeIR(agc.led_ir);       // 红外LED电流
+    max30102.setADCRange(agc_range_reg[agc.range_idx]);
     
-    // 启用SpO2模式
-    max30102.setMode(MAX30105_MODE_SPO2);
+    // 启用SpO2模式（红光+红外）
+    max30102.setLEDMode(2);
     
     // 清除FIFO
     max30102.clearFIFO();
     
+    // 芯片温度转换完成中断（结果由 hr_temperature_service 异步取回）
+    max30102.enableDIETEMPRDY();
+#ifdef HR_TEMP_INT_PIN
+    pinMode(HR_TEMP_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(HR_TEMP_INT_PIN), hr_temperature_isr, FALLING);
+#endif
+    
     sensor_initialized = true;
     Serial.println("[HR] MAX30102初始化成功（使用SparkFun库）");
     return true;
@@ -43,27 +72,83 @@ bool hr_driver_init() {
 
 bool hr_available() {
     if (!sensor_initialized) return false;
+    // 库缓冲为空时从FIFO批量读入（check() 读出FIFO中全部新样本）
+    if (!max30102.available()) {
+        max30102.check();
+    }
     return max30102.available();  // 检查是否有新数据
 }
 
 bool hr_read_latest(int32_t* red, int32_t* ir) {
     if (!sensor_initialized) return false;
     
+    // FIFO读取时顺带取回已完成的温度转换
+    hr_temperature_service();
+    
     // 确保有数据可读
-    if (!max30102.available()) {
+    if (!hr_available()) {
         return false;
     }
     
-    // 读取最新数据
-    *red = (int32_t)max30102.getRed();
-    *ir = (int32_t)max30102.getIR();
+    // 按先后取库缓冲中最旧的样本（getRed/getIR 会阻塞等待新样本并返回最新值）
+    *red = (int32_t)max30102.getFIFORed();
+    *ir = (int32_t)max30102.getFIFOIR();
     
     // 准备读取下一个样本
     max30102.nextSample();
     
+    apply_agc(*red, *ir);
+    return true;
+}
+
+// ──────────────────────────────────────────────
+// FIFO突发读取
+
+#define MAX30102_REG_FIFO_WR_PTR     0x04    // 0x04~0x06 连续：WR_PTR / OVF_COUNTER / RD_PTR
+#define MAX30102_REG_FIFO_DATA       0x07
+#define HR_FIFO_BYTES_PER_SAMPLE     6       // SpO2模式：红光3字节 + 红外3字节（大端，18位）
+#define HR_FIFO_CHUNK_SAMPLES        5       // 每次I2C读取30字节，不超过 Wire 缓冲（AVR 32字节）
+
+static bool fifo_read_regs(uint8_t reg, uint8_t* buf, uint8_t len) {
+    Wire.beginTransmission(MAX30102_I2C_ADDR);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) return false;
+    if (Wire.requestFrom((uint8_t)MAX30102_I2C_ADDR, len) != len) return false;
+    for (uint8_t i = 0; i < len; i++) buf[i] = Wire.read();
     return true;
 }
 
+static inline int32_t fifo_word(const uint8_t* p) {
+    return (int32_t)((((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]) & 0x3FFFF);
+}
+
+uint16_t hr_read_fifo(int32_t* red, int32_t* ir, uint16_t max) {
+    if (!sensor_initialized) return 0;
+    
+    hr_temperature_service();
+    
+    // 写指针 == 读指针时：溢出计数非0表示FIFO已满，否则为空
+    uint8_t ptr[3];
+    if (!fifo_read_regs(MAX30102_REG_FIFO_WR_PTR, ptr, 3)) return 0;
+    uint16_t pending = (ptr[0] - ptr[2]) & (HR_FIFO_DEPTH - 1);
+    if (pending == 0 && ptr[1] != 0) pending = HR_FIFO_DEPTH;
+    if (pending > max) pending = max;
+    
+    // FIFO_DATA 地址不自增，每读完一个完整样本 RD_PTR 前进一格；分块边界对齐样本
+    uint8_t buf[HR_FIFO_CHUNK_SAMPLES * HR_FIFO_BYTES_PER_SAMPLE];
+    uint16_t n = 0;
+    while (n < pending) {
+        uint8_t chunk = (pending - n < HR_FIFO_CHUNK_SAMPLES) ? (uint8_t)(pending - n) : HR_FIFO_CHUNK_SAMPLES;
+        if (!fifo_read_regs(MAX30102_REG_FIFO_DATA, buf, chunk * HR_FIFO_BYTES_PER_SAMPLE)) break;
+        for (uint8_t i = 0; i < chunk; i++, n++) {
+            red[n] = fifo_word(&buf[i * HR_FIFO_BYTES_PER_SAMPLE]);
+            ir[n] = fifo_word(&buf[i * HR_FIFO_BYTES_PER_SAMPLE + 3]);
+            apply_agc(red[n], ir[n]);
+        }
+    }
+    return n;
+}
+
 void hr_shutdown() {
     if (sensor_initialized) {
         max30102.shutDown();
@@ -76,7 +161,128 @@ void hr_wakeup() {
     }
 }
 
+
+// ──────────────────────────────────────────────
+// 芯片温度（异步）
+
+#define MAX30102_REG_INT_STATUS2     0x01
+#define MAX30102_REG_TEMP_INT        0x1F
+#define MAX30102_REG_TEMP_FRAC       0x20
+#define MAX30102_REG_TEMP_CONFIG     0x21
+#define MAX30102_INT_DIE_TEMP_RDY    0x02
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+static HrDieTemperature die_temp = {NAN, 0, false};
+static bool temp_pending = false;
+static uint32_t temp_request_ms = 0;
+static volatile bool temp_irq = false;
+
+void IRAM_ATTR hr_temperature_isr() {
+    temp_irq = true;
+}
+
+bool hr_temperature_request() {
+    if (!sensor_initialized || temp_pending) return false;
+    max30102.writeRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_CONFIG, 0x01);  // TEMP_EN，转换完成后自动清零
+    temp_request_ms = millis();
+    temp_irq = false;
+    temp_pending = true;
+    return true;
+}
+
+void hr_temperature_service() {
+    if (!sensor_initialized) return;
+    uint32_t now = millis();
+
+    if (!temp_pending) {
+#if HR_TEMP_REFRESH_MS > 0
+        if (!die_temp.valid || (now - die_temp.timestamp_ms) >= HR_TEMP_REFRESH_MS) {
+            hr_temperature_request();
+        }
+#endif
+        return;
+    }
+
+    // 未收到中断且未到转换时间：不访问I2C
+    uint32_t elapsed = now - temp_request_ms;
+    if (!temp_irq && elapsed < HR_TEMP_CONVERSION_MS) return;
+    temp_irq = false;
+
+    // 读状态寄存器2同时清除 DIE_TEMP_RDY
+    uint8_t status = max30102.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_INT_STATUS2);
+    if (!(status & MAX30102_INT_DIE_TEMP_RDY)) {
+        if (elapsed >= HR_TEMP_TIMEOUT_MS) temp_pending = false;
+        return;
+    }
+
+    int8_t t_int = (int8_t)max30102.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_INT);
+    uint8_t t_frac = max30102.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_FRAC) & 0x0F;
+    die_temp.celsius = (float)t_int + (float)t_frac * 0.0625f;
+    die_temp.timestamp_ms = now;
+    die_temp.valid = true;
+    temp_pending = false;
+}
+
+bool hr_get_die_temperature(HrDieTemperature* out) {
+    if (out) *out = die_temp;
+    return die_temp.valid;
+}
+
 float hr_read_temperature() {
     if (!sensor_initialized) return NAN;
-    return max30102.readTemperature();
+    hr_temperature_service();
+    return die_temp.valid ? die_temp.celsius : NAN;
+}
+// ──────────────────────────────────────────────
+// 自动增益控制
+
+void hr_agc_enable(bool enable) {
+    agc.enabled = enable;
+}
+
+void hr_set_agc_callback(HrAgcStepCallback cb) {
+    agc_callback = cb;
+}
+
+void hr_get_agc_state(HrAgcState* out) {
+    if (out) *out = agc;
+}
+
+// ──────────────────────────────────────────────
+// 接近模式（佩戴检测）
+
+#define HR_INT_PROX_INT          0x10    // 中断状态1：PROX_INT
+
+void hr_enter_proximity_mode() {
+    if (!sensor_initialized) return;
+    agc.enabled = false;                             // 无接触时不做增益调整
+    max30102.setPulseAmplitudeRed(0);
+    max30102.setPulseAmplitudeIR(HR_PROX_PILOT_PA);
+    max30102.setPulseAmplitudeProximity(HR_PROX_PILOT_PA);
+    max30102.setProximityThreshold(HR_PROX_THRESHOLD);
+    max30102.enablePROXINT();
+    max30102.getINT1();                                 // 清除挂起的中断
+    max30102.setLEDMode(2);                             // 重写模式寄存器，从接近模式开始运行
+}
+
+void hr_exit_proximity_mode() {
+    if (!sensor_initialized) return;
+    max30102.disablePROXINT();
+    max30102.setPulseAmplitudeRed(agc.led_red);
+    max30102.setPulseAmplitudeIR(agc.led_ir);
+    max30102.setADCRange(agc_range_reg[agc.range_idx]);
+    max30102.clearFIFO();
+    agc.red_acc = 0;
+    agc.ir_acc = 0;
+    agc.acc_count = 0;
+    agc.settle = HR_AGC_SETTLE_SAMPLES;
+    agc.enabled = true;
+}
+
+bool hr_proximity_triggered() {
+    if (!sensor_initialized) return false;
+    return (max30102.getINT1() & HR_INT_PROX_INT) != 0;  // 读状态寄存器即清除
 }
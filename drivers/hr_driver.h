@@ -2,26 +2,72 @@
 #define HR_DRIVER_H
 
 #include <Arduino.h>
+#include "hr_agc.h"
 
 // ──────────────────────────────────────────────
 // 配置参数
 #define HR_SAMPLE_RATE          100     // 采样率 Hz (50/100/200/400/800/1600)
+#ifndef HR_SAMPLE_AVERAGE
+#define HR_SAMPLE_AVERAGE       1       // FIFO 每个样本平均的采样次数 (1/2/4/8/16/32)
+#endif
+// FIFO 输出周期 = 平均次数 / 采样率（如 100Hz 平均4次 → 40ms，25Hz）；时间基准以此为标称周期
+#define HR_FIFO_PERIOD_US       (1000000UL * HR_SAMPLE_AVERAGE / HR_SAMPLE_RATE)
 #define HR_PULSE_WIDTH          411     // 脉宽 us (69/118/215/411)
 #define HR_LED_CURRENT          0x0A    // LED 电流档位 0x00~0xFF (约 0~51mA)
 #define MAX30102_I2C_ADDR       0x57    // MAX30102 I2C地址
 #define HR_I2C_RETRY_TIMES      3       // I2C重试次数
+#define HR_FIFO_DEPTH           32      // FIFO 深度（样本）
 
 // ──────────────────────────────────────────────
 // 函数声明
 bool hr_driver_init();                  // 使用SparkFun库初始化MAX30102
-bool hr_read_latest(int32_t* red, int32_t* ir);   // 读取最新一个有效样本
+bool hr_read_latest(int32_t* red, int32_t* ir);   // 按先后读取一个样本（库缓冲为空时先读入FIFO）
+// 读出FIFO中当前全部样本（按先后，最多 max 个），返回个数：
+// 由 FIFO_WR_PTR/OVF_COUNTER/FIFO_RD_PTR 得样本数，再从 FIFO_DATA 突发读取恰好这么多
+// （返回值即读取时刻的FIFO深度，供时间基准反推时间戳）。与 hr_available/hr_read_latest 不要混用
+uint16_t hr_read_fifo(int32_t* red, int32_t* ir, uint16_t max);
 bool hr_available();                    // 是否有新数据可读
 void hr_shutdown();                     // 进入低功耗关断模式
 void hr_wakeup();                       // 从关断唤醒
 
-// 可选：获取芯片温度（用于校准或调试）
+// 芯片温度（异步，不阻塞采集）：
+// hr_temperature_request() 只写触发寄存器；转换完成后（约29ms）在下一次FIFO读取
+// 或 DIE_TEMP_RDY 中断后取回并缓存。缓存超过 HR_TEMP_REFRESH_MS 时FIFO读取会自动触发新转换
+#define HR_TEMP_CONVERSION_MS   30      // 典型转换时间29ms
+#define HR_TEMP_TIMEOUT_MS      200     // 超时放弃本次转换
+#ifndef HR_TEMP_REFRESH_MS
+#define HR_TEMP_REFRESH_MS      10000   // 自动刷新周期（0=仅手动触发）
+#endif
+
+typedef struct {
+    float celsius;                      // 芯片温度（0.0625℃分辨率）
+    uint32_t timestamp_ms;              // 取回时间
+    bool valid;
+} HrDieTemperature;
+
+bool hr_temperature_request();                      // 触发转换，false=未初始化或转换进行中
+void hr_temperature_service();                      // 取回已完成的转换（FIFO读取时自动调用）
+bool hr_get_die_temperature(HrDieTemperature* out); // 读取缓存，false=尚无有效值
+void hr_temperature_isr();                          // DIE_TEMP_RDY中断入口（定义 HR_TEMP_INT_PIN 时自动挂接）
+
+// 兼容接口：返回缓存温度（无则NAN）并在缓存过期时触发转换，不再阻塞
 float hr_read_temperature();
 
+// 自动增益控制（AGC）：闭环调整红光/红外LED电流与ADC量程，使直流电平保持在目标带内
+// 每次调整后调用回调，通知算法重置基线（见 hr_algorithm_reset_baseline）
+typedef void (*HrAgcStepCallback)(void);
+void hr_agc_enable(bool enable);                    // 默认开启
+void hr_set_agc_callback(HrAgcStepCallback cb);
+void hr_get_agc_state(HrAgcState* out);             // 当前LED档位/量程/调整次数
+
+// 接近模式（佩戴检测）：红光关闭，IR以 HR_PROX_PILOT_PA 低电流脉冲，FIFO不写入；
+// IR计数高8位超过 HR_PROX_THRESHOLD 时芯片自动回到SpO2模式并置位 PROX_INT
+#define HR_PROX_PILOT_PA        0x0A    // 接近模式IR电流（约2mA）
+#define HR_PROX_THRESHOLD       0x08    // 阈值（IR计数高8位，≈8192计数）
+void hr_enter_proximity_mode();
+void hr_exit_proximity_mode();                      // 恢复AGC当前的LED/量程设置并清空FIFO
+bool hr_proximity_triggered();                      // 读取并清除 PROX_INT
+
 // 兼容性别名：一些源码使用 `hr_init()` 作为初始化入口，提供内联别名以保持兼容
 static inline bool hr_init() {
 	return hr_driver_init();
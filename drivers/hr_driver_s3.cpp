@@ -14,6 +14,25 @@ static int32_t last_red = 0;
 static int32_t last_ir = 0;
 static bool sensor_initialized = false;
 
+// 自动增益控制（替代固定的 ledBrightness=60 / adcRange=4096）
+static HrAgcState agc;
+static HrAgcStepCallback agc_callback = NULL;
+static const uint8_t agc_range_reg[HR_AGC_RANGE_COUNT] = {
+    MAX30105_ADCRANGE_2048, MAX30105_ADCRANGE_4096,
+    MAX30105_ADCRANGE_8192, MAX30105_ADCRANGE_16384
+};
+
+static void apply_agc(int32_t red, int32_t ir) {
+    uint8_t changed = hr_agc_process(&agc, red, ir);
+    if (changed == 0) return;
+
+    if (changed & HR_AGC_CHANGED_RED) particleSensor.setPulseAmplitudeRed(agc.led_red);
+    if (changed & HR_AGC_CHANGED_IR) particleSensor.setPulseAmplitudeIR(agc.led_ir);
+    if (changed & HR_AGC_CHANGED_RANGE) particleSensor.setADCRange(agc_range_reg[agc.range_idx]);
+
+    if (agc_callback) agc_callback();
+}
+
 // I2C写函数
 static bool i2c_write(uint8_t reg, uint8_t val) {
     for (uint8_t retry = 0; retry < HR_I2C_RETRY_TIMES; retry++) {
@@ -63,18 +82,23 @@ bool hr_init() {
         return false;
     }
     
-    // 配置传感器参数
+    // 配置传感器参数（LED电流与ADC量程为初值，之后由AGC调整）
     byte ledBrightness = 60;  // 0-255
-    byte sampleAverage = 4;   // 1, 2, 4, 8, 16, 32
+    byte sampleAverage = HR_SAMPLE_AVERAGE;   // 1, 2, 4, 8, 16, 32（FIFO输出率 = 采样率 / 平均次数）
     byte ledMode = 2;         // 2 = Red + IR
-    int sampleRate = 100;     // 100Hz
+    int sampleRate = HR_SAMPLE_RATE;          // 100Hz
     int pulseWidth = 411;     // 411us
     int adcRange = 4096;      // 4096nA
     
     particleSensor.setup(ledBrightness, sampleAverage, ledMode, sampleRate, pulseWidth, adcRange);
+    hr_agc_init(&agc, ledBrightness, ledBrightness, HR_AGC_RANGE_DEFAULT);
     
-    // 启用温度传感器（可选）
+    // 芯片温度转换完成中断（结果由 hr_temperature_service 异步取回）
     particleSensor.enableDIETEMPRDY();
+#ifdef HR_TEMP_INT_PIN
+    pinMode(HR_TEMP_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(HR_TEMP_INT_PIN), hr_temperature_isr, FALLING);
+#endif
     
     sensor_initialized = true;
     Serial.println("[HR Driver] MAX30102初始化成功");
@@ -83,27 +107,89 @@ bool hr_init() {
 
 bool hr_available() {
     if (!sensor_initialized) return false;
+    // 库缓冲为空时从FIFO批量读入（check() 读出FIFO中全部新样本）
+    if (!particleSensor.available()) {
+        particleSensor.check();
+    }
     return particleSensor.available();
 }
 
 bool hr_read_sample(int32_t* red, int32_t* ir) {
     if (!sensor_initialized) return false;
     
-    if (particleSensor.available()) {
-        *red = particleSensor.getRed();
-        *ir = particleSensor.getIR();
+    // FIFO读取时顺带取回已完成的温度转换
+    hr_temperature_service();
+    
+    if (hr_available()) {
+        // 按先后取库缓冲中最旧的样本（getRed/getIR 会阻塞等待新样本并返回最新值）
+        *red = particleSensor.getFIFORed();
+        *ir = particleSensor.getFIFOIR();
         particleSensor.nextSample();
         
         // 存储最新数据
         last_red = *red;
         last_ir = *ir;
         
+        apply_agc(*red, *ir);
         return true;
     }
     
     return false;
 }
 
+// ──────────────────────────────────────────────
+// FIFO突发读取
+
+#define MAX30102_REG_FIFO_WR_PTR     0x04    // 0x04~0x06 连续：WR_PTR / OVF_COUNTER / RD_PTR
+#define MAX30102_REG_FIFO_DATA       0x07
+#define HR_FIFO_BYTES_PER_SAMPLE     6       // SpO2模式：红光3字节 + 红外3字节（大端，18位）
+#define HR_FIFO_CHUNK_SAMPLES        5       // 每次I2C读取30字节，不超过 Wire 缓冲（AVR 32字节）
+
+// FIFO_DATA 不重试：部分读出的样本已出队，重读会错位
+static bool fifo_read_data(uint8_t* buf, uint8_t len) {
+    Wire.beginTransmission(MAX30102_I2C_ADDR);
+    Wire.write(MAX30102_REG_FIFO_DATA);
+    if (Wire.endTransmission(false) != 0) return false;
+    if (Wire.requestFrom((uint8_t)MAX30102_I2C_ADDR, len) != len) return false;
+    for (uint8_t i = 0; i < len; i++) buf[i] = Wire.read();
+    return true;
+}
+
+static inline int32_t fifo_word(const uint8_t* p) {
+    return (int32_t)((((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]) & 0x3FFFF);
+}
+
+uint16_t hr_read_fifo(int32_t* red, int32_t* ir, uint16_t max) {
+    if (!sensor_initialized) return 0;
+    
+    hr_temperature_service();
+    
+    // 写指针 == 读指针时：溢出计数非0表示FIFO已满，否则为空
+    uint8_t ptr[3];
+    if (!i2c_read(MAX30102_REG_FIFO_WR_PTR, ptr, 3)) return 0;
+    uint16_t pending = (ptr[0] - ptr[2]) & (HR_FIFO_DEPTH - 1);
+    if (pending == 0 && ptr[1] != 0) pending = HR_FIFO_DEPTH;
+    if (pending > max) pending = max;
+    
+    // FIFO_DATA 地址不自增，每读完一个完整样本 RD_PTR 前进一格；分块边界对齐样本
+    uint8_t buf[HR_FIFO_CHUNK_SAMPLES * HR_FIFO_BYTES_PER_SAMPLE];
+    uint16_t n = 0;
+    while (n < pending) {
+        uint8_t chunk = (pending - n < HR_FIFO_CHUNK_SAMPLES) ? (uint8_t)(pending - n) : HR_FIFO_CHUNK_SAMPLES;
+        if (!fifo_read_data(buf, chunk * HR_FIFO_BYTES_PER_SAMPLE)) break;
+        for (uint8_t i = 0; i < chunk; i++, n++) {
+            red[n] = fifo_word(&buf[i * HR_FIFO_BYTES_PER_SAMPLE]);
+            ir[n] = fifo_word(&buf[i * HR_FIFO_BYTES_PER_SAMPLE + 3]);
+            apply_agc(red[n], ir[n]);
+        }
+    }
+    if (n > 0) {
+        last_red = red[n - 1];
+        last_ir = ir[n - 1];
+    }
+    return n;
+}
+
 bool hr_read_latest(int32_t* red, int32_t* ir) {
     if (!sensor_initialized) return false;
     
@@ -141,9 +227,128 @@ void hr_wakeup() {
     }
 }
 
+
+// ──────────────────────────────────────────────
+// 芯片温度（异步）
+
+#define MAX30102_REG_INT_STATUS2     0x01
+#define MAX30102_REG_TEMP_INT        0x1F
+#define MAX30102_REG_TEMP_FRAC       0x20
+#define MAX30102_REG_TEMP_CONFIG     0x21
+#define MAX30102_INT_DIE_TEMP_RDY    0x02
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+static HrDieTemperature die_temp = {NAN, 0, false};
+static bool temp_pending = false;
+static uint32_t temp_request_ms = 0;
+static volatile bool temp_irq = false;
+
+void IRAM_ATTR hr_temperature_isr() {
+    temp_irq = true;
+}
+
+bool hr_temperature_request() {
+    if (!sensor_initialized || temp_pending) return false;
+    particleSensor.writeRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_CONFIG, 0x01);  // TEMP_EN，转换完成后自动清零
+    temp_request_ms = millis();
+    temp_irq = false;
+    temp_pending = true;
+    return true;
+}
+
+void hr_temperature_service() {
+    if (!sensor_initialized) return;
+    uint32_t now = millis();
+
+    if (!temp_pending) {
+#if HR_TEMP_REFRESH_MS > 0
+        if (!die_temp.valid || (now - die_temp.timestamp_ms) >= HR_TEMP_REFRESH_MS) {
+            hr_temperature_request();
+        }
+#endif
+        return;
+    }
+
+    // 未收到中断且未到转换时间：不访问I2C
+    uint32_t elapsed = now - temp_request_ms;
+    if (!temp_irq && elapsed < HR_TEMP_CONVERSION_MS) return;
+    temp_irq = false;
+
+    // 读状态寄存器2同时清除 DIE_TEMP_RDY
+    uint8_t status = particleSensor.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_INT_STATUS2);
+    if (!(status & MAX30102_INT_DIE_TEMP_RDY)) {
+        if (elapsed >= HR_TEMP_TIMEOUT_MS) temp_pending = false;
+        return;
+    }
+
+    int8_t t_int = (int8_t)particleSensor.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_INT);
+    uint8_t t_frac = particleSensor.readRegister8(MAX30102_I2C_ADDR, MAX30102_REG_TEMP_FRAC) & 0x0F;
+    die_temp.celsius = (float)t_int + (float)t_frac * 0.0625f;
+    die_temp.timestamp_ms = now;
+    die_temp.valid = true;
+    temp_pending = false;
+}
+
+bool hr_get_die_temperature(HrDieTemperature* out) {
+    if (out) *out = die_temp;
+    return die_temp.valid;
+}
+
 float hr_read_temperature() {
     if (!sensor_initialized) return NAN;
-    
-    // 使用SparkFun库读取温度
-    return particleSensor.readTemperature();
-}
\ No newline at end of file
+    hr_temperature_service();
+    return die_temp.valid ? die_temp.celsius : NAN;
+}
+// ──────────────────────────────────────────────
+// 自动增益控制
+
+void hr_agc_enable(bool enable) {
+    agc.enabled = enable;
+}
+
+void hr_set_agc_callback(HrAgcStepCallback cb) {
+    agc_callback = cb;
+}
+
+void hr_get_agc_state(HrAgcState* out) {
+    if (out) *out = agc;
+}
+
+// ──────────────────────────────────────────────
+// 接近模式（佩戴检测）
+
+#define HR_INT_PROX_INT          0x10    // 中断状态1：PROX_INT
+
+void hr_enter_proximity_mode() {
+    if (!sensor_initialized) return;
+    agc.enabled = false;                             // 无接触时不做增益调整
+    particleSensor.setPulseAmplitudeRed(0);
+    particleSensor.setPulseAmplitudeIR(HR_PROX_PILOT_PA);
+    particleSensor.setPulseAmplitudeProximity(HR_PROX_PILOT_PA);
+    particleSensor.setProximityThreshold(HR_PROX_THRESHOLD);
+    particleSensor.enablePROXINT();
+    particleSensor.getINT1();                                 // 清除挂起的中断
+    particleSensor.setLEDMode(2);                             // 重写模式寄存器，从接近模式开始运行
+}
+
+void hr_exit_proximity_mode() {
+    if (!sensor_initialized) return;
+    particleSensor.disablePROXINT();
+    particleSensor.setPulseAmplitudeRed(agc.led_red);
+    particleSensor.setPulseAmplitudeIR(agc.led_ir);
+    particleSensor.setADCRange(agc_range_reg[agc.range_idx]);
+    particleSensor.clearFIFO();
+    agc.red_acc = 0;
+    agc.ir_acc = 0;
+    agc.acc_count = 0;
+    agc.settle = HR_AGC_SETTLE_SAMPLES;
+    agc.enabled = true;
+}
+
+bool hr_proximity_triggered() {
+    if (!sensor_initialized) return false;
+    return (particleSensor.getINT1() & HR_INT_PROX_INT) != 0;  // 读状态寄存器即清除
+}
@@ -0,0 +1,118 @@
+#include "sensor_source.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "hr_driver.h"
+#endif
+
+// ──────────────────────────────────────────────
+// 硬件数据源
+// ──────────────────────────────────────────────
+
+#ifdef ARDUINO
+
+static bool hw_ppg_available() {
+    return hr_available();
+}
+
+static bool hw_ppg_read(int32_t* red, int32_t* ir) {
+    return hr_read_latest(red, ir);
+}
+
+static bool hw_gas_read_raw(uint16_t* raw) {
+    *raw = analogRead(SENSOR_SOURCE_SNO2_ADC_PIN) & 0xFFF;
+    return true;
+}
+
+static bool hw_env_read(EnvData* out) {
+    return env_read(out);
+}
+
+static bool hw_battery_read_raw(uint16_t* raw) {
+    *raw = analogRead(SENSOR_SOURCE_BAT_ADC_PIN) & 0xFFF;
+    return true;
+}
+
+static const SensorSource g_hardware_source = {
+    SENSOR_SOURCE_HARDWARE,
+    "hardware",
+    hw_ppg_available,
+    hw_ppg_read,
+    hw_gas_read_raw,
+    hw_env_read,
+    hw_battery_read_raw,
+    hr_read_fifo
+};
+
+const SensorSource* hardware_source_get() {
+    return &g_hardware_source;
+}
+
+#endif // ARDUINO
+
+// ──────────────────────────────────────────────
+// 当前数据源
+// ──────────────────────────────────────────────
+
+static const SensorSource* g_source = NULL;
+
+static const SensorSource* current_source() {
+    if (g_source == NULL) {
+#ifdef ARDUINO
+        g_source = hardware_source_get();
+#else
+        g_source = synthetic_source_create(NULL);
+#endif
+    }
+    return g_source;
+}
+
+void sensor_source_select(const SensorSource* source) {
+    g_source = source;
+}
+
+const SensorSource* sensor_source_get() {
+    return current_source();
+}
+
+bool sensor_source_ppg_available() {
+    const SensorSource* s = current_source();
+    return (s->ppg_available != NULL) && s->ppg_available();
+}
+
+bool sensor_source_ppg_read(int32_t* red, int32_t* ir) {
+    const SensorSource* s = current_source();
+    if (s->ppg_read == NULL || red == NULL || ir == NULL) return false;
+    return s->ppg_read(red, ir);
+}
+
+uint16_t sensor_source_ppg_read_fifo(int32_t* red, int32_t* ir, uint16_t max) {
+    const SensorSource* s = current_source();
+    if (red == NULL || ir == NULL) return 0;
+    if (s->ppg_read_fifo != NULL) return s->ppg_read_fifo(red, ir, max);
+    
+    uint16_t n = 0;
+    while (n < max && sensor_source_ppg_available()) {
+        if (!sensor_source_ppg_read(&red[n], &ir[n])) break;
+        n++;
+    }
+    return n;
+}
+
+bool sensor_source_gas_read_raw(uint16_t* raw) {
+    const SensorSource* s = current_source();
+    if (s->gas_read_raw == NULL || raw == NULL) return false;
+    return s->gas_read_raw(raw);
+}
+
+bool sensor_source_env_read(EnvData* out) {
+    const SensorSource* s = current_source();
+    if (s->env_read == NULL || out == NULL) return false;
+    return s->env_read(out);
+}
+
+bool sensor_source_battery_read_raw(uint16_t* raw) {
+    const SensorSource* s = current_source();
+    if (s->battery_read_raw == NULL || raw == NULL) return false;
+    return s->battery_read_raw(raw);
+}
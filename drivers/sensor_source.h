@@ -0,0 +1,134 @@
+#ifndef SENSOR_SOURCE_H
+#define SENSOR_SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "env_driver.h"
+
+// ──────────────────────────────────────────────
+// 传感器数据源抽象层
+// ──────────────────────────────────────────────
+// 采集/算法层只通过此接口取数，不直接调用 hr_read_latest()/analogRead()。
+// 三类实现：
+//   1. 硬件：MAX30102 + ADC（仅 Arduino 构建）
+//   2. 回放：内存映射的录制文件（Flash分区 或 Linux mmap）
+//   3. 合成：确定性生成器（HR/SpO2/灌注/噪声/基线漂移/运动突发）
+// 后两者可在 Linux 主机上全速运行 采集→算法→BLE 链路，用于基准测试与回归测试。
+
+typedef enum {
+    SENSOR_SOURCE_HARDWARE = 0,
+    SENSOR_SOURCE_REPLAY,
+    SENSOR_SOURCE_SYNTHETIC
+} SensorSourceKind;
+
+// 数据源接口（函数指针表，任一项可为NULL表示不支持）
+typedef struct {
+    SensorSourceKind kind;
+    const char* name;
+    bool (*ppg_available)();                        // 是否有新PPG样本
+    bool (*ppg_read)(int32_t* red, int32_t* ir);    // 读取一个PPG样本（18位右对齐）
+    bool (*gas_read_raw)(uint16_t* raw);            // SnO₂/AD623 输出ADC原始值（12位）
+    bool (*env_read)(EnvData* out);                 // 温湿度
+    bool (*battery_read_raw)(uint16_t* raw);        // 电池ADC原始值（12位）
+    uint16_t (*ppg_read_fifo)(int32_t* red, int32_t* ir, uint16_t max);  // 一次读出当前全部PPG样本（按先后），NULL=逐个 ppg_read
+} SensorSource;
+
+// ──────────────────────────────────────────────
+// 数据源选择（默认：Arduino构建为硬件，主机构建为合成）
+void sensor_source_select(const SensorSource* source);
+const SensorSource* sensor_source_get();
+
+// 便捷调用（转发到当前数据源，不支持的通道返回false）
+bool sensor_source_ppg_available();
+bool sensor_source_ppg_read(int32_t* red, int32_t* ir);
+uint16_t sensor_source_ppg_read_fifo(int32_t* red, int32_t* ir, uint16_t max);  // 返回个数（即读取时刻的积压深度）
+bool sensor_source_gas_read_raw(uint16_t* raw);
+bool sensor_source_env_read(EnvData* out);
+bool sensor_source_battery_read_raw(uint16_t* raw);
+
+// ──────────────────────────────────────────────
+// 硬件数据源（MAX30102 + ADC）
+#ifdef ARDUINO
+#ifndef SENSOR_SOURCE_SNO2_ADC_PIN
+#define SENSOR_SOURCE_SNO2_ADC_PIN   1       // GPIO1 ADC1_CH0（与 sensor_collector_final 一致）
+#endif
+#ifndef SENSOR_SOURCE_BAT_ADC_PIN
+#define SENSOR_SOURCE_BAT_ADC_PIN    2       // GPIO2 ADC1_CH1
+#endif
+
+const SensorSource* hardware_source_get();
+#endif
+
+// ──────────────────────────────────────────────
+// 回放数据源（录制文件格式，小端）
+// 文件头16字节 + 定长16字节记录；记录按时间排序，各通道独立游标顺序读取
+
+#define REPLAY_MAGIC                 0x31524742UL  // "BGR1"
+#define REPLAY_VERSION               1
+
+typedef enum {
+    REPLAY_RECORD_PPG = 0,           // b=red, c=ir
+    REPLAY_RECORD_GAS = 1,           // a=ADC原始值
+    REPLAY_RECORD_ENV = 2,           // b=温度×100（℃），c=湿度×100（%）
+    REPLAY_RECORD_BATTERY = 3        // a=ADC原始值
+} ReplayRecordType;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sample_rate_hz;         // PPG采样率
+    uint32_t record_count;
+    uint32_t reserved;
+} ReplayHeader;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_ms;
+    uint8_t type;                    // ReplayRecordType
+    uint8_t reserved;
+    uint16_t a;
+    int32_t b;
+    int32_t c;
+} ReplayRecord;
+
+// 打开已映射的内存区域（不拷贝数据），loop=true时读到末尾后从头循环
+const SensorSource* replay_source_open(const uint8_t* base, size_t len, bool loop);
+#if defined(ESP32)
+const SensorSource* replay_source_open_partition(const char* label, bool loop);  // esp_partition_mmap
+#endif
+#ifndef ARDUINO
+const SensorSource* replay_source_open_file(const char* path, bool loop);        // mmap(2)
+#endif
+void replay_source_close();
+void replay_source_rewind();
+uint16_t replay_source_get_sample_rate();
+
+// ──────────────────────────────────────────────
+// 合成数据源（确定性：相同配置与种子产生相同的样本序列）
+
+typedef struct {
+    uint32_t seed;                   // 伪随机种子
+    uint16_t sample_rate_hz;         // PPG采样率
+    float hr_bpm;                    // 心率
+    float spo2_pct;                  // 血氧（按 SpO2 = 110 - 25R 反推红光交流幅度）
+    float perfusion_pct;             // 灌注指数（IR AC/DC，%）
+    int32_t ir_dc;                   // IR直流电平（18位计数）
+    int32_t red_dc;                  // 红光直流电平
+    float noise_rms;                 // 白噪声均方根（计数）
+    float wander_amp;                // 基线漂移幅度（计数）
+    float wander_hz;                 // 基线漂移频率（呼吸，Hz）
+    uint32_t motion_period_ms;       // 运动突发周期（0=无运动）
+    uint32_t motion_burst_ms;        // 每次突发持续时间
+    float motion_amp;                // 突发幅度（计数）
+    uint16_t gas_mv;                 // SnO₂输出电压
+    uint16_t battery_mv;             // 电池ADC电压
+    float temperature_c;
+    float humidity_rh;
+} SyntheticSourceConfig;
+
+void synthetic_source_default_config(SyntheticSourceConfig* config);
+const SensorSource* synthetic_source_create(const SyntheticSourceConfig* config);
+void synthetic_source_reset();                      // 以相同配置从头生成
+uint32_t synthetic_source_get_sample_index();       // 已生成的PPG样本数（虚拟时钟）
+
+#endif // SENSOR_SOURCE_H
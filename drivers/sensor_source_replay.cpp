@@ -0,0 +1,221 @@
+#include "sensor_source.h"
+#include <string.h>
+
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+#ifndef ARDUINO
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// ──────────────────────────────────────────────
+// 私有变量：映射区域 + 各通道独立游标（记录下标）
+// ──────────────────────────────────────────────
+
+typedef struct {
+    const uint8_t* records;          // 指向第一条记录（映射区域内，不拷贝）
+    uint32_t record_count;
+    uint16_t sample_rate_hz;
+    bool loop;
+
+    uint32_t cursor[4];              // 按 ReplayRecordType 索引
+
+#if defined(ESP32)
+    spi_flash_mmap_handle_t flash_handle;
+    bool flash_mapped;
+#endif
+#ifndef ARDUINO
+    void* file_map;
+    size_t file_len;
+#endif
+} ReplayState;
+
+static ReplayState g_replay;
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+// 读取第idx条记录（memcpy避免映射区域的非对齐访问）
+static void load_record(uint32_t idx, ReplayRecord* rec) {
+    memcpy(rec, g_replay.records + (size_t)idx * sizeof(ReplayRecord), sizeof(ReplayRecord));
+}
+
+// 从该通道游标处向后查找下一条同类型记录；到末尾且loop时从头再找一次
+static bool next_record(ReplayRecordType type, ReplayRecord* rec) {
+    if (g_replay.records == NULL || g_replay.record_count == 0) return false;
+
+    uint32_t* cursor = &g_replay.cursor[type];
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        while (*cursor < g_replay.record_count) {
+            load_record(*cursor, rec);
+            (*cursor)++;
+            if (rec->type == type) return true;
+        }
+        if (!g_replay.loop) return false;
+        *cursor = 0;
+    }
+    return false;
+}
+
+static bool peek_record(ReplayRecordType type) {
+    if (g_replay.records == NULL) return false;
+    if (g_replay.loop) return g_replay.record_count > 0;
+
+    ReplayRecord rec;
+    for (uint32_t i = g_replay.cursor[type]; i < g_replay.record_count; i++) {
+        load_record(i, &rec);
+        if (rec.type == type) return true;
+    }
+    return false;
+}
+
+// ──────────────────────────────────────────────
+// 接口实现
+// ──────────────────────────────────────────────
+
+static bool replay_ppg_available() {
+    return peek_record(REPLAY_RECORD_PPG);
+}
+
+static bool replay_ppg_read(int32_t* red, int32_t* ir) {
+    ReplayRecord rec;
+    if (!next_record(REPLAY_RECORD_PPG, &rec)) return false;
+    *red = rec.b;
+    *ir = rec.c;
+    return true;
+}
+
+static bool replay_gas_read_raw(uint16_t* raw) {
+    ReplayRecord rec;
+    if (!next_record(REPLAY_RECORD_GAS, &rec)) return false;
+    *raw = rec.a;
+    return true;
+}
+
+static bool replay_env_read(EnvData* out) {
+    ReplayRecord rec;
+    if (!next_record(REPLAY_RECORD_ENV, &rec)) {
+        out->valid = false;
+        return false;
+    }
+    out->temperature_c = rec.b / 100.0f;
+    out->humidity_rh = rec.c / 100.0f;
+    out->valid = true;
+    return true;
+}
+
+static bool replay_battery_read_raw(uint16_t* raw) {
+    ReplayRecord rec;
+    if (!next_record(REPLAY_RECORD_BATTERY, &rec)) return false;
+    *raw = rec.a;
+    return true;
+}
+
+static const SensorSource g_replay_source = {
+    SENSOR_SOURCE_REPLAY,
+    "replay",
+    replay_ppg_available,
+    replay_ppg_read,
+    replay_gas_read_raw,
+    replay_env_read,
+    replay_battery_read_raw,
+    NULL
+};
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+const SensorSource* replay_source_open(const uint8_t* base, size_t len, bool loop) {
+    if (base == NULL || len < sizeof(ReplayHeader)) return NULL;
+
+    ReplayHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION) {
+        return NULL;
+    }
+
+    // 记录数以实际长度为准，防止截断文件越界
+    uint32_t available = (uint32_t)((len - sizeof(ReplayHeader)) / sizeof(ReplayRecord));
+    g_replay.records = base + sizeof(ReplayHeader);
+    g_replay.record_count = (header.record_count < available) ? header.record_count : available;
+    g_replay.sample_rate_hz = header.sample_rate_hz;
+    g_replay.loop = loop;
+    replay_source_rewind();
+
+    return &g_replay_source;
+}
+
+#if defined(ESP32)
+const SensorSource* replay_source_open_partition(const char* label, bool loop) {
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (part == NULL) return NULL;
+
+    replay_source_close();
+
+    const void* ptr = NULL;
+    if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA,
+                           &ptr, &g_replay.flash_handle) != ESP_OK) {
+        return NULL;
+    }
+    g_replay.flash_mapped = true;
+
+    const SensorSource* source = replay_source_open((const uint8_t*)ptr, part->size, loop);
+    if (source == NULL) replay_source_close();
+    return source;
+}
+#endif
+
+#ifndef ARDUINO
+const SensorSource* replay_source_open_file(const char* path, bool loop) {
+    replay_source_close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    g_replay.file_map = map;
+    g_replay.file_len = (size_t)st.st_size;
+
+    const SensorSource* source = replay_source_open((const uint8_t*)map, g_replay.file_len, loop);
+    if (source == NULL) replay_source_close();
+    return source;
+}
+#endif
+
+void replay_source_close() {
+#if defined(ESP32)
+    if (g_replay.flash_mapped) {
+        spi_flash_munmap(g_replay.flash_handle);
+    }
+#endif
+#ifndef ARDUINO
+    if (g_replay.file_map != NULL) {
+        munmap(g_replay.file_map, g_replay.file_len);
+    }
+#endif
+    memset(&g_replay, 0, sizeof(g_replay));
+}
+
+void replay_source_rewind() {
+    memset(g_replay.cursor, 0, sizeof(g_replay.cursor));
+}
+
+uint16_t replay_source_get_sample_rate() {
+    return g_replay.sample_rate_hz;
+}
@@ -0,0 +1,185 @@
+#include "sensor_source.h"
+#include <math.h>
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 合成数据源：以PPG样本序号为虚拟时钟，与真实时间无关，可全速运行
+// ──────────────────────────────────────────────
+
+#define SYNTH_TWO_PI             6.28318531f
+#define SYNTH_ADC_REF_MV         3300
+#define SYNTH_ADC_RESOLUTION     4096
+#define SYNTH_PPG_MAX            262143      // 18位满量程
+#define SYNTH_MOTION_HZ          2.5f        // 运动伪影主频（挥手/步行）
+
+typedef struct {
+    SyntheticSourceConfig config;
+    uint32_t rng;                    // xorshift32 状态
+    uint32_t sample_index;           // 已生成PPG样本数
+    float pulse_phase;               // 脉搏相位（0~1）
+    float motion_phase;              // 当前突发的随机初相
+    uint32_t motion_burst_id;        // 当前突发编号（用于每次突发只取一次随机相位）
+} SyntheticState;
+
+static SyntheticState g_synth;
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+static uint32_t rng_next() {
+    uint32_t x = g_synth.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g_synth.rng = x;
+    return x;
+}
+
+static float rng_uniform() {
+    return (rng_next() >> 8) * (1.0f / 16777216.0f);  // [0,1)
+}
+
+// 近似高斯：4个均匀分布之和（方差1/3），缩放到单位方差
+static float rng_gauss() {
+    float s = rng_uniform() + rng_uniform() + rng_uniform() + rng_uniform() - 2.0f;
+    return s * 1.7320508f;
+}
+
+// 脉搏波形：主波 + 重搏波，峰值约±1
+static float pulse_shape(float phase) {
+    return 0.8f * sinf(SYNTH_TWO_PI * phase) + 0.25f * sinf(2.0f * SYNTH_TWO_PI * phase + 0.7f);
+}
+
+static int32_t clamp_ppg(float v) {
+    if (v < 0.0f) return 0;
+    if (v > SYNTH_PPG_MAX) return SYNTH_PPG_MAX;
+    return (int32_t)v;
+}
+
+static uint16_t mv_to_raw(uint16_t mv) {
+    uint32_t raw = ((uint32_t)mv * SYNTH_ADC_RESOLUTION) / SYNTH_ADC_REF_MV;
+    return (raw > 4095) ? 4095 : (uint16_t)raw;
+}
+
+// ──────────────────────────────────────────────
+// 接口实现
+// ──────────────────────────────────────────────
+
+static bool synth_ppg_available() {
+    return true;
+}
+
+static bool synth_ppg_read(int32_t* red, int32_t* ir) {
+    const SyntheticSourceConfig* c = &g_synth.config;
+    float fs = (float)c->sample_rate_hz;
+    float t = g_synth.sample_index / fs;
+    uint32_t t_ms = (uint32_t)(((uint64_t)g_synth.sample_index * 1000) / c->sample_rate_hz);
+
+    // 交流幅度：IR由灌注指数决定，红光按 R = (110 - SpO2) / 25 反推
+    float ir_ac = 0.5f * (c->perfusion_pct / 100.0f) * c->ir_dc;
+    float ratio = (110.0f - c->spo2_pct) / 25.0f;
+    float red_ac = ratio * (ir_ac / c->ir_dc) * c->red_dc;
+
+    // 光吸收随血容量增加，故取负号
+    float pulse = pulse_shape(g_synth.pulse_phase);
+    float wander = c->wander_amp * sinf(SYNTH_TWO_PI * c->wander_hz * t);
+
+    // 运动突发：两通道共模的大幅伪影
+    float motion = 0.0f;
+    if (c->motion_period_ms > 0 && (t_ms % c->motion_period_ms) < c->motion_burst_ms) {
+        uint32_t burst_id = t_ms / c->motion_period_ms;
+        if (burst_id != g_synth.motion_burst_id) {
+            g_synth.motion_burst_id = burst_id;
+            g_synth.motion_phase = rng_uniform();
+        }
+        motion = c->motion_amp * sinf(SYNTH_TWO_PI * (SYNTH_MOTION_HZ * t + g_synth.motion_phase));
+    }
+
+    *ir = clamp_ppg(c->ir_dc - ir_ac * pulse + wander + motion + c->noise_rms * rng_gauss());
+    *red = clamp_ppg(c->red_dc - red_ac * pulse + wander + motion + c->noise_rms * rng_gauss());
+
+    g_synth.pulse_phase += c->hr_bpm / 60.0f / fs;
+    if (g_synth.pulse_phase >= 1.0f) g_synth.pulse_phase -= 1.0f;
+    g_synth.sample_index++;
+    return true;
+}
+
+static bool synth_gas_read_raw(uint16_t* raw) {
+    *raw = mv_to_raw(g_synth.config.gas_mv);
+    return true;
+}
+
+static bool synth_env_read(EnvData* out) {
+    out->temperature_c = g_synth.config.temperature_c;
+    out->humidity_rh = g_synth.config.humidity_rh;
+    out->valid = true;
+    return true;
+}
+
+static bool synth_battery_read_raw(uint16_t* raw) {
+    *raw = mv_to_raw(g_synth.config.battery_mv);
+    return true;
+}
+
+static const SensorSource g_synthetic_source = {
+    SENSOR_SOURCE_SYNTHETIC,
+    "synthetic",
+    synth_ppg_available,
+    synth_ppg_read,
+    synth_gas_read_raw,
+    synth_env_read,
+    synth_battery_read_raw,
+    NULL
+};
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void synthetic_source_default_config(SyntheticSourceConfig* config) {
+    if (config == NULL) return;
+
+    config->seed = 0x5EED1234UL;
+    config->sample_rate_hz = 100;
+    config->hr_bpm = 72.0f;
+    config->spo2_pct = 97.0f;
+    config->perfusion_pct = 2.0f;
+    config->ir_dc = 100000;
+    config->red_dc = 80000;
+    config->noise_rms = 20.0f;
+    config->wander_amp = 200.0f;
+    config->wander_hz = 0.25f;
+    config->motion_period_ms = 0;
+    config->motion_burst_ms = 0;
+    config->motion_amp = 0.0f;
+    config->gas_mv = 1650;
+    config->battery_mv = 3000;
+    config->temperature_c = 25.0f;
+    config->humidity_rh = 50.0f;
+}
+
+const SensorSource* synthetic_source_create(const SyntheticSourceConfig* config) {
+    if (config != NULL) {
+        g_synth.config = *config;
+    } else {
+        synthetic_source_default_config(&g_synth.config);
+    }
+    if (g_synth.config.sample_rate_hz == 0) g_synth.config.sample_rate_hz = 100;
+    if (g_synth.config.ir_dc <= 0) g_synth.config.ir_dc = 1;
+
+    synthetic_source_reset();
+    return &g_synthetic_source;
+}
+
+void synthetic_source_reset() {
+    g_synth.rng = g_synth.config.seed ? g_synth.config.seed : 1;
+    g_synth.sample_index = 0;
+    g_synth.pulse_phase = 0.0f;
+    g_synth.motion_phase = 0.0f;
+    g_synth.motion_burst_id = 0xFFFFFFFFUL;
+}
+
+uint32_t synthetic_source_get_sample_index() {
+    return g_synth.sample_index;
+}
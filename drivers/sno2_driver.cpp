@@ -1,4 +1,5 @@
 #include "sno2_driver.h"
+#include "adc_calib.h"
 
 // ──────────────────────────────────────────────
 // 私有变量（低RAM优化）
@@ -16,6 +17,10 @@ static uint8_t sample_count = 0;
 static int16_t calib_a_q = SNO2_CALIB_A_Q;
 static int16_t calib_b_q = SNO2_CALIB_B_Q;
 
+// 查找表：ADC原始值→mV，mV→ppm（Q10.6），初始化/标定时生成
+static AdcCalibLut adc_lut;
+static uint16_t ppm_lut_q[SNO2_PPM_LUT_SIZE];
+
 // ──────────────────────────────────────────────
 // 私有函数声明
 // ──────────────────────────────────────────────
@@ -29,6 +34,8 @@ static void enter_error_state();
 static uint16_t read_adc_raw();
 static uint16_t calculate_average_adc();
 static uint16_t adc_raw_to_mv(uint16_t raw);
+static int32_t model_concentration_q(uint16_t voltage_mv);
+static void build_ppm_lut();
 static uint16_t calculate_concentration(uint16_t voltage_mv);
 static void update_heater(uint8_t state);
 
@@ -47,6 +54,10 @@ void sno2_init() {
     current_data.heater_on = 0;
     current_data.valid = 0;
     
+    // 生成换算查找表
+    adc_calib_build_lut(&adc_lut, SNO2_ADC_REF_MV, SNO2_ADC_RESOLUTION);
+    build_ppm_lut();
+    
     // 记录第一个周期开始时间
     last_cycle_start = millis();
     
@@ -129,6 +140,9 @@ void sno2_set_calibration(float a, float b) {
     // 将浮点参数转换为Q10.6格式
     calib_a_q = (int16_t)(a * SNO2_Q_SCALE);
     calib_b_q = (int16_t)(b * SNO2_Q_SCALE);
+    
+    // 标定参数变化后重建浓度查找表
+    build_ppm_lut();
 }
 
 uint8_t sno2_is_heater_on() {
@@ -209,40 +223,46 @@ static uint16_t calculate_average_adc() {
 }
 
 static uint16_t adc_raw_to_mv(uint16_t raw) {
-    // 定点运算：voltage_mv = raw * 3300 / 4096
-    // 使用32位中间值避免溢出
-    uint32_t voltage = (uint32_t)raw * SNO2_ADC_REF_MV;
-    return (uint16_t)(voltage / SNO2_ADC_RESOLUTION);
+    // 查表+插值（eFuse标定可用时已折算进节点）
+    return adc_calib_raw_to_mv(&adc_lut, raw);
 }
 
-static uint16_t calculate_concentration(uint16_t voltage_mv) {
-    // 使用Q格式定点运算：ppm = a * voltage + b
-    // 步骤：1. voltage * a (Q10.6 * Q10.6 = Q20.12)
-    //       2. 右移6位得到Q20.6
-    //       3. 加上b (Q10.6)
-    //       4. 右移6位得到整数ppm
-    
-    // 转换为int32_t进行中间计算
-    int32_t voltage_q = (int32_t)voltage_mv << SNO2_Q_FRACTION_BITS;  // 转换为Q10.6
+static int32_t model_concentration_q(uint16_t voltage_mv) {
+    // 线性模型（Q10.6）：ppm_q = a_q * voltage + b_q
+    // a_q为Q10.6，voltage为整数，乘积仍为Q10.6，可直接与b_q相加
+    int32_t ppm_q = (int32_t)calib_a_q * voltage_mv + calib_b_q;
     
-    // 计算 a * voltage (Q10.6 * Q10.6 = Q20.12)
-    int32_t product = (int32_t)calib_a_q * voltage_q;  // Q20.12
-    
-    // 右移6位得到Q20.6
-    product >>= SNO2_Q_FRACTION_BITS;  // Q20.6
-    
-    // 加上b (Q10.6转换为Q20.6)
-    int32_t b_q20 = (int32_t)calib_b_q << SNO2_Q_FRACTION_BITS;  // Q20.6
-    product += b_q20;  // Q20.6
+    // 限制范围
+    if (ppm_q < ((int32_t)SNO2_CONC_MIN_PPM << SNO2_Q_FRACTION_BITS)) {
+        ppm_q = (int32_t)SNO2_CONC_MIN_PPM << SNO2_Q_FRACTION_BITS;
+    }
+    if (ppm_q > ((int32_t)SNO2_CONC_MAX_PPM << SNO2_Q_FRACTION_BITS)) {
+        ppm_q = (int32_t)SNO2_CONC_MAX_PPM << SNO2_Q_FRACTION_BITS;
+    }
     
-    // 右移6位得到整数ppm
-    int32_t ppm = product >> SNO2_Q_FRACTION_BITS;  // 整数
+    return ppm_q;
+}
+
+static void build_ppm_lut() {
+    // 每 2^SNO2_PPM_LUT_SHIFT mV 一个节点，节点值为Q10.6浓度
+    for (uint16_t i = 0; i < SNO2_PPM_LUT_SIZE; i++) {
+        ppm_lut_q[i] = (uint16_t)model_concentration_q((uint16_t)(i << SNO2_PPM_LUT_SHIFT));
+    }
+}
+
+static uint16_t calculate_concentration(uint16_t voltage_mv) {
+    // 查表+定点线性插值，结果右移6位得到整数ppm
+    uint16_t idx = voltage_mv >> SNO2_PPM_LUT_SHIFT;
+    if (idx >= SNO2_PPM_LUT_SIZE - 1) {
+        return ppm_lut_q[SNO2_PPM_LUT_SIZE - 1] >> SNO2_Q_FRACTION_BITS;
+    }
     
-    // 限制范围
-    if (ppm < SNO2_CONC_MIN_PPM) ppm = SNO2_CONC_MIN_PPM;
-    if (ppm > SNO2_CONC_MAX_PPM) ppm = SNO2_CONC_MAX_PPM;
+    uint16_t frac = voltage_mv & ((1 << SNO2_PPM_LUT_SHIFT) - 1);
+    int32_t y0 = ppm_lut_q[idx];
+    int32_t y1 = ppm_lut_q[idx + 1];
+    int32_t ppm_q = y0 + (((y1 - y0) * (int32_t)frac) >> SNO2_PPM_LUT_SHIFT);
     
-    return (uint16_t)ppm;
+    return (uint16_t)(ppm_q >> SNO2_Q_FRACTION_BITS);
 }
 
 static void update_heater(uint8_t state) {
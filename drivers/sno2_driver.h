@@ -41,6 +41,10 @@
 #define SNO2_CONC_MIN_PPM       0
 #define SNO2_CONC_MAX_PPM       1000
 
+// 浓度查找表（mV→ppm，Q10.6存储，每 2^SNO2_PPM_LUT_SHIFT mV 一个节点）
+#define SNO2_PPM_LUT_SHIFT      5       // 32mV/节点
+#define SNO2_PPM_LUT_SIZE       ((SNO2_VOLTAGE_MAX_MV >> SNO2_PPM_LUT_SHIFT) + 2)
+
 // ──────────────────────────────────────────────
 // 状态定义
 // ──────────────────────────────────────────────
@@ -79,7 +83,7 @@ Sno2State sno2_get_state();
 // 获取最新数据
 Sno2Data sno2_get_data();
 
-// 设置线性标定参数（a,b为浮点数，内部转换为Q格式）
+// 设置线性标定参数（a,b为浮点数，内部转换为Q格式，并重建查找表）
 void sno2_set_calibration(float a, float b);
 
 // 获取加热器状态
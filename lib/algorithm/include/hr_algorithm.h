@@ -21,10 +21,13 @@
 // function declarations
 void hr_algorithm_init();
 int hr_algorithm_update();
+int hr_algorithm_push_sample(int32_t red, int32_t ir);
 uint8_t hr_calculate_bpm(int* status);
 uint8_t hr_calculate_spo2(int* status);
 uint8_t hr_get_latest_bpm();
 uint8_t hr_get_latest_spo2();
+void hr_algorithm_reset_baseline();
+void hr_algorithm_set_sample_period_us(uint32_t period_us);
 uint8_t hr_get_signal_quality();
 uint8_t hr_get_correlation_quality();
 
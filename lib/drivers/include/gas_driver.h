@@ -11,5 +11,6 @@ bool gas_read(float* voltage_mv, float* conc_ppm);
 bool gas_is_warmed_up();
 float gas_get_heater_duty_cycle();
 uint32_t gas_get_warmup_remaining();
+void gas_set_calibration(float a, float b, float vair_mv);
 
 #endif
@@ -0,0 +1,2 @@
+// Shim: forward to the canonical header so LDF finds it
+#include "../../../drivers/hr_agc.h"
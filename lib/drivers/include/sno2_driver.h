@@ -67,6 +67,12 @@
 #define SNO2_CONC_MAX_PPM       1000
 #endif
 
+// 浓度查找表
+#ifndef SNO2_PPM_LUT_SHIFT
+#define SNO2_PPM_LUT_SHIFT      5
+#endif
+#define SNO2_PPM_LUT_SIZE       ((SNO2_VOLTAGE_MAX_MV >> SNO2_PPM_LUT_SHIFT) + 2)
+
 // 可选包含项目级别 pin 配置（如需要覆盖宏，可在 config/pin_config.h 中定义）
 #include "config/pin_config.h"
 
@@ -21,3 +21,4 @@ bool gas_read(float* voltage_mv, float* conc_ppm) {
 bool gas_is_warmed_up() { return warmup_complete; }
 float gas_get_heater_duty_cycle() { return heater_duty_cycle; }
 uint32_t gas_get_warmup_remaining() { return 0; }
+void gas_set_calibration(float a, float b, float vair_mv) { (void)a; (void)b; (void)vair_mv; }
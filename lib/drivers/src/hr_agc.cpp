@@ -0,0 +1,2 @@
+// Shim: include original implementation so LDF compiles it
+#include "../../../drivers/hr_agc.cpp"
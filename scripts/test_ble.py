@@ -7,31 +7,268 @@ BLE测试脚本 - 用于验证腕带BLE通信
 import asyncio
 import sys
 import json
+import struct
+import time
 from bleak import BleakScanner, BleakClient
 
 # BLE UUID配置（与腕带代码一致）
 SERVICE_UUID = "a1b2c3d4-e5f6-4789-abcd-ef0123456789"
 CHARACTERISTIC_UUID = "a1b2c3d4-e5f6-4789-abcd-ef012345678a"
+PPG_CHARACTERISTIC_UUID = "a1b2c3d4-e5f6-4789-abcd-ef0123456796"  # 原始波形流（--ppg 订阅）
+HISTORY_CHARACTERISTIC_UUID = "a1b2c3d4-e5f6-4789-abcd-ef0123456797"  # 离线历史（--history 拉取）
+# 分字段特征值（--fields 订阅）：值变化超过死区或保活到期才通知；(键名, struct格式)
+FIELD_CHARACTERISTICS = {
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456790": ("hr", "<B"),
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456791": ("spo2", "<B"),
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456792": ("acetone", "<f"),
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456793": ("battery", "<B"),
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456794": ("risk", "<B"),
+    "a1b2c3d4-e5f6-4789-abcd-ef0123456795": ("wear", "<B"),
+}
+BROADCAST_COMPANY_ID = 0xFFFF  # 广播模式厂商数据的公司ID（--broadcast 扫描，与 BLE_BROADCAST_COMPANY_ID 一致）
 DEVICE_NAME = "DiabetesSensor"
 
+# 二进制遥测帧（与 src/telemetry_packet.h 一致）
+TELEMETRY_VERSION = 1
+# (位, 键名, struct格式, 缩放)
+TELEMETRY_FIELDS = [
+    (0x01, "hr", "<B", 1),
+    (0x02, "spo2", "<B", 1),
+    (0x04, "acetone", "<H", 10),
+    (0x08, "battery", "<B", 1),
+    (0x10, "snr", "<B", 1),
+    (0x20, "risk", "<B", 1),
+    (0x40, "wear", "<B", 1),
+]
+RISK_NAMES = {0: "正常", 1: "中风险", 2: "高风险"}
+WEAR_NAMES = {0: "off", 1: "on"}
+
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE（多项式0x1021，初值0xFFFF）"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def telemetry_frame_len(fields):
+    """字段位图对应的遥测帧长度"""
+    length = 8  # 版本 + 位图 + 时间戳 + CRC
+    for bit, _, fmt, _ in TELEMETRY_FIELDS:
+        if fields & bit:
+            length += struct.calcsize(fmt)
+    return length
+
+
+def decode_telemetry(data):
+    """解码二进制遥测帧，返回与JSON格式相同键名的字典；校验失败抛出 ValueError"""
+    if len(data) < 8:
+        raise ValueError(f"帧过短: {len(data)} 字节")
+    if data[0] != TELEMETRY_VERSION:
+        raise ValueError(f"未知版本: {data[0]}")
+    (crc,) = struct.unpack_from("<H", data, len(data) - 2)
+    if crc != crc16_ccitt(data[:-2]):
+        raise ValueError("CRC校验失败")
+
+    fields = data[1]
+    (timestamp,) = struct.unpack_from("<I", data, 2)
+    result = {"timestamp": timestamp}
+    offset = 6
+    for bit, key, fmt, scale in TELEMETRY_FIELDS:
+        if fields & bit:
+            (value,) = struct.unpack_from(fmt, data, offset)
+            offset += struct.calcsize(fmt)
+            result[key] = value / scale if scale != 1 else value
+    if offset != len(data) - 2:
+        raise ValueError("字段位图与帧长度不一致")
+    if "risk" in result:
+        result["risk_level"] = RISK_NAMES.get(result.pop("risk"), "未知")
+    if "wear" in result:
+        result["wear"] = WEAR_NAMES.get(result["wear"], "unknown")
+    return result
+
+
+def encode_telemetry(values):
+    """编码遥测帧（decode_telemetry 的逆过程，用于模拟设备）"""
+    risk_codes = {name: code for code, name in RISK_NAMES.items()}
+    wear_codes = {name: code for code, name in WEAR_NAMES.items()}
+    values = dict(values)
+    if "risk_level" in values:
+        values["risk"] = risk_codes[values.pop("risk_level")]
+    if "wear" in values:
+        values["wear"] = wear_codes.get(values["wear"], values["wear"])
+    fields = 0
+    body = b""
+    for bit, key, fmt, scale in TELEMETRY_FIELDS:
+        if key in values:
+            fields |= bit
+            body += struct.pack(fmt, int(round(values[key] * scale)))
+    frame = struct.pack("<BBI", TELEMETRY_VERSION, fields, values.get("timestamp", 0)) + body
+    return frame + struct.pack("<H", crc16_ccitt(frame))
+
+
+def decode_field(uuid, data):
+    """解码分字段特征值，返回 (键名, 值)；未得出（uint8 0xFF、丙酮负值）返回 None"""
+    key, fmt = FIELD_CHARACTERISTICS[str(uuid).lower()]
+    (value,) = struct.unpack(fmt, bytes(data))
+    if (fmt == "<B" and value == 0xFF) or (key == "acetone" and value < 0):
+        return key, None  # 未得出（与检测端固件相同的哨兵值）
+    if key == "acetone":
+        value = round(value, 1)
+    elif key == "risk":
+        value = RISK_NAMES.get(value, "未知")
+    elif key == "wear":
+        value = WEAR_NAMES.get(value, "unknown")
+    return key, value
+
+
+def decode_broadcast(manufacturer_data):
+    """从扫描结果的厂商数据（{公司ID: 字节}）解出遥测字典；不是本设备的广播返回 None"""
+    data = manufacturer_data.get(BROADCAST_COMPANY_ID)
+    if data is None:
+        return None
+    return decode_telemetry(bytes(data))
+
+
+class SimulatedAdvertiser:
+    """模拟广播模式的设备：每个新结果生成一份与固件相同格式的厂商数据（无硬件自测用）"""
+
+    def __init__(self, name=DEVICE_NAME):
+        self.name = name
+        self.timestamp = 0
+
+    def advertise(self, hr, spo2, acetone, battery, risk_level="正常", wear="on"):
+        self.timestamp += 4
+        values = {"timestamp": self.timestamp, "acetone": acetone, "battery": battery,
+                  "risk_level": risk_level, "wear": wear}
+        if wear == "on":
+            values["hr"] = hr
+            values["spo2"] = spo2
+        frame = encode_telemetry(values)
+        # 传统广播31字节：flags(3) + 厂商数据(4 + 帧)
+        assert 3 + 4 + len(frame) <= 31, "厂商数据超出传统广播负载"
+        return {"local_name": self.name, "manufacturer_data": {BROADCAST_COMPANY_ID: frame}}
+
+
+# 原始PPG波形帧（与 src/ppg_stream_packet.h 一致）
+PPG_STREAM_VERSION = 1
+PPG_STREAM_FLAG_ORDER2 = 0x01
+
+
+def _read_varint(data, offset, end):
+    result = 0
+    for n in range(5):
+        if offset + n >= end:
+            break
+        byte = data[offset + n]
+        result |= (byte & 0x7F) << (7 * n)
+        if not byte & 0x80:
+            return result, offset + n + 1
+    raise ValueError("varint 越界")
+
+
+def decode_ppg_stream(data):
+    """解码波形帧，返回 (首样本序号, 红光列表, 红外列表)；校验失败抛出 ValueError"""
+    if len(data) < 7:
+        raise ValueError(f"帧过短: {len(data)} 字节")
+    if data[0] != PPG_STREAM_VERSION:
+        raise ValueError(f"未知版本: {data[0]}")
+    (crc,) = struct.unpack_from("<H", data, len(data) - 2)
+    if crc != crc16_ccitt(data[:-2]):
+        raise ValueError("CRC校验失败")
+
+    order2 = data[1] & PPG_STREAM_FLAG_ORDER2
+    count = data[2]
+    (seq,) = struct.unpack_from("<H", data, 3)
+    end = len(data) - 2
+    offset = 5
+    channels = ([], [])
+    for k in range(count):
+        for ch in channels:
+            z, offset = _read_varint(data, offset, end)
+            residual = (z >> 1) ^ -(z & 1)
+            if k == 0:
+                pred = 0
+            elif k == 1 or not order2:
+                pred = ch[-1]
+            else:
+                pred = 2 * ch[-1] - ch[-2]
+            # 与固件相同的32位回绕运算
+            value = (pred + residual) & 0xFFFFFFFF
+            ch.append(value - (1 << 32) if value & 0x80000000 else value)
+    if offset != end:
+        raise ValueError("样本数与帧长度不一致")
+    return seq, channels[0], channels[1]
+
+
+# 离线历史同步（与 src/ble_peripheral_final.cpp 的历史协议一致）
+HISTORY_OP_PULL = 0x01
+HISTORY_FRAME_RECORDS = 0x01
+HISTORY_FRAME_END = 0x02
+HISTORY_FRAME_REJECT = 0x03
+
+
+def decode_history_frame(data):
+    """解码历史通知：记录帧返回 ("records", [(序号, 上电编号, 字典), ...])，
+    结束帧返回 ("end", (最旧, 下一序号, 上电编号, 运行秒数))，MTU 过小被拒绝返回 ("reject", 所需ATT MTU)"""
+    if data[:1] == bytes([HISTORY_FRAME_END]) and len(data) >= 17:
+        return "end", struct.unpack_from("<IIII", data, 1)
+    if data[:1] == bytes([HISTORY_FRAME_REJECT]) and len(data) >= 3:
+        return "reject", struct.unpack_from("<H", data, 1)[0]
+    if data[:1] != bytes([HISTORY_FRAME_RECORDS]) or len(data) < 10:
+        raise ValueError(f"未知历史帧: {data[:1].hex()}")
+    count = data[1]
+    seq, boot = struct.unpack_from("<II", data, 2)
+    offset = 10
+    records = []
+    for i in range(count):
+        if offset + 2 > len(data):
+            raise ValueError("历史帧截断")
+        length = telemetry_frame_len(data[offset + 1])
+        records.append((seq + i, boot, decode_telemetry(data[offset:offset + length])))
+        offset += length
+    if offset != len(data):
+        raise ValueError("记录数与帧长度不一致")
+    return "records", records
+
+
 class BLETester:
     def __init__(self):
         self.client = None
         self.connected = False
         self.received_data = []
+        self.ppg_samples = 0
+        self.ppg_bytes = 0
+        self.ppg_lost = 0
+        self.ppg_next_seq = None
+        self.history = []
+        self.history_cursor = 0      # 最后收到的序号 + 1（续传起点）
+        self.history_done = None
+        self.history_clock = None    # 结束帧的 (上电编号, 运行秒数, 本机收到时刻)
+        self.field_updates = {}
         
     def notification_handler(self, sender, data):
         """处理接收到的BLE通知数据"""
         try:
-            # 解码JSON数据
-            json_str = data.decode('utf-8')
-            json_data = json.loads(json_str)
+            # JSON帧以 '{' 开头，否则按二进制遥测帧解码
+            if data[:1] == b"{":
+                json_data = json.loads(data.decode('utf-8'))
+            else:
+                json_data = decode_telemetry(bytes(data))
             
-            print(f"\n📡 收到BLE数据:")
+            print(f"\n📡 收到BLE数据 ({len(data)} 字节):")
             print(f"   心率: {json_data.get('hr', 'N/A')} bpm")
             print(f"   血氧: {json_data.get('spo2', 'N/A')}%")
             print(f"   丙酮: {json_data.get('acetone', 'N/A')} ppm")
-            print(f"   备注: {json_data.get('note', 'N/A')}")
+            print(f"   风险: {json_data.get('risk_level', 'N/A')}")
+            if 'wear' in json_data:
+                print(f"   佩戴: {json_data['wear']}")
+            if 'note' in json_data:
+                print(f"   备注: {json_data['note']}")
             
             self.received_data.append(json_data)
             
@@ -39,6 +276,92 @@ class BLETester:
             print(f"❌ 数据解析错误: {e}")
             print(f"原始数据: {data.hex()}")
     
+    def field_notification_handler(self, sender, data):
+        """分字段通知：只在变化时到达，按字段计数"""
+        try:
+            key, value = decode_field(sender.uuid, data)
+        except Exception as e:
+            print(f"❌ 字段解析错误: {e}")
+            return
+        self.field_updates[key] = self.field_updates.get(key, 0) + 1
+        print(f"🔹 {key} = {value}")
+    
+    def ppg_notification_handler(self, sender, data):
+        """波形帧：按样本序号统计丢失"""
+        try:
+            seq, red, ir = decode_ppg_stream(bytes(data))
+        except Exception as e:
+            print(f"❌ 波形帧解析错误: {e}")
+            return
+        if self.ppg_next_seq is not None and seq != self.ppg_next_seq:
+            self.ppg_lost += (seq - self.ppg_next_seq) & 0xFFFF
+        self.ppg_next_seq = (seq + len(red)) & 0xFFFF
+        self.ppg_samples += len(red)
+        self.ppg_bytes += len(data)
+        if red:
+            print(f"〰️  PPG #{seq}: {len(red)} 样本 ({len(data)} 字节) red={red[-1]} ir={ir[-1]}")
+    
+    def history_notification_handler(self, sender, data):
+        try:
+            kind, payload = decode_history_frame(bytes(data))
+        except Exception as e:
+            print(f"❌ 历史帧解析错误: {e}")
+            return
+        if kind == "reject":
+            print(f"⚠️ 设备拒绝历史拉取：ATT MTU 需不小于 {payload}")
+            if self.history_done:
+                self.history_done.set()
+            return
+        if kind == "end":
+            oldest, next_seq, boot, uptime_s = payload
+            self.history_clock = (boot, uptime_s, time.time())
+            if self.history_cursor > next_seq:
+                self.history_cursor = 0  # 设备日志已重建：下次从头拉取
+            if self.history_done:
+                self.history_done.set()
+            return
+        self.history.extend(payload)
+        self.history_cursor = payload[-1][0] + 1
+
+    def history_wall_time(self, boot, timestamp_s):
+        """记录时间戳是所属上电以来的秒数：只有当前上电的记录能换算成墙上时间"""
+        if self.history_clock is None or boot != self.history_clock[0]:
+            return None
+        _, uptime_s, received = self.history_clock
+        return received - (uptime_s - timestamp_s)
+    
+    async def pull_history(self, service):
+        """从游标处拉取离线历史并统计耗时"""
+        char = next((c for c in service.characteristics
+                     if str(c.uuid).lower() == HISTORY_CHARACTERISTIC_UUID.lower()), None)
+        if char is None:
+            print("⚠️ 设备不支持离线历史")
+            return
+        oldest, next_seq, boot, uptime_s = struct.unpack("<IIII", await self.client.read_gatt_char(char.uuid))
+        print(f"🗂️  设备历史: #{oldest}..#{next_seq - 1}（{next_seq - oldest} 条），上电#{boot} 已运行 {uptime_s} 秒")
+        self.history_done = asyncio.Event()
+        await self.client.start_notify(char.uuid, self.history_notification_handler)
+        start = asyncio.get_running_loop().time()
+        await self.client.write_gatt_char(
+            char.uuid, struct.pack("<BI", HISTORY_OP_PULL, self.history_cursor), response=True)
+        try:
+            await asyncio.wait_for(self.history_done.wait(), timeout=60.0)
+        except asyncio.TimeoutError:
+            print(f"⚠️ 历史拉取超时，已收到 {len(self.history)} 条，下次从 #{self.history_cursor} 续传")
+        elapsed = asyncio.get_running_loop().time() - start
+        print(f"✅ 历史拉取: {len(self.history)} 条，用时 {elapsed:.2f} 秒")
+        if self.history:
+            seq, boot, first = self.history[0]
+            print(f"   最早 #{seq}（上电#{boot}）: {first}")
+            walls = [self.history_wall_time(b, r.get('timestamp', 0)) for _, b, r in self.history]
+            current = [w for w in walls if w is not None]
+            if current:
+                print(f"   本次上电 {len(current)} 条，最早于 "
+                      f"{time.strftime('%Y-%m-%d %H:%M:%S', time.localtime(current[0]))}")
+            if len(current) < len(walls):
+                boots = sorted({b for _, b, _ in self.history})
+                print(f"   {len(walls) - len(current)} 条属于之前的上电，时间戳无法换算为墙上时间（上电编号 {boots}）")
+    
     async def scan_devices(self):
         """扫描BLE设备"""
         print("🔍 正在扫描BLE设备...")
@@ -55,6 +378,45 @@ class BLETester:
         
         return target_devices
     
+    def on_broadcast(self, name, manufacturer_data):
+        """处理一条广播（同一结果重复广播只记一次）"""
+        try:
+            values = decode_broadcast(manufacturer_data)
+        except ValueError as e:
+            print(f"❌ 广播解析错误: {e}")
+            return
+        if values is None:
+            return
+        if self.received_data and self.received_data[-1] == values:
+            return
+        print(f"📣 {name}: 心率 {values.get('hr', 'N/A')} 血氧 {values.get('spo2', 'N/A')} "
+              f"丙酮 {values.get('acetone', 'N/A')} 电量 {values.get('battery', 'N/A')}% "
+              f"风险 {values.get('risk_level', 'N/A')} 佩戴 {values.get('wear', 'N/A')}")
+        self.received_data.append(values)
+    
+    async def listen_broadcast(self, duration=60.0):
+        """广播模式：不连接，持续扫描并解码厂商数据"""
+        print(f"📣 扫描广播中（{duration:.0f}秒）...")
+        
+        def detection_callback(device, advertisement_data):
+            self.on_broadcast(device.name or device.address, advertisement_data.manufacturer_data)
+        
+        async with BleakScanner(detection_callback):
+            await asyncio.sleep(duration)
+        print(f"📊 收到 {len(self.received_data)} 个不同的结果")
+        return len(self.received_data) > 0
+    
+    def simulate_broadcast(self):
+        """无硬件自测：模拟设备广播并经同一解码路径处理"""
+        sim = SimulatedAdvertiser()
+        results = [sim.advertise(72, 98, 1.2, 85), sim.advertise(75, 97, 2.6, 84, "中风险"),
+                   sim.advertise(0, 0, 2.4, 84, "中风险", wear="off")]
+        for adv in results:
+            self.on_broadcast(adv["local_name"], adv["manufacturer_data"])
+            self.on_broadcast(adv["local_name"], adv["manufacturer_data"])  # 重复广播不重复计数
+        self.on_broadcast("other", {0x004C: b"\x02\x15"})  # 其他厂商的广播被忽略
+        return len(self.received_data) == len(results) and "hr" not in self.received_data[-1]
+    
     async def connect_and_listen(self, device):
         """连接设备并监听通知"""
         print(f"\n🔗 正在连接设备: {device.name} ({device.address})")
@@ -101,11 +463,36 @@ class BLETester:
                 await self.client.start_notify(target_char.uuid, self.notification_handler)
                 print("✅ 已订阅通知，等待数据...")
                 
+                if "--history" in sys.argv:
+                    await self.pull_history(target_service)
+                
+                ppg_char = None
+                if "--ppg" in sys.argv:
+                    ppg_char = next((c for c in target_service.characteristics
+                                     if str(c.uuid).lower() == PPG_CHARACTERISTIC_UUID.lower()), None)
+                    if ppg_char:
+                        await self.client.start_notify(ppg_char.uuid, self.ppg_notification_handler)
+                        print("✅ 已订阅原始PPG波形流")
+                    else:
+                        print("⚠️ 设备不支持原始PPG波形流")
+                
+                field_chars = []
+                if "--fields" in sys.argv:
+                    field_chars = [c for c in target_service.characteristics
+                                   if str(c.uuid).lower() in FIELD_CHARACTERISTICS]
+                    for c in field_chars:
+                        await self.client.start_notify(c.uuid, self.field_notification_handler)
+                    print(f"✅ 已订阅 {len(field_chars)} 个分字段特征值")
+                
                 # 监听数据（持续60秒）
                 print("\n⏳ 监听数据中（60秒后自动停止）...")
                 await asyncio.sleep(60)
                 
                 await self.client.stop_notify(target_char.uuid)
+                if ppg_char:
+                    await self.client.stop_notify(ppg_char.uuid)
+                for c in field_chars:
+                    await self.client.stop_notify(c.uuid)
                 print("🛑 停止监听")
             else:
                 print("❌ 特征值不支持notify")
@@ -144,6 +531,14 @@ class BLETester:
         # 连接并监听
         success = await self.connect_and_listen(device)
         
+        if self.ppg_samples:
+            print(f"\n〰️  PPG波形流: {self.ppg_samples} 样本 ({self.ppg_samples / 60.0:.1f} Hz), "
+                  f"{self.ppg_bytes / self.ppg_samples:.2f} 字节/对, 丢失 {self.ppg_lost} 样本")
+        
+        if self.field_updates:
+            print(f"\n🔹 分字段通知（60秒）: " +
+                  ", ".join(f"{k} {n}次" for k, n in self.field_updates.items()))
+        
         # 显示统计信息
         if self.received_data:
             print(f"\n📊 测试统计:")
@@ -171,7 +566,12 @@ def main():
     
     try:
         # 运行测试
-        success = asyncio.run(tester.run_test())
+        if "--simulate-broadcast" in sys.argv:
+            success = tester.simulate_broadcast()
+        elif "--broadcast" in sys.argv:
+            success = asyncio.run(tester.listen_broadcast())
+        else:
+            success = asyncio.run(tester.run_test())
         
         if success:
             print("\n✅ 测试完成")
@@ -2,9 +2,31 @@
 #include "../algorithm/motion_correction.cpp"
 #include "../algorithm/data_filter.cpp"
 #include "../algorithm/risk_assessment.cpp"
+#include "../algorithm/wear_detect.cpp"
+#include "../algorithm/resampler.cpp"
+
+// sensor source layer (hardware / replay / synthetic) used by hr_algorithm and the collector
+#include "../drivers/sensor_source.cpp"
+#include "../drivers/sensor_source_replay.cpp"
+#include "../drivers/sensor_source_synthetic.cpp"
 
 // scheduler implementation exists outside src directory; include directly
 #include "../system/scheduler.cpp"
 
 // system state needs to be linked as well (contains functions used by scheduler/hr)
 #include "../system/system_state.cpp"
+
+// monotonic 64-bit timebase and sample-rate estimator (used by system_state and the collector)
+#include "../system/timebase.cpp"
+
+// host builds only: virtual clock backing millis()/micros()/delay() (empty under Arduino)
+#include "../system/virtual_clock.cpp"
+
+// drift-free periodic timers with execution-time statistics (used by the schedulers)
+#include "../system/periodic.cpp"
+
+// tickless idle: sleep until the earliest registered deadline (light sleep on ESP32)
+#include "../system/idle.cpp"
+
+// hierarchical timer wheel shared by the schedulers, comm sub-tasks and one-shot timers
+#include "../system/timer_wheel.cpp"
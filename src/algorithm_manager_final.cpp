@@ -6,16 +6,35 @@
  * 2. 运动校正（Kalman + TSSD）
  * 3. 风险评估（基于BPM/SpO2/SnO2组合）
  * 4. 输出AlgorithmResult + RiskAssessment
+ *
+ * 样本摄入与分析分离：每次更新只把新样本重采样后送入HR缓冲（O(新样本数)），
+ * BPM/SpO2 按 ALG_ANALYSIS_HOP_MS 跳步或积累 ALG_ANALYSIS_MIN_NEW_SAMPLES 个新样本时计算；
+ * 风险评估只在其输入（BPM/SpO2/质量/丙酮）变化时重新执行。
+ * 检测模块的读数（可选，经 detector_link_final 投递）在分析时合并，离腕期间也合并并重新评估风险。
  */
 
 #include <Arduino.h>
 #include "../algorithm/hr_algorithm.h"
 #include "../algorithm/motion_correction.h"
+#include "../algorithm/wear_detect.h"
+#include "../algorithm/resampler.h"
+#include "hr_driver.h"
 #include "algorithm_manager_final.h"
 #include "sensor_collector_final.h"
+#include "sample_bus_final.h"
+#include "task_runtime_final.h"
+#include "../system/timebase.h"
 
 // ==================== 全局算法状态 ====================
 
+// 风险评估输入的脏标志
+#define ALG_DIRTY_HR         0x01
+#define ALG_DIRTY_SPO2       0x02
+#define ALG_DIRTY_QUALITY    0x04
+#define ALG_DIRTY_ACETONE    0x08
+
+#define ALG_RISK_SNR_MIN     50      // 信号质量低于此值计一个风险因素
+
 typedef struct {
     // HR算法
     uint8_t latest_bpm;
@@ -36,19 +55,89 @@ typedef struct {
     uint8_t risk_level;  // 0:低风险 1:中风险 2:高风险
     char risk_description[32];
     
+    // 佩戴检测
+    uint8_t suspended;  // 离腕暂停中
+    
+    // 样本总线订阅（PPG只由采集器读取）
+    uint8_t bus_sub;
+    
+    // 均匀网格重采样（总线时间戳 → 固定 HR_SAMPLE_INTERVAL_MS 网格）
+    ResamplerState resampler;
+    
+    // AGC调整发生在采集任务中，基线重置推迟到DSP任务执行，避免打断正在进行的滤波
+    volatile uint8_t baseline_reset_pending;
+    
+    // 对外发布的结果快照（通信任务读取，临界区内整体拷贝）
+    AlgorithmResult published;
+    RiskAssessment published_risk;
+    
+    // 分析节拍
+    uint32_t last_analysis_ms;
+    uint16_t new_samples;            // 自上次分析以来摄入的网格样本
+    uint64_t newest_sample_us;       // 最新网格样本时间戳
+    uint8_t dirty;                   // ALG_DIRTY_*
+    uint32_t last_sno2_ts;           // 最新SnO2读数的采集时刻
+    
+    // 检测模块读数（通信任务投递到 inbox，DSP任务取走合并）
+    ExternalReading external_inbox;
+    volatile uint8_t external_pending;
+    ExternalReading external;
+    uint8_t external_fields;         // ALG_EXT_*：当前取自检测模块的项
+    
     // 统计
     uint32_t total_updates;
     uint32_t last_update_ms;
+    AlgorithmManagerStats stats;
+    uint64_t analysis_total_us;
+    uint32_t rate_window_start_ms;
+    uint32_t rate_window_count;
 } AlgorithmManagerState;
 
 static AlgorithmManagerState g_alg = {0};
 
+// ==================== 私有函数 ====================
+
+static void algorithm_on_agc_step() {
+    g_alg.baseline_reset_pending = 1;
+}
+
+// 一次完整更新后发布快照，读取方不会看到更新到一半的结果
+static void algorithm_publish_result() {
+    task_runtime_enter_critical();
+    g_alg.published.timestamp_ms = g_alg.last_analysis_ms;
+    g_alg.published.bpm = g_alg.latest_bpm;
+    g_alg.published.spo2 = g_alg.latest_spo2;
+    // 检测模块的心率未经本机运动校正，原样作为校正值
+    g_alg.published.corrected_bpm = (g_alg.external_fields & ALG_EXT_HR) ? g_alg.latest_bpm
+                                  : (uint8_t)((g_alg.corrected_bpm / 256) & 0xFF);
+    g_alg.published.signal_quality = g_alg.signal_quality;
+    g_alg.published.correlation_quality = g_alg.correlation_quality;
+    g_alg.published.acetone_ppm = g_alg.acetone_ppm;
+    g_alg.published.external = g_alg.external_fields;
+    g_alg.published_risk.risk_level = g_alg.risk_level;
+    memcpy(g_alg.published_risk.risk_description, g_alg.risk_description, sizeof(g_alg.risk_description));
+    task_runtime_exit_critical();
+}
+
 // ==================== 初始化 ====================
 
 void algorithm_manager_init() {
     // 初始化HR算法
     hr_algorithm_init();
     
+    // AGC每次调整LED/量程后重置算法基线
+    hr_set_agc_callback(algorithm_on_agc_step);
+    
+    // 佩戴检测（离腕时暂停整条PPG处理链）
+    wear_detect_init();
+    
+    // 订阅PPG样本总线（需在 sensor_collector_init 之后）
+    g_alg.bus_sub = sample_bus_subscribe("algorithm");
+    
+    // 总线时间戳由FIFO反推、间隔近似均匀，用三次插值；DSP按网格周期换算BPM
+    resampler_init(&g_alg.resampler, HR_SAMPLE_INTERVAL_MS * 1000UL, RESAMPLER_CUBIC);
+    hr_algorithm_set_sample_period_us(resampler_get_period_us(&g_alg.resampler));
+    
     // 初始化运动校正
     kalman_init(&g_alg.kalman_state, 70);  // 初始70 BPM
     tssd_init(&g_alg.tssd_state);
@@ -61,24 +150,69 @@ void algorithm_manager_init() {
     
     strcpy(g_alg.risk_description, "正常");
     g_alg.risk_level = 0;
+    g_alg.last_analysis_ms = millis();
+    g_alg.rate_window_start_ms = g_alg.last_analysis_ms;
+    algorithm_publish_result();
     
 #ifdef DEBUG_MODE
     Serial.println("[ALG] 算法管理器初始化完成");
 #endif
 }
 
-// ==================== HR算法更新（10ms周期） ====================
+// ==================== 样本摄入（每次更新） ====================
 
-void algorithm_manager_update_hr() {
-    // 调用hr_algorithm_update（自动从MAX30102采集）
-    int status = hr_algorithm_update();
+// 从样本总线取出自上次以来的全部新样本（直接读共享缓冲，不再访问FIFO），
+// 重采样到均匀网格后送入HR算法；出现间隙时先重置基线，避免跨间隙的缓冲污染BPM
+static void algorithm_ingest_samples() {
+    if (g_alg.baseline_reset_pending) {
+        g_alg.baseline_reset_pending = 0;
+        hr_algorithm_reset_baseline();
+    }
     
+    PpgSpan span;
+    ResampledSample grid[RESAMPLER_MAX_OUT];
+    uint16_t n;
+    while ((n = sample_bus_peek(g_alg.bus_sub, &span)) > 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            uint8_t gap = 0;
+            uint8_t m = resampler_push(&g_alg.resampler, span.timestamp_us[i], span.red[i], span.ir[i],
+                                       grid, RESAMPLER_MAX_OUT, &gap);
+            if (gap) {
+                hr_algorithm_reset_baseline();
+            }
+            for (uint8_t j = 0; j < m; j++) {
+                hr_algorithm_push_sample(grid[j].red, grid[j].ir);
+            }
+            if (m > 0) {
+                g_alg.newest_sample_us = grid[m - 1].timestamp_us;
+                g_alg.new_samples += m;
+                g_alg.stats.ingested_samples += m;
+            }
+        }
+        if (sample_bus_consume(g_alg.bus_sub, n) > 0) {
+            // 读取期间被生产者覆盖（严重落后）：已送入的数据不可信，丢弃缓冲重新开始
+            resampler_reset(&g_alg.resampler);
+            hr_algorithm_reset_baseline();
+        }
+    }
+}
+
+// ==================== HR分析（按跳步） ====================
+
+static uint8_t algorithm_analysis_due(uint32_t now_ms) {
+    return (g_alg.new_samples >= ALG_ANALYSIS_MIN_NEW_SAMPLES ||
+            (now_ms - g_alg.last_analysis_ms) >= ALG_ANALYSIS_HOP_MS) ? 1 : 0;
+}
+
+static void algorithm_analyze_hr() {
     // 尝试计算BPM
     int bpm_status = 0;
     uint8_t bpm = hr_calculate_bpm(&bpm_status);
     
     if (bpm > 0) {
+        if (bpm != g_alg.latest_bpm) g_alg.dirty |= ALG_DIRTY_HR;
         g_alg.latest_bpm = bpm;
+        g_alg.external_fields &= ~ALG_EXT_HR;
         
         // 应用Kalman滤波
         int16_t corrected = kalman_update(&g_alg.kalman_state, (int16_t)bpm);
@@ -91,29 +225,115 @@ void algorithm_manager_update_hr() {
     int spo2_status = 0;
     uint8_t spo2 = hr_calculate_spo2(&spo2_status);
     if (spo2 > 0) {
+        if (spo2 != g_alg.latest_spo2) g_alg.dirty |= ALG_DIRTY_SPO2;
         g_alg.latest_spo2 = spo2;
+        g_alg.external_fields &= ~ALG_EXT_SPO2;
     }
     
-    g_alg.signal_quality = hr_get_signal_quality();
+    // 风险评估只看信号质量是否低于阈值：跨越阈值才需要重新评估，其余波动只更新发布值
+    uint8_t snr = hr_get_signal_quality();
+    if ((snr < ALG_RISK_SNR_MIN) != (g_alg.signal_quality < ALG_RISK_SNR_MIN)) {
+        g_alg.dirty |= ALG_DIRTY_QUALITY;
+    }
+    g_alg.signal_quality = snr;
     g_alg.correlation_quality = hr_get_correlation_quality();
+    wear_detect_feed_sqi(g_alg.signal_quality, g_alg.correlation_quality);
 }
 
 // ==================== SnO2采集（从传感器采集器） ====================
 
+// 简单线性转换：voltage → ppm（需根据实际标定调整）
+// 假设：0mV → 0ppm，3300mV → 100ppm
+static inline float algorithm_sno2_to_ppm(uint16_t voltage_mv) {
+    return (voltage_mv * 100.0f) / 3300.0f;
+}
+
 static void algorithm_update_sno2() {
-    SensorSample sample = {0};
-    if (sensor_collector_get_latest(SENSOR_TYPE_SNO2, &sample)) {
-        g_alg.sno2_voltage_mv = sample.data.sno2.voltage_mv;
-        
-        // 简单线性转换：voltage → ppm（需根据实际标定调整）
-        // 假设：0mV → 0ppm，3300mV → 100ppm
-        g_alg.acetone_ppm = (sample.data.sno2.voltage_mv * 100.0f) / 3300.0f;
+    // 取走采集任务交来的全部读数，只用最新一个
+    Sno2Reading readings[SENSOR_SNO2_HANDOFF_SIZE];
+    uint16_t n = sensor_collector_pop_sno2(readings, SENSOR_SNO2_HANDOFF_SIZE);
+    if (n > 0) {
+        const Sno2Reading& sno2 = readings[n - 1];
+        g_alg.last_sno2_ts = sno2.timestamp_ms;
+        uint8_t changed = (sno2.voltage_mv != g_alg.sno2_voltage_mv);
+        g_alg.sno2_voltage_mv = sno2.voltage_mv;
+        if (g_alg.external_fields & ALG_EXT_ACETONE) return;   // 检测模块读数优先
+        if (changed) g_alg.dirty |= ALG_DIRTY_ACETONE;
+        g_alg.acetone_ppm = algorithm_sno2_to_ppm(sno2.voltage_mv);
+    }
+}
+
+// ==================== 检测模块读数合并 ====================
+
+// 采用一项外部读数：值变化或来源切换时置脏标志
+static void algorithm_take_external_u8(uint8_t* field, uint8_t value, uint8_t ext_flag, uint8_t dirty_flag) {
+    if (*field != value || !(g_alg.external_fields & ext_flag)) g_alg.dirty |= dirty_flag;
+    *field = value;
+    g_alg.external_fields |= ext_flag;
+}
+
+// 读数过期或失效：放弃来自检测模块的值（本机没有更新的结果，不再显示旧值）
+static void algorithm_drop_external_u8(uint8_t* field, uint8_t ext_flag, uint8_t dirty_flag) {
+    if (!(g_alg.external_fields & ext_flag)) return;
+    g_alg.external_fields &= ~ext_flag;
+    *field = 0;
+    g_alg.dirty |= dirty_flag;
+}
+
+// 丙酮：检测模块（专用气室与加热规程）优先于本机SnO2估算；
+// 心率/血氧：本机PPG优先，本机没有结果或离腕时采用检测模块（指夹式）的读数，
+// 本机重新得出结果后由 algorithm_analyze_hr 接管
+static void algorithm_merge_external(uint32_t now_ms) {
+    if (g_alg.external_pending) {
+        task_runtime_enter_critical();
+        g_alg.external = g_alg.external_inbox;
+        g_alg.external_pending = 0;
+        task_runtime_exit_critical();
+        g_alg.stats.external_merges++;
+    }
+    
+    const ExternalReading* ext = &g_alg.external;
+    uint8_t fresh = (ext->received_ms != 0 && (now_ms - ext->received_ms) <= ALG_EXTERNAL_MAX_AGE_MS);
+    
+    if (fresh && ext->acetone_valid) {
+        if (ext->acetone_ppm != g_alg.acetone_ppm || !(g_alg.external_fields & ALG_EXT_ACETONE)) {
+            g_alg.dirty |= ALG_DIRTY_ACETONE;
+        }
+        g_alg.acetone_ppm = ext->acetone_ppm;
+        g_alg.external_fields |= ALG_EXT_ACETONE;
+    } else if (g_alg.external_fields & ALG_EXT_ACETONE) {
+        // 恢复本机来源：按最近一次SnO2读数换算（尚无读数时为0）
+        g_alg.external_fields &= ~ALG_EXT_ACETONE;
+        g_alg.acetone_ppm = g_alg.last_sno2_ts ? algorithm_sno2_to_ppm(g_alg.sno2_voltage_mv) : 0.0f;
+        g_alg.dirty |= ALG_DIRTY_ACETONE;
+    }
+    
+    uint8_t hr_open = g_alg.suspended || g_alg.latest_bpm == 0 || (g_alg.external_fields & ALG_EXT_HR);
+    if (fresh && ext->bpm > 0 && hr_open) {
+        algorithm_take_external_u8(&g_alg.latest_bpm, ext->bpm, ALG_EXT_HR, ALG_DIRTY_HR);
+    } else if (!fresh || ext->bpm == 0) {
+        algorithm_drop_external_u8(&g_alg.latest_bpm, ALG_EXT_HR, ALG_DIRTY_HR);
+    }
+    
+    uint8_t spo2_open = g_alg.suspended || g_alg.latest_spo2 == 0 || (g_alg.external_fields & ALG_EXT_SPO2);
+    if (fresh && ext->spo2 > 0 && spo2_open) {
+        algorithm_take_external_u8(&g_alg.latest_spo2, ext->spo2, ALG_EXT_SPO2, ALG_DIRTY_SPO2);
+    } else if (!fresh || ext->spo2 == 0) {
+        algorithm_drop_external_u8(&g_alg.latest_spo2, ALG_EXT_SPO2, ALG_DIRTY_SPO2);
     }
 }
 
 // ==================== 风险评估 ====================
 
 static void algorithm_assess_risk() {
+    // 输入未变化：结果与上次相同
+    if (g_alg.dirty == 0) {
+        g_alg.stats.risk_skipped++;
+        return;
+    }
+    g_alg.dirty = 0;
+    g_alg.stats.risk_evaluations++;
+    
     // 初始化为低风险
     g_alg.risk_level = 0;
     strcpy(g_alg.risk_description, "正常");
@@ -139,7 +359,7 @@ static void algorithm_assess_risk() {
     }
     
     // 因素4：信号质量差
-    if (g_alg.signal_quality < 50) {
+    if (g_alg.signal_quality < ALG_RISK_SNR_MIN) {
         risk_factors++;
     }
     
@@ -156,15 +376,84 @@ static void algorithm_assess_risk() {
     }
 }
 
+// ==================== 统计 ====================
+
+static void algorithm_update_stats(uint32_t exec_us) {
+    AlgorithmManagerStats* st = &g_alg.stats;
+    st->analyses++;
+    g_alg.analysis_total_us += exec_us;
+    st->analysis_avg_us = (uint32_t)(g_alg.analysis_total_us / st->analyses);
+    if (exec_us > st->analysis_max_us) st->analysis_max_us = exec_us;
+    
+    // 结果延迟：最新样本的采样时刻到结果发布
+    uint64_t now_us = timebase_now_us();
+    if (g_alg.newest_sample_us > 0 && now_us > g_alg.newest_sample_us) {
+        uint32_t latency = (uint32_t)(now_us - g_alg.newest_sample_us);
+        st->latency_avg_us = (st->latency_avg_us == 0) ? latency
+                           : (st->latency_avg_us * 7 + latency) / 8;
+        if (latency > st->latency_max_us) st->latency_max_us = latency;
+    }
+    
+    g_alg.rate_window_count++;
+    uint32_t window = g_alg.last_analysis_ms - g_alg.rate_window_start_ms;
+    if (window >= ALG_RATE_WINDOW_MS) {
+        st->analyses_per_sec_x10 = (uint16_t)((g_alg.rate_window_count * 10000UL) / window);
+        g_alg.rate_window_count = 0;
+        g_alg.rate_window_start_ms = g_alg.last_analysis_ms;
+    }
+}
+
 // ==================== 主更新（从调度器调用） ====================
 
+// 重新佩戴后热启动：丢弃离腕前的HR缓冲（保留最近结果），Kalman以最近BPM为初值，TSSD重新统计
+// 基线在本任务中重置（佩戴检测在采集任务中切换状态，不直接触碰HR算法）
+static void algorithm_warm_start() {
+    sample_bus_skip(g_alg.bus_sub);  // 丢弃离腕前积压的样本
+    g_alg.baseline_reset_pending = 0;
+    hr_algorithm_reset_baseline();
+    resampler_reset(&g_alg.resampler);
+    kalman_init(&g_alg.kalman_state, g_alg.latest_bpm > 0 ? g_alg.latest_bpm : 70);
+    tssd_init(&g_alg.tssd_state);
+    g_alg.new_samples = 0;
+}
+
 void algorithm_manager_update() {
-    algorithm_manager_update_hr();  // HR + 运动校正
-    algorithm_update_sno2();        // SnO2 → 丙酮
-    algorithm_assess_risk();        // 风险评估
+    // 离腕：暂停HR算法，保留最近结果；SnO2与检测模块的读数不依赖佩戴，照常取走、合并并重新评估
+    // （SnO2交接队列每次都要取空，否则采集任务的读数被丢弃、丙酮停在离腕前的值）
+    if (!wear_detect_is_on_wrist()) {
+        g_alg.suspended = 1;
+        algorithm_merge_external(millis());
+        algorithm_update_sno2();
+        if (g_alg.dirty) {
+            algorithm_assess_risk();
+            algorithm_publish_result();
+        }
+        return;
+    }
+    if (g_alg.suspended) {
+        g_alg.suspended = 0;
+        algorithm_warm_start();
+    }
     
+    algorithm_ingest_samples();     // 新样本 → 重采样 → HR缓冲
     g_alg.total_updates++;
     g_alg.last_update_ms = millis();
+    
+    if (!algorithm_analysis_due(g_alg.last_update_ms)) {
+        return;
+    }
+    
+    uint32_t start_us = micros();
+    algorithm_merge_external(g_alg.last_update_ms);
+    if (g_alg.new_samples > 0) {
+        algorithm_analyze_hr();     // HR + 运动校正（没有新样本时结果不会变化）
+    }
+    algorithm_update_sno2();        // SnO2 → 丙酮
+    algorithm_assess_risk();        // 风险评估（输入变化时）
+    g_alg.last_analysis_ms = g_alg.last_update_ms;
+    g_alg.new_samples = 0;
+    algorithm_publish_result();
+    algorithm_update_stats(micros() - start_us);
 }
 
 // ==================== 结果查询 ====================
@@ -172,31 +461,58 @@ void algorithm_manager_update() {
 void algorithm_manager_get_result(AlgorithmResult* result) {
     if (result == NULL) return;
     
-    result->timestamp_ms = millis();
-    result->bpm = g_alg.latest_bpm;
-    result->spo2 = g_alg.latest_spo2;
-    result->corrected_bpm = (uint8_t)((g_alg.corrected_bpm / 256) & 0xFF);
-    result->signal_quality = g_alg.signal_quality;
-    result->correlation_quality = g_alg.correlation_quality;
-    result->acetone_ppm = g_alg.acetone_ppm;
+    task_runtime_enter_critical();
+    *result = g_alg.published;
+    task_runtime_exit_critical();
 }
 
 void algorithm_manager_get_risk_assessment(RiskAssessment* risk) {
     if (risk == NULL) return;
     
-    risk->risk_level = g_alg.risk_level;
-    strncpy(risk->risk_description, g_alg.risk_description, sizeof(risk->risk_description) - 1);
-    risk->risk_description[sizeof(risk->risk_description) - 1] = '\0';
+    task_runtime_enter_critical();
+    *risk = g_alg.published_risk;
+    task_runtime_exit_critical();
 }
 
 uint8_t algorithm_manager_has_valid_result() {
-    return (g_alg.latest_bpm > 0 || g_alg.latest_spo2 > 0) ? 1 : 0;
+    task_runtime_enter_critical();
+    uint8_t valid = (g_alg.published.bpm > 0 || g_alg.published.spo2 > 0) ? 1 : 0;
+    task_runtime_exit_critical();
+    return valid;
+}
+
+void algorithm_manager_submit_external(const ExternalReading* reading) {
+    if (reading == NULL) return;
+    
+    task_runtime_enter_critical();
+    g_alg.external_inbox = *reading;
+    g_alg.external_pending = 1;
+    task_runtime_exit_critical();
+}
+
+void algorithm_manager_get_stats(AlgorithmManagerStats* stats) {
+    if (stats) *stats = g_alg.stats;
 }
 
 void algorithm_manager_print_stats() {
 #ifdef DEBUG_MODE
-    Serial.printf("\n[ALG] BPM:%u SpO2:%u Acetone:%.1f RiskLevel:%u (%s)\n",
+    Serial.printf("\n[ALG] BPM:%u SpO2:%u Acetone:%.1f RiskLevel:%u (%s) 检测模块:%s%s%s 合并:%lu\n",
         g_alg.latest_bpm, g_alg.latest_spo2, g_alg.acetone_ppm,
-        g_alg.risk_level, g_alg.risk_description);
+        g_alg.risk_level, g_alg.risk_description,
+        (g_alg.external_fields & ALG_EXT_HR) ? "HR " : "",
+        (g_alg.external_fields & ALG_EXT_SPO2) ? "SpO2 " : "",
+        (g_alg.external_fields & ALG_EXT_ACETONE) ? "丙酮" : (g_alg.external_fields ? "" : "-"),
+        g_alg.stats.external_merges);
+    
+    ResamplerStats rs;
+    resampler_get_stats(&g_alg.resampler, &rs);
+    Serial.printf("[ALG] 重采样 in:%lu out:%lu gaps:%lu dropped:%lu max_interval:%luus\n",
+        rs.inputs, rs.outputs, rs.gaps, rs.dropped, rs.max_interval_us);
+    
+    const AlgorithmManagerStats* st = &g_alg.stats;
+    Serial.printf("[ALG] 分析 %lu次 (%u.%u/s, avg:%luus max:%luus) 风险 评估:%lu 跳过:%lu | 延迟 avg:%lums max:%lums\n",
+        st->analyses, st->analyses_per_sec_x10 / 10, st->analyses_per_sec_x10 % 10,
+        st->analysis_avg_us, st->analysis_max_us, st->risk_evaluations, st->risk_skipped,
+        st->latency_avg_us / 1000, st->latency_max_us / 1000);
 #endif
 }
\ No newline at end of file
@@ -3,26 +3,76 @@
 
 #include <Arduino.h>
 
+// 分析节拍：样本逐个摄入（重采样 → HR缓冲），BPM/SpO2/风险只在跳步到期
+// 或自上次分析以来新样本足够多时计算（可通过 build_flags 覆盖）
+#ifndef ALG_ANALYSIS_HOP_MS
+#define ALG_ANALYSIS_HOP_MS          500
+#endif
+#ifndef ALG_ANALYSIS_MIN_NEW_SAMPLES
+#define ALG_ANALYSIS_MIN_NEW_SAMPLES 50      // 0.5秒 @100Hz
+#endif
+#define ALG_RATE_WINDOW_MS           10000   // 每秒计算次数的统计窗口
+
+// 外部读数（检测模块经BLE送来，见 detector_link_final.h）超过此时间未更新则不再采用
+// （检测模块一轮 心率30s → 加热60s → 丙酮5s，约95秒通知一次）
+#ifndef ALG_EXTERNAL_MAX_AGE_MS
+#define ALG_EXTERNAL_MAX_AGE_MS      180000
+#endif
+
+// AlgorithmResult.external：该项当前取自检测模块
+#define ALG_EXT_HR                   0x01
+#define ALG_EXT_SPO2                 0x02
+#define ALG_EXT_ACETONE              0x04
+
 typedef struct {
-    uint32_t timestamp_ms;
+    uint32_t timestamp_ms;           // 产生该结果的分析时刻
     uint8_t bpm;
     uint8_t spo2;
     uint8_t corrected_bpm;
     uint8_t signal_quality;
     uint8_t correlation_quality;
     float acetone_ppm;
+    uint8_t external;                // ALG_EXT_*
 } AlgorithmResult;
 
+// 检测模块的一份读数（无效项为0 / acetone_valid=0）
+typedef struct {
+    uint32_t received_ms;            // 最近一次收到通知的时刻
+    uint8_t bpm;
+    uint8_t spo2;
+    uint8_t acetone_valid;
+    float acetone_ppm;
+    uint8_t error_code;              // 检测模块错误码（仅供显示，无效项已由链路层清除）
+} ExternalReading;
+
 typedef struct {
     uint8_t risk_level;  // 0:低 1:中 2:高
     char risk_description[32];
 } RiskAssessment;
 
+typedef struct {
+    uint32_t ingested_samples;       // 送入HR算法的网格样本
+    uint32_t analyses;               // BPM/SpO2 计算次数
+    uint32_t risk_evaluations;
+    uint32_t risk_skipped;           // 输入未变化而跳过的风险评估
+    uint32_t external_merges;        // 合并的检测模块读数
+    uint16_t analyses_per_sec_x10;   // 最近统计窗口内每秒分析次数 ×10
+    uint32_t analysis_avg_us;        // 单次分析耗时
+    uint32_t analysis_max_us;
+    uint32_t latency_avg_us;         // 最新样本时间戳 → 结果发布（指数平均 1/8）
+    uint32_t latency_max_us;
+} AlgorithmManagerStats;
+
 void algorithm_manager_init();
 void algorithm_manager_update();
 void algorithm_manager_get_result(AlgorithmResult* result);
 void algorithm_manager_get_risk_assessment(RiskAssessment* risk);
 uint8_t algorithm_manager_has_valid_result();
+
+// 投递检测模块读数（通信任务调用）：替换尚未合并的上一份，DSP任务下次更新时合并。
+// 丙酮以检测模块为准；心率/血氧以本机PPG为准，本机没有结果或离腕时才采用检测模块的读数
+void algorithm_manager_submit_external(const ExternalReading* reading);
+void algorithm_manager_get_stats(AlgorithmManagerStats* stats);
 void algorithm_manager_print_stats();
 
 #endif
\ No newline at end of file
@@ -1,7 +1,9 @@
 /*
  * ble_peripheral_final.cpp - BLE主从通信（最终版）
  * 
- * 数据格式（用户指定）：
+ * 默认负载为二进制遥测帧（telemetry_packet.h，全字段16字节，一次通知发完，无堆分配）。
+ * 
+ * 兼容模式 BLE_PAYLOAD_JSON（MIT App Inventor APP，用户指定格式）：
  * {
  *   "hr": 85,
  *   "spo2": 97,
@@ -13,6 +15,30 @@
  * }
  * 
  * 使用NimBLE库实现ESP32-S3 BLE Server
+ * 
+ * 链路：声明期望 MTU 247，连接后请求 LE Data Length Extension 与 2M PHY；
+ * 负载按 MTU-3 切块进入发送队列（ble_tx_queue_final），协议栈空闲缓冲（mbuf）低于保留数时暂停发送，
+ * 队列满时生产者下次再发（背压），不再用固定微秒间隔盲发。波形流/历史的保留数高于遥测，缓冲紧张时先让出。
+ * 
+ * 原始PPG波形流（可选）：中心订阅 PPG_CHAR_UUID 后，通信任务从样本总线读取 100Hz 红光/红外，
+ * 按连接间隔攒批，残差 varint 压缩（ppg_stream_packet.h）后经独立的发送队列推送；取消订阅即释放总线游标。
+ * 
+ * 离线历史：未连接时遥测帧写入 Flash 环形日志（history_log_final），重连后中心经历史特征值
+ * 按序号游标拉取，每次通知装满 MTU-3 字节并连续发送（不受4秒通知周期限制），实时通知照常进行；
+ * MTU 装不下一条记录时等待 MTU 交换，超时回复拒绝帧（HISTORY_FRAME_REJECT）。
+ * 
+ * 分字段特征值：HR、SpO2、丙酮、电量、风险、佩戴各一个（读 + 通知，值格式与检测端固件一致），
+ * 汇总特征值（CHAR_UUID）保留完整遥测帧/JSON。各特征值只在值变化超过死区（BLE_DEADBAND_*）时通知，
+ * 最长 BLE_NOTIFY_KEEPALIVE_MS 保活一次；手机只订阅关心的指标即可。
+ * 
+ * 连接参数按用途分档（BleConnProfile）：空闲摘要用长间隔 + 从机延迟，波形流用短间隔，历史批量用最短间隔；
+ * 通信任务按当前需求经连接参数更新过程请求，需求下降时延迟降档。各档位按生效参数估算连接事件与空中字节能耗，
+ * 统计每字节能耗。遥测通知按需发送：结果不变时只按保活周期发送。
+ * 
+ * 广播模式（BleLinkMode）：最新结果编码为遥测帧放入厂商数据（公司ID + 帧），每个新结果刷新一次，
+ * 任意数量的扫描者无需连接即可读取。默认传统广播（31字节：flags + 厂商数据，名称在扫描响应中）；
+ * 开启 CONFIG_BT_NIMBLE_EXT_ADV 时另开一个不可连接的扩展广播实例（名称、服务UUID与厂商数据同在一个PDU，
+ * 连接期间照常广播），GATT 仍使用传统可连接广播实例。
  */
 
 #include <Arduino.h>
@@ -20,15 +46,75 @@
 #include <NimBLEServer.h>
 #include <NimBLEUtils.h>
 #include <NimBLE2902.h>
-#include <ArduinoJson.h>
+#include "../config/ble_config.h"
+#include "../config/system_config.h"
 #include "ble_peripheral_final.h"
+#include "ble_tx_queue_final.h"
+#include "telemetry_packet.h"
+#include "ppg_stream_packet.h"
+#include "json_writer.h"
+#include "sample_bus_final.h"
+#include "history_log_final.h"
+#include "task_runtime_final.h"
 #include "algorithm_manager_final.h"
 #include "sensor_collector_final.h"
+#include "../algorithm/wear_detect.h"
 
 // ==================== BLE GATT定义 ====================
 
 #define SERVICE_UUID        "a1b2c3d4-e5f6-4789-abcd-ef0123456789"
 #define CHAR_UUID           "a1b2c3d4-e5f6-4789-abcd-ef012345678a"
+#define PPG_CHAR_UUID       "a1b2c3d4-e5f6-4789-abcd-ef0123456796"  // …678b~678e 为检测模块的特征值，不可复用
+#define HISTORY_CHAR_UUID   "a1b2c3d4-e5f6-4789-abcd-ef0123456797"
+#define HR_CHAR_UUID        "a1b2c3d4-e5f6-4789-abcd-ef0123456790"
+#define SPO2_CHAR_UUID      "a1b2c3d4-e5f6-4789-abcd-ef0123456791"
+#define ACETONE_CHAR_UUID   "a1b2c3d4-e5f6-4789-abcd-ef0123456792"
+#define BATTERY_CHAR_UUID   "a1b2c3d4-e5f6-4789-abcd-ef0123456793"
+#define RISK_CHAR_UUID      "a1b2c3d4-e5f6-4789-abcd-ef0123456794"
+#define WEAR_CHAR_UUID      "a1b2c3d4-e5f6-4789-abcd-ef0123456795"
+#define BLE_FIELD_CHAR_COUNT 6
+
+// 历史同步协议（历史特征值，小端）：
+//   中心写入  [0x01][起始序号 u32]            从该序号拉取到最新（0 = 从最旧开始）
+//             [0x02]                          停止
+//   设备通知  [0x01][条数][首序号 u32][上电编号 u32][遥测帧…]  序号连续、同一次上电的记录（遥测帧按字段位图自定界）
+//             [0x02][最旧 u32][下一序号 u32][上电编号 u32][运行秒数 u32]
+//                                             本次拉取结束；起始序号超过下一序号说明日志已重建，中心应重置游标
+//   读取值    [最旧 u32][下一序号 u32][上电编号 u32][运行秒数 u32]
+// 中心保存"最后收到的序号 + 1"，断开后从该处续传。
+// 记录的时间戳是所属上电以来的秒数：上电编号等于当前编号的记录，墙上时间 = 收到结束帧/读取值的时刻
+// - (运行秒数 - 时间戳)；之前上电的记录只能按上电编号与序号排序（见 history_log_final.h）
+#define HISTORY_OP_PULL         0x01
+#define HISTORY_OP_STOP         0x02
+#define HISTORY_FRAME_RECORDS   0x01
+#define HISTORY_FRAME_END       0x02
+#define HISTORY_FRAME_REJECT    0x03    // MTU 装不下一条记录：[0x03][所需ATT MTU u16]
+#define HISTORY_FRAME_HEADER    10
+#define HISTORY_END_LEN         17
+#define HISTORY_RANGE_LEN       16
+#define HISTORY_MIN_ATT_MTU     (HISTORY_FRAME_HEADER + TELEMETRY_MAX_LEN + BLE_ATT_NOTIFY_OVERHEAD)
+
+#if defined(CONFIG_BT_NIMBLE_EXT_ADV) && CONFIG_BT_NIMBLE_EXT_ADV
+#define BLE_USE_EXT_ADV         1
+#define BLE_ADV_INST_GATT       0
+#define BLE_ADV_INST_BROADCAST  1
+#else
+#define BLE_USE_EXT_ADV         0
+#endif
+
+// AD 类型
+#define BLE_AD_FLAGS            0x01
+#define BLE_AD_UUID128_COMPLETE 0x07
+#define BLE_AD_NAME_COMPLETE    0x09
+#define BLE_AD_SLAVE_ITVL_RANGE 0x12
+#define BLE_AD_MANUFACTURER     0xFF
+#define BLE_AD_FLAGS_GENERAL    0x06    // 一般可发现 + 不支持 BR/EDR
+
+#define BLE_JSON_BUF_LEN    192     // JSON兼容模式的序列化缓冲（栈上）
+
+#if defined(ESP32)
+extern "C" int os_msys_num_free(void);   // NimBLE 协议栈空闲 mbuf 数
+#endif
 
 // ==================== 全局BLE状态 ====================
 
@@ -38,37 +124,215 @@ typedef struct {
     NimBLECharacteristic* characteristic;
     
     uint8_t is_connected;
+    volatile uint8_t session_reset_pending;   // 已断开，通信任务清空发送队列与会话状态
+    volatile uint8_t conn_start_pending;      // 新连接，通信任务开始能耗统计并请求连接参数
+    uint16_t conn_handle;
     uint32_t last_notify_ms;
     uint32_t notify_interval_ms;
+    TelemetryFrame last_frame;                // 最近发出的汇总（判断结果是否变化）
+    uint32_t notify_skipped;
+    uint32_t last_skip_ms;
+    
+    // 分字段特征值
+    NimBLECharacteristic* field_characteristics[BLE_FIELD_CHAR_COUNT];
+    TelemetryFrame field_sent;                // 各特征值最近通知的值（按字段位）
+    uint8_t field_sent_mask;                  // 本次连接已通知过的字段
+    uint32_t field_sent_ms[BLE_FIELD_CHAR_COUNT];
+    uint32_t field_check_ms;
+    uint32_t field_notifications;
+    uint32_t field_suppressed;
+    
+    // 连接参数管理
+    BleConnProfile conn_profile;              // 已请求的档位
+    uint8_t conn_retries;
+    uint16_t conn_itvl;                       // 生效的间隔（1.25ms 单位）
+    uint16_t conn_latency;
+    uint32_t conn_request_ms;
+    uint32_t conn_demand_drop_ms;             // 需求下降的时刻（0 = 未下降）
+    uint32_t conn_param_requests;
+    uint32_t energy_last_ms;
+    uint32_t energy_bytes_mark;               // 各队列累计发送字节的上次读数
+    uint64_t energy_nj[BLE_CONN_PROFILE_COUNT];
+    uint64_t energy_events_x1000[BLE_CONN_PROFILE_COUNT];
+    BleConnEnergy energy[BLE_CONN_PROFILE_COUNT];
     
     uint32_t total_notifications;
     uint32_t total_bytes_sent;
     
+    BlePayloadFormat payload_format;
+    uint16_t last_payload_len;
+    
+    // 链路参数
+    uint16_t att_mtu;
+    uint16_t dle_tx_octets;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint32_t fragmented_payloads;
+    uint32_t json_overflows;
+    
+    // 发送队列（按协议栈缓冲限流）
+    BleTxQueue tx;
+    volatile uint8_t in_notify;      // notify() 调用期间（同步回调的错误归属本次发送）
+    volatile int notify_rc;
+    
+    // 原始PPG波形流
+    NimBLECharacteristic* ppg_characteristic;
+    BleTxQueue ppg_tx;
+    volatile uint8_t ppg_requested;  // 中心已订阅（回调中设置，通信任务据此订阅样本总线）
+    uint8_t ppg_bus_sub;             // SAMPLE_BUS_INVALID_SUB = 未在推流
+    uint16_t conn_interval_ms;
+    uint8_t ppg_batch_target;
+    PpgStreamEncoder ppg_enc;
+    uint32_t ppg_batches;
+    uint32_t ppg_samples;
+    uint32_t ppg_bytes;
+    uint32_t ppg_stalls;
+    uint32_t ppg_discarded;          // 编码期间样本被覆盖而作废的帧
+    uint32_t ppg_order2_batches;
+    
+    // 离线历史同步
+    NimBLECharacteristic* history_characteristic;
+    uint8_t history_range[HISTORY_RANGE_LEN - 4];   // 读取值的序号范围与上电编号（读取时补运行秒数）
+    BleTxQueue history_tx;
+    volatile uint8_t history_request;         // HISTORY_OP_*（回调设置，通信任务处理）
+    volatile uint32_t history_request_seq;
+    uint8_t history_active;
+    uint32_t history_cursor;                  // 下一条要发送的序号
+    uint32_t history_started_ms;
+    uint32_t last_history_ms;                 // 离线记录的周期
+    uint32_t history_records_logged;
+    uint32_t history_records_sent;
+    uint32_t history_syncs;
+    uint32_t history_last_sync_ms;            // 最近一次拉取的耗时
+    uint32_t history_last_sync_records;
+    
+    // 广播模式
+    BleLinkMode mode;
+    volatile uint8_t adv_dirty;               // 连接状态/模式变化，通信任务重新配置广播
+    uint8_t adv_custom;                       // 已改用自定义广播数据（传统广播）
+    uint8_t broadcast_frame[TELEMETRY_MAX_LEN];
+    uint8_t broadcast_len;
+    uint32_t broadcast_result_ms;             // 当前广播负载对应的分析时刻
+    uint32_t broadcast_refresh_ms;
+    uint32_t broadcast_updates;
+    
     // 风险评估数据
     uint8_t risk_level;
     char risk_desc[32];
+    
+    // 已通知的佩戴状态（状态变化时只发送一次）
+    uint8_t wear_state_sent;
 } BlePeripheralState;
 
 static BlePeripheralState g_ble = {0};
 
+static int ble_tx_send_notify(const uint8_t* data, uint16_t len);
+static int ble_ppg_send_notify(const uint8_t* data, uint16_t len);
+static int ble_history_send_notify(const uint8_t* data, uint16_t len);
+static void ble_history_update_range();
+static void put_u32(uint8_t* out, uint32_t v);
+static void ble_adv_apply();
+static void ble_conn_request(BleConnProfile profile, uint32_t now_ms);
+static void ble_conn_start(uint32_t now_ms);
+static const char* ble_mode_name(BleLinkMode mode);
+
 // ==================== BLE回调 ====================
 
+// 通知的发送结果：notify() 内同步报告的错误记为本次发送失败
+// （SUCCESS_NOTIFY 同样在 notify() 内同步上报，只表示已交给协议栈，流控见 ble_tx_queue_final.h）
+class TxStatusCallbacks : public NimBLECharacteristicCallbacks {
+public:
+    void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) {
+        if (s != SUCCESS_NOTIFY && g_ble.in_notify) {
+            g_ble.notify_rc = code ? code : -1;
+        }
+    }
+};
+
+// 波形流特征值：CCCD 写入只记录请求，总线订阅在通信任务中进行
+class PpgStreamCallbacks : public TxStatusCallbacks {
+public:
+    void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue) {
+        g_ble.ppg_requested = (subValue & 0x0001) ? 1 : 0;
+#ifdef DEBUG_MODE
+        Serial.printf("[BLE] PPG波形流: %s\n", g_ble.ppg_requested ? "订阅" : "取消");
+#endif
+    }
+};
+
+// 历史特征值：写入的拉取/停止请求交给通信任务
+class HistoryCallbacks : public TxStatusCallbacks {
+public:
+    void onWrite(NimBLECharacteristic* pCharacteristic) {
+        std::string value = pCharacteristic->getValue();
+        const uint8_t* req = (const uint8_t*)value.data();
+        if (value.length() >= 5 && req[0] == HISTORY_OP_PULL) {
+            g_ble.history_request_seq = (uint32_t)req[1] | ((uint32_t)req[2] << 8) |
+                                        ((uint32_t)req[3] << 16) | ((uint32_t)req[4] << 24);
+            g_ble.history_request = HISTORY_OP_PULL;
+        } else if (value.length() >= 1 && req[0] == HISTORY_OP_STOP) {
+            g_ble.history_request = HISTORY_OP_STOP;
+        }
+    }
+    
+    // 读取值在读取时生成：范围由通信任务更新（ble_history_update_range），这里只补当前运行秒数
+    void onRead(NimBLECharacteristic* pCharacteristic) {
+        uint8_t range[HISTORY_RANGE_LEN];
+        task_runtime_enter_critical();
+        memcpy(range, g_ble.history_range, sizeof(g_ble.history_range));
+        task_runtime_exit_critical();
+        put_u32(range + sizeof(g_ble.history_range), millis() / 1000);
+        pCharacteristic->setValue(range, sizeof(range));
+    }
+};
+
 class MyServerCallbacks : public NimBLEServerCallbacks {
+    // NimBLE 主机任务上下文：只记录连接与中心选的初始参数，连接参数请求与能耗统计归通信任务，
+    // 由 ble_peripheral_poll() 执行（同 onDisconnect → session_reset_pending）
     void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+        g_ble.conn_handle = desc->conn_handle;
+        g_ble.conn_itvl = desc->conn_itvl;
+        g_ble.conn_latency = desc->conn_latency;
+        g_ble.conn_interval_ms = desc->conn_itvl * 5 / 4;  // 1.25ms 单位
+        g_ble.conn_start_pending = 1;
         g_ble.is_connected = 1;
+        g_ble.att_mtu = BLE_DEFAULT_ATT_MTU;  // 中心发起MTU交换前按默认值发送
+        g_ble.tx_phy = 0;
+        g_ble.rx_phy = 0;
         Serial.println("[BLE] 连接成功");
+        g_ble.adv_dirty = 1;  // 同时广播时改为不可连接广播
         
-        // 更新连接参数（降低延迟）
-        pServer->updateConnParams(desc->conn_handle, 40, 80, 0, 400);
+        // 链路层大包：一个连接事件内发完一次通知
+        pServer->setDataLen(desc->conn_handle, BLE_DLE_TX_OCTETS);
+        g_ble.dle_tx_octets = BLE_DLE_TX_OCTETS;
+        
+#if BLE_PREFER_2M_PHY
+        // 中心不支持 2M 时控制器保持 1M
+        ble_gap_set_prefered_le_phy(desc->conn_handle, BLE_GAP_LE_PHY_2M_MASK,
+                                    BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+#endif
     }
     
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+        g_ble.att_mtu = MTU;
+#ifdef DEBUG_MODE
+        Serial.printf("[BLE] MTU协商: %u（单次通知 %u 字节）\n", MTU, MTU - BLE_ATT_NOTIFY_OVERHEAD);
+#endif
+    }
+    
+    // NimBLE 主机任务上下文：发送队列与通知状态归通信任务所有，这里只置标志，
+    // 由 ble_peripheral_poll() 清理（同 ppg_requested → ble_ppg_update_subscription）
     void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
         g_ble.is_connected = 0;
+        g_ble.att_mtu = BLE_DEFAULT_ATT_MTU;
+        g_ble.dle_tx_octets = 0;
+        g_ble.ppg_requested = 0;         // 总线游标由通信任务释放
+        g_ble.history_request = HISTORY_OP_STOP;
+        g_ble.session_reset_pending = 1;
         Serial.println("[BLE] 连接断开，重启广播");
         
-        // 重启广播
-        NimBLEAdvertising* pAdvertising = pServer->getAdvertising();
-        pAdvertising->start();
+        // 由通信任务按当前模式重启广播
+        g_ble.adv_dirty = 1;
     }
 };
 
@@ -77,6 +341,9 @@ class MyServerCallbacks : public NimBLEServerCallbacks {
 void ble_peripheral_init() {
     NimBLEDevice::init(BLE_DEVICE_NAME);
     
+    // 期望的ATT MTU（在中心发起交换时回应）
+    NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+    
     // 创建Server
     g_ble.server = NimBLEDevice::createServer();
     g_ble.server->setCallbacks(new MyServerCallbacks());
@@ -92,35 +359,405 @@ void ble_peripheral_init() {
     
     // 添加CCCD（Client Characteristic Configuration Descriptor）
     g_ble.characteristic->addDescriptor(new NimBLE2902());
+    g_ble.characteristic->setCallbacks(new TxStatusCallbacks());
+    
+    // 原始PPG波形流（仅通知，订阅后才推送）
+    g_ble.ppg_characteristic = g_ble.service->createCharacteristic(
+        PPG_CHAR_UUID,
+        NIMBLE_PROPERTY::NOTIFY
+    );
+    g_ble.ppg_characteristic->addDescriptor(new NimBLE2902());
+    g_ble.ppg_characteristic->setCallbacks(new PpgStreamCallbacks());
+    
+    // 离线历史（读：记录范围；写：拉取请求；通知：记录批）
+    g_ble.history_characteristic = g_ble.service->createCharacteristic(
+        HISTORY_CHAR_UUID,
+        NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY
+    );
+    g_ble.history_characteristic->addDescriptor(new NimBLE2902());
+    g_ble.history_characteristic->setCallbacks(new HistoryCallbacks());
+    
+    // 分字段特征值（读 + 通知）
+    static const char* const field_uuids[BLE_FIELD_CHAR_COUNT] = {
+        HR_CHAR_UUID, SPO2_CHAR_UUID, ACETONE_CHAR_UUID, BATTERY_CHAR_UUID, RISK_CHAR_UUID, WEAR_CHAR_UUID
+    };
+    for (uint8_t i = 0; i < BLE_FIELD_CHAR_COUNT; i++) {
+        g_ble.field_characteristics[i] = g_ble.service->createCharacteristic(
+            field_uuids[i],
+            NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
+        );
+        g_ble.field_characteristics[i]->addDescriptor(new NimBLE2902());
+        g_ble.field_characteristics[i]->setCallbacks(new TxStatusCallbacks());
+    }
     
     // 启动Service
     g_ble.service->start();
     
-    // 配置广播
-    NimBLEAdvertising* pAdvertising = g_ble.server->getAdvertising();
-    pAdvertising->addServiceUUID(SERVICE_UUID);
-    pAdvertising->setScanResponse(true);
-    pAdvertising->setMinPreferred(0x06);
-    pAdvertising->setMaxPreferred(0x12);
-    pAdvertising->start();
-    
     g_ble.last_notify_ms = millis();
     g_ble.notify_interval_ms = 4000;  // 4秒通知一次
     g_ble.is_connected = 0;
+    g_ble.payload_format = BLE_PAYLOAD_DEFAULT;
+    g_ble.att_mtu = BLE_DEFAULT_ATT_MTU;
+    ble_tx_init(&g_ble.tx, ble_tx_send_notify);
+    ble_tx_init(&g_ble.ppg_tx, ble_ppg_send_notify);
+    g_ble.ppg_bus_sub = SAMPLE_BUS_INVALID_SUB;
+    ble_tx_init(&g_ble.history_tx, ble_history_send_notify);
+    history_log_init();
+    ble_history_update_range();
+    
+    // 配置广播
+    g_ble.mode = BLE_MODE_DEFAULT;
+    ble_adv_apply();
     
     Serial.println("[BLE] Peripheral初始化完成");
     Serial.printf("    Service UUID: %s\n", SERVICE_UUID);
     Serial.printf("    Device Name: %s\n", BLE_DEVICE_NAME);
+    Serial.printf("    Payload: %s\n", g_ble.payload_format == BLE_PAYLOAD_JSON ? "JSON" : "binary v1");
+    Serial.printf("    Mode: %s (%s advertising)\n", ble_mode_name(g_ble.mode), BLE_USE_EXT_ADV ? "extended" : "legacy");
+}
+
+// ==================== 通知发送 ====================
+
+static uint16_t ble_max_notify_len() {
+    return g_ble.att_mtu - BLE_ATT_NOTIFY_OVERHEAD;
+}
+
+// 发送队列的发送函数：协议栈空闲缓冲低于 min_free_mbufs 时不调用 notify()
+// （mbuf 在控制器发出数据包后才释放，空闲数即反映在途数据量）
+static int ble_notify_characteristic(NimBLECharacteristic* characteristic, const uint8_t* data, uint16_t len,
+                                     int min_free_mbufs) {
+#if defined(ESP32)
+    if (os_msys_num_free() < min_free_mbufs) {
+        return BLE_TX_SEND_BUSY;
+    }
+#endif
+    g_ble.notify_rc = 0;
+    g_ble.in_notify = 1;
+    characteristic->setValue(data, len);
+    characteristic->notify();
+    g_ble.in_notify = 0;
+    return g_ble.notify_rc;
+}
+
+static int ble_tx_send_notify(const uint8_t* data, uint16_t len) {
+    return ble_notify_characteristic(g_ble.characteristic, data, len, BLE_TX_MIN_FREE_MBUFS);
+}
+
+static int ble_ppg_send_notify(const uint8_t* data, uint16_t len) {
+    return ble_notify_characteristic(g_ble.ppg_characteristic, data, len, BLE_PPG_TX_MIN_FREE_MBUFS);
 }
 
-// ==================== 数据发送（JSON格式） ====================
+static int ble_history_send_notify(const uint8_t* data, uint16_t len) {
+    return ble_notify_characteristic(g_ble.history_characteristic, data, len, BLE_HISTORY_TX_MIN_FREE_MBUFS);
+}
+
+// 负载入队：不超过 MTU-3 为一块，否则按当前上限切块（协商前的默认 MTU 下的 JSON 兼容模式）；
+// 队列放不下返回0，调用方保留数据下次再发；空负载（编码失败）同样返回0，不计为已发送
+static uint8_t ble_notify_payload(const uint8_t* bytes, uint16_t len) {
+    const uint16_t max_chunk = ble_max_notify_len();
+    
+    if (len == 0) {
+        return 0;
+    }
+    if (!ble_tx_enqueue(&g_ble.tx, bytes, len, max_chunk)) {
+        return 0;
+    }
+    if (len > max_chunk) {
+        g_ble.fragmented_payloads++;
+    }
+    
+    g_ble.total_notifications++;
+    g_ble.total_bytes_sent += len;
+    g_ble.last_payload_len = len;
+    
+    ble_tx_pump(&g_ble.tx, millis());
+    return 1;
+}
+
+// 读取当前连接的 PHY（PHY 更新事件未经 NimBLE 1.4 的服务器回调转发，查询时读取）
+static void ble_refresh_phy() {
+    if (!g_ble.is_connected) return;
+    uint8_t tx_phy = 0, rx_phy = 0;
+    if (ble_gap_read_le_phy(g_ble.conn_handle, &tx_phy, &rx_phy) == 0) {
+        g_ble.tx_phy = tx_phy;
+        g_ble.rx_phy = rx_phy;
+    }
+}
+
+// ==================== 佩戴状态变化 ====================
+
+// 离腕/重新佩戴时发送一次：二进制模式为只含 WEAR 字段的帧，
+// JSON 模式为 {"wear":"off"} / {"wear":"on"}；离腕期间不再推送测量数据
+// 返回1表示当前离腕或状态变化未能入队（调用方跳过数据推送）
+static uint8_t ble_handle_wear_state(uint32_t now_ms) {
+    uint8_t state = (uint8_t)wear_detect_get_state();
+    if (state != g_ble.wear_state_sent) {
+        uint8_t queued;
+        if (g_ble.payload_format == BLE_PAYLOAD_BINARY) {
+            TelemetryFrame frame = {0};
+            frame.fields = TELEMETRY_FIELD_WEAR;
+            frame.timestamp_s = now_ms / 1000;
+            frame.wear = state;
+            uint8_t packet[TELEMETRY_MAX_LEN];
+            uint8_t len = telemetry_encode(&frame, packet, sizeof(packet));
+            queued = ble_notify_payload(packet, len);
+        } else {
+            char msg[24];
+            int len = snprintf(msg, sizeof(msg), "{\"wear\":\"%s\"}",
+                               (state == WEAR_STATE_OFF_WRIST) ? "off" : "on");
+            queued = ble_notify_payload((const uint8_t*)msg, (uint16_t)len);
+        }
+        if (!queued) {
+            return 1;  // 队列满：状态未记为已发送，下次再发（期间不推送数据）
+        }
+        g_ble.wear_state_sent = state;
+        g_ble.last_notify_ms = now_ms;
+        
+#ifdef DEBUG_MODE
+        Serial.printf("[BLE] 佩戴状态: %s\n", (state == WEAR_STATE_OFF_WRIST) ? "off" : "on");
+#endif
+    }
+    return (state == WEAR_STATE_OFF_WRIST) ? 1 : 0;
+}
+
+// ==================== 数据发送 ====================
+
+// 遥测字段：未得出的 HR/SpO2 不置位，其余字段总是携带
+static void ble_fill_telemetry(const AlgorithmResult* alg, const RiskAssessment* risk, uint8_t battery_pct,
+                               uint8_t wear, uint32_t now_ms, TelemetryFrame* frame) {
+    memset(frame, 0, sizeof(TelemetryFrame));
+    frame->fields = TELEMETRY_FIELD_ACETONE | TELEMETRY_FIELD_BATTERY | TELEMETRY_FIELD_SNR |
+                    TELEMETRY_FIELD_RISK | TELEMETRY_FIELD_WEAR;
+    frame->timestamp_s = now_ms / 1000;
+    if (alg->bpm > 0) {
+        frame->fields |= TELEMETRY_FIELD_HR;
+        frame->hr_bpm = alg->bpm;
+    }
+    if (alg->spo2 > 0) {
+        frame->fields |= TELEMETRY_FIELD_SPO2;
+        frame->spo2 = alg->spo2;
+    }
+    frame->acetone_x10 = telemetry_scale_acetone(alg->acetone_ppm);
+    frame->battery_pct = battery_pct;
+    frame->snr = alg->signal_quality;
+    frame->risk = risk->risk_level;
+    frame->wear = wear;
+}
+
+static uint16_t ble_build_telemetry(const AlgorithmResult* alg, const RiskAssessment* risk, uint8_t battery_pct,
+                                    uint8_t wear, uint32_t now_ms, uint8_t* out, uint8_t capacity) {
+    TelemetryFrame frame;
+    ble_fill_telemetry(alg, risk, battery_pct, wear, now_ms, &frame);
+    return telemetry_encode(&frame, out, capacity);
+}
+
+// ==================== 变化死区 ====================
+
+static int32_t telemetry_field_value(const TelemetryFrame* f, uint8_t field) {
+    switch (field) {
+        case TELEMETRY_FIELD_HR:      return f->hr_bpm;
+        case TELEMETRY_FIELD_SPO2:    return f->spo2;
+        case TELEMETRY_FIELD_ACETONE: return f->acetone_x10;
+        case TELEMETRY_FIELD_BATTERY: return f->battery_pct;
+        case TELEMETRY_FIELD_SNR:     return f->snr;
+        case TELEMETRY_FIELD_RISK:    return f->risk;
+        case TELEMETRY_FIELD_WEAR:    return f->wear;
+        default:                      return 0;
+    }
+}
+
+static uint16_t telemetry_field_deadband(uint8_t field) {
+    switch (field) {
+        case TELEMETRY_FIELD_HR:      return BLE_DEADBAND_HR;
+        case TELEMETRY_FIELD_SPO2:    return BLE_DEADBAND_SPO2;
+        case TELEMETRY_FIELD_ACETONE: return BLE_DEADBAND_ACETONE;
+        case TELEMETRY_FIELD_BATTERY: return BLE_DEADBAND_BATTERY;
+        case TELEMETRY_FIELD_SNR:     return BLE_DEADBAND_SNR;
+        default:                      return 0;
+    }
+}
+
+// 字段相对参考值是否越过死区（出现/消失总算变化）
+static uint8_t telemetry_field_changed(const TelemetryFrame* now, const TelemetryFrame* ref, uint8_t field) {
+    uint8_t present = (now->fields & field) ? 1 : 0;
+    if (present != ((ref->fields & field) ? 1 : 0)) return 1;
+    if (!present) return 0;
+    int32_t delta = telemetry_field_value(now, field) - telemetry_field_value(ref, field);
+    if (delta < 0) delta = -delta;
+    return delta > (int32_t)telemetry_field_deadband(field);
+}
+
+static uint8_t telemetry_frame_changed(const TelemetryFrame* now, const TelemetryFrame* ref) {
+    for (uint8_t field = TELEMETRY_FIELD_HR; field & TELEMETRY_FIELD_ALL; field <<= 1) {
+        if (telemetry_field_changed(now, ref, field)) return 1;
+    }
+    return 0;
+}
+
+// JSON兼容模式（字段与APP约定一致），流式写入栈上缓冲；丙酮保留1位小数（与遥测帧精度相同）
+static uint16_t ble_build_json(const AlgorithmResult* alg, const RiskAssessment* risk,
+                               uint8_t battery_pct, uint32_t now_ms, char* out, uint16_t capacity) {
+    JsonWriter w;
+    json_begin(&w, out, capacity);
+    json_key(&w, JSON_KEY("hr"));         json_uint(&w, alg->bpm);
+    json_key(&w, JSON_KEY("spo2"));       json_uint(&w, alg->spo2);
+    json_key(&w, JSON_KEY("acetone"));    json_fixed(&w, telemetry_scale_acetone(alg->acetone_ppm), 1);
+    json_key(&w, JSON_KEY("battery"));    json_uint(&w, battery_pct);
+    json_key(&w, JSON_KEY("snr"));        json_uint(&w, alg->signal_quality);
+    json_key(&w, JSON_KEY("timestamp"));  json_uint(&w, now_ms / 1000);  // Unix时间戳（秒）
+    json_key(&w, JSON_KEY("risk_level")); json_string(&w, risk->risk_description);
+    return json_end(&w);
+}
+
+// ==================== 离线历史 ====================
+
+static void put_u32(uint8_t* out, uint32_t v) {
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)(v >> 16);
+    out[3] = (uint8_t)(v >> 24);
+}
+
+// 历史特征值的读取值：当前可拉取的序号范围与上电编号（主机任务读取时补运行秒数）
+static void ble_history_update_range() {
+    uint8_t range[sizeof(g_ble.history_range)];
+    put_u32(range, history_log_oldest_seq());
+    put_u32(range + 4, history_log_next_seq());
+    put_u32(range + 8, history_log_boot_id());
+    task_runtime_enter_critical();
+    memcpy(g_ble.history_range, range, sizeof(range));
+    task_runtime_exit_critical();
+}
+
+// 未连接：按通知周期把遥测帧写入日志（离腕期间不记录）
+static void ble_history_record(uint32_t now_ms) {
+    if ((now_ms - g_ble.last_history_ms) < g_ble.notify_interval_ms) return;
+    if (wear_detect_get_state() == WEAR_STATE_OFF_WRIST) return;
+    g_ble.last_history_ms = now_ms;
+    
+    AlgorithmResult alg_result = {0};
+    algorithm_manager_get_result(&alg_result);
+    CollectorStats collector_stats = {0};
+    sensor_collector_get_stats(&collector_stats);
+    RiskAssessment risk = {0};
+    algorithm_manager_get_risk_assessment(&risk);
+    
+    uint8_t packet[TELEMETRY_MAX_LEN];
+    uint8_t len = (uint8_t)ble_build_telemetry(&alg_result, &risk, collector_stats.battery_percent,
+                                               WEAR_STATE_ON_WRIST, now_ms, packet, sizeof(packet));
+    if (history_log_append(packet, len)) {
+        g_ble.history_records_logged++;
+        ble_history_update_range();
+    }
+}
+
+// 从游标处装一帧连续、同一次上电的记录；损坏的记录与空槽跳过（首序号出现缺口）；到达最新记录返回0
+// （调用方保证 capacity 至少装得下一条最长记录，否则装不下与没有记录无法区分）
+static uint8_t ble_history_build_frame(uint8_t* frame, uint8_t capacity) {
+    uint8_t count = 0;
+    uint8_t p = HISTORY_FRAME_HEADER;
+    uint32_t frame_boot = 0;
+    uint32_t next_seq = history_log_next_seq();
+    while (g_ble.history_cursor < next_seq && count < 255) {
+        uint8_t rec[TELEMETRY_MAX_LEN];
+        uint32_t boot;
+        uint8_t len = history_log_read(g_ble.history_cursor, rec, &boot);
+        if (len == 0) {
+            if (count > 0) break;    // 本帧到此为止，下一帧从缺口之后开始
+            g_ble.history_cursor++;
+            continue;
+        }
+        if (p + len > capacity || (count > 0 && boot != frame_boot)) break;
+        if (count == 0) {
+            put_u32(frame + 2, g_ble.history_cursor);
+            put_u32(frame + 6, boot);
+            frame_boot = boot;
+        }
+        memcpy(frame + p, rec, len);
+        p += len;
+        count++;
+        g_ble.history_cursor++;
+    }
+    if (count == 0) return 0;
+    frame[0] = HISTORY_FRAME_RECORDS;
+    frame[1] = count;
+    g_ble.history_records_sent += count;
+    return p;
+}
+
+static void ble_history_poll(uint32_t now_ms) {
+    uint8_t op = g_ble.history_request;
+    if (op) {
+        g_ble.history_request = 0;
+        if (op == HISTORY_OP_PULL) {
+            uint32_t from = g_ble.history_request_seq;
+            uint32_t oldest = history_log_oldest_seq();
+            g_ble.history_cursor = (from < oldest) ? oldest : from;  // 0 或已被覆盖：从最旧开始
+            g_ble.history_active = 1;
+            g_ble.history_started_ms = now_ms;
+            g_ble.history_last_sync_records = g_ble.history_records_sent;
+        } else {
+            g_ble.history_active = 0;
+        }
+    }
+    if (!g_ble.is_connected) return;
+    
+    ble_tx_pump(&g_ble.history_tx, now_ms);
+    if (!g_ble.history_active) return;
+    
+    uint16_t capacity = ble_max_notify_len();
+    if (capacity > BLE_TX_MAX_CHUNK) capacity = BLE_TX_MAX_CHUNK;
+    
+    // 默认 MTU 23 只有20字节：等中心完成 MTU 交换，超时仍不够则拒绝本次拉取（不能发 END 冒充完成）
+    if (capacity < HISTORY_MIN_ATT_MTU - BLE_ATT_NOTIFY_OVERHEAD) {
+        if ((now_ms - g_ble.history_started_ms) < BLE_HISTORY_MTU_WAIT_MS) return;
+        uint8_t reject[3] = {HISTORY_FRAME_REJECT, (uint8_t)HISTORY_MIN_ATT_MTU, (uint8_t)(HISTORY_MIN_ATT_MTU >> 8)};
+        ble_tx_enqueue(&g_ble.history_tx, reject, sizeof(reject), capacity);
+        g_ble.history_active = 0;
+#ifdef DEBUG_MODE
+        Serial.printf("[BLE] 历史拉取被拒绝: ATT MTU %u < %u\n", g_ble.att_mtu, HISTORY_MIN_ATT_MTU);
+#endif
+        ble_tx_pump(&g_ble.history_tx, now_ms);
+        return;
+    }
+    
+    // 流水线：队列有空间就继续装帧，发送节奏由协议栈空闲缓冲决定
+    while (ble_tx_free_bytes(&g_ble.history_tx) >= capacity + 2) {
+        uint8_t frame[BLE_TX_MAX_CHUNK];
+        uint8_t len = ble_history_build_frame(frame, (uint8_t)capacity);
+        if (len == 0) {
+            frame[0] = HISTORY_FRAME_END;
+            put_u32(frame + 1, history_log_oldest_seq());
+            put_u32(frame + 5, history_log_next_seq());
+            put_u32(frame + 9, history_log_boot_id());
+            put_u32(frame + 13, now_ms / 1000);      // 与记录时间戳同一时钟
+            ble_tx_enqueue(&g_ble.history_tx, frame, HISTORY_END_LEN, capacity);
+            g_ble.history_active = 0;
+            g_ble.history_syncs++;
+            g_ble.history_last_sync_ms = now_ms - g_ble.history_started_ms;
+            g_ble.history_last_sync_records = g_ble.history_records_sent - g_ble.history_last_sync_records;
+#ifdef DEBUG_MODE
+            Serial.printf("[BLE] 历史同步完成: %lu条 %lums\n",
+                g_ble.history_last_sync_records, g_ble.history_last_sync_ms);
+#endif
+            break;
+        }
+        ble_tx_enqueue(&g_ble.history_tx, frame, len, capacity);
+    }
+    ble_tx_pump(&g_ble.history_tx, now_ms);
+}
 
 void ble_peripheral_send_data() {
+    uint32_t now_ms = millis();
     if (!g_ble.is_connected) {
-        return;  // 未连接
+        ble_history_record(now_ms);  // 未连接：写入离线历史
+        return;
+    }
+    
+    if (ble_handle_wear_state(now_ms)) {
+        return;  // 离腕：只发状态变化
     }
     
-    uint32_t now_ms = millis();
     if ((now_ms - g_ble.last_notify_ms) < g_ble.notify_interval_ms) {
         return;  // 未到通知时间
     }
@@ -137,45 +774,580 @@ void ble_peripheral_send_data() {
     RiskAssessment risk = {0};
     algorithm_manager_get_risk_assessment(&risk);
     
-    // 构建JSON（163字节左右，BLE MTU 23足够）
-    StaticJsonDocument<256> doc;
-    doc["hr"] = alg_result.bpm;
-    doc["spo2"] = alg_result.spo2;
-    doc["acetone"] = alg_result.acetone_ppm;
-    doc["battery"] = collector_stats.battery_percent;
-    doc["snr"] = alg_result.signal_quality;
-    doc["timestamp"] = now_ms / 1000;  // Unix时间戳（秒）
-    doc["risk_level"] = risk.risk_description;
-    
-    // 序列化为字符串
-    String json_str;
-    serializeJson(doc, json_str);
-    
-    // 分片发送（如果超过MTU size）
-    const uint8_t* json_bytes = (const uint8_t*)json_str.c_str();
-    uint16_t json_len = json_str.length();
-    const uint16_t MAX_CHUNK = 20;  // BLE MTU 23 - overhead
-    
-    uint16_t offset = 0;
-    while (offset < json_len) {
-        uint16_t chunk_len = (json_len - offset > MAX_CHUNK) ? MAX_CHUNK : (json_len - offset);
+    // 按需通知：各字段相对上次发出的汇总都在死区内时只按保活周期发送
+    TelemetryFrame frame;
+    ble_fill_telemetry(&alg_result, &risk, collector_stats.battery_percent, g_ble.wear_state_sent, now_ms, &frame);
+    if (!telemetry_frame_changed(&frame, &g_ble.last_frame) &&
+        (now_ms - g_ble.last_notify_ms) < BLE_NOTIFY_KEEPALIVE_MS) {
+        if (g_ble.last_skip_ms != g_ble.last_notify_ms) {
+            g_ble.last_skip_ms = g_ble.last_notify_ms;
+            g_ble.notify_skipped++;      // 每个通知周期只计一次
+        }
+        return;
+    }
+    
+    uint8_t queued;
+    if (g_ble.payload_format == BLE_PAYLOAD_BINARY) {
+        uint8_t packet[TELEMETRY_MAX_LEN];
+        uint8_t len = telemetry_encode(&frame, packet, sizeof(packet));
+        queued = ble_notify_payload(packet, len);
+    } else {
+        // JSON约150字节，超过MTU时分片发送
+        char json[BLE_JSON_BUF_LEN];
+        uint16_t len = ble_build_json(&alg_result, &risk, collector_stats.battery_percent,
+                                      now_ms, json, sizeof(json));
+        if (len == 0) {
+            g_ble.json_overflows++;  // BLE_JSON_BUF_LEN 不足：json_end 返回0，本次不发送
+        }
+        queued = ble_notify_payload((const uint8_t*)json, len);
+#ifdef DEBUG_MODE
+        if (queued && g_ble.total_notifications % 3 == 0) {
+            Serial.printf("[BLE] SEND #%lu: %s\n", g_ble.total_notifications, json);
+        }
+#endif
+    }
+    if (queued) {
+        g_ble.last_notify_ms = now_ms;  // 背压：未入队则下次调用重新取最新结果再发
+        g_ble.last_frame = frame;
+    }
+}
+
+// ==================== 分字段特征值 ====================
+
+static const uint8_t k_field_char_fields[BLE_FIELD_CHAR_COUNT] = {
+    TELEMETRY_FIELD_HR, TELEMETRY_FIELD_SPO2, TELEMETRY_FIELD_ACETONE,
+    TELEMETRY_FIELD_BATTERY, TELEMETRY_FIELD_RISK, TELEMETRY_FIELD_WEAR
+};
+
+// 特征值格式（与检测端固件一致）：HR/SpO2/电量/风险/佩戴 uint8（未得出为 0xFF），
+// 丙酮 float32 ppm（小端，未得出为 -1.0）
+#define BLE_FIELD_NONE_U8       0xFF
+#define BLE_FIELD_NONE_PPM      -1.0f
+
+static uint8_t ble_field_encode(const TelemetryFrame* f, uint8_t field, uint8_t* out) {
+    if (field == TELEMETRY_FIELD_ACETONE) {
+        float ppm = (f->fields & field) ? f->acetone_x10 / 10.0f : BLE_FIELD_NONE_PPM;
+        memcpy(out, &ppm, sizeof(ppm));
+        return sizeof(ppm);
+    }
+    out[0] = (f->fields & field) ? (uint8_t)telemetry_field_value(f, field) : BLE_FIELD_NONE_U8;
+    return 1;
+}
+
+// 每 BLE_FIELD_CHECK_MS 检查一次：越过死区、保活到期或本次连接尚未通知的字段各自通知；
+// 未订阅的特征值只更新值（供读取）；协议栈缓冲不足时保留状态，下次检查再发
+static void ble_field_poll(uint32_t now_ms) {
+    if (!g_ble.is_connected || (now_ms - g_ble.field_check_ms) < BLE_FIELD_CHECK_MS) return;
+    g_ble.field_check_ms = now_ms;
+    
+    AlgorithmResult alg_result = {0};
+    algorithm_manager_get_result(&alg_result);
+    CollectorStats collector_stats = {0};
+    sensor_collector_get_stats(&collector_stats);
+    RiskAssessment risk = {0};
+    algorithm_manager_get_risk_assessment(&risk);
+    
+    uint8_t wear = (uint8_t)wear_detect_get_state();
+    if (wear == WEAR_STATE_OFF_WRIST) {
+        alg_result.bpm = 0;   // 离腕：HR/SpO2 通知一次"未得出"，不再推送旧值
+        alg_result.spo2 = 0;
+    }
+    TelemetryFrame frame;
+    ble_fill_telemetry(&alg_result, &risk, collector_stats.battery_percent, wear, now_ms, &frame);
+    
+    for (uint8_t i = 0; i < BLE_FIELD_CHAR_COUNT; i++) {
+        uint8_t field = k_field_char_fields[i];
+        NimBLECharacteristic* chr = g_ble.field_characteristics[i];
+        uint8_t value[4];
+        uint8_t len = ble_field_encode(&frame, field, value);
         
-        g_ble.characteristic->setValue(json_bytes + offset, chunk_len);
-        g_ble.characteristic->notify();
+        if (chr->getSubscribedCount() == 0) {
+            chr->setValue(value, len);
+            continue;
+        }
+        uint8_t due = !(g_ble.field_sent_mask & field) ||
+                      telemetry_field_changed(&frame, &g_ble.field_sent, field) ||
+                      (now_ms - g_ble.field_sent_ms[i]) >= BLE_NOTIFY_KEEPALIVE_MS;
+        if (!due) {
+            g_ble.field_suppressed++;
+            continue;
+        }
+        if (ble_notify_characteristic(chr, value, len, BLE_TX_MIN_FREE_MBUFS) != 0) continue;
         
-        offset += chunk_len;
-        delayMicroseconds(100);  // 避免过快发送
+        // 只记录本字段：各特征值的参考值相互独立
+        g_ble.field_sent.fields = (g_ble.field_sent.fields & ~field) | (frame.fields & field);
+        switch (field) {
+            case TELEMETRY_FIELD_HR:      g_ble.field_sent.hr_bpm = frame.hr_bpm; break;
+            case TELEMETRY_FIELD_SPO2:    g_ble.field_sent.spo2 = frame.spo2; break;
+            case TELEMETRY_FIELD_ACETONE: g_ble.field_sent.acetone_x10 = frame.acetone_x10; break;
+            case TELEMETRY_FIELD_BATTERY: g_ble.field_sent.battery_pct = frame.battery_pct; break;
+            case TELEMETRY_FIELD_RISK:    g_ble.field_sent.risk = frame.risk; break;
+            case TELEMETRY_FIELD_WEAR:    g_ble.field_sent.wear = frame.wear; break;
+        }
+        g_ble.field_sent_mask |= field;
+        g_ble.field_sent_ms[i] = now_ms;
+        g_ble.field_notifications++;
+    }
+}
+
+// ==================== 原始PPG波形流 ====================
+
+// 订阅变化在通信任务中生效（总线游标只由本任务修改）
+static void ble_ppg_update_subscription() {
+    uint8_t want = g_ble.is_connected && g_ble.ppg_requested;
+    uint8_t active = (g_ble.ppg_bus_sub != SAMPLE_BUS_INVALID_SUB);
+    if (want && !active) {
+        g_ble.ppg_bus_sub = sample_bus_subscribe("ble_ppg");
+        memset(&g_ble.ppg_enc, 0, sizeof(PpgStreamEncoder));
+        ble_tx_reset(&g_ble.ppg_tx);
+    } else if (!want && active) {
+        sample_bus_unsubscribe(g_ble.ppg_bus_sub);
+        g_ble.ppg_bus_sub = SAMPLE_BUS_INVALID_SUB;
+        ble_tx_reset(&g_ble.ppg_tx);
+    }
+}
+
+// 每批样本数：不短于 BLE_PPG_MIN_BATCH_MS 的最少整数个连接间隔（中心调整连接参数后随之变化），
+// 每隔固定个连接事件发一帧
+static uint8_t ble_ppg_batch_target() {
+    uint16_t interval_ms = g_ble.conn_interval_ms ? g_ble.conn_interval_ms : BLE_PPG_MIN_BATCH_MS;
+    uint16_t events = (BLE_PPG_MIN_BATCH_MS + interval_ms - 1) / interval_ms;
+    uint32_t batch_ms = (uint32_t)events * interval_ms;
+    if (batch_ms > BLE_PPG_MAX_BATCH_MS) batch_ms = BLE_PPG_MAX_BATCH_MS;
+    return (uint8_t)(batch_ms * HR_SAMPLE_RATE / 1000);
+}
+
+// 直接从总线片段编码一帧（可能跨越环形缓冲末尾），只消费已写入帧的样本；
+// 片段序号不连续（总线覆盖）时提前结束，下一帧的首样本序号体现缺口。
+// 编码期间有样本被覆盖时整帧作废（*discarded=1，返回0），接收方同样从序号缺口得知
+static uint8_t ble_ppg_encode_batch(uint8_t* frame, uint8_t capacity, uint8_t* discarded) {
+    PpgSpan span;
+    uint8_t started = 0;
+    uint32_t next_seq = 0;
+    *discarded = 0;
+    while (sample_bus_peek(g_ble.ppg_bus_sub, &span) > 0) {
+        if (!started) {
+            ppg_stream_begin(&g_ble.ppg_enc, frame, capacity, (uint16_t)span.seq);
+            started = 1;
+        } else if (span.seq != next_seq) {
+            break;
+        }
+        uint16_t n = 0;
+        while (n < span.count && ppg_stream_add(&g_ble.ppg_enc, span.red[n], span.ir[n])) {
+            n++;
+        }
+        if (sample_bus_consume(g_ble.ppg_bus_sub, n) > 0) *discarded = 1;
+        next_seq = span.seq + n;
+        if (n < span.count) break;  // 帧已满
     }
+    if (*discarded) {
+        g_ble.ppg_enc.len = 0;
+        g_ble.ppg_discarded++;
+        return 0;
+    }
+    return started ? ppg_stream_finish(&g_ble.ppg_enc) : 0;
+}
+
+static void ble_ppg_stream_poll(uint32_t now_ms) {
+    ble_ppg_update_subscription();
+    if (g_ble.ppg_bus_sub == SAMPLE_BUS_INVALID_SUB) return;
     
-    g_ble.last_notify_ms = now_ms;
-    g_ble.total_notifications++;
-    g_ble.total_bytes_sent += json_len;
+    ble_tx_pump(&g_ble.ppg_tx, now_ms);
     
+    g_ble.ppg_batch_target = ble_ppg_batch_target();
+    uint16_t capacity = ble_max_notify_len();
+    if (capacity > BLE_TX_MAX_CHUNK) capacity = BLE_TX_MAX_CHUNK;
+    
+    // 积压时（中心暂时收不动）连续发满帧追赶；队列放不下则样本留在总线上等待，
+    // 落后超过总线容量时由总线丢弃最旧样本，接收方从序号缺口得知
+    while (sample_bus_lag(g_ble.ppg_bus_sub) >= g_ble.ppg_batch_target) {
+        if (ble_tx_free_bytes(&g_ble.ppg_tx) < capacity + 2) {
+            g_ble.ppg_stalls++;
+            break;
+        }
+        uint8_t frame[BLE_TX_MAX_CHUNK];
+        uint8_t discarded;
+        uint8_t len = ble_ppg_encode_batch(frame, (uint8_t)capacity, &discarded);
+        if (discarded) continue;
+        if (len == 0) break;
+        
+        ble_tx_enqueue(&g_ble.ppg_tx, frame, len, capacity);
+        g_ble.ppg_batches++;
+        g_ble.ppg_samples += g_ble.ppg_enc.count;
+        g_ble.ppg_bytes += len;
+        if (g_ble.ppg_enc.flags & PPG_STREAM_FLAG_ORDER2) g_ble.ppg_order2_batches++;
+    }
+    ble_tx_pump(&g_ble.ppg_tx, now_ms);
+}
+
+// ==================== 连接参数管理 ====================
+
+typedef struct {
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint16_t latency;
+    uint16_t timeout;
+} BleConnParams;
+
+static const BleConnParams k_conn_profiles[BLE_CONN_PROFILE_COUNT] = {
+    {BLE_CONN_IDLE_INTERVAL_MIN, BLE_CONN_IDLE_INTERVAL_MAX, BLE_CONN_IDLE_LATENCY, BLE_CONN_IDLE_TIMEOUT},
+    {BLE_CONN_STREAM_INTERVAL_MIN, BLE_CONN_STREAM_INTERVAL_MAX, BLE_CONN_STREAM_LATENCY, BLE_CONN_STREAM_TIMEOUT},
+    {BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX, BLE_CONN_LATENCY, BLE_CONN_TIMEOUT},
+};
+
+static const char* const k_conn_profile_names[BLE_CONN_PROFILE_COUNT] = {"空闲", "波形", "批量"};
+
+static uint32_t ble_conn_bytes_sent() {
+    return g_ble.tx.stats.bytes_sent + g_ble.ppg_tx.stats.bytes_sent + g_ble.history_tx.stats.bytes_sent;
+}
+
+// 新连接（通信任务）：能耗统计从此刻开始，先按空闲摘要请求，中心拉取历史或订阅波形时再升档。
+// 处理前已断开则只清标志
+static void ble_conn_start(uint32_t now_ms) {
+    g_ble.conn_start_pending = 0;
+    if (!g_ble.is_connected) return;
+    g_ble.conn_demand_drop_ms = 0;
+    g_ble.conn_retries = 0;
+    g_ble.energy_last_ms = now_ms;
+    g_ble.energy_bytes_mark = ble_conn_bytes_sent();
+    ble_conn_request(BLE_CONN_PROFILE_IDLE, now_ms);
+}
+
+// 经 L2CAP/链路层连接参数更新过程请求（结果由中心决定，生效参数在轮询中读取）
+static void ble_conn_request(BleConnProfile profile, uint32_t now_ms) {
+    const BleConnParams* p = &k_conn_profiles[profile];
+    if (profile != g_ble.conn_profile) g_ble.conn_retries = 0;
+    g_ble.server->updateConnParams(g_ble.conn_handle, p->itvl_min, p->itvl_max, p->latency, p->timeout);
+    g_ble.conn_profile = profile;
+    g_ble.conn_request_ms = now_ms;
+    g_ble.conn_demand_drop_ms = 0;
+    g_ble.conn_param_requests++;
 #ifdef DEBUG_MODE
-    if (g_ble.total_notifications % 3 == 0) {
-        Serial.printf("[BLE] SEND #%lu: %s\n", g_ble.total_notifications, json_str.c_str());
+    Serial.printf("[BLE] 连接参数请求: %s %u-%ums 延迟%u\n", k_conn_profile_names[profile],
+        p->itvl_min * 5 / 4, p->itvl_max * 5 / 4, p->latency);
+#endif
+}
+
+// 需求：历史批量 > 波形流 > 空闲摘要
+static BleConnProfile ble_conn_demand() {
+    if (g_ble.history_active) return BLE_CONN_PROFILE_BULK;
+    if (g_ble.ppg_bus_sub != SAMPLE_BUS_INVALID_SUB) return BLE_CONN_PROFILE_STREAM;
+    return BLE_CONN_PROFILE_IDLE;
+}
+
+// 按生效参数累计到当前档位：连接事件数 = 时长 / (间隔 × (1 + 从机延迟))（有数据时外设不跳过事件，
+// 按空中时间另计），空中字节按 PHY 计（2M 减半）
+static void ble_conn_account(uint32_t now_ms) {
+    uint32_t dt_ms = now_ms - g_ble.energy_last_ms;
+    g_ble.energy_last_ms = now_ms;
+    uint32_t total = ble_conn_bytes_sent();
+    uint32_t bytes = total - g_ble.energy_bytes_mark;
+    g_ble.energy_bytes_mark = total;
+    
+    uint8_t idx = g_ble.conn_profile;
+    BleConnEnergy* e = &g_ble.energy[idx];
+    e->time_ms += dt_ms;
+    e->bytes += bytes;
+    
+    uint32_t period_x125 = (uint32_t)g_ble.conn_itvl * (g_ble.conn_latency + 1);   // 1.25ms 单位
+    if (period_x125 > 0) {
+        uint64_t events_x1000 = (uint64_t)dt_ms * 1000 * 4 / (period_x125 * 5);
+        g_ble.energy_events_x1000[idx] += events_x1000;
+        g_ble.energy_nj[idx] += events_x1000 * BLE_ENERGY_EVENT_UJ;   // µJ × 1000 = nJ
+    }
+    uint32_t byte_nj = (g_ble.tx_phy == BLE_GAP_LE_PHY_2M) ? BLE_ENERGY_BYTE_NJ / 2 : BLE_ENERGY_BYTE_NJ;
+    g_ble.energy_nj[idx] += (uint64_t)bytes * byte_nj;
+    e->events = (uint32_t)(g_ble.energy_events_x1000[idx] / 1000);
+    e->energy_uj = (uint32_t)(g_ble.energy_nj[idx] / 1000);
+}
+
+static void ble_conn_manager_poll(uint32_t now_ms) {
+    // 本轮开头之后才建立的连接留到下一轮，先由 ble_conn_start() 建立统计起点
+    if (!g_ble.is_connected || g_ble.conn_start_pending) return;
+    
+    // 生效参数（中心可能改用其他值，或自行发起更新）
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(g_ble.conn_handle, &desc) == 0) {
+        g_ble.conn_itvl = desc.conn_itvl;
+        g_ble.conn_latency = desc.conn_latency;
+        g_ble.conn_interval_ms = desc.conn_itvl * 5 / 4;
+    }
+    ble_conn_account(now_ms);
+    
+    // 升档立即请求；降档等需求持续下降 BLE_CONN_HOLD_MS（历史拉取间隙、重新订阅时不来回切换）
+    BleConnProfile want = ble_conn_demand();
+    if (want > g_ble.conn_profile) {
+        ble_conn_request(want, now_ms);
+        return;
+    }
+    if (want < g_ble.conn_profile) {
+        if (g_ble.conn_demand_drop_ms == 0) g_ble.conn_demand_drop_ms = now_ms ? now_ms : 1;
+        if ((now_ms - g_ble.conn_demand_drop_ms) >= BLE_CONN_HOLD_MS) ble_conn_request(want, now_ms);
+        return;
     }
+    g_ble.conn_demand_drop_ms = 0;
+    
+    // 中心没有采用请求的参数：隔一段时间重试，次数有限（中心可能始终坚持自己的参数）
+    const BleConnParams* p = &k_conn_profiles[g_ble.conn_profile];
+    uint8_t applied = (g_ble.conn_itvl >= p->itvl_min && g_ble.conn_itvl <= p->itvl_max &&
+                       g_ble.conn_latency == p->latency);
+    if (!applied && g_ble.conn_retries < BLE_CONN_MAX_RETRIES &&
+        (now_ms - g_ble.conn_request_ms) >= BLE_CONN_RETRY_MS) {
+        g_ble.conn_retries++;
+        ble_conn_request(g_ble.conn_profile, now_ms);
+    }
+}
+
+// ==================== 广播 ====================
+
+static const char* ble_mode_name(BleLinkMode mode) {
+    static const char* const names[] = {"GATT", "broadcast", "GATT+broadcast"};
+    return (mode <= BLE_MODE_GATT_BROADCAST) ? names[mode] : "?";
+}
+
+// AD 结构：[长度][类型][数据]
+static void ad_append(std::string* ad, uint8_t type, const void* data, uint8_t len) {
+    ad->push_back((char)(len + 1));
+    ad->push_back((char)type);
+    ad->append((const char*)data, len);
+}
+
+static uint8_t hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 0;
+}
+
+// 128位UUID字符串 → 空中字节序（小端）
+static void ad_append_uuid128(std::string* ad, const char* uuid) {
+    uint8_t bytes[16];
+    uint8_t n = 0;
+    for (const char* c = uuid; *c && n < 32; c++) {
+        if (*c == '-') continue;
+        uint8_t idx = 15 - n / 2;
+        bytes[idx] = (n & 1) ? (uint8_t)(bytes[idx] | hex_nibble(*c)) : (uint8_t)(hex_nibble(*c) << 4);
+        n++;
+    }
+    ad_append(ad, BLE_AD_UUID128_COMPLETE, bytes, sizeof(bytes));
+}
+
+static void ad_append_manufacturer(std::string* ad) {
+    uint8_t data[2 + TELEMETRY_MAX_LEN];
+    data[0] = (uint8_t)BLE_BROADCAST_COMPANY_ID;
+    data[1] = (uint8_t)(BLE_BROADCAST_COMPANY_ID >> 8);
+    memcpy(data + 2, g_ble.broadcast_frame, g_ble.broadcast_len);
+    ad_append(ad, BLE_AD_MANUFACTURER, data, 2 + g_ble.broadcast_len);
+}
+
+// 广播负载：最新结果的遥测帧，时间戳取分析时刻（同一结果负载不变）；离腕时不带 HR/SpO2
+static uint8_t ble_broadcast_build(uint8_t* out) {
+    AlgorithmResult alg_result = {0};
+    algorithm_manager_get_result(&alg_result);
+    CollectorStats collector_stats = {0};
+    sensor_collector_get_stats(&collector_stats);
+    RiskAssessment risk = {0};
+    algorithm_manager_get_risk_assessment(&risk);
+    
+    uint8_t wear = (uint8_t)wear_detect_get_state();
+    if (wear == WEAR_STATE_OFF_WRIST) {
+        alg_result.bpm = 0;
+        alg_result.spo2 = 0;
+    }
+    g_ble.broadcast_result_ms = alg_result.timestamp_ms;
+    return (uint8_t)ble_build_telemetry(&alg_result, &risk, collector_stats.battery_percent, wear,
+                                        alg_result.timestamp_ms, out, TELEMETRY_MAX_LEN);
+}
+
+#if BLE_USE_EXT_ADV
+
+static void ble_adv_set_broadcast_data() {
+    NimBLEExtAdvertisement broadcast(BLE_HCI_LE_PHY_1M, BLE_HCI_LE_PHY_1M);
+    std::string ad;
+    uint8_t flags = BLE_AD_FLAGS_GENERAL;
+    ad_append(&ad, BLE_AD_FLAGS, &flags, 1);
+    ad_append(&ad, BLE_AD_NAME_COMPLETE, BLE_DEVICE_NAME, strlen(BLE_DEVICE_NAME));
+    ad_append_uuid128(&ad, SERVICE_UUID);
+    ad_append_manufacturer(&ad);
+    broadcast.setConnectable(false);
+    broadcast.setScannable(false);
+    broadcast.setMinInterval(BLE_ADV_INTERVAL_MIN);
+    broadcast.setMaxInterval(BLE_ADV_INTERVAL_MAX);
+    broadcast.addData(ad);
+    NimBLEDevice::getAdvertising()->setInstanceData(BLE_ADV_INST_BROADCAST, broadcast);
+}
+
+// 实例0：传统可连接广播（与原 GATT 广播内容相同），连接期间停止；实例1：扩展广播，连接期间照常
+static void ble_adv_apply() {
+    NimBLEExtAdvertising* adv = NimBLEDevice::getAdvertising();
+    
+    if (g_ble.mode != BLE_MODE_BROADCAST && !g_ble.is_connected) {
+        NimBLEExtAdvertisement gatt;
+        NimBLEExtAdvertisement scan_rsp;
+        std::string ad, rsp;
+        uint8_t flags = BLE_AD_FLAGS_GENERAL;
+        uint8_t itvl[4] = {0x06, 0x00, 0x12, 0x00};
+        ad_append(&ad, BLE_AD_FLAGS, &flags, 1);
+        ad_append_uuid128(&ad, SERVICE_UUID);
+        ad_append(&rsp, BLE_AD_NAME_COMPLETE, BLE_DEVICE_NAME, strlen(BLE_DEVICE_NAME));
+        ad_append(&rsp, BLE_AD_SLAVE_ITVL_RANGE, itvl, sizeof(itvl));
+        gatt.setLegacyAdvertising(true);
+        gatt.setConnectable(true);
+        gatt.setScannable(true);
+        gatt.addData(ad);
+        scan_rsp.setLegacyAdvertising(true);
+        scan_rsp.addData(rsp);
+        adv->setInstanceData(BLE_ADV_INST_GATT, gatt);
+        adv->setScanResponseData(BLE_ADV_INST_GATT, scan_rsp);
+        adv->start(BLE_ADV_INST_GATT);
+    } else if (adv->isActive(BLE_ADV_INST_GATT)) {
+        adv->stop(BLE_ADV_INST_GATT);
+    }
+    
+    if (g_ble.mode != BLE_MODE_GATT) {
+        g_ble.broadcast_len = ble_broadcast_build(g_ble.broadcast_frame);
+        ble_adv_set_broadcast_data();
+        if (!adv->isActive(BLE_ADV_INST_BROADCAST)) adv->start(BLE_ADV_INST_BROADCAST);
+    } else if (adv->isActive(BLE_ADV_INST_BROADCAST)) {
+        adv->stop(BLE_ADV_INST_BROADCAST);
+    }
+}
+
+#else
+
+// 传统广播数据（31字节）：广播模式下 flags + 厂商数据（20字节），128位服务UUID放不下，
+// 扫描响应只放名称；可连接时 GATT 服务在连接后发现
+static void ble_adv_set_legacy_data(NimBLEAdvertising* adv, uint8_t connectable) {
+    std::string ad, rsp;
+    uint8_t flags = BLE_AD_FLAGS_GENERAL;
+    ad_append(&ad, BLE_AD_FLAGS, &flags, 1);
+    if (g_ble.mode == BLE_MODE_GATT) {
+        ad_append_uuid128(&ad, SERVICE_UUID);
+    } else {
+        ad_append_manufacturer(&ad);
+    }
+    ad_append(&rsp, BLE_AD_NAME_COMPLETE, BLE_DEVICE_NAME, strlen(BLE_DEVICE_NAME));
+    if (connectable) {
+        uint8_t itvl[4] = {0x06, 0x00, 0x12, 0x00};
+        ad_append(&rsp, BLE_AD_SLAVE_ITVL_RANGE, itvl, sizeof(itvl));
+    }
+    
+    NimBLEAdvertisementData adv_data, rsp_data;
+    adv_data.addData(ad);
+    rsp_data.addData(rsp);
+    adv->setAdvertisementData(adv_data);
+    adv->setScanResponseData(rsp_data);
+    g_ble.adv_custom = 1;
+}
+
+static void ble_adv_set_broadcast_data() {
+    ble_adv_set_legacy_data(NimBLEDevice::getAdvertising(),
+                            g_ble.mode == BLE_MODE_GATT_BROADCAST && !g_ble.is_connected);
+}
+
+static void ble_adv_apply() {
+    NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+    uint8_t connectable = (g_ble.mode != BLE_MODE_BROADCAST) && !g_ble.is_connected;
+    
+    if (g_ble.mode == BLE_MODE_GATT) {
+        if (!connectable) return;  // 已连接：协议栈已停止可连接广播
+        if (!g_ble.adv_custom) {
+            adv->addServiceUUID(SERVICE_UUID);
+            adv->setScanResponse(true);
+            adv->setMinPreferred(0x06);
+            adv->setMaxPreferred(0x12);
+        } else {
+            ble_adv_set_legacy_data(adv, 1);
+        }
+        adv->setAdvertisementType(BLE_GAP_CONN_MODE_UND);
+        adv->start();
+        return;
+    }
+    
+    // 已连接时改为不可连接（可扫描）广播
+    if (adv->isAdvertising()) adv->stop();
+    g_ble.broadcast_len = ble_broadcast_build(g_ble.broadcast_frame);
+    ble_adv_set_legacy_data(adv, connectable);
+    adv->setAdvertisementType(connectable ? BLE_GAP_CONN_MODE_UND : BLE_GAP_CONN_MODE_NON);
+    adv->setMinInterval(BLE_ADV_INTERVAL_MIN);
+    adv->setMaxInterval(BLE_ADV_INTERVAL_MAX);
+    adv->start();
+}
+
 #endif
+
+// 新结果（或超过刷新周期，电量/佩戴变化）时重建负载，内容变化才更新广播数据
+static void ble_broadcast_poll(uint32_t now_ms) {
+    if (g_ble.adv_dirty) {
+        g_ble.adv_dirty = 0;
+        ble_adv_apply();
+    }
+    if (g_ble.mode == BLE_MODE_GATT) return;
+    
+    AlgorithmResult alg_result = {0};
+    algorithm_manager_get_result(&alg_result);
+    if (alg_result.timestamp_ms == g_ble.broadcast_result_ms &&
+        (now_ms - g_ble.broadcast_refresh_ms) < BLE_BROADCAST_REFRESH_MS) {
+        return;
+    }
+    g_ble.broadcast_refresh_ms = now_ms;
+    
+    uint8_t frame[TELEMETRY_MAX_LEN];
+    uint8_t len = ble_broadcast_build(frame);
+    if (len == g_ble.broadcast_len && memcmp(frame, g_ble.broadcast_frame, len) == 0) return;
+    memcpy(g_ble.broadcast_frame, frame, len);
+    g_ble.broadcast_len = len;
+    ble_adv_set_broadcast_data();
+    g_ble.broadcast_updates++;
+}
+
+void ble_peripheral_set_mode(BleLinkMode mode) {
+    if (mode > BLE_MODE_GATT_BROADCAST || mode == g_ble.mode) return;
+    g_ble.mode = mode;
+    g_ble.adv_dirty = 1;
+}
+
+BleLinkMode ble_peripheral_get_mode() {
+    return g_ble.mode;
+}
+
+// 断开后的会话清理（通信任务）：先于本轮的发送执行；
+// 若清理前已重新连接，新连接尚未发送任何数据，清理同样适用
+static void ble_session_reset() {
+    g_ble.session_reset_pending = 0;
+    ble_tx_reset(&g_ble.tx);
+    ble_tx_reset(&g_ble.ppg_tx);
+    ble_tx_reset(&g_ble.history_tx);
+    memset(&g_ble.ppg_enc, 0, sizeof(PpgStreamEncoder));
+    g_ble.field_sent_mask = 0;       // 新连接先通知一次当前值
+    g_ble.last_frame.fields = 0;
+    g_ble.wear_state_sent = WEAR_STATE_ON_WRIST;  // 新连接若处于离腕会重新通知
+}
+
+void ble_peripheral_poll() {
+    uint32_t now_ms = millis();
+    if (g_ble.session_reset_pending) {
+        ble_session_reset();
+    }
+    if (g_ble.conn_start_pending) {
+        ble_conn_start(now_ms);
+    }
+    if (g_ble.is_connected) {
+        ble_tx_pump(&g_ble.tx, now_ms);  // 实时遥测优先
+    }
+    ble_history_poll(now_ms);
+    ble_ppg_stream_poll(now_ms);  // 断开后也要走一次以释放总线游标
+    ble_field_poll(now_ms);
+    ble_conn_manager_poll(now_ms);
+    ble_broadcast_poll(now_ms);
+}
+
+void ble_peripheral_set_payload_format(BlePayloadFormat format) {
+    g_ble.payload_format = format;
+}
+
+BlePayloadFormat ble_peripheral_get_payload_format() {
+    return g_ble.payload_format;
 }
 
 // ==================== 查询函数 ====================
@@ -194,13 +1366,104 @@ void ble_peripheral_get_stats(BleStats* stats) {
     stats->is_connected = g_ble.is_connected;
     stats->total_notifications = g_ble.total_notifications;
     stats->total_bytes_sent = g_ble.total_bytes_sent;
+    stats->payload_format = g_ble.payload_format;
+    stats->last_payload_len = g_ble.last_payload_len;
+    
+    ble_refresh_phy();
+    stats->att_mtu = g_ble.att_mtu;
+    stats->max_notify_len = ble_max_notify_len();
+    stats->dle_tx_octets = g_ble.dle_tx_octets;
+    stats->tx_phy = g_ble.tx_phy;
+    stats->rx_phy = g_ble.rx_phy;
+    stats->fragmented_payloads = g_ble.fragmented_payloads;
+    stats->json_overflows = g_ble.json_overflows;
+    
+    ble_tx_get_stats(&g_ble.tx, &stats->tx);
+    
+    stats->conn_profile = g_ble.conn_profile;
+    stats->conn_interval_x100 = g_ble.conn_itvl * 125;
+    stats->conn_latency = g_ble.conn_latency;
+    stats->conn_param_requests = g_ble.conn_param_requests;
+    stats->notify_skipped = g_ble.notify_skipped;
+    stats->field_notifications = g_ble.field_notifications;
+    stats->field_suppressed = g_ble.field_suppressed;
+    memcpy(stats->energy, g_ble.energy, sizeof(stats->energy));
+    
+    stats->ppg_streaming = (g_ble.ppg_bus_sub != SAMPLE_BUS_INVALID_SUB);
+    stats->ppg_batch_target = g_ble.ppg_batch_target;
+    stats->ppg_batches = g_ble.ppg_batches;
+    stats->ppg_samples = g_ble.ppg_samples;
+    stats->ppg_bytes = g_ble.ppg_bytes;
+    stats->ppg_stalls = g_ble.ppg_stalls;
+    stats->ppg_discarded = g_ble.ppg_discarded;
+    stats->ppg_bytes_per_pair_x100 = g_ble.ppg_samples ?
+        (uint16_t)((uint64_t)g_ble.ppg_bytes * 100 / g_ble.ppg_samples) : 0;
+    
+    stats->mode = g_ble.mode;
+    stats->broadcast_updates = g_ble.broadcast_updates;
+    
+    stats->history_syncing = g_ble.history_active;
+    stats->history_records_logged = g_ble.history_records_logged;
+    stats->history_records_sent = g_ble.history_records_sent;
+    stats->history_syncs = g_ble.history_syncs;
+    stats->history_last_sync_ms = g_ble.history_last_sync_ms;
+    stats->history_last_sync_records = g_ble.history_last_sync_records;
 }
 
 void ble_peripheral_print_stats() {
 #ifdef DEBUG_MODE
-    Serial.printf("\n[BLE STATS] 连接:%s 通知:%lu 发送:%lu字节\n",
+    Serial.printf("\n[BLE STATS] 模式:%s 广播更新:%lu\n", ble_mode_name(g_ble.mode), g_ble.broadcast_updates);
+    Serial.printf("[BLE STATS] 连接:%s 通知:%lu 发送:%lu字节 格式:%s 最近负载:%u字节\n",
         g_ble.is_connected ? "✓" : "✗",
         g_ble.total_notifications,
-        g_ble.total_bytes_sent);
+        g_ble.total_bytes_sent,
+        g_ble.payload_format == BLE_PAYLOAD_JSON ? "JSON" : "binary",
+        g_ble.last_payload_len);
+    if (g_ble.is_connected) {
+        ble_refresh_phy();
+        static const char* const phy_names[] = {"-", "1M", "2M", "Coded"};
+        Serial.printf("[BLE STATS] MTU:%u (通知≤%u字节) DLE:%u PHY tx:%s rx:%s 分片负载:%lu JSON溢出:%lu\n",
+            g_ble.att_mtu, ble_max_notify_len(), g_ble.dle_tx_octets,
+            phy_names[g_ble.tx_phy & 3], phy_names[g_ble.rx_phy & 3], g_ble.fragmented_payloads,
+            g_ble.json_overflows);
+    }
+    if (g_ble.is_connected) {
+        Serial.printf("[BLE STATS] 连接档位:%s 间隔:%u.%02ums 延迟:%u 参数请求:%lu 省去通知:%lu\n",
+            k_conn_profile_names[g_ble.conn_profile], g_ble.conn_itvl * 125 / 100, g_ble.conn_itvl * 125 % 100,
+            g_ble.conn_latency, g_ble.conn_param_requests, g_ble.notify_skipped);
+        Serial.printf("[BLE STATS] 分字段通知:%lu 死区内省去:%lu\n",
+            g_ble.field_notifications, g_ble.field_suppressed);
+    }
+    for (uint8_t i = 0; i < BLE_CONN_PROFILE_COUNT; i++) {
+        const BleConnEnergy* e = &g_ble.energy[i];
+        if (e->time_ms == 0) continue;
+        // 每字节能耗（估算）与平均功率
+        Serial.printf("[BLE STATS]   %s: %lus 事件:%lu 字节:%lu 能耗≈%luµJ (%lu.%02luµJ/字节, %lu.%02lumW)\n",
+            k_conn_profile_names[i], e->time_ms / 1000, e->events, e->bytes, e->energy_uj,
+            e->bytes ? e->energy_uj / e->bytes : 0,
+            e->bytes ? (uint32_t)((uint64_t)e->energy_uj * 100 / e->bytes % 100) : 0,
+            e->energy_uj / e->time_ms, (uint32_t)((uint64_t)e->energy_uj * 100 / e->time_ms % 100));
+    }
+    BleTxStats tx;
+    ble_tx_get_stats(&g_ble.tx, &tx);
+    Serial.printf("[BLE STATS] 队列:%u/%u字节(峰值%u) 拒绝:%lu 丢弃:%lu 重试:%lu 缓冲等待:%lu 吞吐:%luB/s\n",
+        tx.queued_bytes, BLE_TX_QUEUE_BYTES, tx.queued_bytes_max,
+        tx.payloads_rejected, tx.payloads_dropped, tx.retries,
+        tx.mbuf_stalls, tx.throughput_bps);
+    if (g_ble.ppg_bus_sub != SAMPLE_BUS_INVALID_SUB || g_ble.ppg_batches > 0) {
+        BleTxStats ptx;
+        ble_tx_get_stats(&g_ble.ppg_tx, &ptx);
+        Serial.printf("[BLE STATS] PPG流:%s 批:%lu(目标%u样本 二阶%lu) 样本:%lu %lu.%02lu字节/对 等待:%lu 作废帧:%lu 丢弃:%lu 吞吐:%luB/s\n",
+            g_ble.ppg_bus_sub != SAMPLE_BUS_INVALID_SUB ? "on" : "off",
+            g_ble.ppg_batches, g_ble.ppg_batch_target, g_ble.ppg_order2_batches, g_ble.ppg_samples,
+            g_ble.ppg_samples ? g_ble.ppg_bytes / g_ble.ppg_samples : 0,
+            g_ble.ppg_samples ? (g_ble.ppg_bytes * 100 / g_ble.ppg_samples) % 100 : 0,
+            g_ble.ppg_stalls, g_ble.ppg_discarded, ptx.payloads_dropped, ptx.throughput_bps);
+    }
+    Serial.printf("[BLE STATS] 历史:%s 离线记录:%lu 已发送:%lu 同步:%lu次（最近 %lu条/%lums）\n",
+        g_ble.history_active ? "同步中" : "空闲", g_ble.history_records_logged,
+        g_ble.history_records_sent, g_ble.history_syncs,
+        g_ble.history_last_sync_records, g_ble.history_last_sync_ms);
+    history_log_print_stats();
 #endif
 }
\ No newline at end of file
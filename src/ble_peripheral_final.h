@@ -2,17 +2,103 @@
 #define BLE_PERIPHERAL_FINAL_H
 
 #include <Arduino.h>
+#include "ble_tx_queue_final.h"
 
 #define BLE_DEVICE_NAME     "DiabetesSensor"
 
+// 通知负载格式：二进制遥测帧（见 telemetry_packet.h）或兼容 App Inventor APP 的 JSON
+typedef enum {
+    BLE_PAYLOAD_BINARY = 0,
+    BLE_PAYLOAD_JSON
+} BlePayloadFormat;
+
+#ifndef BLE_PAYLOAD_DEFAULT
+#define BLE_PAYLOAD_DEFAULT BLE_PAYLOAD_BINARY
+#endif
+
+// 链路模式：GATT 连接通知、无连接广播（厂商数据携带最新遥测帧），或两者同时
+typedef enum {
+    BLE_MODE_GATT = 0,
+    BLE_MODE_BROADCAST,
+    BLE_MODE_GATT_BROADCAST
+} BleLinkMode;
+
+#ifndef BLE_MODE_DEFAULT
+#define BLE_MODE_DEFAULT BLE_MODE_GATT
+#endif
+
+// 连接参数档位（按需求从低到高，参数见 config/ble_config.h）
+typedef enum {
+    BLE_CONN_PROFILE_IDLE = 0,   // 空闲摘要：长间隔 + 从机延迟
+    BLE_CONN_PROFILE_STREAM,     // PPG波形流：短间隔
+    BLE_CONN_PROFILE_BULK,       // 历史批量：最短间隔
+    BLE_CONN_PROFILE_COUNT
+} BleConnProfile;
+
+// 各档位累计（能耗为模型估算，见 BLE_ENERGY_*）
+typedef struct {
+    uint32_t time_ms;
+    uint32_t bytes;              // 交给协议栈的通知负载
+    uint32_t events;             // 估算的连接事件数
+    uint32_t energy_uj;
+} BleConnEnergy;
+
 typedef struct {
+    uint8_t mode;                // BleLinkMode
+    uint32_t broadcast_updates;  // 广播负载更新次数
     uint8_t is_connected;
     uint32_t total_notifications;
     uint32_t total_bytes_sent;
+    uint8_t payload_format;      // BlePayloadFormat
+    uint16_t last_payload_len;   // 最近一次数据负载字节数
+    
+    // 当前连接的链路参数
+    uint16_t att_mtu;            // 协商后的ATT MTU（未协商为默认23）
+    uint16_t max_notify_len;     // 单次通知负载上限（MTU - 3）
+    uint16_t dle_tx_octets;      // 已请求的链路层负载（0 = 未请求；NimBLE 1.4 不回调协商结果）
+    uint8_t tx_phy;              // 1=1M 2=2M 3=Coded（0 = 未知）
+    uint8_t rx_phy;
+    uint32_t fragmented_payloads; // 超过单次通知上限、退回分片发送的负载数
+    uint32_t json_overflows;     // JSON 兼容模式下缓冲不足、未发送的负载数
+    
+    BleTxStats tx;               // 发送队列（排队字节、丢弃、重试、吞吐）
+    
+    // 连接参数管理
+    uint8_t conn_profile;        // BleConnProfile（已请求）
+    uint16_t conn_interval_x100; // 生效的连接间隔（0.01ms）
+    uint16_t conn_latency;
+    uint32_t conn_param_requests;
+    uint32_t notify_skipped;     // 结果未变化而省去的通知
+    uint32_t field_notifications; // 分字段特征值的通知
+    uint32_t field_suppressed;   // 分字段变化在死区内而省去的通知
+    BleConnEnergy energy[BLE_CONN_PROFILE_COUNT];
+    
+    // 原始PPG波形流（中心订阅波形特征值时）
+    uint8_t ppg_streaming;
+    uint8_t ppg_batch_target;    // 当前每批样本数（随连接间隔）
+    uint32_t ppg_batches;
+    uint32_t ppg_samples;
+    uint32_t ppg_bytes;          // 含帧头与CRC
+    uint32_t ppg_stalls;         // 发送队列满，样本留在总线上
+    uint32_t ppg_discarded;      // 编码期间样本被覆盖，整帧作废
+    uint16_t ppg_bytes_per_pair_x100;
+    
+    // 离线历史（未连接时记录，重连后由中心拉取）
+    uint8_t history_syncing;
+    uint32_t history_records_logged;
+    uint32_t history_records_sent;
+    uint32_t history_syncs;
+    uint32_t history_last_sync_ms;
+    uint32_t history_last_sync_records;
 } BleStats;
 
 void ble_peripheral_init();
-void ble_peripheral_send_data();
+void ble_peripheral_send_data();  // 未连接时写入离线历史
+void ble_peripheral_poll();      // 通信任务周期调用：按协议栈空闲缓冲继续发送队列中的块，推送历史同步与PPG波形流
+void ble_peripheral_set_payload_format(BlePayloadFormat format);
+BlePayloadFormat ble_peripheral_get_payload_format();
+void ble_peripheral_set_mode(BleLinkMode mode);   // 广播在下一次 ble_peripheral_poll() 重新配置
+BleLinkMode ble_peripheral_get_mode();
 
 uint8_t ble_peripheral_is_connected();
 uint32_t ble_peripheral_get_notifications_sent();
@@ -0,0 +1,152 @@
+/*
+ * ble_tx_queue_final.cpp - BLE 通知发送队列（按协议栈缓冲限流）
+ *
+ * 环形缓冲按块存放：[2字节头][数据]，头低15位为块长，最高位标记负载的首块。
+ * 读写位置自由递增（uint16），取模访问，空满由差值判断。
+ */
+
+#include <Arduino.h>
+#include "ble_tx_queue_final.h"
+
+#define BLE_TX_HEADER_LEN        2
+#define BLE_TX_FLAG_FIRST        0x8000
+#define BLE_TX_LEN_MASK          0x7FFF
+
+// ==================== 私有函数 ====================
+
+static uint16_t tx_used(const BleTxQueue* q) {
+    return (uint16_t)(q->write_pos - q->read_pos);
+}
+
+static void tx_put(BleTxQueue* q, uint8_t byte) {
+    q->ring[q->write_pos & BLE_TX_QUEUE_MASK] = byte;
+    q->write_pos++;
+}
+
+static uint8_t tx_at(const BleTxQueue* q, uint16_t pos) {
+    return q->ring[pos & BLE_TX_QUEUE_MASK];
+}
+
+static uint16_t tx_head_header(const BleTxQueue* q) {
+    return (uint16_t)tx_at(q, q->read_pos) | ((uint16_t)tx_at(q, q->read_pos + 1) << 8);
+}
+
+static void tx_pop_head(BleTxQueue* q) {
+    uint16_t len = tx_head_header(q) & BLE_TX_LEN_MASK;
+    q->read_pos += BLE_TX_HEADER_LEN + len;
+}
+
+// 丢弃队首块所属负载的剩余块（直到下一条负载的首块）
+static void tx_drop_payload(BleTxQueue* q) {
+    tx_pop_head(q);
+    while (tx_used(q) > 0 && !(tx_head_header(q) & BLE_TX_FLAG_FIRST)) {
+        tx_pop_head(q);
+    }
+    q->head_retries = 0;
+    q->stats.payloads_dropped++;
+}
+
+static void tx_update_rate(BleTxQueue* q, uint32_t now_ms) {
+    uint32_t window = now_ms - q->window_start_ms;
+    if (window >= BLE_TX_RATE_WINDOW_MS) {
+        q->stats.throughput_bps = (uint32_t)((uint64_t)q->window_bytes * 1000 / window);
+        q->window_bytes = 0;
+        q->window_start_ms = now_ms;
+    }
+}
+
+// ==================== 公共函数 ====================
+
+void ble_tx_init(BleTxQueue* q, BleTxSendFn send) {
+    memset(q, 0, sizeof(BleTxQueue));
+    q->send = send;
+    q->window_start_ms = millis();
+}
+
+void ble_tx_reset(BleTxQueue* q) {
+    while (tx_used(q) > 0) {
+        tx_drop_payload(q);
+    }
+    q->read_pos = q->write_pos = 0;
+    q->head_retries = 0;
+}
+
+uint8_t ble_tx_enqueue(BleTxQueue* q, const uint8_t* data, uint16_t len, uint16_t chunk_len) {
+    if (len == 0) return 1;
+    if (chunk_len == 0 || chunk_len > BLE_TX_MAX_CHUNK) chunk_len = BLE_TX_MAX_CHUNK;
+
+    uint16_t chunks = (len + chunk_len - 1) / chunk_len;
+    uint16_t needed = len + chunks * BLE_TX_HEADER_LEN;
+    if (needed > ble_tx_free_bytes(q)) {
+        q->stats.payloads_rejected++;
+        return 0;
+    }
+
+    uint16_t offset = 0;
+    while (offset < len) {
+        uint16_t n = (len - offset > chunk_len) ? chunk_len : (len - offset);
+        uint16_t header = n | (offset == 0 ? BLE_TX_FLAG_FIRST : 0);
+        tx_put(q, (uint8_t)header);
+        tx_put(q, (uint8_t)(header >> 8));
+        for (uint16_t i = 0; i < n; i++) {
+            tx_put(q, data[offset + i]);
+        }
+        offset += n;
+    }
+
+    q->stats.payloads_enqueued++;
+    uint16_t used = tx_used(q);
+    if (used > q->stats.queued_bytes_max) q->stats.queued_bytes_max = used;
+    return 1;
+}
+
+uint16_t ble_tx_free_bytes(const BleTxQueue* q) {
+    return BLE_TX_QUEUE_BYTES - tx_used(q);
+}
+
+uint8_t ble_tx_idle(const BleTxQueue* q) {
+    return (tx_used(q) == 0) ? 1 : 0;
+}
+
+uint8_t ble_tx_pump(BleTxQueue* q, uint32_t now_ms) {
+    uint8_t sent = 0;
+    uint8_t chunk[BLE_TX_MAX_CHUNK];
+    while (tx_used(q) > 0) {
+        uint16_t len = tx_head_header(q) & BLE_TX_LEN_MASK;
+        uint16_t pos = q->read_pos + BLE_TX_HEADER_LEN;
+        for (uint16_t i = 0; i < len; i++) {
+            chunk[i] = tx_at(q, pos + i);
+        }
+
+        int rc = q->send(chunk, len);
+        if (rc == 0) {
+            tx_pop_head(q);
+            q->head_retries = 0;
+            q->stats.chunks_sent++;
+            q->stats.bytes_sent += len;
+            q->window_bytes += len;
+            sent++;
+            continue;
+        }
+
+        if (rc == BLE_TX_SEND_BUSY) {
+            q->stats.mbuf_stalls++;          // 协议栈缓冲不足：不算失败，下次再试
+        } else {
+            q->stats.retries++;
+            if (++q->head_retries > BLE_TX_MAX_RETRIES) {
+                tx_drop_payload(q);
+            }
+        }
+        break;
+    }
+
+    q->stats.queued_bytes = tx_used(q);
+    tx_update_rate(q, now_ms);
+    return sent;
+}
+
+void ble_tx_get_stats(const BleTxQueue* q, BleTxStats* stats) {
+    if (stats == NULL) return;
+    *stats = q->stats;
+    stats->queued_bytes = tx_used(q);
+}
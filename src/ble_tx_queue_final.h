@@ -0,0 +1,71 @@
+#ifndef BLE_TX_QUEUE_FINAL_H
+#define BLE_TX_QUEUE_FINAL_H
+
+#include <Arduino.h>
+
+/*
+ * ble_tx_queue_final.h - BLE 通知发送队列（按协议栈缓冲限流）
+ *
+ * 生产者把整条负载入队（按当前单次通知上限切块，全部放得下才入队，否则返回0由生产者稍后重试），
+ * 通信任务周期调用 ble_tx_pump() 发送：
+ *   - 限流只看协议栈缓冲：发送函数在空闲 mbuf（os_msys_num_free()）低于保留数时返回
+ *     BLE_TX_SEND_BUSY，本次暂停，下次 pump 再试；mbuf 在控制器把数据包发出后才释放，
+ *     因此它就是在途数据量。NimBLE 1.4 的通知“发送完成”（BLE_GAP_EVENT_NOTIFY_TX）
+ *     在 notify() 内部同步上报，不代表已发出，不用于流控
+ *   - 发送被拒绝（ENOMEM 等）时块保留在队首，有限次重试后丢弃整条负载的剩余块，
+ *     接收方不会收到拼接错乱的负载
+ * 统计：排队字节（当前/峰值）、拒绝入队、丢弃、重试、缓冲等待次数、实际吞吐。
+ */
+
+#define BLE_TX_QUEUE_BYTES       1024    // 必须为2的幂（块记录含2字节头）
+#define BLE_TX_QUEUE_MASK        (BLE_TX_QUEUE_BYTES - 1)
+#define BLE_TX_MAX_CHUNK         244     // 单块上限（MTU 247 - 3）
+#define BLE_TX_MAX_RETRIES       3
+#define BLE_TX_MIN_FREE_MBUFS    4       // 遥测：协议栈空闲缓冲低于此值时暂停发送（波形流/历史的保留数见 ble_config.h）
+#define BLE_TX_RATE_WINDOW_MS    5000    // 吞吐统计窗口
+
+// 发送一块：返回0表示协议栈已接受，BLE_TX_SEND_BUSY 表示缓冲不足（稍后再试，不计重试），
+// 其他值为拒绝（计入重试）
+#define BLE_TX_SEND_BUSY         1
+typedef int (*BleTxSendFn)(const uint8_t* data, uint16_t len);
+
+typedef struct {
+    uint16_t queued_bytes;           // 当前排队（含块头）
+    uint16_t queued_bytes_max;
+    uint32_t payloads_enqueued;
+    uint32_t payloads_rejected;      // 队列满，生产者被要求稍后重试
+    uint32_t payloads_dropped;       // 重试耗尽或断开时丢弃
+    uint32_t chunks_sent;
+    uint32_t bytes_sent;             // 被协议栈接受的负载字节（累计）
+    uint32_t retries;
+    uint32_t mbuf_stalls;            // 因协议栈缓冲不足暂停
+    uint32_t throughput_bps;         // 最近窗口内被协议栈接受的字节/秒
+} BleTxStats;
+
+typedef struct {
+    uint8_t ring[BLE_TX_QUEUE_BYTES];
+    uint16_t read_pos;               // 自由递增，取模访问
+    uint16_t write_pos;
+    uint8_t head_retries;
+    BleTxSendFn send;
+    BleTxStats stats;
+    uint32_t window_start_ms;
+    uint32_t window_bytes;
+} BleTxQueue;
+
+void ble_tx_init(BleTxQueue* q, BleTxSendFn send);
+
+// 断开连接：清空队列（未发完的负载计入丢弃）
+void ble_tx_reset(BleTxQueue* q);
+
+// 整条负载入队，按 chunk_len 切块；放不下返回0（背压）
+uint8_t ble_tx_enqueue(BleTxQueue* q, const uint8_t* data, uint16_t len, uint16_t chunk_len);
+uint16_t ble_tx_free_bytes(const BleTxQueue* q);
+uint8_t ble_tx_idle(const BleTxQueue* q);          // 队列空
+
+// 在协议栈缓冲允许的范围内依次发送队首的块，返回发送块数
+uint8_t ble_tx_pump(BleTxQueue* q, uint32_t now_ms);
+
+void ble_tx_get_stats(const BleTxQueue* q, BleTxStats* stats);
+
+#endif
@@ -0,0 +1,693 @@
+/*
+ * detector_link_final.cpp - 检测模块链路（腕带作为BLE中心）
+ *
+ * 传输层回调（NimBLE 主机任务）只在临界区内更新最新特征值并置 pending，
+ * 通信任务的 detector_link_poll() 把它们组成一份 ExternalReading 投递给算法管理器；
+ * 检测模块的错误码在此处生效（对应的测量项作废）。
+ */
+
+#include <Arduino.h>
+#include "../config/ble_config.h"
+#include "detector_link_final.h"
+#include "algorithm_manager_final.h"
+#include "task_runtime_final.h"
+
+#if defined(ESP32)
+#include <NimBLEDevice.h>
+#endif
+
+// ==================== 检测模块 GATT 定义（与 detection_sensor.ino 一致） ====================
+
+#define DETECTOR_SERVICE_UUID       "a1b2c3d4-e5f6-4789-abcd-ef0123456789"
+#define DETECTOR_HR_CHAR_UUID       "a1b2c3d4-e5f6-4789-abcd-ef012345678b"
+#define DETECTOR_SPO2_CHAR_UUID     "a1b2c3d4-e5f6-4789-abcd-ef012345678c"
+#define DETECTOR_ACETONE_CHAR_UUID  "a1b2c3d4-e5f6-4789-abcd-ef012345678d"
+#define DETECTOR_ERROR_CHAR_UUID    "a1b2c3d4-e5f6-4789-abcd-ef012345678e"
+
+// 按 DetectorValue 顺序
+static const char* const g_detector_char_uuids[DETECTOR_VALUE_COUNT] = {
+    DETECTOR_HR_CHAR_UUID, DETECTOR_SPO2_CHAR_UUID, DETECTOR_ACETONE_CHAR_UUID, DETECTOR_ERROR_CHAR_UUID
+};
+
+// ==================== 全局链路状态 ====================
+
+typedef struct {
+    const DetectorTransport* transport;
+    DetectorLinkState state;
+
+    // 最新特征值（传输层回调写入，临界区内读写）
+    uint8_t hr;                      // 0=无
+    uint8_t spo2;
+    uint8_t acetone_valid;
+    float acetone_ppm;
+    uint8_t error_code;
+    uint32_t last_value_ms;
+    volatile uint8_t pending;        // 自上次投递以来有新值
+
+    DetectorLinkStats stats;
+} DetectorLinkCore;
+
+static DetectorLinkCore g_link = {0};
+
+// ==================== 传输层上报 ====================
+
+void detector_link_on_state(DetectorLinkState state) {
+    DetectorLinkState prev = g_link.state;
+    if (state == prev) return;
+    g_link.state = state;
+
+    if (prev == DETECTOR_LINK_CONNECTED) {
+        g_link.stats.disconnects++;
+    } else if (prev == DETECTOR_LINK_CONNECTING && state != DETECTOR_LINK_CONNECTED) {
+        g_link.stats.connect_failures++;
+    }
+
+    if (state == DETECTOR_LINK_SCANNING) {
+        g_link.stats.scans++;
+    } else if (state == DETECTOR_LINK_CONNECTING) {
+        // 新会话：错误码只在非0时通知，以连接后读取的初值为准
+        task_runtime_enter_critical();
+        g_link.error_code = DETECTOR_ERR_NONE;
+        task_runtime_exit_critical();
+    } else if (state == DETECTOR_LINK_CONNECTED) {
+        g_link.stats.connects++;
+    }
+
+#ifdef DEBUG_MODE
+    if (state == DETECTOR_LINK_CONNECTED) {
+        Serial.println("[LINK] 检测模块已连接");
+    } else if (prev == DETECTOR_LINK_CONNECTED) {
+        Serial.println("[LINK] 检测模块断开");
+    }
+#endif
+}
+
+// 值格式见 DetectorValue；空值（未设置过的特征值）按"无"处理
+void detector_link_on_value(DetectorValue which, const uint8_t* data, uint16_t len) {
+    if ((uint8_t)which >= DETECTOR_VALUE_COUNT) return;
+
+    float ppm = -1.0f;
+    if (which == DETECTOR_VALUE_ACETONE) {
+        if (len == sizeof(float)) {
+            memcpy(&ppm, data, sizeof(float));      // 两端均为小端
+        } else if (len != 0) {
+            g_link.stats.malformed++;
+            return;
+        }
+    } else if (len > 1) {
+        g_link.stats.malformed++;
+        return;
+    }
+    uint8_t u8 = (len >= 1) ? data[0] : 0;
+
+    task_runtime_enter_critical();
+    switch (which) {
+        case DETECTOR_VALUE_HR:
+            g_link.hr = (u8 == 0xFF) ? 0 : u8;
+            break;
+        case DETECTOR_VALUE_SPO2:
+            g_link.spo2 = (u8 == 0xFF || u8 > 100) ? 0 : u8;
+            break;
+        case DETECTOR_VALUE_ACETONE:
+            g_link.acetone_valid = (ppm >= 0.0f) ? 1 : 0;        // NaN 比较为假
+            g_link.acetone_ppm = g_link.acetone_valid ? ppm : 0.0f;
+            break;
+        default:
+            g_link.error_code = u8;
+            break;
+    }
+    g_link.stats.values[which]++;
+    g_link.last_value_ms = millis();
+    g_link.pending = 1;
+    task_runtime_exit_critical();
+}
+
+// ==================== 初始化与轮询 ====================
+
+uint8_t detector_link_init(const DetectorTransport* transport) {
+    detector_link_stop();
+    memset(&g_link, 0, sizeof(DetectorLinkCore));
+
+    if (transport == NULL) {
+#if defined(ESP32)
+        transport = nimble_detector_transport_get();
+#else
+        transport = loopback_detector_transport_get();
+#endif
+    }
+
+    uint8_t ok = transport->start();
+    g_link.transport = ok ? transport : NULL;
+    Serial.printf("[LINK] 检测模块链路：%s%s\n", transport->name, ok ? "" : "（启动失败）");
+    return ok;
+}
+
+void detector_link_stop() {
+    if (g_link.transport == NULL) return;
+    g_link.transport->stop();
+    g_link.transport = NULL;
+}
+
+void detector_link_poll(uint32_t now_ms) {
+    if (g_link.transport == NULL) return;
+    g_link.transport->poll(now_ms);
+    if (!g_link.pending) return;
+
+    ExternalReading reading;
+    task_runtime_enter_critical();
+    reading.received_ms = g_link.last_value_ms;
+    reading.bpm = g_link.hr;
+    reading.spo2 = g_link.spo2;
+    reading.acetone_valid = g_link.acetone_valid;
+    reading.acetone_ppm = g_link.acetone_ppm;
+    reading.error_code = g_link.error_code;
+    g_link.pending = 0;
+    task_runtime_exit_critical();
+
+    // 错误码所指的测量作废（检测模块此时仍在发送上次的值或占位值）
+    if (reading.error_code == DETECTOR_ERR_PPG) {
+        reading.bpm = 0;
+        reading.spo2 = 0;
+    } else if (reading.error_code == DETECTOR_ERR_SNO2) {
+        reading.acetone_valid = 0;
+    }
+
+    algorithm_manager_submit_external(&reading);
+    g_link.stats.submitted++;
+}
+
+uint8_t detector_link_is_connected() {
+    return g_link.state == DETECTOR_LINK_CONNECTED;
+}
+
+// ==================== NimBLE 中心 ====================
+
+#if defined(ESP32)
+
+// NimBLE-Arduino 1.4 的 NimBLEClient::connect()/getService()/subscribe()/readValue() 都在调用任务中
+// 等待协议栈完成；这里直接用主机层的 GAP/GATT 客户端接口：每次 poll 只发起一个过程，
+// 完成回调（主机任务）记下结果，通信任务下次 poll 再推进，不在通信任务中等待。
+
+#define NIMBLE_DETECTOR_REJECT_SLOTS 4   // 广播同一服务但不是检测模块的设备（其他腕带）
+#define NIMBLE_DETECTOR_VALUE_MAX    8   // 通知/读取值的拷贝上限（超长值截断后长度不符，按 malformed 丢弃）
+#define NIMBLE_UUID_CCCD             0x2902
+#define NIMBLE_SETUP_DONE            (-1)
+
+// 连接建立的步骤（g_nb.step 为最近发起的一步）；每个特征值依次 VALUE_BEGIN → DISC_CCCD → SUBSCRIBE → READ，
+// 对端没有的特征值与不支持的步骤跳过
+typedef enum {
+    NB_STEP_CONNECT = 0,             // ble_gap_connect，等待 BLE_GAP_EVENT_CONNECT
+    NB_STEP_DISC_SVC,
+    NB_STEP_DISC_CHRS,
+    NB_STEP_VALUE_BEGIN,             // 开始处理 step_value（不对应GATT过程）
+    NB_STEP_DISC_CCCD,
+    NB_STEP_SUBSCRIBE,
+    NB_STEP_READ
+} NimbleSetupStep;
+
+typedef struct {
+    DetectorLinkState state;
+    NimBLEScan* scan;
+    NimBLEUUID service_uuid;
+    NimBLEUUID char_uuids[DETECTOR_VALUE_COUNT];
+    NimBLEAddress candidate;
+    volatile uint8_t candidate_found;
+    volatile uint8_t scan_done;
+    volatile uint8_t disconnected;
+    volatile uint16_t conn_handle;
+
+    // 连接建立（GATT 过程的回调写入结果并置 op_done）
+    NimbleSetupStep step;
+    uint8_t step_value;
+    volatile uint8_t op_done;
+    volatile int op_status;
+    uint32_t setup_deadline_ms;
+    uint16_t svc_start;              // 0=对端没有检测服务
+    uint16_t svc_end;
+    uint8_t last_chr;                // 最近发现的本方特征值（结束句柄待下一个特征值声明确定）
+    uint16_t val_handles[DETECTOR_VALUE_COUNT];  // 0=对端没有该特征值
+    uint16_t end_handles[DETECTOR_VALUE_COUNT];  // 描述符范围的结束句柄
+    uint16_t cccd_handles[DETECTOR_VALUE_COUNT];
+    uint8_t props[DETECTOR_VALUE_COUNT];
+
+    uint32_t next_attempt_ms;
+    uint32_t retry_ms;
+    NimBLEAddress rejected[NIMBLE_DETECTOR_REJECT_SLOTS];
+    uint8_t rejected_count;
+    uint8_t rejected_next;
+} NimbleDetectorState;
+
+static NimbleDetectorState g_nb;
+
+static void nimble_set_state(DetectorLinkState state) {
+    g_nb.state = state;
+    detector_link_on_state(state);
+}
+
+static uint8_t nimble_is_rejected(const NimBLEAddress& addr) {
+    for (uint8_t i = 0; i < g_nb.rejected_count; i++) {
+        if (g_nb.rejected[i] == addr) return 1;
+    }
+    return 0;
+}
+
+static void nimble_reject(const NimBLEAddress& addr) {
+    g_nb.rejected[g_nb.rejected_next] = addr;
+    g_nb.rejected_next = (g_nb.rejected_next + 1) % NIMBLE_DETECTOR_REJECT_SLOTS;
+    if (g_nb.rejected_count < NIMBLE_DETECTOR_REJECT_SLOTS) g_nb.rejected_count++;
+}
+
+// 未找到或连接失败：退避后重扫，连续失败间隔翻倍
+static void nimble_backoff(uint32_t now_ms) {
+    g_nb.next_attempt_ms = now_ms + g_nb.retry_ms;
+    g_nb.retry_ms = (g_nb.retry_ms * 2 > BLE_DETECTOR_RETRY_MAX_MS) ? BLE_DETECTOR_RETRY_MAX_MS : g_nb.retry_ms * 2;
+    nimble_set_state(DETECTOR_LINK_IDLE);
+}
+
+// 扫描回调（主机任务）：只记下第一个广播检测服务的设备，连接由通信任务发起
+class DetectorScanCallbacks : public NimBLEAdvertisedDeviceCallbacks {
+    void onResult(NimBLEAdvertisedDevice* device) {
+        if (g_nb.candidate_found || !device->isAdvertisingService(g_nb.service_uuid)) return;
+        if (nimble_is_rejected(device->getAddress())) return;
+        g_nb.candidate = device->getAddress();
+        g_nb.candidate_found = 1;
+        NimBLEDevice::getScan()->stop();
+    }
+};
+
+static DetectorScanCallbacks g_nb_scan_callbacks;
+
+static void nimble_scan_done(NimBLEScanResults results) {
+    g_nb.scan_done = 1;
+}
+
+// ──────────────────────────────────────────────
+// 主机任务回调
+
+static void nimble_op_finish(int status) {
+    g_nb.op_status = status;
+    g_nb.op_done = 1;
+}
+
+// 通知或读取到的值：按值句柄找到特征值
+static void nimble_deliver(uint16_t attr_handle, const struct os_mbuf* om) {
+    for (uint8_t i = 0; i < DETECTOR_VALUE_COUNT; i++) {
+        if (g_nb.val_handles[i] == 0 || g_nb.val_handles[i] != attr_handle) continue;
+        uint8_t data[NIMBLE_DETECTOR_VALUE_MAX];
+        uint16_t len = OS_MBUF_PKTLEN(om);
+        if (len > sizeof(data)) len = sizeof(data);
+        os_mbuf_copydata(om, 0, len, data);
+        detector_link_on_value((DetectorValue)i, data, len);
+        return;
+    }
+}
+
+static int nimble_gap_event(struct ble_gap_event* event, void* arg) {
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONNECT:
+            if (event->connect.status == 0) g_nb.conn_handle = event->connect.conn_handle;
+            nimble_op_finish(event->connect.status);    // 超时或被取消时 status 非0
+            return 0;
+
+        case BLE_GAP_EVENT_DISCONNECT:
+            if (event->disconnect.conn.conn_handle != g_nb.conn_handle) return 0;  // 上一次会话的迟到事件
+            g_nb.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+            g_nb.disconnected = 1;
+            return 0;
+
+        case BLE_GAP_EVENT_NOTIFY_RX:
+            nimble_deliver(event->notify_rx.attr_handle, event->notify_rx.om);
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+static int nimble_on_service(uint16_t conn_handle, const struct ble_gatt_error* error,
+                             const struct ble_gatt_svc* service, void* arg) {
+    if (error->status == 0) {
+        g_nb.svc_start = service->start_handle;
+        g_nb.svc_end = service->end_handle;
+        return 0;
+    }
+    nimble_op_finish(error->status == BLE_HS_EDONE ? 0 : error->status);
+    return 0;
+}
+
+// 特征值按句柄顺序返回：下一个特征值的声明之前是上一个特征值的描述符
+static int nimble_on_characteristic(uint16_t conn_handle, const struct ble_gatt_error* error,
+                                    const struct ble_gatt_chr* chr, void* arg) {
+    if (error->status != 0) {
+        nimble_op_finish(error->status == BLE_HS_EDONE ? 0 : error->status);
+        return 0;
+    }
+    if (g_nb.last_chr < DETECTOR_VALUE_COUNT) g_nb.end_handles[g_nb.last_chr] = chr->def_handle - 1;
+    g_nb.last_chr = DETECTOR_VALUE_COUNT;
+    for (uint8_t i = 0; i < DETECTOR_VALUE_COUNT; i++) {
+        if (ble_uuid_cmp(&chr->uuid.u, &g_nb.char_uuids[i].getNative()->u) != 0) continue;
+        g_nb.val_handles[i] = chr->val_handle;
+        g_nb.end_handles[i] = g_nb.svc_end;
+        g_nb.props[i] = chr->properties;
+        g_nb.last_chr = i;
+        break;
+    }
+    return 0;
+}
+
+static int nimble_on_descriptor(uint16_t conn_handle, const struct ble_gatt_error* error,
+                                uint16_t chr_val_handle, const struct ble_gatt_dsc* dsc, void* arg) {
+    if (error->status != 0) {
+        nimble_op_finish(error->status == BLE_HS_EDONE ? 0 : error->status);
+        return 0;
+    }
+    if (dsc->uuid.u.type == BLE_UUID_TYPE_16 && dsc->uuid.u16.value == NIMBLE_UUID_CCCD) {
+        g_nb.cccd_handles[g_nb.step_value] = dsc->handle;
+    }
+    return 0;
+}
+
+static int nimble_on_write(uint16_t conn_handle, const struct ble_gatt_error* error,
+                           struct ble_gatt_attr* attr, void* arg) {
+    nimble_op_finish(error->status);
+    return 0;
+}
+
+static int nimble_on_read(uint16_t conn_handle, const struct ble_gatt_error* error,
+                          struct ble_gatt_attr* attr, void* arg) {
+    if (error->status == 0) nimble_deliver(attr->handle, attr->om);
+    nimble_op_finish(error->status);
+    return 0;
+}
+
+// ──────────────────────────────────────────────
+// 连接建立（通信任务）
+
+// 从当前步骤之后找到下一个GATT过程并发起：返回0已发起，NIMBLE_SETUP_DONE 全部完成，其余为错误码
+static int nimble_setup_next() {
+    uint16_t conn = g_nb.conn_handle;
+    static const uint8_t cccd_notify[2] = {0x01, 0x00};
+
+    for (;;) {
+        uint8_t i = g_nb.step_value;
+        switch (g_nb.step) {
+            case NB_STEP_CONNECT:
+                g_nb.step = NB_STEP_DISC_SVC;
+                return ble_gattc_disc_svc_by_uuid(conn, &g_nb.service_uuid.getNative()->u, nimble_on_service, NULL);
+
+            case NB_STEP_DISC_SVC:
+                g_nb.step = NB_STEP_DISC_CHRS;
+                g_nb.last_chr = DETECTOR_VALUE_COUNT;
+                return ble_gattc_disc_all_chrs(conn, g_nb.svc_start, g_nb.svc_end, nimble_on_characteristic, NULL);
+
+            case NB_STEP_DISC_CHRS:
+                g_nb.step_value = 0;
+                g_nb.step = NB_STEP_VALUE_BEGIN;
+                break;
+
+            case NB_STEP_VALUE_BEGIN:
+                if (i >= DETECTOR_VALUE_COUNT) return NIMBLE_SETUP_DONE;
+                if (g_nb.val_handles[i] != 0 && (g_nb.props[i] & BLE_GATT_CHR_PROP_NOTIFY)) {
+                    if (g_nb.end_handles[i] <= g_nb.val_handles[i]) return BLE_HS_ENOENT;  // 可通知却没有描述符
+                    g_nb.step = NB_STEP_DISC_CCCD;
+                    return ble_gattc_disc_all_dscs(conn, g_nb.val_handles[i], g_nb.end_handles[i],
+                                                   nimble_on_descriptor, NULL);
+                }
+                g_nb.step = NB_STEP_SUBSCRIBE;
+                break;
+
+            case NB_STEP_DISC_CCCD:
+                if (g_nb.cccd_handles[i] == 0) return BLE_HS_ENOENT;
+                g_nb.step = NB_STEP_SUBSCRIBE;
+                return ble_gattc_write_flat(conn, g_nb.cccd_handles[i], cccd_notify, sizeof(cccd_notify),
+                                            nimble_on_write, NULL);
+
+            case NB_STEP_SUBSCRIBE:
+                g_nb.step = NB_STEP_READ;
+                if (g_nb.val_handles[i] != 0 && (g_nb.props[i] & BLE_GATT_CHR_PROP_READ)) {
+                    return ble_gattc_read(conn, g_nb.val_handles[i], nimble_on_read, NULL);
+                }
+                break;
+
+            default:                 // NB_STEP_READ：本特征值完成
+                g_nb.step_value++;
+                g_nb.step = NB_STEP_VALUE_BEGIN;
+                break;
+        }
+    }
+}
+
+static void nimble_connect_start(uint32_t now_ms) {
+    ble_addr_t peer;
+    peer.type = g_nb.candidate.getType();
+    memcpy(peer.val, g_nb.candidate.getNative(), sizeof(peer.val));
+
+    // 发现服务与订阅期间用短间隔
+    struct ble_gap_conn_params params;
+    memset(&params, 0, sizeof(params));
+    params.scan_itvl = 16;
+    params.scan_window = 16;
+    params.itvl_min = BLE_CONN_STREAM_INTERVAL_MIN;
+    params.itvl_max = BLE_CONN_STREAM_INTERVAL_MAX;
+    params.latency = BLE_CONN_STREAM_LATENCY;
+    params.supervision_timeout = BLE_CONN_STREAM_TIMEOUT;
+
+    memset(g_nb.val_handles, 0, sizeof(g_nb.val_handles));
+    memset(g_nb.cccd_handles, 0, sizeof(g_nb.cccd_handles));
+    memset(g_nb.props, 0, sizeof(g_nb.props));
+    g_nb.svc_start = 0;
+    g_nb.svc_end = 0;
+    g_nb.step = NB_STEP_CONNECT;
+    g_nb.step_value = 0;
+    g_nb.op_done = 0;
+    g_nb.disconnected = 0;
+    g_nb.setup_deadline_ms = now_ms + BLE_DETECTOR_CONNECT_TIMEOUT_MS + BLE_DETECTOR_SETUP_TIMEOUT_MS;
+    nimble_set_state(DETECTOR_LINK_CONNECTING);
+
+    if (ble_gap_connect(BLE_OWN_ADDR_PUBLIC, &peer, BLE_DETECTOR_CONNECT_TIMEOUT_MS, &params,
+                        nimble_gap_event, NULL) != 0) {
+        nimble_backoff(now_ms);
+    }
+}
+
+// 建立失败：断开（或取消未完成的连接）后退避重扫
+static void nimble_setup_failed(uint32_t now_ms) {
+    if (g_nb.conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+        ble_gap_terminate(g_nb.conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+    } else if (g_nb.step == NB_STEP_CONNECT) {
+        ble_gap_conn_cancel();
+    }
+    nimble_backoff(now_ms);
+}
+
+// 上一步完成：检查结果并发起下一步；全部完成后降到空闲档
+static void nimble_setup_poll(uint32_t now_ms) {
+    if (g_nb.disconnected) {
+        nimble_backoff(now_ms);
+        return;
+    }
+    if (!g_nb.op_done) {
+        if ((int32_t)(now_ms - g_nb.setup_deadline_ms) >= 0) nimble_setup_failed(now_ms);
+        return;
+    }
+    g_nb.op_done = 0;
+    if (g_nb.op_status != 0) {
+        nimble_setup_failed(now_ms);
+        return;
+    }
+
+    // 另一只腕带也广播同一服务UUID，但没有 …678b~678e：以丙酮与错误码特征值确认对端是检测模块
+    if ((g_nb.step == NB_STEP_DISC_SVC && g_nb.svc_start == 0) ||
+        (g_nb.step == NB_STEP_DISC_CHRS &&
+         (g_nb.val_handles[DETECTOR_VALUE_ACETONE] == 0 || g_nb.val_handles[DETECTOR_VALUE_ERROR] == 0))) {
+        nimble_reject(g_nb.candidate);
+        nimble_setup_failed(now_ms);
+        return;
+    }
+
+    int rc = nimble_setup_next();
+    if (rc == NIMBLE_SETUP_DONE) {
+        // 检测模块约95秒通知一次：订阅完成后降到空闲档
+        struct ble_gap_upd_params idle;
+        memset(&idle, 0, sizeof(idle));
+        idle.itvl_min = BLE_CONN_IDLE_INTERVAL_MIN;
+        idle.itvl_max = BLE_CONN_IDLE_INTERVAL_MAX;
+        idle.latency = BLE_CONN_IDLE_LATENCY;
+        idle.supervision_timeout = BLE_CONN_IDLE_TIMEOUT;
+        ble_gap_update_params(g_nb.conn_handle, &idle);
+        g_nb.retry_ms = BLE_DETECTOR_RETRY_MIN_MS;
+        nimble_set_state(DETECTOR_LINK_CONNECTED);
+    } else if (rc != 0) {
+        nimble_setup_failed(now_ms);
+    }
+}
+
+static uint8_t nimble_start() {
+    g_nb.service_uuid = NimBLEUUID(DETECTOR_SERVICE_UUID);
+    for (uint8_t i = 0; i < DETECTOR_VALUE_COUNT; i++) {
+        g_nb.char_uuids[i] = NimBLEUUID(g_detector_char_uuids[i]);
+    }
+    g_nb.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+
+    g_nb.scan = NimBLEDevice::getScan();
+    g_nb.scan->setAdvertisedDeviceCallbacks(&g_nb_scan_callbacks, false);
+    g_nb.scan->setActiveScan(false);     // 服务UUID在广播包中，不需要扫描请求
+    g_nb.scan->setInterval(BLE_DETECTOR_SCAN_INTERVAL_MS);
+    g_nb.scan->setWindow(BLE_DETECTOR_SCAN_WINDOW_MS);
+    g_nb.scan->setMaxResults(0);         // 只用回调，不缓存扫描结果
+
+    g_nb.retry_ms = BLE_DETECTOR_RETRY_MIN_MS;
+    g_nb.next_attempt_ms = millis();
+    nimble_set_state(DETECTOR_LINK_IDLE);
+    return 1;
+}
+
+static void nimble_stop() {
+    if (g_nb.scan && g_nb.scan->isScanning()) g_nb.scan->stop();
+    if (g_nb.conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+        ble_gap_terminate(g_nb.conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+    } else if (g_nb.state == DETECTOR_LINK_CONNECTING) {
+        ble_gap_conn_cancel();
+    }
+    nimble_set_state(DETECTOR_LINK_IDLE);
+}
+
+static void nimble_poll(uint32_t now_ms) {
+    switch (g_nb.state) {
+        case DETECTOR_LINK_IDLE:
+            if ((int32_t)(now_ms - g_nb.next_attempt_ms) < 0) return;
+            g_nb.candidate_found = 0;
+            g_nb.scan_done = 0;
+            if (!g_nb.scan->start((BLE_DETECTOR_SCAN_MS + 999) / 1000, nimble_scan_done, false)) {
+                nimble_backoff(now_ms);
+                return;
+            }
+            nimble_set_state(DETECTOR_LINK_SCANNING);
+            return;
+
+        case DETECTOR_LINK_SCANNING:
+            if (g_nb.candidate_found) {
+                if (g_nb.scan->isScanning()) g_nb.scan->stop();
+                nimble_connect_start(now_ms);
+            } else if (g_nb.scan_done) {
+                nimble_backoff(now_ms);
+            }
+            return;
+
+        case DETECTOR_LINK_CONNECTING:
+            nimble_setup_poll(now_ms);
+            return;
+
+        case DETECTOR_LINK_CONNECTED:
+            if (g_nb.disconnected) {
+                g_nb.retry_ms = BLE_DETECTOR_RETRY_MIN_MS;
+                g_nb.next_attempt_ms = now_ms + BLE_DETECTOR_RETRY_MIN_MS;
+                nimble_set_state(DETECTOR_LINK_IDLE);
+            }
+            return;
+
+        default:
+            return;
+    }
+}
+
+static const DetectorTransport g_nimble_transport = {
+    DETECTOR_TRANSPORT_NIMBLE,
+    "nimble",
+    nimble_start,
+    nimble_stop,
+    nimble_poll
+};
+
+const DetectorTransport* nimble_detector_transport_get() {
+    return &g_nimble_transport;
+}
+
+#endif // ESP32
+
+// ==================== 进程内回环 ====================
+
+#define LOOPBACK_VALUE_MAX 8
+
+typedef struct {
+    uint8_t present;
+    uint8_t connected;
+    uint8_t value[DETECTOR_VALUE_COUNT][LOOPBACK_VALUE_MAX];
+    uint8_t len[DETECTOR_VALUE_COUNT];
+} LoopbackDetectorState;
+
+static LoopbackDetectorState g_loop = {0};
+
+static uint8_t loopback_start() {
+    g_loop.connected = 0;
+    return 1;
+}
+
+static void loopback_stop() {
+    if (!g_loop.connected) return;
+    g_loop.connected = 0;
+    detector_link_on_state(DETECTOR_LINK_IDLE);
+}
+
+static void loopback_poll(uint32_t now_ms) {
+    if (g_loop.present && !g_loop.connected) {
+        detector_link_on_state(DETECTOR_LINK_CONNECTING);
+        for (uint8_t i = 0; i < DETECTOR_VALUE_COUNT; i++) {
+            detector_link_on_value((DetectorValue)i, g_loop.value[i], g_loop.len[i]);    // 初值读取
+        }
+        g_loop.connected = 1;
+        detector_link_on_state(DETECTOR_LINK_CONNECTED);
+    } else if (!g_loop.present && g_loop.connected) {
+        g_loop.connected = 0;
+        detector_link_on_state(DETECTOR_LINK_IDLE);
+    }
+}
+
+void detector_loopback_set_present(uint8_t present) {
+    g_loop.present = present;
+}
+
+void detector_loopback_notify(DetectorValue which, const uint8_t* data, uint16_t len) {
+    if ((uint8_t)which >= DETECTOR_VALUE_COUNT) return;
+    g_loop.len[which] = (len > LOOPBACK_VALUE_MAX) ? LOOPBACK_VALUE_MAX : (uint8_t)len;
+    memcpy(g_loop.value[which], data, g_loop.len[which]);
+    if (g_loop.connected) {
+        detector_link_on_value(which, data, len);
+    }
+}
+
+static const DetectorTransport g_loopback_transport = {
+    DETECTOR_TRANSPORT_LOOPBACK,
+    "loopback",
+    loopback_start,
+    loopback_stop,
+    loopback_poll
+};
+
+const DetectorTransport* loopback_detector_transport_get() {
+    return &g_loopback_transport;
+}
+
+// ==================== 统计信息 ====================
+
+void detector_link_get_stats(DetectorLinkStats* stats) {
+    if (stats == NULL) return;
+    *stats = g_link.stats;
+    stats->state = g_link.state;
+    stats->transport = g_link.transport ? g_link.transport->name : "-";
+    stats->last_value_ms = g_link.last_value_ms;
+    stats->error_code = g_link.error_code;
+}
+
+void detector_link_print_stats() {
+#ifdef DEBUG_MODE
+    static const char* const state_names[] = {"空闲", "扫描中", "连接中", "已连接"};
+    const DetectorLinkStats* st = &g_link.stats;
+    Serial.printf("[LINK] %s %s | 扫描:%lu 连接:%lu 失败:%lu 断开:%lu | HR:%lu SpO2:%lu 丙酮:%lu 错误码:%lu 格式错误:%lu 投递:%lu | 检测模块错误码:%u\n",
+        g_link.transport ? g_link.transport->name : "-", state_names[g_link.state],
+        st->scans, st->connects, st->connect_failures, st->disconnects,
+        st->values[DETECTOR_VALUE_HR], st->values[DETECTOR_VALUE_SPO2],
+        st->values[DETECTOR_VALUE_ACETONE], st->values[DETECTOR_VALUE_ERROR],
+        st->malformed, st->submitted, g_link.error_code);
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef DETECTOR_LINK_FINAL_H
+#define DETECTOR_LINK_FINAL_H
+
+#include <Arduino.h>
+
+/*
+ * detector_link_final.h - 检测模块链路（腕带作为BLE中心，可选）
+ *
+ * 腕带连接检测模块（detection_sensor.ino），订阅其心率/血氧/丙酮/错误码特征值，
+ * 解码后以 ExternalReading 投递给算法管理器，合并进本机结果与风险评估（规则见
+ * algorithm_manager_submit_external）。外设侧（ble_peripheral_final）照常工作。
+ *
+ * 链路层可替换（函数指针表，同 drivers/sensor_source.h）：
+ *   - nimble：NimBLE 中心。被动扫描广播服务UUID的设备 → 连接 → 发现服务 → 订阅并读取初值，
+ *     每次 poll 只发起一步（异步完成，不阻塞通信任务），失败或断开后按退避间隔重扫（仅 ESP32）
+ *   - loopback：进程内回环，测试代码扮演检测模块（注入特征值、出现/离开），主机构建默认使用
+ * 传输层经 detector_link_on_state()/detector_link_on_value() 上报，可在任意任务上下文调用；
+ * detector_link_poll() 只在通信任务中调用。
+ */
+
+// 检测模块的特征值
+typedef enum {
+    DETECTOR_VALUE_HR = 0,           // uint8 bpm，0xFF=无
+    DETECTOR_VALUE_SPO2,             // uint8 %，0xFF=无
+    DETECTOR_VALUE_ACETONE,          // float32 ppm（小端），<0=无
+    DETECTOR_VALUE_ERROR,            // uint8 错误码（只在非0时通知，读取为空即0）
+    DETECTOR_VALUE_COUNT
+} DetectorValue;
+
+// 检测模块错误码（detection_sensor.ino errorCode）
+#define DETECTOR_ERR_NONE        0
+#define DETECTOR_ERR_PPG         1   // MAX30102 初始化失败：HR/SpO2 无效
+#define DETECTOR_ERR_SNO2        2   // SnO₂ ADC 异常：丙酮无效
+
+typedef enum {
+    DETECTOR_LINK_IDLE = 0,          // 未连接，等待下次查找
+    DETECTOR_LINK_SCANNING,
+    DETECTOR_LINK_CONNECTING,        // 连接、发现服务、订阅
+    DETECTOR_LINK_CONNECTED
+} DetectorLinkState;
+
+typedef enum {
+    DETECTOR_TRANSPORT_NIMBLE = 0,
+    DETECTOR_TRANSPORT_LOOPBACK
+} DetectorTransportKind;
+
+// 链路层接口
+typedef struct {
+    DetectorTransportKind kind;
+    const char* name;
+    uint8_t (*start)();                          // 初始化，失败返回0
+    void (*stop)();                              // 断开并停止查找
+    void (*poll)(uint32_t now_ms);               // 通信任务中推进：查找、连接、订阅、退避
+} DetectorTransport;
+
+typedef struct {
+    DetectorLinkState state;
+    const char* transport;
+    uint32_t scans;
+    uint32_t connects;               // 连接并订阅成功
+    uint32_t connect_failures;       // 连接失败或对端不是检测模块
+    uint32_t disconnects;
+    uint32_t values[DETECTOR_VALUE_COUNT];       // 收到的各特征值（含连接后读取的初值）
+    uint32_t malformed;              // 长度不符被丢弃
+    uint32_t submitted;              // 投递给算法管理器的读数
+    uint32_t last_value_ms;
+    uint8_t error_code;
+} DetectorLinkStats;
+
+// 选择链路层并启动（NULL：ESP32 为 nimble，主机构建为 loopback），须在 ble_peripheral_init 之后
+uint8_t detector_link_init(const DetectorTransport* transport);
+void detector_link_stop();
+void detector_link_poll(uint32_t now_ms);
+uint8_t detector_link_is_connected();
+
+// 传输层上报
+void detector_link_on_state(DetectorLinkState state);
+void detector_link_on_value(DetectorValue which, const uint8_t* data, uint16_t len);
+
+void detector_link_get_stats(DetectorLinkStats* stats);
+void detector_link_print_stats();
+
+// ──────────────────────────────────────────────
+// 链路层实现
+
+#if defined(ESP32)
+const DetectorTransport* nimble_detector_transport_get();
+#endif
+
+// 回环：present=1 时下次 poll 连接并送出各特征值的当前值，present=0 断开；
+// notify 更新特征值，已连接时立即送出（模拟通知）
+const DetectorTransport* loopback_detector_transport_get();
+void detector_loopback_set_present(uint8_t present);
+void detector_loopback_notify(DetectorValue which, const uint8_t* data, uint16_t len);
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * history_log_final.cpp - 离线历史记录（Flash环形日志）
+ *
+ * 记录按序号线性映射到槽位：环中第 k 条记录槽（跳过各扇区头）存放序号 oldest 起的连续记录，
+ * 因此读取任意序号只需由写位置倒推，不需要索引。
+ * 扇区头在擦除后、写第一条记录前写入；扇区头损坏的扇区视为空闲，轮到时重新擦除。
+ * 换上电时跳过的空槽同样占用序号，映射不变。
+ */
+
+#include <Arduino.h>
+#include "history_log_final.h"
+#include "telemetry_packet.h"
+
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+#define HISTORY_MAGIC            0x32474C48UL    // "HLG2"（旧版扇区头不含上电编号，视为空闲）
+#define HISTORY_HEADER_LEN       14              // 魔数、首记录序号、上电编号（u32）+ CRC16
+#define HISTORY_EMPTY_SEQ        0xFFFFFFFFUL
+
+// ==================== 全局日志状态 ====================
+
+typedef struct {
+    uint8_t available;
+    uint16_t sectors;
+    uint16_t head_sector;            // 正在写入的扇区
+    uint16_t head_slot;              // 下一个写入槽（1..HISTORY_SLOTS_PER_SECTOR，等于上限表示写满）
+    uint32_t oldest_seq;
+    uint32_t next_seq;
+    uint32_t boot_id;                // 本次上电编号
+    uint32_t head_boot;              // 写扇区头中的上电编号
+    HistoryLogStats stats;
+#if defined(ESP32)
+    const esp_partition_t* part;
+#endif
+} HistoryLogState;
+
+static HistoryLogState g_hist = {0};
+
+#if !defined(ESP32)
+static uint8_t g_host_flash[HISTORY_HOST_BYTES];
+#endif
+
+// ==================== 存储后端 ====================
+
+static uint8_t flash_read(uint32_t addr, void* buf, uint32_t len) {
+#if defined(ESP32)
+    return esp_partition_read(g_hist.part, addr, buf, len) == ESP_OK;
+#else
+    memcpy(buf, g_host_flash + addr, len);
+    return 1;
+#endif
+}
+
+// NOR Flash 语义：只能把位从1写成0
+static uint8_t flash_write(uint32_t addr, const void* buf, uint32_t len) {
+#if defined(ESP32)
+    return esp_partition_write(g_hist.part, addr, buf, len) == ESP_OK;
+#else
+    const uint8_t* src = (const uint8_t*)buf;
+    for (uint32_t i = 0; i < len; i++) {
+        g_host_flash[addr + i] &= src[i];
+    }
+    return 1;
+#endif
+}
+
+static uint8_t flash_erase_sector(uint16_t sector) {
+    g_hist.stats.sector_erases++;
+#if defined(ESP32)
+    return esp_partition_erase_range(g_hist.part, (uint32_t)sector * HISTORY_SECTOR_SIZE,
+                                     HISTORY_SECTOR_SIZE) == ESP_OK;
+#else
+    memset(g_host_flash + (uint32_t)sector * HISTORY_SECTOR_SIZE, 0xFF, HISTORY_SECTOR_SIZE);
+    return 1;
+#endif
+}
+
+static uint32_t slot_addr(uint16_t sector, uint16_t slot) {
+    return (uint32_t)sector * HISTORY_SECTOR_SIZE + (uint32_t)slot * HISTORY_RECORD_SIZE;
+}
+
+// ==================== 扇区头 ====================
+
+static uint32_t get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint8_t read_sector_header(uint16_t sector, uint32_t* base_seq, uint32_t* boot) {
+    uint8_t hdr[HISTORY_HEADER_LEN];
+    if (!flash_read(slot_addr(sector, 0), hdr, sizeof(hdr))) return 0;
+    uint16_t crc = (uint16_t)hdr[12] | ((uint16_t)hdr[13] << 8);
+    if (get_u32(hdr) != HISTORY_MAGIC || crc != telemetry_crc16(hdr, 12)) return 0;
+    *base_seq = get_u32(hdr + 4);
+    *boot = get_u32(hdr + 8);
+    return 1;
+}
+
+// 擦除并写入扇区头（上电编号为本次上电）
+static uint8_t start_sector(uint16_t sector, uint32_t base_seq) {
+    if (!flash_erase_sector(sector)) return 0;
+    uint8_t hdr[16];
+    memset(hdr, 0xFF, sizeof(hdr));
+    uint32_t magic = HISTORY_MAGIC;
+    for (uint8_t i = 0; i < 4; i++) {
+        hdr[i] = (uint8_t)(magic >> (8 * i));
+        hdr[4 + i] = (uint8_t)(base_seq >> (8 * i));
+        hdr[8 + i] = (uint8_t)(g_hist.boot_id >> (8 * i));
+    }
+    uint16_t crc = telemetry_crc16(hdr, 12);
+    hdr[12] = (uint8_t)crc;
+    hdr[13] = (uint8_t)(crc >> 8);
+    g_hist.head_boot = g_hist.boot_id;
+    return flash_write(slot_addr(sector, 0), hdr, sizeof(hdr));
+}
+
+// ==================== 初始化 ====================
+
+// 写位置：头序号最大的扇区中第一个空槽；最旧记录：自写扇区向前，扇区头序号连续的最远一个；
+// 上电编号：各扇区头中的最大值 + 1
+static void history_recover() {
+    uint8_t found = 0;
+    uint32_t head_base = 0;
+    uint32_t last_boot = 0;
+    for (uint16_t s = 0; s < g_hist.sectors; s++) {
+        uint32_t base, boot;
+        if (!read_sector_header(s, &base, &boot)) continue;
+        if (boot > last_boot) last_boot = boot;
+        if (!found || base > head_base) {
+            found = 1;
+            head_base = base;
+            g_hist.head_sector = s;
+            g_hist.head_boot = boot;
+        }
+    }
+    g_hist.boot_id = last_boot + 1;
+
+    if (!found) {
+        g_hist.head_sector = 0;
+        g_hist.head_slot = 1;
+        g_hist.next_seq = 1;
+        g_hist.oldest_seq = 1;
+        if (!start_sector(0, 1)) g_hist.stats.write_errors++;
+        return;
+    }
+
+    g_hist.head_slot = 1;
+    while (g_hist.head_slot < HISTORY_SLOTS_PER_SECTOR) {
+        uint32_t seq;
+        flash_read(slot_addr(g_hist.head_sector, g_hist.head_slot), &seq, sizeof(seq));
+        if (seq == HISTORY_EMPTY_SEQ) break;
+        g_hist.head_slot++;
+    }
+    g_hist.next_seq = head_base + (g_hist.head_slot - 1);
+
+    g_hist.oldest_seq = head_base;
+    for (uint16_t k = 1; k < g_hist.sectors; k++) {
+        uint16_t s = (g_hist.head_sector + g_hist.sectors - k) % g_hist.sectors;
+        uint32_t base, boot;
+        uint32_t expected = head_base - (uint32_t)k * HISTORY_RECORDS_PER_SECTOR;
+        if (!read_sector_header(s, &base, &boot) || base != expected || expected >= head_base) break;
+        g_hist.oldest_seq = base;
+    }
+}
+
+uint8_t history_log_init() {
+    memset(&g_hist, 0, sizeof(HistoryLogState));
+
+#if defined(ESP32)
+    g_hist.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           HISTORY_PARTITION_LABEL);
+    if (g_hist.part == NULL) {
+        Serial.printf("[HIST] 未找到分区 %s，离线记录关闭\n", HISTORY_PARTITION_LABEL);
+        return 0;
+    }
+    g_hist.sectors = g_hist.part->size / HISTORY_SECTOR_SIZE;
+#else
+    g_hist.sectors = HISTORY_HOST_BYTES / HISTORY_SECTOR_SIZE;
+#endif
+    if (g_hist.sectors < 2) return 0;
+
+    g_hist.available = 1;
+    history_recover();
+
+    Serial.printf("[HIST] %u扇区 容量%lu条 记录 #%lu..#%lu 上电#%lu\n", g_hist.sectors,
+        (uint32_t)(g_hist.sectors - 1) * HISTORY_RECORDS_PER_SECTOR,
+        g_hist.oldest_seq, g_hist.next_seq - 1, g_hist.boot_id);
+    return 1;
+}
+
+// ==================== 读写 ====================
+
+uint32_t history_log_append(const uint8_t* frame, uint8_t len) {
+    if (!g_hist.available || len == 0 || len > TELEMETRY_MAX_LEN) return 0;
+
+    if (g_hist.head_boot != g_hist.boot_id && g_hist.head_slot > 1) {
+        // 写扇区存着之前上电的记录：剩余槽位跳过（占用序号），本次上电从下一扇区开始
+        uint32_t rest = HISTORY_SLOTS_PER_SECTOR - g_hist.head_slot;
+        g_hist.next_seq += rest;
+        g_hist.stats.skipped += rest;
+        g_hist.head_slot = HISTORY_SLOTS_PER_SECTOR;
+    }
+
+    if (g_hist.head_slot >= HISTORY_SLOTS_PER_SECTOR) {
+        // 换到下一扇区：其余扇区最多保留 (sectors-1) 扇区的记录，超出部分被覆盖
+        uint16_t next = (g_hist.head_sector + 1) % g_hist.sectors;
+        uint32_t keep = (uint32_t)(g_hist.sectors - 1) * HISTORY_RECORDS_PER_SECTOR;
+        if (g_hist.next_seq - g_hist.oldest_seq > keep) {
+            uint32_t oldest = g_hist.next_seq - keep;
+            g_hist.stats.overwritten += oldest - g_hist.oldest_seq;
+            g_hist.oldest_seq = oldest;
+        }
+        if (!start_sector(next, g_hist.next_seq)) {
+            g_hist.stats.write_errors++;
+        }
+        g_hist.head_sector = next;
+        g_hist.head_slot = 1;
+    } else if (g_hist.head_boot != g_hist.boot_id) {
+        // 写扇区还没有记录，扇区头属于之前的上电：就地重写
+        if (!start_sector(g_hist.head_sector, g_hist.next_seq)) {
+            g_hist.stats.write_errors++;
+        }
+    }
+
+    // 写入失败也占用序号，保持序号与槽位的线性映射（读取时按损坏跳过）
+    uint32_t seq = g_hist.next_seq;
+    uint8_t rec[HISTORY_RECORD_SIZE];
+    memset(rec, 0xFF, sizeof(rec));
+    memcpy(rec, &seq, sizeof(seq));
+    memcpy(rec + sizeof(seq), frame, len);
+    uint8_t ok = flash_write(slot_addr(g_hist.head_sector, g_hist.head_slot), rec, sizeof(rec));
+    g_hist.head_slot++;
+    g_hist.next_seq++;
+    if (!ok) {
+        g_hist.stats.write_errors++;
+        return 0;
+    }
+    g_hist.stats.appended++;
+    return seq;
+}
+
+uint8_t history_log_read(uint32_t seq, uint8_t* out, uint32_t* boot) {
+    if (!g_hist.available || seq < g_hist.oldest_seq || seq >= g_hist.next_seq) return 0;
+
+    // 由写位置倒推：环中记录槽线性编号 = 扇区 × 每扇区记录数 + (槽 - 1)
+    uint32_t total = (uint32_t)g_hist.sectors * HISTORY_RECORDS_PER_SECTOR;
+    uint32_t head = (uint32_t)g_hist.head_sector * HISTORY_RECORDS_PER_SECTOR + (g_hist.head_slot - 1);
+    uint32_t idx = (head + total - (g_hist.next_seq - seq)) % total;
+    uint16_t sector = (uint16_t)(idx / HISTORY_RECORDS_PER_SECTOR);
+    uint16_t slot = (uint16_t)(idx % HISTORY_RECORDS_PER_SECTOR) + 1;
+
+    uint8_t rec[HISTORY_RECORD_SIZE];
+    if (!flash_read(slot_addr(sector, slot), rec, sizeof(rec))) return 0;
+
+    uint32_t stored;
+    memcpy(&stored, rec, sizeof(stored));
+    if (stored == HISTORY_EMPTY_SEQ) return 0;   // 换上电时跳过的空槽
+    const uint8_t* frame = rec + sizeof(stored);
+    uint8_t len = telemetry_frame_len(frame[1] & TELEMETRY_FIELD_ALL);
+    TelemetryFrame check;
+    if (stored != seq || telemetry_decode(frame, len, &check) != TELEMETRY_OK) {
+        g_hist.stats.corrupt_reads++;
+        return 0;
+    }
+    if (boot != NULL) {
+        uint32_t base;
+        if (!read_sector_header(sector, &base, boot)) *boot = 0;
+    }
+    memcpy(out, frame, len);
+    return len;
+}
+
+uint32_t history_log_oldest_seq() {
+    return g_hist.oldest_seq;
+}
+
+uint32_t history_log_next_seq() {
+    return g_hist.next_seq;
+}
+
+uint32_t history_log_boot_id() {
+    return g_hist.boot_id;
+}
+
+// ==================== 统计信息 ====================
+
+void history_log_get_stats(HistoryLogStats* stats) {
+    if (stats == NULL) return;
+    *stats = g_hist.stats;
+    stats->available = g_hist.available;
+    stats->sectors = g_hist.sectors;
+    stats->capacity = g_hist.sectors ? (uint32_t)(g_hist.sectors - 1) * HISTORY_RECORDS_PER_SECTOR : 0;
+    stats->oldest_seq = g_hist.oldest_seq;
+    stats->next_seq = g_hist.next_seq;
+    stats->boot_id = g_hist.boot_id;
+}
+
+void history_log_print_stats() {
+#ifdef DEBUG_MODE
+    Serial.printf("[HIST] 记录 #%lu..#%lu (%lu条) 上电#%lu 追加:%lu 覆盖:%lu 跳过:%lu 擦除:%lu 损坏:%lu 写错误:%lu\n",
+        g_hist.oldest_seq, g_hist.next_seq - 1, g_hist.next_seq - g_hist.oldest_seq, g_hist.boot_id,
+        g_hist.stats.appended, g_hist.stats.overwritten, g_hist.stats.skipped, g_hist.stats.sector_erases,
+        g_hist.stats.corrupt_reads, g_hist.stats.write_errors);
+#endif
+}
@@ -0,0 +1,64 @@
+#ifndef HISTORY_LOG_FINAL_H
+#define HISTORY_LOG_FINAL_H
+
+#include <Arduino.h>
+
+/*
+ * history_log_final.h - 离线历史记录（Flash环形日志，断电保留）
+ *
+ * 未连接期间的遥测帧（telemetry_packet.h）追加到数据分区，重连后由中心按序号游标批量拉取。
+ * - 记录序号全局单调递增，中心保存"已收到的最后序号 + 1"即可断点续传
+ * - 分区按扇区（4KB）组成环：每扇区首槽为扇区头（魔数 + 本扇区首记录序号 + 上电编号），
+ *   其后每槽一条记录 [序号][遥测帧，不足补0xFF]；写满后擦除下一扇区，最旧的一扇区记录被覆盖
+ * - 上电扫描各扇区头恢复写位置与上电编号（最大值 + 1），无需额外的元数据写入
+ * - 遥测帧的时间戳是本次上电以来的秒数，各次上电互相重叠：一个扇区只存一次上电的记录，
+ *   本次上电首次追加时若写扇区属于之前的上电，剩余槽位跳过（占用序号，读取为缺口）并换到下一扇区。
+ *   记录的上电编号即所在扇区头的编号；本次上电没有追加记录时编号不落盘，下次上电沿用（没有记录引用它）
+ * - 记录的遥测帧自带CRC，断电写坏的记录读取时跳过（序号留空）
+ * ESP32 使用 HISTORY_PARTITION_LABEL 数据分区（按原始扇区读写，不挂载文件系统）；
+ * 主机构建使用内存模拟的同样布局。
+ * 只在通信任务中调用（不加锁）。
+ */
+
+#ifndef HISTORY_PARTITION_LABEL
+#define HISTORY_PARTITION_LABEL  "spiffs"    // huge_app.csv 中未使用的数据分区
+#endif
+#define HISTORY_SECTOR_SIZE      4096
+#define HISTORY_RECORD_SIZE      20          // 4字节序号 + 16字节遥测帧
+#define HISTORY_SLOTS_PER_SECTOR (HISTORY_SECTOR_SIZE / HISTORY_RECORD_SIZE)    // 含扇区头
+#define HISTORY_RECORDS_PER_SECTOR (HISTORY_SLOTS_PER_SECTOR - 1)
+#define HISTORY_HOST_BYTES       (16 * HISTORY_SECTOR_SIZE)                     // 主机构建的模拟分区
+
+typedef struct {
+    uint8_t available;               // 找到分区
+    uint16_t sectors;
+    uint32_t capacity;               // 最多保留的记录数
+    uint32_t oldest_seq;             // 最旧的可读记录
+    uint32_t next_seq;               // 下一条记录的序号（= 最新 + 1）
+    uint32_t boot_id;                // 本次上电编号
+    uint32_t appended;               // 本次上电追加的记录
+    uint32_t overwritten;            // 被环形覆盖的记录
+    uint32_t skipped;                // 换上电时跳过的空槽（序号缺口）
+    uint32_t sector_erases;
+    uint32_t corrupt_reads;          // 读取时CRC不符（写入时断电）
+    uint32_t write_errors;
+} HistoryLogStats;
+
+// 打开分区并恢复写位置；没有可用分区返回0（之后的追加被忽略）
+uint8_t history_log_init();
+
+// 追加一条遥测帧（<= TELEMETRY_MAX_LEN），返回分配的序号；失败返回0
+uint32_t history_log_append(const uint8_t* frame, uint8_t len);
+
+// 读取 seq 处的记录到 out（容量 >= TELEMETRY_MAX_LEN），返回帧长度；不在范围内、空槽或已损坏返回0。
+// boot 非空时写入记录所属的上电编号（时间戳以该次上电为零点）
+uint8_t history_log_read(uint32_t seq, uint8_t* out, uint32_t* boot);
+
+uint32_t history_log_oldest_seq();
+uint32_t history_log_next_seq();
+uint32_t history_log_boot_id();
+
+void history_log_get_stats(HistoryLogStats* stats);
+void history_log_print_stats();
+
+#endif
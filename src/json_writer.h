@@ -0,0 +1,157 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+/*
+ * json_writer.h - 流式JSON写入（兼容 App Inventor 的JSON格式，仅头文件，无 Arduino 依赖）
+ *
+ * 直接写入调用方提供的定长缓冲：不分配堆、不建文档树、不用 String 临时对象，
+ * 长期运行不产生堆碎片。只支持单层对象（现有JSON负载都是扁平的）。
+ *   - 键名在编译期拼成常量片段 ",\"key\":"（JSON_KEY），运行时整段拷贝，首个字段跳过逗号
+ *   - 数字只用整数运算格式化；小数按定点整数传入（如丙酮 ×10 → "1.2"），不引入 printf/dtoa
+ *   - 缓冲不足时停止写入，json_end() 返回0（不会输出被截断的JSON）
+ *
+ * 用法：
+ *   JsonWriter w;
+ *   json_begin(&w, buf, sizeof(buf));
+ *   json_key(&w, JSON_KEY("hr"));      json_uint(&w, 72);
+ *   json_key(&w, JSON_KEY("acetone")); json_fixed(&w, 12, 1);
+ *   uint16_t len = json_end(&w);       // 不含结尾 '\0'
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+// 常量键片段及其长度（作为 json_key 的两个参数）
+#define JSON_KEY(name)          ",\"" name "\":", (uint16_t)(sizeof(",\"" name "\":") - 1)
+// 常量字符串值（已知无需转义）
+#define JSON_CONST_STR(text)    "\"" text "\"", (uint16_t)(sizeof("\"" text "\"") - 1)
+
+typedef struct {
+    char* out;
+    uint16_t capacity;               // 含结尾 '\0'
+    uint16_t len;
+    uint8_t overflow;
+    uint8_t empty;                   // 尚未写入字段（下一个键省略逗号）
+} JsonWriter;
+
+// ──────────────────────────────────────────────
+// 基础写入
+
+static inline void json_raw(JsonWriter* w, const char* s, uint16_t n) {
+    if (w->overflow) return;
+    if ((uint32_t)w->len + n + 1 > w->capacity) {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->out + w->len, s, n);
+    w->len += n;
+}
+
+static inline void json_char(JsonWriter* w, char c) {
+    json_raw(w, &c, 1);
+}
+
+static inline void json_begin(JsonWriter* w, char* out, uint16_t capacity) {
+    w->out = out;
+    w->capacity = capacity;
+    w->len = 0;
+    w->overflow = (capacity == 0);
+    w->empty = 1;
+    json_char(w, '{');
+}
+
+// 结束对象并写入 '\0'，返回长度（不含 '\0'）；缓冲不足返回0
+static inline uint16_t json_end(JsonWriter* w) {
+    json_char(w, '}');
+    if (w->overflow) {
+        if (w->capacity) w->out[0] = '\0';
+        return 0;
+    }
+    w->out[w->len] = '\0';
+    return w->len;
+}
+
+// 键片段来自 JSON_KEY()：首个字段跳过开头的逗号
+static inline void json_key(JsonWriter* w, const char* fragment, uint16_t n) {
+    if (w->empty) {
+        fragment++;
+        n--;
+        w->empty = 0;
+    }
+    json_raw(w, fragment, n);
+}
+
+// ──────────────────────────────────────────────
+// 值
+
+static inline void json_uint(JsonWriter* w, uint32_t v) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    json_raw(w, digits + sizeof(digits) - n, n);
+}
+
+static inline void json_int(JsonWriter* w, int32_t v) {
+    if (v < 0) {
+        json_char(w, '-');
+        json_uint(w, (uint32_t)0 - (uint32_t)v);
+    } else {
+        json_uint(w, (uint32_t)v);
+    }
+}
+
+// 定点数：value / 10^decimals，例如 (12, 1) → "1.2"，(-5, 2) → "-0.05"
+static inline void json_fixed(JsonWriter* w, int32_t value, uint8_t decimals) {
+    uint32_t mag = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    if (value < 0) json_char(w, '-');
+    json_uint(w, mag / scale);
+    if (decimals == 0) return;
+
+    char frac[9];
+    uint32_t rem = mag % scale;
+    if (decimals > sizeof(frac)) decimals = sizeof(frac);
+    for (uint8_t i = decimals; i > 0; i--) {
+        frac[i - 1] = (char)('0' + rem % 10);
+        rem /= 10;
+    }
+    json_char(w, '.');
+    json_raw(w, frac, decimals);
+}
+
+static inline void json_null(JsonWriter* w) {
+    json_raw(w, "null", 4);
+}
+
+static inline void json_bool(JsonWriter* w, uint8_t v) {
+    if (v) json_raw(w, "true", 4);
+    else json_raw(w, "false", 5);
+}
+
+// 任意字符串（如风险描述）：转义引号、反斜杠与控制字符，UTF-8 多字节原样输出
+static inline void json_string(JsonWriter* w, const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    json_char(w, '"');
+    const char* run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        json_raw(w, run, (uint16_t)(s - run));
+        run = s + 1;
+        if (c == '"' || c == '\\') {
+            char esc[2] = {'\\', (char)c};
+            json_raw(w, esc, 2);
+        } else {
+            char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            json_raw(w, esc, 6);
+        }
+    }
+    json_raw(w, run, (uint16_t)(s - run));
+    json_char(w, '"');
+}
+
+#endif // JSON_WRITER_H
@@ -35,6 +35,8 @@
 #include "../algorithm/hr_algorithm.h"
 #include "hr_driver.h"
 #include "../system/scheduler.h"
+#include "../system/timer_wheel.h"
+#include "../system/idle.h"
 
 // ==================== 引脚定义（ESP32-C3 SuperMini）====================
 #ifndef PIN_SDA
@@ -69,6 +71,7 @@
 #define DEBOUNCE_MS         50      // 按键消抖时间
 #define BLE_UPDATE_INTERVAL_MS 1000 // BLE数据更新间隔（1秒）
 #define BATTERY_UPDATE_INTERVAL_MS 5000 // 电池电压更新间隔（5秒）
+#define HEALTH_UPDATE_INTERVAL_MS 2000  // 健康数据更新间隔（2秒）
 
 // ==================== 电池电压参数 ====================
 #define BAT_ADC_MAX         4095    // 12位ADC最大值
@@ -91,8 +94,15 @@ bool bleAdvertising = false;
 // 系统状态
 bool oledPowerOn = true;
 uint32_t lastActivityTime = 0;
-uint32_t lastBleUpdateTime = 0;
-uint32_t lastBatteryUpdateTime = 0;
+
+// 定时器（注册在共享时间轮上，由 scheduler_run() 推进）
+static PeriodicTimer healthTimer;
+static PeriodicTimer batteryTimer;
+static PeriodicTimer bleTimer;
+static TimerWheelTimer healthWheel;
+static TimerWheelTimer batteryWheel;
+static TimerWheelTimer bleWheel;
+static TimerWheelTimer screenTimeoutWheel;   // 单次：每次操作重新计时
 
 // 健康数据
 uint8_t currentHeartRate = 0;
@@ -125,17 +135,33 @@ class MyServerCallbacks : public BLEServerCallbacks {
 };
 
 // ==================== OLED电源控制 ====================
+static void onScreenTimeout();
+
+// 用户操作：亮屏期间重新开始熄屏计时
+static void noteActivity(uint32_t now) {
+    lastActivityTime = now;
+    if (oledPowerOn) {
+        timer_wheel_start_oneshot(&screenTimeoutWheel, "screen_off", SCREEN_TIMEOUT_MS, onScreenTimeout);
+    }
+}
+
 void setOLEDPower(bool on) {
     if (on) {
         display.ssd1306_command(SSD1306_DISPLAYON);
         oledPowerOn = true;
-        lastActivityTime = millis();
+        noteActivity(millis());
     } else {
         display.ssd1306_command(SSD1306_DISPLAYOFF);
         oledPowerOn = false;
+        timer_wheel_cancel(&screenTimeoutWheel);
     }
 }
 
+static void onScreenTimeout() {
+    setOLEDPower(false);
+    DEBUG_PRINTLN("[OLED] 超时熄屏");
+}
+
 // ==================== 电池电量读取 ====================
 void updateBatteryVoltage() {
     uint32_t adcValue = analogRead(PIN_BAT_ADC);
@@ -305,7 +331,7 @@ void handleButtons() {
     if (btn1State == LOW && btn1LastState == HIGH) {
         // 按键1按下
         btn1PressTime = now;
-        lastActivityTime = now;
+        noteActivity(now);
         
         // 唤醒OLED
         if (!oledPowerOn) {
@@ -322,7 +348,7 @@ void handleButtons() {
     // 按键2处理（开关OLED）
     if (btn2State == LOW && btn2LastState == HIGH) {
         // 按键2按下
-        lastActivityTime = now;
+        noteActivity(now);
         
         // 切换OLED电源
         setOLEDPower(!oledPowerOn);
@@ -332,6 +358,18 @@ void handleButtons() {
     btn2LastState = btn2State;
 }
 
+// ==================== 空闲休眠来源 ====================
+
+// BLE连接或广播期间射频需要时钟，不进入显式 light sleep
+static uint8_t wrist_ble_blocks_light_sleep() {
+    return (bleConnected || bleAdvertising) ? 1 : 0;
+}
+
+// 调度器任务与 BLE/电池/熄屏定时器都在时间轮上，一个来源即可
+static const IdleSource g_wrist_idle_sources[] = {
+    {"timers", scheduler_time_to_next_ms, wrist_ble_blocks_light_sleep},
+};
+
 // ==================== 腕带主控初始化 ====================
 void wrist_setup() {
     // 初始化串口
@@ -391,6 +429,16 @@ void wrist_setup() {
     scheduler_init();
     DEBUG_PRINTLN("[Init] 调度器初始化完成");
     
+    // 空闲休眠：截止时刻来源 + 唤醒引脚（按键、MAX30102 INT 均为低电平有效）
+    for (uint8_t i = 0; i < sizeof(g_wrist_idle_sources) / sizeof(g_wrist_idle_sources[0]); i++) {
+        idle_register_source(&g_wrist_idle_sources[i]);
+    }
+    idle_add_wake_gpio(PIN_BTN1, LOW);
+    idle_add_wake_gpio(PIN_BTN2, LOW);
+#ifdef PIN_MAX30102_INT
+    idle_add_wake_gpio(PIN_MAX30102_INT, LOW);
+#endif
+    
     // 初始化BLE
     initBLE();
     
@@ -398,8 +446,17 @@ void wrist_setup() {
     pinMode(PIN_BAT_ADC, INPUT);
     updateBatteryVoltage();
     
+    // 周期定时器与熄屏定时器
+    uint32_t now = millis();
+    periodic_init(&healthTimer, HEALTH_UPDATE_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&batteryTimer, BATTERY_UPDATE_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&bleTimer, BLE_UPDATE_INTERVAL_MS, PERIODIC_SKIP, now);
+    timer_wheel_start_periodic(&healthWheel, "health", &healthTimer, updateHealthData);
+    timer_wheel_start_periodic(&batteryWheel, "battery", &batteryTimer, updateBatteryVoltage);
+    timer_wheel_start_periodic(&bleWheel, "ble_send", &bleTimer, sendBLEData);
+    
     // 初始化完成
-    lastActivityTime = millis();
+    noteActivity(now);
     display.clearDisplay();
     display.setCursor(0, 28);
     display.println("   初始化完成");
@@ -411,44 +468,17 @@ void wrist_setup() {
 
 // ==================== 腕带主循环 ====================
 void wrist_loop() {
-    uint32_t now = millis();
-    
     // 处理按键
     handleButtons();
     
-    // 运行调度器（处理心率采样和计算）
+    // 推进时间轮：心率采样/计算、健康数据、电池、BLE推送、熄屏
     scheduler_run();
     
-    // 更新健康数据
-    static uint32_t lastHealthUpdate = 0;
-    if (now - lastHealthUpdate >= 2000) {  // 每2秒更新一次
-        updateHealthData();
-        lastHealthUpdate = now;
-    }
-    
-    // 更新电池电压
-    if (now - lastBatteryUpdateTime >= BATTERY_UPDATE_INTERVAL_MS) {
-        updateBatteryVoltage();
-        lastBatteryUpdateTime = now;
-    }
-    
-    // 发送BLE数据
-    if (now - lastBleUpdateTime >= BLE_UPDATE_INTERVAL_MS) {
-        sendBLEData();
-        lastBleUpdateTime = now;
-    }
-    
-    // 检查OLED超时熄屏
-    if (oledPowerOn && (now - lastActivityTime >= SCREEN_TIMEOUT_MS)) {
-        setOLEDPower(false);
-        DEBUG_PRINTLN("[OLED] 超时熄屏");
-    }
-    
     // 刷新OLED显示
     if (oledPowerOn) {
         drawMainDisplay();
     }
     
-    // 低功耗延迟
-    delay(10);  // 10ms延迟，对应100Hz采样率
+    // 休眠到最早的截止时刻（调度器任务、BLE/电池/熄屏定时器），按键或传感器中断提前唤醒
+    idle_sleep();
 }
\ No newline at end of file
@@ -6,8 +6,13 @@
  * 2. SnO2采集 (10Hz)
  * 3. 电池监控 (60s)
  * 4. UI实时刷新 (500ms)
- * 5. BLE JSON推送 (4000ms)
+ * 5. BLE推送 (4000ms，二进制遥测帧，可选JSON兼容)
  * 6. DeepSleep功耗管理
+ * 7. 可选：作为BLE中心连接检测模块，合并其读数（DETECTOR_LINK_ENABLE）
+ * 
+ * 任务布局（ESP32-S3 双核，见 task_runtime_final.h）：
+ *   采集 core1/高优先级 → 样本总线 → 通知 DSP core1/中优先级
+ *   通信（BLE/UI/日志）core0/低优先级
  * 
  * 硬件：ESP32-S3 + MAX30102 (GPIO17/18) + AMOLED (SPI)
  * 
@@ -33,18 +38,30 @@
 
 // 新增：最终版本管理器
 #include "sensor_collector_final.h"
+#include "sample_bus_final.h"
+#include "history_log_final.h"
+#include "../system/timebase.h"
 #include "algorithm_manager_final.h"
 #include "ble_peripheral_final.h"
+#include "detector_link_final.h"
+#include "task_runtime_final.h"
+#include "../system/periodic.h"
+#include "../system/timer_wheel.h"
+#include "../system/idle.h"
 
 // ==================== 全局任务调度 ====================
 
 typedef struct {
-    uint32_t last_run_ms;
+    PeriodicTimer timer;         // 无漂移释放时刻 + 执行时间/截止时间统计
+    TimerWheelTimer wheel;       // 在共享时间轮中按释放时刻排队
     uint32_t period_ms;
+    PeriodicPolicy policy;
     void (*task_func)(void);
     const char* task_name;
 } ScheduledTask;
 
+static void scheduler_print_stats();
+
 // ==================== 全局统计 ====================
 
 typedef struct {
@@ -64,17 +81,25 @@ static SystemStats g_sys_stats = {0};
 
 // ==================== 任务函数 ====================
 
-// 任务1：采集更新（10ms）
-static void task_sensor_collection() {
+static uint8_t g_dsp_task = RT_INVALID_TASK;
+
+// 采集任务（10ms）：读空传感器FIFO，有新样本时通知DSP
+static void task_acquisition() {
+    uint32_t published = sample_bus_published();
     sensor_collector_update();
+    if (sample_bus_published() != published) {
+        task_runtime_notify(g_dsp_task);
+    }
 }
 
-// 任务2：算法更新（10ms）
-static void task_algorithm_update() {
+// DSP任务（新样本通知，最长等待20ms）
+static void task_dsp() {
     algorithm_manager_update();
 }
 
-// 任务3：UI刷新（500ms）
+// 通信任务的子任务（按各自周期轮询）
+
+// 子任务1：UI刷新（500ms）
 static void task_ui_update() {
     // 获取最新算法结果显示在AMOLED
     AlgorithmResult result = {0};
@@ -95,7 +120,7 @@ static void task_ui_update() {
     g_sys_stats.last_activity_ms = millis();
 }
 
-// 任务4：BLE推送（4000ms）
+// 子任务2：BLE推送（4000ms）
 static void task_ble_send() {
     ble_peripheral_send_data();
 #ifdef DEBUG_MODE
@@ -105,7 +130,7 @@ static void task_ble_send() {
 #endif
 }
 
-// 任务5：电池检查（60s）
+// 子任务3：电池检查（60s）
 static void task_battery_check() {
     CollectorStats stats = {0};
     sensor_collector_get_stats(&stats);
@@ -119,7 +144,7 @@ static void task_battery_check() {
     }
 }
 
-// 任务6：统计信息打印（30s）
+// 子任务4：统计信息打印（30s）
 static void task_print_stats() {
     Serial.println("\n\n========== 系统统计 (30s) ==========");
     
@@ -133,43 +158,93 @@ static void task_print_stats() {
         collector_stats.total_hr_samples, collector_stats.total_sno2_samples,
         collector_stats.battery_percent, collector_stats.battery_mv);
     
-    Serial.printf("BLE: %s | 通知: %lu | 总循环: %lu\n",
+    Serial.printf("BLE: %s | 通知: %lu | 队列: %u字节 丢弃: %lu 吞吐: %luB/s | 总循环: %lu\n",
         ble_stats.is_connected ? "✓" : "✗",
         ble_stats.total_notifications,
+        ble_stats.tx.queued_bytes, ble_stats.tx.payloads_dropped, ble_stats.tx.throughput_bps,
         g_sys_stats.total_loop_cycles);
     
     algorithm_manager_print_stats();
+    sample_bus_print_stats();
+    history_log_print_stats();
+#if DETECTOR_LINK_ENABLE
+    detector_link_print_stats();
+#endif
+    task_runtime_print_stats();
+    idle_print_stats();
+    scheduler_print_stats();
+    
+    TimebaseStats tb = {0};
+    timebase_get_stats(&tb);
+    Serial.printf("采样周期: %lu ns (标称 %lu us, 偏差 %ld ppm) | 读取抖动 avg:%lu max:%lu us\n",
+        tb.period_ns, tb.nominal_period_us, tb.drift_ppm, tb.jitter_avg_us, tb.jitter_max_us);
     
     Serial.println("=====================================\n");
 }
 
-// 定义所有任务
+// 通信任务内的子任务
+// 均取最新数据，落后时跳过错过的释放而不补跑
 static ScheduledTask g_tasks[] = {
-    {0, 10,    task_sensor_collection,  "SensorCollection"},
-    {0, 10,    task_algorithm_update,   "AlgorithmUpdate"},
-    {0, 500,   task_ui_update,          "UIUpdate"},
-    {0, 4000,  task_ble_send,           "BLESend"},
-    {0, 60000, task_battery_check,      "BatteryCheck"},
-    {0, 30000, task_print_stats,        "PrintStats"},
+    {{0}, {0}, 500,   PERIODIC_SKIP, task_ui_update,          "UIUpdate"},
+    {{0}, {0}, 4000,  PERIODIC_SKIP, task_ble_send,           "BLESend"},
+    {{0}, {0}, 60000, PERIODIC_SKIP, task_battery_check,      "BatteryCheck"},
+    {{0}, {0}, 30000, PERIODIC_SKIP, task_print_stats,        "PrintStats"},
 };
 
 #define NUM_TASKS (sizeof(g_tasks) / sizeof(g_tasks[0]))
 
-// ==================== 调度器更新 ====================
+// ==================== 通信任务调度 ====================
 
+// 子任务都注册在时间轮上，每次只处理到期的定时器
 static void scheduler_update() {
-    uint32_t now_ms = millis();
-    
+    timer_wheel_advance(millis());
+}
+
+static void scheduler_print_stats() {
+    Serial.println("子任务          runs  skip  miss   min/avg/max/p99 (us)");
     for (int i = 0; i < NUM_TASKS; i++) {
-        if ((now_ms - g_tasks[i].last_run_ms) >= g_tasks[i].period_ms) {
-            if (g_tasks[i].task_func) {
-                g_tasks[i].task_func();
-            }
-            g_tasks[i].last_run_ms = now_ms;
-        }
+        PeriodicStats ps;
+        periodic_get_stats(&g_tasks[i].timer, &ps);
+        Serial.printf("  %-12s %6lu %5lu %5lu   %lu/%lu/%lu/%lu\n",
+            g_tasks[i].task_name, ps.runs, ps.skipped, ps.deadline_misses,
+            ps.exec_min_us, ps.exec_avg_us, ps.exec_max_us, ps.exec_p99_us);
     }
+    timer_wheel_print_stats();
 }
 
+// 通信任务（core 0）：BLE/UI/日志，慢操作不再阻塞采集
+// 时间轮只在本任务中推进和修改
+static void task_comm() {
+    scheduler_update();
+    ble_peripheral_poll();  // 协议栈缓冲释放后继续发送排队的块
+#if DETECTOR_LINK_ENABLE
+    detector_link_poll(millis());
+#endif
+}
+
+// 任务布局：注册顺序即协作模式下的运行顺序
+static const RtTaskConfig g_rt_layout[] = {
+    {"ACQ",  task_acquisition, 10, RT_WAKE_PERIODIC, RT_CORE_ACQ,  RT_PRIO_ACQ,  RT_STACK_ACQ},
+    {"DSP",  task_dsp,         20, RT_WAKE_NOTIFY,   RT_CORE_DSP,  RT_PRIO_DSP,  RT_STACK_DSP},
+    {"COMM", task_comm,        10, RT_WAKE_PERIODIC, RT_CORE_COMM, RT_PRIO_COMM, RT_STACK_COMM},
+};
+
+#define NUM_RT_TASKS (sizeof(g_rt_layout) / sizeof(g_rt_layout[0]))
+
+// ==================== 空闲休眠来源 ====================
+
+// BLE连接期间不进入显式 light sleep
+static uint8_t ble_blocks_light_sleep() {
+#if DETECTOR_LINK_ENABLE
+    if (detector_link_is_connected()) return 1;
+#endif
+    return ble_peripheral_is_connected();
+}
+
+static const IdleSource g_idle_sources[] = {
+    {"comm", timer_wheel_time_to_next_ms, ble_blocks_light_sleep},
+};
+
 // ==================== 初始化 ====================
 
 void setup() {
@@ -243,18 +318,47 @@ void setup() {
     ble_peripheral_init();
     Serial.println("    ✓ BLE ready");
     
+#if DETECTOR_LINK_ENABLE
+    // 7. 检测模块链路（BLE中心，与外设共用 NimBLE 协议栈）
+    Serial.println("[INIT] Detector link...");
+    detector_link_init(NULL);
+    Serial.println("    ✓ Detector link ready");
+#endif
+    
     // ==================== 系统初始化 ====================
     
     // 初始化任务计时器
     uint32_t now = millis();
     for (int i = 0; i < NUM_TASKS; i++) {
-        g_tasks[i].last_run_ms = now;
+        periodic_init(&g_tasks[i].timer, g_tasks[i].period_ms, g_tasks[i].policy, now);
+        timer_wheel_start_periodic(&g_tasks[i].wheel, g_tasks[i].task_name, &g_tasks[i].timer, g_tasks[i].task_func);
     }
     
     g_sys_stats.deep_sleep_enabled = 0;
     g_sys_stats.last_battery_check_ms = now;
     g_sys_stats.last_activity_ms = now;
     
+    // 注册并启动任务（所有模块初始化完成之后）
+    for (int i = 0; i < NUM_RT_TASKS; i++) {
+        uint8_t id = task_runtime_add(&g_rt_layout[i]);
+        if (g_rt_layout[i].func == task_dsp) {
+            g_dsp_task = id;
+        }
+    }
+    task_runtime_start();
+    
+    // 空闲休眠：协作模式下 loop() 休眠到最早的截止时刻，MAX30102 INT 提前唤醒；
+    // FreeRTOS 模式下由空闲任务自动 light sleep
+    for (int i = 0; i < sizeof(g_idle_sources) / sizeof(g_idle_sources[0]); i++) {
+        idle_register_source(&g_idle_sources[i]);
+    }
+#ifdef PIN_MAX30102_INT
+    idle_add_wake_gpio(PIN_MAX30102_INT, LOW);
+#endif
+#if RT_USE_FREERTOS
+    idle_configure_pm();
+#endif
+    
     // ==================== 启动完成 ====================
     
     Serial.println("\n✓ 系统初始化完成！");
@@ -263,7 +367,8 @@ void setup() {
     Serial.println("  SnO2采样：10Hz (100ms周期)");
     Serial.println("  电池检查：60s周期");
     Serial.println("  UI刷新：500ms周期");
-    Serial.println("  BLE推送：4000ms周期 (JSON格式)");
+    Serial.printf("  BLE推送：4000ms周期 (%s)\n", ble_peripheral_get_payload_format() == BLE_PAYLOAD_JSON ? "JSON格式" : "二进制遥测帧");
+    Serial.printf("  任务：%s\n", RT_USE_FREERTOS ? "FreeRTOS（采集/DSP core1，通信 core0）" : "协作式轮询");
     Serial.println("  心率范围：40-180 BPM");
     Serial.println("  SpO2范围：70-100%");
     Serial.println("\n开始主循环...\n");
@@ -272,13 +377,12 @@ void setup() {
 // ==================== 主循环 ====================
 
 void loop() {
-    // 核心调度更新（非阻塞）
-    scheduler_update();
+    // FreeRTOS模式：任务已在各核运行，这里只休眠；
+    // 协作模式：按优先级运行到期任务，然后休眠到最早的下一次释放
+    task_runtime_loop();
     
     g_sys_stats.total_loop_cycles++;
     
-    // 保持CPU响应性
-    delayMicroseconds(100);
     
     // ==================== 可选：DeepSleep逻辑 ====================
     // 如果启用DeepSleep（检测模块10秒唤醒）：
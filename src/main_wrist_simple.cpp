@@ -202,7 +202,7 @@ void processSample() {
         // 更新心率算法
         int hr_status = hr_algorithm_update();
         
-        // 每128个样本计算一次BPM和SpO2（10ms间隔，128个样本≈1.28秒），匹配hr_algorithm.h中的HR_BUFFER_SIZE
+        // 每128个样本计算一次BPM和SpO2（10ms间隔，≈1.28秒；窗口长度见hr_algorithm.h中的HR_BUFFER_SIZE）
         static uint8_t sample_count = 0;
         sample_count++;
         
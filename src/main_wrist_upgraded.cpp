@@ -78,8 +78,8 @@ void loop() {
     // 5. 通过BLE发送数据
     send_data_via_ble();
     
-    // 6. 短暂延时，避免CPU占用过高
-    delay(1);  // 1ms延时，足够响应10ms的MAX30102采样
+    // 6. 休眠到最早的下一次任务释放，避免空转
+    delay(wrist_scheduler_time_to_next_ms());
 }
 
 // ──────────────────────────────────────────────
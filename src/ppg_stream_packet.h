@@ -0,0 +1,218 @@
+#ifndef PPG_STREAM_PACKET_H
+#define PPG_STREAM_PACKET_H
+
+/*
+ * ppg_stream_packet.h - 原始PPG波形批量帧（固件与主机工具共用，仅头文件，无 Arduino 依赖）
+ *
+ * 帧格式（小端）：
+ *   [0]     版本 PPG_STREAM_VERSION
+ *   [1]     标志 PPG_STREAM_FLAG_*
+ *   [2]     本批样本数
+ *   [3..4]  首个样本的序号（总线序号低16位）：应等于上一批首序号 + 样本数，
+ *           不等即有样本丢失（整批丢失或设备端发送不及被总线覆盖），缺口长度即丢失的样本数
+ *   ...     每个样本依次为 红光残差、红外残差，均为 zig-zag varint
+ *   [n-2..] CRC-16/CCITT-FALSE（与遥测帧相同，见 telemetry_packet.h）
+ *
+ * 残差 = 样本 - 预测值（32位无符号回绕运算，任意 int32 输入均无损）：
+ *   批内第1个样本预测为0（每批独立可解，丢一批不影响后续）
+ *   第2个样本预测为前一样本（一阶差分）
+ *   其余按标志位选择一阶（x[n-1]）或二阶线性预测（2·x[n-1] - x[n-2]）
+ * 编码器在每批同时统计两种预测的残差字节数，下一批采用较小的一种：
+ * 100Hz 的平滑脉搏波二阶残差多为1字节，噪声大时一阶更省。
+ * 18位样本首个绝对值3字节，之后典型每通道1字节；连同7字节帧头/CRC，
+ * 每批20个样本约2.6字节/对，50个约2.2字节/对（合成数据源 + 10LSB 噪声，
+ * 实测见 tools/host_tests/ppg_stream_bench.cpp）。
+ *
+ * 编码器只写调用方提供的缓冲，无堆分配；样本逐个加入，放不下时返回0。
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "telemetry_packet.h"
+
+#define PPG_STREAM_VERSION       1
+#define PPG_STREAM_HEADER_LEN    5
+#define PPG_STREAM_CRC_LEN       2
+#define PPG_STREAM_MAX_SAMPLES   255
+#define PPG_STREAM_VARINT_MAX    5       // uint32 varint 最长字节数
+
+#define PPG_STREAM_FLAG_ORDER2   0x01    // 第3个样本起使用二阶预测
+
+// 解码返回值（>=0 为样本数）
+#define PPG_STREAM_ERR_LENGTH    -1
+#define PPG_STREAM_ERR_VERSION   -2
+#define PPG_STREAM_ERR_CRC       -3
+#define PPG_STREAM_ERR_FORMAT    -4
+#define PPG_STREAM_ERR_CAPACITY  -5
+
+typedef struct {
+    uint8_t flags;
+    uint8_t count;
+    uint16_t seq;                    // 首个样本的序号
+} PpgStreamHeader;
+
+typedef struct {
+    uint8_t* out;
+    uint8_t capacity;
+    uint8_t len;
+    uint8_t count;
+    uint8_t flags;
+    uint32_t red[2];                 // [0]=x[n-1] [1]=x[n-2]
+    uint32_t ir[2];
+    uint32_t cost[2];                // 本批第3个样本起，一阶/二阶预测的残差字节数
+} PpgStreamEncoder;
+
+// ──────────────────────────────────────────────
+// 残差编码
+
+static inline uint32_t ppg_stream_zigzag(uint32_t v) {
+    return (v << 1) ^ (uint32_t)((int32_t)v >> 31);
+}
+
+static inline uint32_t ppg_stream_unzigzag(uint32_t z) {
+    return (z >> 1) ^ (uint32_t)(-(int32_t)(z & 1));
+}
+
+static inline uint8_t ppg_stream_varint_len(uint32_t v) {
+    uint8_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline uint8_t ppg_stream_put_varint(uint8_t* out, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// 读取一个 varint，返回消耗字节数；越界或超长返回0
+static inline uint8_t ppg_stream_get_varint(const uint8_t* in, uint16_t avail, uint32_t* v) {
+    uint32_t result = 0;
+    for (uint8_t n = 0; n < PPG_STREAM_VARINT_MAX && n < avail; n++) {
+        result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            *v = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// 第 index 个样本的预测值（x1 = x[n-1], x2 = x[n-2]）
+static inline uint32_t ppg_stream_predict(uint8_t index, uint8_t order2, uint32_t x1, uint32_t x2) {
+    if (index == 0) return 0;
+    if (index == 1 || !order2) return x1;
+    return 2 * x1 - x2;
+}
+
+// ──────────────────────────────────────────────
+// 编码
+
+// 开始一批：预测阶数沿用上一批统计中较省的一种（首批为一阶）
+static inline void ppg_stream_begin(PpgStreamEncoder* e, uint8_t* out, uint8_t capacity, uint16_t seq) {
+    e->out = out;
+    e->capacity = capacity;
+    e->count = 0;
+    e->flags = (e->cost[1] < e->cost[0]) ? PPG_STREAM_FLAG_ORDER2 : 0;
+    e->cost[0] = 0;
+    e->cost[1] = 0;
+    e->len = 0;
+    if (capacity < PPG_STREAM_HEADER_LEN + PPG_STREAM_CRC_LEN) return;
+    out[0] = PPG_STREAM_VERSION;
+    out[1] = e->flags;
+    out[2] = 0;
+    out[3] = (uint8_t)seq;
+    out[4] = (uint8_t)(seq >> 8);
+    e->len = PPG_STREAM_HEADER_LEN;
+}
+
+// 加入一个样本；剩余空间（扣除CRC）放不下或已满 255 个时返回0，该样本未写入
+static inline uint8_t ppg_stream_add(PpgStreamEncoder* e, int32_t red, int32_t ir) {
+    if (e->len == 0 || e->count >= PPG_STREAM_MAX_SAMPLES) return 0;
+
+    uint8_t order2 = e->flags & PPG_STREAM_FLAG_ORDER2;
+    uint32_t r = (uint32_t)red;
+    uint32_t i = (uint32_t)ir;
+    uint32_t zr = ppg_stream_zigzag(r - ppg_stream_predict(e->count, order2, e->red[0], e->red[1]));
+    uint32_t zi = ppg_stream_zigzag(i - ppg_stream_predict(e->count, order2, e->ir[0], e->ir[1]));
+    uint8_t need = ppg_stream_varint_len(zr) + ppg_stream_varint_len(zi);
+    if ((uint16_t)e->len + need + PPG_STREAM_CRC_LEN > e->capacity) return 0;
+
+    if (e->count >= 2) {
+        // 两种预测的代价都记下，供下一批选择
+        e->cost[0] += ppg_stream_varint_len(ppg_stream_zigzag(r - e->red[0])) +
+                      ppg_stream_varint_len(ppg_stream_zigzag(i - e->ir[0]));
+        e->cost[1] += ppg_stream_varint_len(ppg_stream_zigzag(r - (2 * e->red[0] - e->red[1]))) +
+                      ppg_stream_varint_len(ppg_stream_zigzag(i - (2 * e->ir[0] - e->ir[1])));
+    }
+
+    e->len += ppg_stream_put_varint(e->out + e->len, zr);
+    e->len += ppg_stream_put_varint(e->out + e->len, zi);
+    e->red[1] = e->red[0];
+    e->red[0] = r;
+    e->ir[1] = e->ir[0];
+    e->ir[0] = i;
+    e->count++;
+    return 1;
+}
+
+// 结束一批：写入样本数与CRC，返回帧长度（没有样本返回0）
+static inline uint8_t ppg_stream_finish(PpgStreamEncoder* e) {
+    if (e->len == 0 || e->count == 0) return 0;
+    e->out[2] = e->count;
+    uint16_t crc = telemetry_crc16(e->out, e->len);
+    e->out[e->len++] = (uint8_t)crc;
+    e->out[e->len++] = (uint8_t)(crc >> 8);
+    return e->len;
+}
+
+// ──────────────────────────────────────────────
+// 解码
+
+// 校验并解出样本，返回样本数（<0 为错误码）
+static inline int16_t ppg_stream_decode(const uint8_t* in, uint16_t len, PpgStreamHeader* hdr,
+                                        int32_t* red, int32_t* ir, uint16_t max) {
+    if (len < PPG_STREAM_HEADER_LEN + PPG_STREAM_CRC_LEN) return PPG_STREAM_ERR_LENGTH;
+    if (in[0] != PPG_STREAM_VERSION) return PPG_STREAM_ERR_VERSION;
+    uint16_t crc = (uint16_t)in[len - 2] | ((uint16_t)in[len - 1] << 8);
+    if (crc != telemetry_crc16(in, len - PPG_STREAM_CRC_LEN)) return PPG_STREAM_ERR_CRC;
+
+    hdr->flags = in[1];
+    hdr->count = in[2];
+    hdr->seq = (uint16_t)in[3] | ((uint16_t)in[4] << 8);
+    if (hdr->count > max) return PPG_STREAM_ERR_CAPACITY;
+
+    uint8_t order2 = hdr->flags & PPG_STREAM_FLAG_ORDER2;
+    uint16_t end = len - PPG_STREAM_CRC_LEN;
+    uint16_t p = PPG_STREAM_HEADER_LEN;
+    uint32_t r1 = 0, r2 = 0, i1 = 0, i2 = 0;
+    for (uint8_t k = 0; k < hdr->count; k++) {
+        uint32_t zr, zi;
+        uint8_t n = ppg_stream_get_varint(in + p, end - p, &zr);
+        if (n == 0) return PPG_STREAM_ERR_FORMAT;
+        p += n;
+        n = ppg_stream_get_varint(in + p, end - p, &zi);
+        if (n == 0) return PPG_STREAM_ERR_FORMAT;
+        p += n;
+
+        uint32_t r = ppg_stream_predict(k, order2, r1, r2) + ppg_stream_unzigzag(zr);
+        uint32_t i = ppg_stream_predict(k, order2, i1, i2) + ppg_stream_unzigzag(zi);
+        red[k] = (int32_t)r;
+        ir[k] = (int32_t)i;
+        r2 = r1;
+        r1 = r;
+        i2 = i1;
+        i1 = i;
+    }
+    if (p != end) return PPG_STREAM_ERR_FORMAT;
+    return hdr->count;
+}
+
+#endif // PPG_STREAM_PACKET_H
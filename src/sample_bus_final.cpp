@@ -0,0 +1,215 @@
+/*
+ * sample_bus_final.cpp - PPG样本总线（单生产者 / 多消费者）
+ *
+ * 序号采用32位自由递增计数，槽位 = 序号 & MASK；
+ * 未读数 = head - cursor（无符号减法自动处理回绕）。
+ *
+ * 生产者（采集任务）与消费者（DSP/通信任务）可以运行在不同任务/核上：
+ * 样本先写入槽位，再以 release 语义发布 head；消费者以 acquire 语义读取 head，
+ * 因此看到的序号对应的槽位数据必然已写完。游标只由各自的消费者修改。
+ */
+
+#include <Arduino.h>
+#include "sample_bus_final.h"
+
+// ==================== 全局总线状态 ====================
+
+typedef struct {
+    uint8_t active;
+    const char* name;
+    uint32_t cursor;             // 下一个要读的序号
+    uint32_t delivered;
+    uint32_t dropped;
+    uint16_t max_lag;
+} SampleBusSubscriber;
+
+typedef struct {
+    uint64_t timestamp_us[SAMPLE_BUS_CAPACITY];
+    int32_t red[SAMPLE_BUS_CAPACITY];
+    int32_t ir[SAMPLE_BUS_CAPACITY];
+    uint32_t head;               // 下一个要写的序号（只经 bus_head_load/store 访问）
+    SampleBusSubscriber subs[SAMPLE_BUS_MAX_SUBSCRIBERS];
+} SampleBusState;
+
+static SampleBusState g_bus = {0};
+
+// ==================== 私有函数 ====================
+
+static inline uint32_t bus_head_load() {
+    return __atomic_load_n(&g_bus.head, __ATOMIC_ACQUIRE);
+}
+
+static inline void bus_head_store(uint32_t head) {
+    __atomic_store_n(&g_bus.head, head, __ATOMIC_RELEASE);
+}
+
+// 可交给消费者的最大未读数：保留 SAMPLE_BUS_GUARD 个槽位的余量
+#define SAMPLE_BUS_MAX_LAG           (SAMPLE_BUS_CAPACITY - SAMPLE_BUS_GUARD)
+
+// 落后超过 SAMPLE_BUS_MAX_LAG：跳过最旧的样本（仅消费者自己调用）
+static uint32_t sample_bus_catch_up(SampleBusSubscriber* s) {
+    uint32_t head = bus_head_load();
+    uint32_t lag = head - s->cursor;
+    if (lag > SAMPLE_BUS_MAX_LAG) {
+        s->dropped += lag - SAMPLE_BUS_MAX_LAG;
+        s->cursor = head - SAMPLE_BUS_MAX_LAG;
+        lag = SAMPLE_BUS_MAX_LAG;
+    }
+    if (lag > s->max_lag) {
+        s->max_lag = (uint16_t)lag;
+    }
+    return lag;
+}
+
+static SampleBusSubscriber* sample_bus_sub(uint8_t sub) {
+    if (sub >= SAMPLE_BUS_MAX_SUBSCRIBERS || !g_bus.subs[sub].active) {
+        return NULL;
+    }
+    return &g_bus.subs[sub];
+}
+
+// ==================== 初始化 ====================
+
+void sample_bus_init() {
+    memset(&g_bus, 0, sizeof(SampleBusState));
+}
+
+// ==================== 生产者 ====================
+
+void sample_bus_publish(uint64_t timestamp_us, int32_t red, int32_t ir) {
+    uint32_t head = g_bus.head;  // 只有生产者写 head
+    uint32_t idx = head & SAMPLE_BUS_MASK;
+    g_bus.timestamp_us[idx] = timestamp_us;
+    g_bus.red[idx] = red;
+    g_bus.ir[idx] = ir;
+    bus_head_store(head + 1);
+}
+
+uint32_t sample_bus_published() {
+    return bus_head_load();
+}
+
+uint8_t sample_bus_get_latest(PpgSample* sample) {
+    uint32_t head = bus_head_load();
+    if (sample == NULL || head == 0) return 0;
+    uint32_t idx = (head - 1) & SAMPLE_BUS_MASK;
+    sample->timestamp_us = g_bus.timestamp_us[idx];
+    sample->red = g_bus.red[idx];
+    sample->ir = g_bus.ir[idx];
+    return 1;
+}
+
+uint16_t sample_bus_copy_latest(int32_t* red, int32_t* ir, uint64_t* timestamp_us, uint16_t max) {
+    uint32_t head = bus_head_load();
+    uint32_t count = (head < SAMPLE_BUS_CAPACITY) ? head : SAMPLE_BUS_CAPACITY;
+    uint16_t n = (max < count) ? max : (uint16_t)count;
+    uint32_t seq = head - n;
+    
+    for (uint16_t i = 0; i < n; i++, seq++) {
+        uint32_t idx = seq & SAMPLE_BUS_MASK;
+        if (red) red[i] = g_bus.red[idx];
+        if (ir) ir[i] = g_bus.ir[idx];
+        if (timestamp_us) timestamp_us[i] = g_bus.timestamp_us[idx];
+    }
+    return n;
+}
+
+// ==================== 消费者 ====================
+
+uint8_t sample_bus_subscribe(const char* name) {
+    for (uint8_t i = 0; i < SAMPLE_BUS_MAX_SUBSCRIBERS; i++) {
+        SampleBusSubscriber* s = &g_bus.subs[i];
+        if (!s->active) {
+            memset(s, 0, sizeof(SampleBusSubscriber));
+            s->active = 1;
+            s->name = name;
+            s->cursor = bus_head_load();
+            return i;
+        }
+    }
+    return SAMPLE_BUS_INVALID_SUB;
+}
+
+void sample_bus_unsubscribe(uint8_t sub) {
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s) s->active = 0;
+}
+
+uint16_t sample_bus_peek(uint8_t sub, PpgSpan* span) {
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s == NULL || span == NULL) return 0;
+
+    uint32_t lag = sample_bus_catch_up(s);
+    if (lag == 0) return 0;
+
+    // 连续片段不跨越缓冲末尾
+    uint32_t idx = s->cursor & SAMPLE_BUS_MASK;
+    uint32_t contiguous = SAMPLE_BUS_CAPACITY - idx;
+    span->timestamp_us = &g_bus.timestamp_us[idx];
+    span->red = &g_bus.red[idx];
+    span->ir = &g_bus.ir[idx];
+    span->count = (uint16_t)((lag < contiguous) ? lag : contiguous);
+    span->seq = s->cursor;
+    return span->count;
+}
+
+uint16_t sample_bus_consume(uint8_t sub, uint16_t count) {
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s == NULL) return 0;
+
+    // 复查：序号 seq 的槽位在生产者写 seq + 容量 时被覆盖（正在写 head 时即可能读到半新半旧的值），
+    // 因此 [cursor, head + 1 - 容量) 内的样本已不可信
+    uint32_t lag = bus_head_load() - s->cursor;
+    if (count > lag) count = (uint16_t)lag;
+    uint32_t overwritten = (lag + 1 > SAMPLE_BUS_CAPACITY) ? lag + 1 - SAMPLE_BUS_CAPACITY : 0;
+    if (overwritten > count) overwritten = count;
+
+    s->cursor += count;
+    s->delivered += count - overwritten;
+    s->dropped += overwritten;
+    return (uint16_t)overwritten;
+}
+
+void sample_bus_skip(uint8_t sub) {
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s) s->cursor = bus_head_load();
+}
+
+uint16_t sample_bus_lag(uint8_t sub) {
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s == NULL) return 0;
+    uint32_t lag = bus_head_load() - s->cursor;
+    return (uint16_t)((lag > SAMPLE_BUS_MAX_LAG) ? SAMPLE_BUS_MAX_LAG : lag);
+}
+
+// ==================== 统计信息 ====================
+
+void sample_bus_get_subscriber_stats(uint8_t sub, SampleBusSubscriberStats* stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(SampleBusSubscriberStats));
+
+    SampleBusSubscriber* s = sample_bus_sub(sub);
+    if (s == NULL) return;
+
+    // 只读：尚未被 peek 跳过的积压也计入丢弃
+    uint32_t lag = bus_head_load() - s->cursor;
+    uint32_t pending_drop = (lag > SAMPLE_BUS_MAX_LAG) ? lag - SAMPLE_BUS_MAX_LAG : 0;
+    stats->lag = (uint16_t)(lag - pending_drop);
+    stats->name = s->name;
+    stats->delivered = s->delivered;
+    stats->dropped = s->dropped + pending_drop;
+    stats->max_lag = s->max_lag;
+}
+
+void sample_bus_print_stats() {
+#ifdef DEBUG_MODE
+    uint32_t head = bus_head_load();
+    Serial.printf("[BUS] published:%lu\n", head);
+    for (uint8_t i = 0; i < SAMPLE_BUS_MAX_SUBSCRIBERS; i++) {
+        SampleBusSubscriber* s = &g_bus.subs[i];
+        if (!s->active) continue;
+        Serial.printf("  %-10s delivered:%lu dropped:%lu lag:%lu max_lag:%u\n",
+            s->name, s->delivered, s->dropped, head - s->cursor, s->max_lag);
+    }
+#endif
+}
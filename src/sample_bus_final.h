@@ -0,0 +1,70 @@
+#ifndef SAMPLE_BUS_FINAL_H
+#define SAMPLE_BUS_FINAL_H
+
+#include <Arduino.h>
+
+/*
+ * sample_bus_final.h - PPG样本总线（单生产者 / 多消费者）
+ *
+ * 采集器是唯一读取MAX30102 FIFO的模块，样本只写入一次共享环形缓冲；
+ * 每个消费者（算法、波形UI、BLE原始流、Flash记录）持有独立读游标，
+ * 通过 peek/consume 直接读取环形缓冲中的连续片段，不再拷贝。
+ * 缓冲按结构数组（SoA）存放：时间戳（微秒）、红光、红外各自连续，便于逐通道批处理。
+ * 消费者落后接近容量时（只剩 SAMPLE_BUS_GUARD 个样本的余量），peek 先把游标跳到
+ * 余量之内并累计丢弃计数，使交出的片段在一次采集排空（≤32个样本）内不会被覆盖；
+ * consume 再按当时的 head 复查，读取期间仍被覆盖的样本计入丢弃并返回其个数，调用方丢弃由它们得出的结果。
+ * lag/统计查询只读，不移动游标。
+ */
+
+#define SAMPLE_BUS_CAPACITY          256     // 必须为2的幂（≈2.56秒 @100Hz）
+#define SAMPLE_BUS_MASK              (SAMPLE_BUS_CAPACITY - 1)
+#define SAMPLE_BUS_MAX_SUBSCRIBERS   4
+#define SAMPLE_BUS_INVALID_SUB       0xFF
+#define SAMPLE_BUS_GUARD             32      // peek 保留的覆盖余量（= 采集器单次最多排空的样本数）
+
+typedef struct {
+    uint64_t timestamp_us;           // 采集时刻（由FIFO深度反推，见 timebase）
+    int32_t red;
+    int32_t ir;
+} PpgSample;
+
+// 共享缓冲中的一段连续样本（只读，consume 之前有效）
+typedef struct {
+    const uint64_t* timestamp_us;
+    const int32_t* red;
+    const int32_t* ir;
+    uint16_t count;
+    uint32_t seq;                    // 首个样本的总线序号（前后片段不连续即有样本被覆盖）
+} PpgSpan;
+
+typedef struct {
+    const char* name;
+    uint32_t delivered;          // 已消费样本数
+    uint32_t dropped;            // 因落后被覆盖的样本数
+    uint16_t lag;                // 当前未读样本数
+    uint16_t max_lag;            // 历史最大未读样本数
+} SampleBusSubscriberStats;
+
+void sample_bus_init();
+
+// 生产者（仅采集器）
+void sample_bus_publish(uint64_t timestamp_us, int32_t red, int32_t ir);
+uint32_t sample_bus_published();
+uint8_t sample_bus_get_latest(PpgSample* sample);
+uint16_t sample_bus_copy_latest(int32_t* red, int32_t* ir, uint64_t* timestamp_us, uint16_t max);  // 最近max个（按时间先后）
+
+// 消费者：订阅后从当前位置开始接收新样本
+uint8_t sample_bus_subscribe(const char* name);    // 返回订阅ID，满则 SAMPLE_BUS_INVALID_SUB
+void sample_bus_unsubscribe(uint8_t sub);
+
+// 取出可读连续片段（到环形缓冲末尾为止），span 指向共享缓冲，读完后调用 consume；返回样本数
+uint16_t sample_bus_peek(uint8_t sub, PpgSpan* span);
+// 消费 count 个样本，返回其中在读取期间已被生产者覆盖的个数（位于片段开头，通常为0）
+uint16_t sample_bus_consume(uint8_t sub, uint16_t count);
+void sample_bus_skip(uint8_t sub);                 // 丢弃全部未读样本
+uint16_t sample_bus_lag(uint8_t sub);              // peek 可取的未读样本数（只读）
+
+void sample_bus_get_subscriber_stats(uint8_t sub, SampleBusSubscriberStats* stats);
+void sample_bus_print_stats();
+
+#endif
@@ -17,7 +17,12 @@
 #include "../config/system_config.h"
 #include "hr_driver.h"
 #include "sno2_driver.h"
+#include "sensor_source.h"
 #include "sensor_collector_final.h"
+#include "sample_bus_final.h"
+#include "../system/timebase.h"
+#include "../algorithm/wear_detect.h"
+#include "../utils/spsc_ring.h"
 
 // ==================== 引脚定义（用户确认） ====================
 #define PIN_BAT_ADC              2          // GPIO2 ADC1_CH1
@@ -35,6 +40,7 @@ typedef struct {
     int32_t hr_ir;
     uint32_t hr_last_read_ms;
     uint32_t hr_sample_count;
+    uint8_t hr_was_off_wrist;
     
     // SnO2采集（10Hz）
     uint16_t sno2_raw_adc;
@@ -46,19 +52,29 @@ typedef struct {
     uint8_t battery_percent;
     uint32_t battery_last_read_ms;
     
-    // 环形缓冲
-    SensorSample sample_buffer[SENSOR_BUFFER_SIZE];
-    uint16_t buffer_head;
-    uint16_t buffer_tail;
-    uint16_t buffer_count;
+    // 分类型环形缓冲（HR在样本总线中）；head为自由递增计数，最新样本 = head-1
+    uint32_t sno2_ts[SENSOR_SNO2_RING_SIZE];
+    uint16_t sno2_mv[SENSOR_SNO2_RING_SIZE];
+    uint8_t sno2_heater[SENSOR_SNO2_RING_SIZE];
+    uint32_t sno2_head;
+    
+    uint32_t battery_ts[SENSOR_BATTERY_RING_SIZE];
+    uint16_t battery_mv_ring[SENSOR_BATTERY_RING_SIZE];
+    uint8_t battery_pct_ring[SENSOR_BATTERY_RING_SIZE];
+    uint32_t battery_head;
     
     // 统计
+    uint32_t sno2_handoff_drops;
     uint32_t total_reads;
     uint32_t last_stats_ms;
 } SensorCollectorState;
 
 static SensorCollectorState g_collector = {0};
 
+// SnO2 读数交给DSP：采集任务（core 1 高优先级）随时可能抢占正在读取的DSP任务，
+// 经无锁队列交接，DSP 不会读到写了一半的读数
+static SpscRing<Sno2Reading, SENSOR_SNO2_HANDOFF_SIZE> g_sno2_handoff;
+
 // ==================== 初始化 ====================
 
 void sensor_collector_init() {
@@ -69,6 +85,10 @@ void sensor_collector_init() {
     adcAttachPin(PIN_BAT_ADC);          // 附加电池ADC
     adcAttachPin(PIN_SNO2_ADC);         // 附加SnO2 ADC
     
+    // HR样本走样本总线（红光/红外SoA环形缓冲）
+    sample_bus_init();
+    timebase_rate_init(HR_FIFO_PERIOD_US);  // FIFO输出周期（含片上平均）
+    
     // 时间戳初始化
     uint32_t now = millis();
     g_collector.hr_last_read_ms = now;
@@ -84,19 +104,16 @@ void sensor_collector_init() {
 
 // ==================== 环形缓冲管理 ====================
 
-static uint8_t sensor_buffer_push(const SensorSample* sample) {
-    if (g_collector.buffer_count >= SENSOR_BUFFER_SIZE) {
-        // 缓冲满，丢弃最旧数据
-        g_collector.buffer_tail = (g_collector.buffer_tail + 1) % SENSOR_BUFFER_SIZE;
-        g_collector.buffer_count--;
-    }
-    
-    memcpy(&g_collector.sample_buffer[g_collector.buffer_head], 
-           sample, sizeof(SensorSample));
-    g_collector.buffer_head = (g_collector.buffer_head + 1) % SENSOR_BUFFER_SIZE;
-    g_collector.buffer_count++;
-    
-    return 1;
+// 缓冲内有效样本数（未写满前为 head）
+static inline uint16_t ring_count(uint32_t head, uint16_t size) {
+    return (head < size) ? (uint16_t)head : size;
+}
+
+// 从 head 往前取最近 max 个样本的起始序号，*n 输出实际个数
+static inline uint32_t ring_oldest(uint32_t head, uint16_t size, uint16_t max, uint16_t* n) {
+    uint16_t count = ring_count(head, size);
+    *n = (max < count) ? max : count;
+    return head - *n;
 }
 
 // ==================== HR采集（10ms周期） ====================
@@ -109,26 +126,45 @@ static void sensor_collect_hr() {
         return;
     }
     
-    if (hr_available()) {
-        if (hr_read_latest(&g_collector.hr_red, &g_collector.hr_ir)) {
-            SensorSample sample;
-            sample.timestamp_ms = now_ms;
-            sample.type = SENSOR_TYPE_HR;
-            sample.data.hr.red = g_collector.hr_red;
-            sample.data.hr.ir = g_collector.hr_ir;
-            
-            sensor_buffer_push(&sample);
-            g_collector.hr_sample_count++;
-            g_collector.hr_last_read_ms = now_ms;
-            
+    // 佩戴状态切换在本任务中执行（含算法管理器请求的离腕）
+    wear_detect_poll(now_ms);
+    
+    // 离腕：MAX30102处于接近模式，FIFO无数据，只查询接近中断
+    if (!wear_detect_is_on_wrist()) {
+        g_collector.hr_was_off_wrist = 1;
+        return;
+    }
+    
+    // 重新佩戴：数据流中断过，周期估计重新锚定
+    if (g_collector.hr_was_off_wrist) {
+        g_collector.hr_was_off_wrist = 0;
+        timebase_rate_reset();
+    }
+    
+    // 读空FIFO：按读写指针得出的深度一次突发读出，样本数即读取时刻的FIFO深度，据此反推每个样本的采集时刻
+    // 采集器是唯一的FIFO读取者：写入样本总线，各消费者按自己的游标读取
+    int32_t red[SENSOR_HR_MAX_DRAIN];
+    int32_t ir[SENSOR_HR_MAX_DRAIN];
+    uint64_t ts_us[SENSOR_HR_MAX_DRAIN];
+    uint16_t n = sensor_source_ppg_read_fifo(red, ir, SENSOR_HR_MAX_DRAIN);
+    g_collector.hr_last_read_ms = now_ms;
+    if (n == 0) return;
+    
+    timebase_on_drain(timebase_now_us(), n, ts_us);
+    for (uint16_t i = 0; i < n; i++) {
+        sample_bus_publish(ts_us[i], red[i], ir[i]);
+        wear_detect_feed_ppg(ir[i]);
+    }
+    g_collector.hr_red = red[n - 1];
+    g_collector.hr_ir = ir[n - 1];
+    g_collector.hr_sample_count += n;
+    
 #ifdef VERBOSE_COLLECTOR_DEBUG
-            if (g_collector.hr_sample_count % 50 == 0) {
-                Serial.printf("[HR] R:%ld IR:%ld (cnt:%lu)\n",
-                    g_collector.hr_red, g_collector.hr_ir, g_collector.hr_sample_count);
-            }
-#endif
-        }
+    if (g_collector.hr_sample_count % 50 < n) {
+        Serial.printf("[HR] R:%ld IR:%ld (cnt:%lu drain:%u)\n",
+            g_collector.hr_red, g_collector.hr_ir, g_collector.hr_sample_count, n);
     }
+#endif
 }
 
 // ==================== SnO2采集（100ms周期） ====================
@@ -144,25 +180,29 @@ static void sensor_collect_sno2() {
     // 更新SnO2驱动状态机
     sno2_update();
     
-    // 直接读取ADC（AD623输出）
-    uint16_t adc_raw = analogRead(PIN_SNO2_ADC);
+    // 读取ADC（AD623输出，经数据源层）
+    uint16_t adc_raw = 0;
+    if (!sensor_source_gas_read_raw(&adc_raw)) {
+        return;
+    }
     uint16_t voltage_mv = (adc_raw * ADC_REF_MV) / ADC_RESOLUTION;
     
-    SensorSample sample;
-    sample.timestamp_ms = now_ms;
-    sample.type = SENSOR_TYPE_SNO2;
-    sample.data.sno2.voltage_mv = voltage_mv;
-    sample.data.sno2.concentration_ppm = 0;  // 实际由sno2_driver计算
-    sample.data.sno2.heater_on = sno2_is_heater_on();
-    
-    sensor_buffer_push(&sample);
+    uint8_t heater_on = sno2_is_heater_on() ? 1 : 0;
+    uint16_t idx = g_collector.sno2_head & SENSOR_SNO2_RING_MASK;
+    g_collector.sno2_ts[idx] = now_ms;
+    g_collector.sno2_mv[idx] = voltage_mv;
+    g_collector.sno2_heater[idx] = heater_on;
+    g_collector.sno2_head++;
     g_collector.sno2_sample_count++;
+    
+    Sno2Reading reading = { now_ms, voltage_mv, heater_on };
+    if (!g_sno2_handoff.push(reading)) g_collector.sno2_handoff_drops++;
     g_collector.sno2_last_read_ms = now_ms;
     
 #ifdef VERBOSE_COLLECTOR_DEBUG
     if (g_collector.sno2_sample_count % 10 == 0) {
         Serial.printf("[SnO2] ADC:%u mV:%u H:%u (cnt:%lu)\n",
-            adc_raw, voltage_mv, sample.data.sno2.heater_on, g_collector.sno2_sample_count);
+            adc_raw, voltage_mv, heater_on, g_collector.sno2_sample_count);
     }
 #endif
 }
@@ -177,8 +217,11 @@ static void sensor_collect_battery() {
         return;
     }
     
-    // 读取电池ADC（GPIO2）
-    uint16_t adc_raw = analogRead(PIN_BAT_ADC);
+    // 读取电池ADC（GPIO2，经数据源层）
+    uint16_t adc_raw = 0;
+    if (!sensor_source_battery_read_raw(&adc_raw)) {
+        return;
+    }
     g_collector.battery_mv = (adc_raw * ADC_REF_MV) / ADC_RESOLUTION;
     
     // 简单的百分比估算（根据实际电池特性调整）
@@ -192,13 +235,11 @@ static void sensor_collect_battery() {
             ((g_collector.battery_mv - 2500) * 100) / (4200 - 2500);
     }
     
-    SensorSample sample;
-    sample.timestamp_ms = now_ms;
-    sample.type = SENSOR_TYPE_BATTERY;
-    sample.data.battery.voltage_mv = g_collector.battery_mv;
-    sample.data.battery.percent = g_collector.battery_percent;
-    
-    sensor_buffer_push(&sample);
+    uint16_t idx = g_collector.battery_head & SENSOR_BATTERY_RING_MASK;
+    g_collector.battery_ts[idx] = now_ms;
+    g_collector.battery_mv_ring[idx] = g_collector.battery_mv;
+    g_collector.battery_pct_ring[idx] = g_collector.battery_percent;
+    g_collector.battery_head++;
     g_collector.battery_last_read_ms = now_ms;
     
 #ifdef DEBUG_MODE
@@ -220,35 +261,78 @@ void sensor_collector_update() {
 
 // ==================== 缓冲查询API ====================
 
-uint16_t sensor_collector_available() {
-    return g_collector.buffer_count;
+uint8_t sensor_collector_latest_sno2(Sno2Data* data, uint32_t* timestamp_ms) {
+    if (data == NULL || g_collector.sno2_head == 0) return 0;
+    
+    uint16_t idx = (g_collector.sno2_head - 1) & SENSOR_SNO2_RING_MASK;
+    memset(data, 0, sizeof(Sno2Data));
+    data->voltage_mv = g_collector.sno2_mv[idx];
+    data->concentration_ppm = 0;  // 实际由sno2_driver计算
+    data->valid = 1;
+    data->heater_on = g_collector.sno2_heater[idx];
+    if (timestamp_ms) *timestamp_ms = g_collector.sno2_ts[idx];
+    return 1;
 }
 
-uint8_t sensor_collector_read(SensorSample* sample) {
-    if (sample == NULL || g_collector.buffer_count == 0) {
-        return 0;
-    }
-    
-    memcpy(sample, &g_collector.sample_buffer[g_collector.buffer_tail], 
-           sizeof(SensorSample));
-    g_collector.buffer_tail = (g_collector.buffer_tail + 1) % SENSOR_BUFFER_SIZE;
-    g_collector.buffer_count--;
+uint8_t sensor_collector_latest_battery(BatteryData* data, uint32_t* timestamp_ms) {
+    if (data == NULL || g_collector.battery_head == 0) return 0;
     
+    uint16_t idx = (g_collector.battery_head - 1) & SENSOR_BATTERY_RING_MASK;
+    data->voltage_mv = g_collector.battery_mv_ring[idx];
+    data->percent = g_collector.battery_pct_ring[idx];
+    if (timestamp_ms) *timestamp_ms = g_collector.battery_ts[idx];
     return 1;
 }
 
-// 获取最新指定类型的样本
+uint16_t sensor_collector_read_hr(int32_t* red, int32_t* ir, uint64_t* timestamp_us, uint16_t max) {
+    return sample_bus_copy_latest(red, ir, timestamp_us, max);
+}
+
+uint16_t sensor_collector_read_sno2(uint16_t* voltage_mv, uint32_t* timestamp_ms, uint16_t max) {
+    uint16_t n;
+    uint32_t seq = ring_oldest(g_collector.sno2_head, SENSOR_SNO2_RING_SIZE, max, &n);
+    for (uint16_t i = 0; i < n; i++, seq++) {
+        uint16_t idx = seq & SENSOR_SNO2_RING_MASK;
+        if (voltage_mv) voltage_mv[i] = g_collector.sno2_mv[idx];
+        if (timestamp_ms) timestamp_ms[i] = g_collector.sno2_ts[idx];
+    }
+    return n;
+}
+
+uint16_t sensor_collector_read_battery(uint16_t* voltage_mv, uint32_t* timestamp_ms, uint16_t max) {
+    uint16_t n;
+    uint32_t seq = ring_oldest(g_collector.battery_head, SENSOR_BATTERY_RING_SIZE, max, &n);
+    for (uint16_t i = 0; i < n; i++, seq++) {
+        uint16_t idx = seq & SENSOR_BATTERY_RING_MASK;
+        if (voltage_mv) voltage_mv[i] = g_collector.battery_mv_ring[idx];
+        if (timestamp_ms) timestamp_ms[i] = g_collector.battery_ts[idx];
+    }
+    return n;
+}
+
+uint16_t sensor_collector_pop_sno2(Sno2Reading* out, uint16_t max) {
+    if (out == NULL) return 0;
+    return (uint16_t)g_sno2_handoff.pop_bulk(out, max);
+}
+
+// 兼容接口：按类型取最新样本（O(1)）
 uint8_t sensor_collector_get_latest(SensorType type, SensorSample* sample) {
     if (sample == NULL) return 0;
     
-    // 从缓冲末尾向前查找
-    uint16_t idx = (g_collector.buffer_head - 1 + SENSOR_BUFFER_SIZE) % SENSOR_BUFFER_SIZE;
-    for (uint16_t i = 0; i < g_collector.buffer_count; i++) {
-        if (g_collector.sample_buffer[idx].type == type) {
-            memcpy(sample, &g_collector.sample_buffer[idx], sizeof(SensorSample));
+    sample->type = type;
+    switch (type) {
+        case SENSOR_TYPE_HR: {
+            PpgSample ppg;
+            if (!sample_bus_get_latest(&ppg)) return 0;
+            sample->timestamp_ms = (uint32_t)(ppg.timestamp_us / 1000);
+            sample->data.hr.red = ppg.red;
+            sample->data.hr.ir = ppg.ir;
             return 1;
         }
-        idx = (idx - 1 + SENSOR_BUFFER_SIZE) % SENSOR_BUFFER_SIZE;
+        case SENSOR_TYPE_SNO2:
+            return sensor_collector_latest_sno2(&sample->data.sno2, &sample->timestamp_ms);
+        case SENSOR_TYPE_BATTERY:
+            return sensor_collector_latest_battery(&sample->data.battery, &sample->timestamp_ms);
     }
     return 0;
 }
@@ -262,7 +346,9 @@ void sensor_collector_get_stats(CollectorStats* stats) {
     stats->total_sno2_samples = g_collector.sno2_sample_count;
     stats->battery_mv = g_collector.battery_mv;
     stats->battery_percent = g_collector.battery_percent;
-    stats->buffer_count = g_collector.buffer_count;
+    stats->buffer_count = ring_count(g_collector.sno2_head, SENSOR_SNO2_RING_SIZE)
+                        + ring_count(g_collector.battery_head, SENSOR_BATTERY_RING_SIZE);
+    stats->sno2_handoff_drops = g_collector.sno2_handoff_drops;
     stats->total_reads = g_collector.total_reads;
 }
 
@@ -270,9 +356,11 @@ void sensor_collector_print_stats() {
 #ifdef DEBUG_MODE
     uint32_t now = millis();
     if ((now - g_collector.last_stats_ms) > 5000) {
-        Serial.printf("\n[COLLECTOR STATS] HR:%lu SnO2:%lu Battery:%u%% Buffer:%u/%d\n",
+        Serial.printf("\n[COLLECTOR STATS] HR:%lu SnO2:%lu Battery:%u%% SnO2缓冲:%u/%d 交接:%lu待取 %lu丢弃\n",
             g_collector.hr_sample_count, g_collector.sno2_sample_count,
-            g_collector.battery_percent, g_collector.buffer_count, SENSOR_BUFFER_SIZE);
+            g_collector.battery_percent,
+            ring_count(g_collector.sno2_head, SENSOR_SNO2_RING_SIZE), SENSOR_SNO2_RING_SIZE,
+            (unsigned long)g_sno2_handoff.size(), g_collector.sno2_handoff_drops);
         g_collector.last_stats_ms = now;
     }
 #endif
@@ -3,7 +3,18 @@
 
 #include <Arduino.h>
 
-#define SENSOR_BUFFER_SIZE      256
+// 分类型环形缓冲容量（按采样率与保留时长确定，必须为2的幂）
+// HR：红光/红外SoA环形缓冲位于样本总线（SAMPLE_BUS_CAPACITY，≈2.56秒 @100Hz）
+#define SENSOR_SNO2_RING_SIZE       64      // ≈6.4秒 @10Hz
+#define SENSOR_SNO2_RING_MASK       (SENSOR_SNO2_RING_SIZE - 1)
+#define SENSOR_BATTERY_RING_SIZE    8       // ≈8分钟 @60s
+#define SENSOR_BATTERY_RING_MASK    (SENSOR_BATTERY_RING_SIZE - 1)
+
+// 每次HR采集最多读出的样本数（MAX30102 FIFO深度32）
+#define SENSOR_HR_MAX_DRAIN         32
+
+// SnO2 采集→DSP 交接队列（utils/spsc_ring.h，无锁单生产者/单消费者），≈1.6秒 @10Hz
+#define SENSOR_SNO2_HANDOFF_SIZE    16
 
 typedef enum {
     SENSOR_TYPE_HR = 0,
@@ -24,6 +35,13 @@ typedef struct {
     uint8_t percent;
 } BatteryData;
 
+// 交接队列中的一次SnO2读数
+typedef struct {
+    uint32_t timestamp_ms;
+    uint16_t voltage_mv;
+    uint8_t heater_on;
+} Sno2Reading;
+
 typedef struct {
     uint32_t timestamp_ms;
     SensorType type;
@@ -39,15 +57,27 @@ typedef struct {
     uint32_t total_sno2_samples;
     uint16_t battery_mv;
     uint8_t battery_percent;
-    uint16_t buffer_count;
+    uint16_t buffer_count;      // SnO2 + 电池环形缓冲中的样本数
+    uint32_t sno2_handoff_drops;    // 交接队列满（DSP未及时取走）丢弃的读数
     uint32_t total_reads;
 } CollectorStats;
 
 void sensor_collector_init();
 void sensor_collector_update();
-uint16_t sensor_collector_available();
-uint8_t sensor_collector_read(SensorSample* sample);
-uint8_t sensor_collector_get_latest(SensorType type, SensorSample* sample);
+
+// 最新样本（O(1)），timestamp_ms 可为NULL
+uint8_t sensor_collector_latest_sno2(Sno2Data* data, uint32_t* timestamp_ms);
+uint8_t sensor_collector_latest_battery(BatteryData* data, uint32_t* timestamp_ms);
+uint8_t sensor_collector_get_latest(SensorType type, SensorSample* sample);  // 兼容接口
+
+// 批量读取最近 max 个样本（按时间先后），输出数组可为NULL，返回实际个数
+uint16_t sensor_collector_read_hr(int32_t* red, int32_t* ir, uint64_t* timestamp_us, uint16_t max);
+uint16_t sensor_collector_read_sno2(uint16_t* voltage_mv, uint32_t* timestamp_ms, uint16_t max);
+uint16_t sensor_collector_read_battery(uint16_t* voltage_mv, uint32_t* timestamp_ms, uint16_t max);
+
+// 取出采集任务交给DSP的SnO2读数（按时间先后），返回个数；只能由DSP任务（唯一消费者）调用
+uint16_t sensor_collector_pop_sno2(Sno2Reading* out, uint16_t max);
+
 void sensor_collector_get_stats(CollectorStats* stats);
 void sensor_collector_print_stats();
 
@@ -0,0 +1,237 @@
+/*
+ * task_runtime_final.cpp - 任务运行时（FreeRTOS 双核 / 协作式回退）
+ *
+ * 两种模式共用同一套计时与统计：rt_run() 记录唤醒延迟与运行时间，
+ * 区别只在于谁来决定"何时运行"（FreeRTOS 的 vTaskDelayUntil / 任务通知，
+ * 或 loop() 中的轮询）。
+ */
+
+#include <Arduino.h>
+#include "task_runtime_final.h"
+#include "../system/timebase.h"
+#include "../system/idle.h"
+
+#if RT_USE_FREERTOS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// ==================== 全局运行时状态 ====================
+
+typedef struct {
+    RtTaskConfig cfg;
+    RtTaskStats stats;
+    uint64_t next_due_us;            // 周期任务：下一个计划时刻；通知任务：等待超时时刻
+    volatile uint8_t notified;
+    volatile uint32_t notify_us;     // 首个未处理通知的时刻（低32位，差值自动处理回绕）
+#if RT_USE_FREERTOS
+    TaskHandle_t handle;
+#endif
+} RtTask;
+
+typedef struct {
+    RtTask tasks[RT_MAX_TASKS];
+    uint8_t count;
+    uint8_t started;
+    uint64_t start_us;
+} RtState;
+
+static RtState g_rt = {0};
+
+#if RT_USE_FREERTOS
+static portMUX_TYPE g_rt_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+// ==================== 私有函数 ====================
+
+static RtTask* rt_task(uint8_t id) {
+    return (id < g_rt.count) ? &g_rt.tasks[id] : NULL;
+}
+
+// 运行一次任务函数：先结算唤醒延迟，再计时
+static void rt_run(RtTask* t) {
+    uint64_t start = timebase_now_us();
+    uint32_t period_us = t->cfg.period_ms * 1000UL;
+    uint32_t latency = 0;
+    uint8_t has_latency = 0;
+
+    if (t->cfg.wake == RT_WAKE_PERIODIC) {
+        if (start >= t->next_due_us) {
+            latency = (uint32_t)(start - t->next_due_us);
+            has_latency = 1;
+        }
+        if (latency >= period_us) {
+            // 错过整个周期：不补跑，从当前时刻重新对齐
+            t->stats.overruns++;
+            t->next_due_us = start;
+        }
+        t->next_due_us += period_us;
+    } else {
+        if (t->notified) {
+            latency = (uint32_t)start - t->notify_us;
+            has_latency = 1;
+            t->notified = 0;
+        }
+        t->next_due_us = start + period_us;
+    }
+
+    if (has_latency) {
+        int32_t avg = (int32_t)t->stats.latency_avg_us;
+        t->stats.latency_avg_us = (uint32_t)(avg + ((int32_t)latency - avg) / 16);
+        if (latency > t->stats.latency_max_us) t->stats.latency_max_us = latency;
+    }
+
+    t->cfg.func();
+
+    uint32_t run_us = (uint32_t)(timebase_now_us() - start);
+    t->stats.runs++;
+    t->stats.busy_us += run_us;
+    if (run_us > t->stats.max_run_us) t->stats.max_run_us = run_us;
+}
+
+#if RT_USE_FREERTOS
+static void rt_task_entry(void* arg) {
+    RtTask* t = (RtTask*)arg;
+    TickType_t period = pdMS_TO_TICKS(t->cfg.period_ms);
+    if (period == 0) period = 1;
+    TickType_t last_wake = xTaskGetTickCount();
+    t->next_due_us = timebase_now_us();
+
+    for (;;) {
+        if (t->cfg.wake == RT_WAKE_NOTIFY) {
+            ulTaskNotifyTake(pdTRUE, period);
+        } else {
+            vTaskDelayUntil(&last_wake, period);
+        }
+        rt_run(t);
+    }
+}
+#endif
+
+// ==================== 注册与启动 ====================
+
+uint8_t task_runtime_add(const RtTaskConfig* cfg) {
+    if (cfg == NULL || cfg->func == NULL || g_rt.started || g_rt.count >= RT_MAX_TASKS) {
+        return RT_INVALID_TASK;
+    }
+    RtTask* t = &g_rt.tasks[g_rt.count];
+    memset(t, 0, sizeof(RtTask));
+    t->cfg = *cfg;
+    t->stats.name = cfg->name;
+    t->stats.core = RT_USE_FREERTOS ? cfg->core : 0;
+    t->stats.priority = cfg->priority;
+    return g_rt.count++;
+}
+
+void task_runtime_start() {
+    g_rt.start_us = timebase_now_us();
+
+    for (uint8_t i = 0; i < g_rt.count; i++) {
+        RtTask* t = &g_rt.tasks[i];
+        t->next_due_us = g_rt.start_us;
+#if RT_USE_FREERTOS
+        xTaskCreatePinnedToCore(rt_task_entry, t->cfg.name, t->cfg.stack_bytes, t,
+                                t->cfg.priority, &t->handle, t->cfg.core);
+#endif
+    }
+    g_rt.started = 1;
+#if !RT_USE_FREERTOS
+    // 协作模式：任务计划时刻作为空闲休眠的截止时刻来源
+    static const IdleSource rt_idle_source = {"tasks", task_runtime_time_to_next_ms, NULL};
+    idle_register_source(&rt_idle_source);
+#endif
+
+#ifdef DEBUG_MODE
+    Serial.printf("[RT] %u 个任务已启动（%s）\n", g_rt.count, RT_USE_FREERTOS ? "FreeRTOS" : "协作式");
+#endif
+}
+
+// ==================== 运行 ====================
+
+void task_runtime_loop() {
+#if RT_USE_FREERTOS
+    vTaskDelay(pdMS_TO_TICKS(RT_IDLE_LOOP_MS));
+#else
+    // 按注册顺序（即优先级）运行所有到期任务
+    for (uint8_t i = 0; i < g_rt.count; i++) {
+        RtTask* t = &g_rt.tasks[i];
+        uint64_t now = timebase_now_us();
+        if (t->notified || now >= t->next_due_us) {
+            rt_run(t);
+        }
+    }
+    
+    // 休眠到所有来源中最早的截止时刻（任务计划时刻、BLE等）
+    idle_sleep();
+#endif
+}
+
+uint32_t task_runtime_time_to_next_ms() {
+    uint64_t now = timebase_now_us();
+    uint64_t next = now + RT_IDLE_LOOP_MS * 1000ULL;
+    for (uint8_t i = 0; i < g_rt.count; i++) {
+        RtTask* t = &g_rt.tasks[i];
+        if (t->notified || t->next_due_us <= now) return 0;
+        if (t->next_due_us < next) next = t->next_due_us;
+    }
+    return (uint32_t)((next - now + 999) / 1000);  // 向上取整：不足1ms时休眠1ms，而不是空转
+}
+
+void task_runtime_notify(uint8_t id) {
+    RtTask* t = rt_task(id);
+    if (t == NULL) return;
+
+    t->stats.notifies++;
+    if (!t->notified) {
+        t->notify_us = (uint32_t)timebase_now_us();
+        t->notified = 1;
+    }
+#if RT_USE_FREERTOS
+    if (t->handle) xTaskNotifyGive(t->handle);
+#endif
+}
+
+void task_runtime_enter_critical() {
+#if RT_USE_FREERTOS
+    portENTER_CRITICAL(&g_rt_mux);
+#endif
+}
+
+void task_runtime_exit_critical() {
+#if RT_USE_FREERTOS
+    portEXIT_CRITICAL(&g_rt_mux);
+#endif
+}
+
+// ==================== 统计信息 ====================
+
+void task_runtime_get_stats(uint8_t id, RtTaskStats* stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(RtTaskStats));
+
+    RtTask* t = rt_task(id);
+    if (t == NULL) return;
+
+    *stats = t->stats;
+#if RT_USE_FREERTOS
+    if (t->handle) stats->stack_free_min = uxTaskGetStackHighWaterMark(t->handle);
+#endif
+}
+
+void task_runtime_print_stats() {
+#ifdef DEBUG_MODE
+    uint64_t elapsed = timebase_now_us() - g_rt.start_us;
+    if (elapsed == 0) elapsed = 1;
+
+    Serial.printf("[RT] 任务（%s）\n", RT_USE_FREERTOS ? "FreeRTOS" : "协作式");
+    for (uint8_t i = 0; i < g_rt.count; i++) {
+        RtTaskStats s;
+        task_runtime_get_stats(i, &s);
+        uint32_t cpu_x10 = (uint32_t)(s.busy_us * 1000 / elapsed);
+        Serial.printf("  %-6s core:%u prio:%u runs:%lu cpu:%lu.%lu%% run_max:%luus "
+                      "lat avg:%luus max:%luus overruns:%lu stack_free:%lu\n",
+            s.name, s.core, s.priority, s.runs, cpu_x10 / 10, cpu_x10 % 10, s.max_run_us,
+            s.latency_avg_us, s.latency_max_us, s.overruns, s.stack_free_min);
+    }
+#endif
+}
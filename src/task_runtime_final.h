@@ -0,0 +1,99 @@
+#ifndef TASK_RUNTIME_FINAL_H
+#define TASK_RUNTIME_FINAL_H
+
+#include <Arduino.h>
+
+/*
+ * task_runtime_final.h - 任务运行时（FreeRTOS 双核 / 协作式回退）
+ *
+ * ESP32-S3：每个任务一个 FreeRTOS 任务并绑定核心
+ *   采集（core 1，高优先级）：周期读空传感器FIFO，发布到样本总线后通知DSP
+ *   DSP  （core 1，中优先级）：等待通知（超时即周期）处理新样本块
+ *   通信 （core 0，低优先级）：BLE / UI / 日志，与NimBLE主机任务同核
+ * 其他平台（ESP32-C3 单核）或定义 RT_COOPERATIVE：同一接口退化为在 loop() 中
+ *   按注册顺序轮询（注册顺序即优先级），通知只是置标志。
+ *
+ * 每个任务统计：运行次数、CPU时间、单次最长运行、唤醒延迟（周期任务相对计划时刻，
+ * 通知任务相对通知时刻）、错过周期次数、栈最低剩余。
+ */
+
+#if defined(MCU_ESP32_S3) && !defined(RT_COOPERATIVE)
+#define RT_USE_FREERTOS          1
+#else
+#define RT_USE_FREERTOS          0
+#endif
+
+#define RT_MAX_TASKS             4
+#define RT_INVALID_TASK          0xFF
+#define RT_IDLE_LOOP_MS          100     // loop() 单次最长休眠（FreeRTOS 模式下固定休眠）
+
+// 任务布局（可通过 build_flags 覆盖）
+#ifndef RT_CORE_ACQ
+#define RT_CORE_ACQ              1
+#endif
+#ifndef RT_CORE_DSP
+#define RT_CORE_DSP              1
+#endif
+#ifndef RT_CORE_COMM
+#define RT_CORE_COMM             0
+#endif
+#define RT_PRIO_ACQ              5
+#define RT_PRIO_DSP              4
+#define RT_PRIO_COMM             2       // 低于 NimBLE 主机任务
+#define RT_STACK_ACQ             4096    // 字节
+#define RT_STACK_DSP             6144
+#define RT_STACK_COMM            8192    // JSON 序列化 + printf
+
+typedef enum {
+    RT_WAKE_PERIODIC = 0,            // 固定周期（无漂移，按计划时刻累加）
+    RT_WAKE_NOTIFY                   // 等待通知，period_ms 为最长等待时间
+} RtWakeMode;
+
+typedef struct {
+    const char* name;
+    void (*func)(void);
+    uint32_t period_ms;
+    RtWakeMode wake;
+    uint8_t core;
+    uint8_t priority;
+    uint32_t stack_bytes;
+} RtTaskConfig;
+
+typedef struct {
+    const char* name;
+    uint8_t core;
+    uint8_t priority;
+    uint32_t runs;
+    uint64_t busy_us;                // 累计运行时间
+    uint32_t max_run_us;
+    uint32_t latency_avg_us;         // 唤醒延迟（指数平均 1/16）
+    uint32_t latency_max_us;
+    uint32_t overruns;               // 周期任务：错过计划时刻超过一个周期的次数
+    uint32_t notifies;               // 通知任务：收到的通知数（多次通知可能合并为一次运行）
+    uint32_t stack_free_min;         // 栈最低剩余字节（协作模式为0）
+} RtTaskStats;
+
+// 注册任务（task_runtime_start 之前），返回任务ID，满则 RT_INVALID_TASK
+uint8_t task_runtime_add(const RtTaskConfig* cfg);
+
+// 启动全部任务（FreeRTOS 模式创建任务；协作模式只初始化计划时刻）
+void task_runtime_start();
+
+// 在 loop() 中调用：协作模式下运行到期任务，再由 idle_sleep() 休眠到最早的截止时刻；
+// FreeRTOS 模式下仅休眠（任务自行阻塞，空闲时由 PM 自动 light sleep）
+void task_runtime_loop();
+
+// 距最早的任务计划时刻（ms，有待处理通知或已到期返回0）
+uint32_t task_runtime_time_to_next_ms();
+
+// 唤醒通知任务（任务上下文调用）
+void task_runtime_notify(uint8_t id);
+
+// 跨任务共享数据的短临界区（FreeRTOS 模式为自旋锁 + 关中断，协作模式为空）
+void task_runtime_enter_critical();
+void task_runtime_exit_critical();
+
+void task_runtime_get_stats(uint8_t id, RtTaskStats* stats);
+void task_runtime_print_stats();
+
+#endif
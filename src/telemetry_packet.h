@@ -0,0 +1,162 @@
+#ifndef TELEMETRY_PACKET_H
+#define TELEMETRY_PACKET_H
+
+/*
+ * telemetry_packet.h - 紧凑二进制遥测帧（固件与主机工具共用，仅头文件，无 Arduino 依赖）
+ *
+ * 帧格式（小端）：
+ *   [0]     版本 TELEMETRY_VERSION（JSON 帧以 '{' 开头，接收方据首字节区分）
+ *   [1]     字段位图 TELEMETRY_FIELD_*
+ *   [2..5]  时间戳（uint32，秒，总是存在）
+ *   ...     位图中置位的字段，按位序紧凑排列：
+ *             HR      uint8   bpm
+ *             SPO2    uint8   %
+ *             ACETONE uint16  ppm ×10
+ *             BATTERY uint8   %
+ *             SNR     uint8   信号质量（与 AlgorithmResult.signal_quality 相同）
+ *             RISK    uint8   TelemetryRisk
+ *             WEAR    uint8   佩戴状态（WearState）
+ *   [n-2..] CRC-16/CCITT-FALSE（多项式 0x1021，初值 0xFFFF，覆盖之前全部字节）
+ *
+ * 全字段帧 16 字节，一次 20 字节通知（默认 MTU 23）即可发完。
+ * 位7保留给后续扩展：解码器遇到未知位返回 TELEMETRY_ERR_FIELDS。
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define TELEMETRY_VERSION        1
+#define TELEMETRY_HEADER_LEN     6       // 版本 + 位图 + 时间戳
+#define TELEMETRY_CRC_LEN        2
+#define TELEMETRY_MAX_LEN        16      // 全字段帧
+#define TELEMETRY_NOTIFY_MAX     20      // 默认 ATT MTU 23 的单次通知负载
+
+// 字段位图
+#define TELEMETRY_FIELD_HR       0x01
+#define TELEMETRY_FIELD_SPO2     0x02
+#define TELEMETRY_FIELD_ACETONE  0x04
+#define TELEMETRY_FIELD_BATTERY  0x08
+#define TELEMETRY_FIELD_SNR      0x10
+#define TELEMETRY_FIELD_RISK     0x20
+#define TELEMETRY_FIELD_WEAR     0x40
+#define TELEMETRY_FIELD_ALL      0x7F
+
+// 解码返回值
+#define TELEMETRY_OK             0
+#define TELEMETRY_ERR_LENGTH     -1
+#define TELEMETRY_ERR_VERSION    -2
+#define TELEMETRY_ERR_CRC        -3
+#define TELEMETRY_ERR_FIELDS     -4
+
+typedef enum {
+    TELEMETRY_RISK_LOW = 0,
+    TELEMETRY_RISK_MEDIUM = 1,
+    TELEMETRY_RISK_HIGH = 2
+} TelemetryRisk;
+
+typedef struct {
+    uint8_t fields;                  // TELEMETRY_FIELD_* 有效字段
+    uint32_t timestamp_s;
+    uint8_t hr_bpm;
+    uint8_t spo2;
+    uint16_t acetone_x10;
+    uint8_t battery_pct;
+    uint8_t snr;
+    uint8_t risk;                    // TelemetryRisk
+    uint8_t wear;
+} TelemetryFrame;
+
+// ──────────────────────────────────────────────
+// 编解码
+
+static inline uint16_t telemetry_crc16(const uint8_t* data, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// 位图对应的帧长度
+static inline uint8_t telemetry_frame_len(uint8_t fields) {
+    uint8_t len = TELEMETRY_HEADER_LEN + TELEMETRY_CRC_LEN;
+    if (fields & TELEMETRY_FIELD_HR)      len += 1;
+    if (fields & TELEMETRY_FIELD_SPO2)    len += 1;
+    if (fields & TELEMETRY_FIELD_ACETONE) len += 2;
+    if (fields & TELEMETRY_FIELD_BATTERY) len += 1;
+    if (fields & TELEMETRY_FIELD_SNR)     len += 1;
+    if (fields & TELEMETRY_FIELD_RISK)    len += 1;
+    if (fields & TELEMETRY_FIELD_WEAR)    len += 1;
+    return len;
+}
+
+// 丙酮 ppm → ×10 定点（四舍五入，负值记0，超出饱和）
+static inline uint16_t telemetry_scale_acetone(float ppm) {
+    if (ppm <= 0.0f) return 0;
+    float scaled = ppm * 10.0f + 0.5f;
+    return (scaled >= 65535.0f) ? 65535 : (uint16_t)scaled;
+}
+
+// 编码到 out，返回帧长度；容量不足返回0
+static inline uint8_t telemetry_encode(const TelemetryFrame* f, uint8_t* out, uint8_t capacity) {
+    uint8_t fields = f->fields & TELEMETRY_FIELD_ALL;
+    uint8_t len = telemetry_frame_len(fields);
+    if (capacity < len) return 0;
+
+    uint8_t p = 0;
+    out[p++] = TELEMETRY_VERSION;
+    out[p++] = fields;
+    out[p++] = (uint8_t)(f->timestamp_s);
+    out[p++] = (uint8_t)(f->timestamp_s >> 8);
+    out[p++] = (uint8_t)(f->timestamp_s >> 16);
+    out[p++] = (uint8_t)(f->timestamp_s >> 24);
+    if (fields & TELEMETRY_FIELD_HR)      out[p++] = f->hr_bpm;
+    if (fields & TELEMETRY_FIELD_SPO2)    out[p++] = f->spo2;
+    if (fields & TELEMETRY_FIELD_ACETONE) {
+        out[p++] = (uint8_t)(f->acetone_x10);
+        out[p++] = (uint8_t)(f->acetone_x10 >> 8);
+    }
+    if (fields & TELEMETRY_FIELD_BATTERY) out[p++] = f->battery_pct;
+    if (fields & TELEMETRY_FIELD_SNR)     out[p++] = f->snr;
+    if (fields & TELEMETRY_FIELD_RISK)    out[p++] = f->risk;
+    if (fields & TELEMETRY_FIELD_WEAR)    out[p++] = f->wear;
+
+    uint16_t crc = telemetry_crc16(out, p);
+    out[p++] = (uint8_t)crc;
+    out[p++] = (uint8_t)(crc >> 8);
+    return p;
+}
+
+// 解码并校验；未出现的字段清零
+static inline int8_t telemetry_decode(const uint8_t* in, uint16_t len, TelemetryFrame* f) {
+    if (len < TELEMETRY_HEADER_LEN + TELEMETRY_CRC_LEN) return TELEMETRY_ERR_LENGTH;
+    if (in[0] != TELEMETRY_VERSION) return TELEMETRY_ERR_VERSION;
+    uint8_t fields = in[1];
+    if (fields & ~TELEMETRY_FIELD_ALL) return TELEMETRY_ERR_FIELDS;
+    if (len != telemetry_frame_len(fields)) return TELEMETRY_ERR_LENGTH;
+
+    uint16_t crc = (uint16_t)in[len - 2] | ((uint16_t)in[len - 1] << 8);
+    if (crc != telemetry_crc16(in, len - TELEMETRY_CRC_LEN)) return TELEMETRY_ERR_CRC;
+
+    memset(f, 0, sizeof(TelemetryFrame));
+    f->fields = fields;
+    f->timestamp_s = (uint32_t)in[2] | ((uint32_t)in[3] << 8) |
+                     ((uint32_t)in[4] << 16) | ((uint32_t)in[5] << 24);
+    uint8_t p = TELEMETRY_HEADER_LEN;
+    if (fields & TELEMETRY_FIELD_HR)      f->hr_bpm = in[p++];
+    if (fields & TELEMETRY_FIELD_SPO2)    f->spo2 = in[p++];
+    if (fields & TELEMETRY_FIELD_ACETONE) {
+        f->acetone_x10 = (uint16_t)in[p] | ((uint16_t)in[p + 1] << 8);
+        p += 2;
+    }
+    if (fields & TELEMETRY_FIELD_BATTERY) f->battery_pct = in[p++];
+    if (fields & TELEMETRY_FIELD_SNR)     f->snr = in[p++];
+    if (fields & TELEMETRY_FIELD_RISK)    f->risk = in[p++];
+    if (fields & TELEMETRY_FIELD_WEAR)    f->wear = in[p++];
+    return TELEMETRY_OK;
+}
+
+#endif // TELEMETRY_PACKET_H
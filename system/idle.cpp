@@ -0,0 +1,163 @@
+#include "idle.h"
+#include "timebase.h"
+#include <string.h>
+
+#if defined(ESP32)
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <esp_idf_version.h>
+#if defined(CONFIG_PM_ENABLE)
+#include <esp_pm.h>
+#endif
+#elif !defined(ARDUINO)
+#include "virtual_clock.h"
+#endif
+
+// ──────────────────────────────────────────────
+// 私有状态
+// ──────────────────────────────────────────────
+
+typedef struct {
+    IdleSource sources[IDLE_MAX_SOURCES];
+    uint8_t source_count;
+    uint8_t wake_pins[IDLE_MAX_WAKE_GPIOS];
+    uint8_t wake_levels[IDLE_MAX_WAKE_GPIOS];
+    uint8_t wake_pin_count;
+    IdleStats stats;
+} IdleState;
+
+static IdleState g_idle = {0};
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+static uint8_t light_sleep_blocked() {
+    for (uint8_t i = 0; i < g_idle.source_count; i++) {
+        if (g_idle.sources[i].blocks_light_sleep && g_idle.sources[i].blocks_light_sleep()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// light sleep 直到 sleep_ms 或 GPIO 电平唤醒
+static IdleWakeReason enter_light_sleep(uint32_t sleep_ms) {
+#if defined(ESP32)
+    Serial.flush();  // light sleep 期间 UART 时钟停止，先发完缓冲
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000ULL);
+    if (g_idle.wake_pin_count > 0) {
+        for (uint8_t i = 0; i < g_idle.wake_pin_count; i++) {
+            gpio_wakeup_enable((gpio_num_t)g_idle.wake_pins[i],
+                               g_idle.wake_levels[i] ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+        }
+        esp_sleep_enable_gpio_wakeup();
+    }
+    esp_light_sleep_start();
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    if (cause == ESP_SLEEP_WAKEUP_TIMER) return IDLE_WAKE_TIMER;
+    if (cause == ESP_SLEEP_WAKEUP_GPIO) return IDLE_WAKE_GPIO;
+    return IDLE_WAKE_OTHER;
+#elif !defined(ARDUINO)
+    uint8_t irq = vclock_sleep_until_us(vclock_now_us() + (uint64_t)sleep_ms * 1000ULL);
+    return irq ? IDLE_WAKE_GPIO : IDLE_WAKE_TIMER;
+#else
+    delay(sleep_ms);  // 无 light sleep 的平台退化为阻塞等待
+    return IDLE_WAKE_TIMER;
+#endif
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+uint8_t idle_register_source(const IdleSource* source) {
+    if (source == NULL || source->time_to_next_ms == NULL || g_idle.source_count >= IDLE_MAX_SOURCES) {
+        return 0;
+    }
+    g_idle.sources[g_idle.source_count++] = *source;
+    return 1;
+}
+
+uint8_t idle_add_wake_gpio(uint8_t pin, uint8_t level) {
+    if (g_idle.wake_pin_count >= IDLE_MAX_WAKE_GPIOS) return 0;
+    g_idle.wake_pins[g_idle.wake_pin_count] = pin;
+    g_idle.wake_levels[g_idle.wake_pin_count] = level;
+    g_idle.wake_pin_count++;
+    return 1;
+}
+
+void idle_configure_pm() {
+#if defined(ESP32) && defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t cfg = {};
+#else
+    esp_pm_config_esp32s3_t cfg = {};
+#endif
+    cfg.max_freq_mhz = 240;
+    cfg.min_freq_mhz = 80;
+    cfg.light_sleep_enable = true;
+    esp_pm_configure(&cfg);
+#ifdef DEBUG_MODE
+    Serial.println("[IDLE] 已启用空闲自动 light sleep");
+#endif
+#endif
+}
+
+uint32_t idle_time_to_next_ms(const char** limiter) {
+    uint32_t next = IDLE_MAX_SLEEP_MS;
+    const char* who = "max";
+    for (uint8_t i = 0; i < g_idle.source_count; i++) {
+        uint32_t t = g_idle.sources[i].time_to_next_ms();
+        if (t < next) {
+            next = t;
+            who = g_idle.sources[i].name;
+        }
+    }
+    if (limiter) *limiter = who;
+    return next;
+}
+
+IdleWakeReason idle_sleep() {
+    g_idle.stats.calls++;
+
+    const char* limiter = NULL;
+    uint32_t sleep_ms = idle_time_to_next_ms(&limiter);
+    g_idle.stats.last_limiter = limiter;
+    if (sleep_ms == 0) {
+        g_idle.stats.no_sleep++;
+        return IDLE_WAKE_NONE;
+    }
+
+    uint64_t start = timebase_now_us();
+    IdleWakeReason reason;
+    if (sleep_ms >= IDLE_LIGHT_SLEEP_MIN_MS && !light_sleep_blocked()) {
+        reason = enter_light_sleep(sleep_ms);
+        g_idle.stats.light_sleeps++;
+        g_idle.stats.light_slept_us += timebase_now_us() - start;
+        if (reason == IDLE_WAKE_GPIO) g_idle.stats.gpio_wakeups++;
+    } else {
+        delay(sleep_ms);
+        reason = IDLE_WAKE_TIMER;
+        g_idle.stats.blocking_waits++;
+        g_idle.stats.waited_us += timebase_now_us() - start;
+    }
+    return reason;
+}
+
+void idle_get_stats(IdleStats* stats) {
+    if (stats) *stats = g_idle.stats;
+}
+
+void idle_print_stats() {
+#ifdef DEBUG_MODE
+    uint64_t now = timebase_now_us();
+    if (now == 0) now = 1;
+    uint32_t sleep_x10 = (uint32_t)((g_idle.stats.waited_us + g_idle.stats.light_slept_us) * 1000 / now);
+    Serial.printf("[IDLE] calls:%lu busy:%lu wait:%lu light:%lu gpio_wake:%lu 休眠占比:%lu.%lu%% (light %lums) limiter:%s\n",
+        g_idle.stats.calls, g_idle.stats.no_sleep, g_idle.stats.blocking_waits, g_idle.stats.light_sleeps,
+        g_idle.stats.gpio_wakeups, sleep_x10 / 10, sleep_x10 % 10,
+        (unsigned long)(g_idle.stats.light_slept_us / 1000),
+        g_idle.stats.last_limiter ? g_idle.stats.last_limiter : "-");
+#endif
+}
@@ -0,0 +1,62 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <Arduino.h>
+
+// ──────────────────────────────────────────────
+// 无节拍空闲：休眠到最早的截止时刻
+// ──────────────────────────────────────────────
+// 各模块注册"截止时刻来源"（调度器下次释放、任务运行时、BLE发送等），
+// loop() 处理完到期工作后调用 idle_sleep()：
+//   1. 取所有来源中最早的截止时刻（上限 IDLE_MAX_SLEEP_MS）
+//   2. 足够长且没有来源禁止时进入 light sleep（定时器 + GPIO 唤醒，如 MAX30102 INT、按键）
+//   3. 否则阻塞等待（delay → vTaskDelay；启用 PM 自动 light sleep 时由 FreeRTOS 空闲任务进入）
+// BLE 连接期间射频需要保持时钟，由应用注册的 BLE 来源通过 blocks_light_sleep 禁止显式 light sleep。
+// 主机构建中 delay()/light sleep 由虚拟时钟实现（见 virtual_clock）。
+
+#define IDLE_MAX_SOURCES         6
+#define IDLE_MAX_WAKE_GPIOS      4
+#define IDLE_NO_DEADLINE         0xFFFFFFFFUL    // 来源当前没有截止时刻
+#ifndef IDLE_LIGHT_SLEEP_MIN_MS
+#define IDLE_LIGHT_SLEEP_MIN_MS  5       // 短于此用阻塞等待（light sleep 进出约1ms）
+#endif
+#define IDLE_MAX_SLEEP_MS        1000    // 单次最长休眠（兜底）
+
+typedef enum {
+    IDLE_WAKE_NONE = 0,              // 已有到期工作，未休眠
+    IDLE_WAKE_TIMER,                 // 截止时刻到达
+    IDLE_WAKE_GPIO,                  // 外部中断提前唤醒
+    IDLE_WAKE_OTHER
+} IdleWakeReason;
+
+typedef struct {
+    const char* name;
+    uint32_t (*time_to_next_ms)(void);   // 距该来源下一个截止时刻；无则返回 IDLE_NO_DEADLINE
+    uint8_t (*blocks_light_sleep)(void); // 可为NULL
+} IdleSource;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t no_sleep;               // 有到期工作，直接返回
+    uint32_t blocking_waits;
+    uint32_t light_sleeps;
+    uint32_t gpio_wakeups;
+    uint64_t waited_us;              // 阻塞等待累计
+    uint64_t light_slept_us;         // light sleep 累计
+    const char* last_limiter;        // 最近一次决定休眠时长的来源
+} IdleStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+uint8_t idle_register_source(const IdleSource* source);  // 满返回0
+uint8_t idle_add_wake_gpio(uint8_t pin, uint8_t level);  // light sleep 唤醒引脚（电平触发）
+void idle_configure_pm();            // 启用 FreeRTOS 空闲自动 light sleep（需 CONFIG_PM_ENABLE）
+
+uint32_t idle_time_to_next_ms(const char** limiter);     // 所有来源中最早的截止时刻
+IdleWakeReason idle_sleep();
+
+void idle_get_stats(IdleStats* stats);
+void idle_print_stats();
+
+#endif // IDLE_H
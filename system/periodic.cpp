@@ -0,0 +1,126 @@
+#include "periodic.h"
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+// 执行时间直方图：0~3us 各一档，之后每个2倍区间 [2^k, 2^(k+1)) 分4档
+static uint8_t hist_bucket(uint32_t us) {
+    if (us < 4) return (uint8_t)us;
+    uint8_t octave = 31 - __builtin_clz(us);
+    uint8_t sub = (us >> (octave - 2)) & 3;
+    uint32_t idx = 4 * (uint32_t)(octave - 1) + sub;
+    return (idx < PERIODIC_HIST_BUCKETS) ? (uint8_t)idx : (PERIODIC_HIST_BUCKETS - 1);
+}
+
+static uint32_t hist_upper_us(uint8_t idx) {
+    if (idx < 4) return idx;
+    uint8_t octave = idx / 4 + 1;
+    uint8_t sub = idx % 4;
+    uint32_t width = 1UL << (octave - 2);
+    return (4UL + sub) * width + width - 1;
+}
+
+static void hist_add(PeriodicTimer* t, uint32_t exec_us) {
+    uint8_t idx = hist_bucket(exec_us);
+    if (t->exec_hist[idx] == 0xFFFF) {
+        // 计数饱和：全部减半（同时让分布偏向近期）
+        for (uint8_t i = 0; i < PERIODIC_HIST_BUCKETS; i++) {
+            t->exec_hist[i] >>= 1;
+        }
+    }
+    t->exec_hist[idx]++;
+}
+
+static uint32_t hist_p99(const PeriodicTimer* t) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PERIODIC_HIST_BUCKETS; i++) {
+        total += t->exec_hist[i];
+    }
+    if (total == 0) return 0;
+
+    uint32_t target = total - total / 100;  // 第 ceil(0.99·N) 个
+    uint32_t acc = 0;
+    for (uint8_t i = 0; i < PERIODIC_HIST_BUCKETS; i++) {
+        acc += t->exec_hist[i];
+        if (acc >= target) {
+            uint32_t upper = hist_upper_us(i);
+            return (upper < t->exec_max_us) ? upper : t->exec_max_us;
+        }
+    }
+    return t->exec_max_us;
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void periodic_init(PeriodicTimer* t, uint32_t period_ms, PeriodicPolicy policy, uint32_t now_ms) {
+    memset(t, 0, sizeof(PeriodicTimer));
+    t->period_ms = period_ms ? period_ms : 1;
+    t->policy = policy;
+    t->next_release_ms = now_ms + t->period_ms;
+    t->current_release_ms = now_ms;
+    t->exec_min_us = 0xFFFFFFFF;
+}
+
+void periodic_set_deadline(PeriodicTimer* t, uint32_t deadline_ms) {
+    t->deadline_ms = deadline_ms;
+}
+
+uint8_t periodic_due(PeriodicTimer* t, uint32_t now_ms) {
+    int32_t late = (int32_t)(now_ms - t->next_release_ms);
+    if (late < 0) return 0;
+
+    // 完整错过的周期数：SKIP 全部丢弃，CATCH_UP 只丢弃超出积压上限的部分
+    uint32_t missed = (uint32_t)late / t->period_ms;
+    uint32_t drop = missed;
+    if (t->policy == PERIODIC_CATCH_UP) {
+        drop = (missed > PERIODIC_MAX_BACKLOG) ? (missed - PERIODIC_MAX_BACKLOG) : 0;
+    }
+    t->skipped += drop;
+    t->next_release_ms += drop * t->period_ms;
+
+    t->current_release_ms = t->next_release_ms;
+    t->next_release_ms += t->period_ms;
+    return 1;
+}
+
+void periodic_complete(PeriodicTimer* t, uint32_t exec_us, uint32_t finish_ms) {
+    t->runs++;
+    t->exec_total_us += exec_us;
+    if (exec_us < t->exec_min_us) t->exec_min_us = exec_us;
+    if (exec_us > t->exec_max_us) t->exec_max_us = exec_us;
+    hist_add(t, exec_us);
+
+    uint32_t deadline = t->deadline_ms ? t->deadline_ms : t->period_ms;
+    if (finish_ms - t->current_release_ms > deadline) {
+        t->deadline_misses++;
+    }
+}
+
+uint8_t periodic_run(PeriodicTimer* t, void (*func)(void), uint32_t now_ms) {
+    if (!periodic_due(t, now_ms)) return 0;
+
+    uint32_t start_us = micros();
+    if (func) func();
+    periodic_complete(t, micros() - start_us, millis());
+    return 1;
+}
+
+uint32_t periodic_time_to_release(const PeriodicTimer* t, uint32_t now_ms) {
+    int32_t remaining = (int32_t)(t->next_release_ms - now_ms);
+    return (remaining > 0) ? (uint32_t)remaining : 0;
+}
+
+void periodic_get_stats(const PeriodicTimer* t, PeriodicStats* stats) {
+    if (stats == NULL) return;
+    stats->runs = t->runs;
+    stats->skipped = t->skipped;
+    stats->deadline_misses = t->deadline_misses;
+    stats->exec_min_us = t->runs ? t->exec_min_us : 0;
+    stats->exec_avg_us = t->runs ? (uint32_t)(t->exec_total_us / t->runs) : 0;
+    stats->exec_max_us = t->exec_max_us;
+    stats->exec_p99_us = hist_p99(t);
+}
@@ -0,0 +1,75 @@
+#ifndef PERIODIC_H
+#define PERIODIC_H
+
+#include <Arduino.h>
+
+// ──────────────────────────────────────────────
+// 周期任务定时器（无漂移释放 + 截止时间统计）
+// ──────────────────────────────────────────────
+// - 释放时刻按 period_ms 精确累加（release += period），不再用"本次运行时刻"作为下次基准，
+//   运行延迟不会累积成周期漂移
+// - 落后超过一个周期时按策略处理：
+//   PERIODIC_SKIP     丢弃错过的释放，保持原相位，只运行一次（适合"取最新值"的任务）
+//   PERIODIC_CATCH_UP 每次调用补跑一次，直到追上（适合计数/积分类任务），
+//                     积压超过 PERIODIC_MAX_BACKLOG 个周期的部分仍丢弃
+// - 每次运行记录执行时间（min/avg/max/p99，p99 取对数直方图的档位上界，偏保守，误差<25%）
+// - 完成时刻晚于 释放时刻 + deadline_ms 记为一次截止时间违约
+
+#define PERIODIC_MAX_BACKLOG     4       // CATCH_UP 最多补跑的周期数
+#define PERIODIC_HIST_BUCKETS    80      // 每2倍区间4档，覆盖 0 ~ 2^21 us（≈2秒）
+
+typedef enum {
+    PERIODIC_SKIP = 0,
+    PERIODIC_CATCH_UP
+} PeriodicPolicy;
+
+typedef struct {
+    uint32_t period_ms;
+    uint32_t deadline_ms;            // 相对释放时刻（0 = 等于周期）
+    PeriodicPolicy policy;
+
+    uint32_t next_release_ms;
+    uint32_t current_release_ms;     // 本次运行对应的释放时刻
+
+    // 统计
+    uint32_t runs;
+    uint32_t skipped;                // 被丢弃的释放次数
+    uint32_t deadline_misses;
+    uint32_t exec_min_us;
+    uint32_t exec_max_us;
+    uint64_t exec_total_us;
+    uint16_t exec_hist[PERIODIC_HIST_BUCKETS];
+} PeriodicTimer;
+
+typedef struct {
+    uint32_t runs;
+    uint32_t skipped;
+    uint32_t deadline_misses;
+    uint32_t exec_min_us;
+    uint32_t exec_avg_us;
+    uint32_t exec_max_us;
+    uint32_t exec_p99_us;
+} PeriodicStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+// 首次释放在 now_ms + period_ms
+void periodic_init(PeriodicTimer* t, uint32_t period_ms, PeriodicPolicy policy, uint32_t now_ms);
+void periodic_set_deadline(PeriodicTimer* t, uint32_t deadline_ms);
+
+// 到期则推进释放时刻并返回1（调用方随后执行任务并调用 periodic_complete）
+uint8_t periodic_due(PeriodicTimer* t, uint32_t now_ms);
+
+// 记录一次执行：执行时间与完成时刻（用于截止时间判定）
+void periodic_complete(PeriodicTimer* t, uint32_t exec_us, uint32_t finish_ms);
+
+// 到期则执行 func 并计时，返回是否执行
+uint8_t periodic_run(PeriodicTimer* t, void (*func)(void), uint32_t now_ms);
+
+// 距下次释放的毫秒数（已到期返回0）
+uint32_t periodic_time_to_release(const PeriodicTimer* t, uint32_t now_ms);
+
+void periodic_get_stats(const PeriodicTimer* t, PeriodicStats* stats);
+
+#endif // PERIODIC_H
@@ -4,6 +4,8 @@
 #include "../algorithm/hr_algorithm.h"
 #include "gas_driver.h"
 #include "env_driver.h"
+#include "periodic.h"
+#include "timer_wheel.h"
 
 // ──────────────────────────────────────────────
 // 调度周期配置
@@ -11,6 +13,74 @@
 #define GAS_POLL_INTERVAL_MS     1000    // 气体轮询周期（1秒）
 #define ENV_POLL_INTERVAL_MS     2000    // 环境轮询周期（2秒）
 
+// ──────────────────────────────────────────────
+// 周期定时器（释放时刻无漂移；都是"取最新值"的任务，落后时跳过而不补跑）
+// 由共享时间轮按释放时刻触发
+static PeriodicTimer hr_sample_timer;
+static PeriodicTimer hr_calc_timer;
+static TimerWheelTimer hr_sample_wt;
+static TimerWheelTimer hr_calc_wt;
+#ifdef DEVICE_ROLE_DETECTOR
+static PeriodicTimer gas_poll_timer;
+static PeriodicTimer env_poll_timer;
+static TimerWheelTimer gas_poll_wt;
+static TimerWheelTimer env_poll_wt;
+#endif
+
+// ──────────────────────────────────────────────
+// 任务
+
+// 心率采样（高频，10ms）：更新失败可记录日志，但不阻塞
+static void task_hr_sample() {
+    hr_algorithm_update();
+}
+
+// 心率计算（中频，2秒）
+static void task_hr_calc() {
+    int calc_status;
+    uint8_t bpm = hr_calculate_bpm(&calc_status);
+    uint8_t snr_x10 = hr_get_signal_quality();
+    
+#ifdef DEVICE_ROLE_WRIST
+    // 腕带模式：同时计算 SpO2
+    uint8_t spo2 = hr_calculate_spo2(&calc_status);
+    uint8_t correlation = hr_get_correlation_quality();
+    system_state_set_hr_spo2(bpm, spo2, snr_x10, correlation, (int8_t)calc_status);
+#else
+    // 检测模块模式：只设置心率
+    system_state_set_hr(bpm, snr_x10, (int8_t)calc_status);
+#endif
+}
+
+#ifdef DEVICE_ROLE_DETECTOR
+// 气体传感器轮询（低频，1秒）
+static void task_gas_poll() {
+    float voltage_mv, conc_ppm;
+    if (gas_read(&voltage_mv, &conc_ppm)) {
+        // 只有有效数据才更新状态（转换为uint16_t）
+        uint16_t v_mv = (uint16_t)(voltage_mv + 0.5f);  // 四舍五入
+        uint16_t c_ppm_x10 = (uint16_t)(conc_ppm * 10.0f + 0.5f);  // ppm*10存储
+        system_state_set_gas(v_mv, c_ppm_x10, true);
+    } else {
+        // 预热中或无呼吸触发，标记无效但不更新数值
+        system_state_set_gas(0, 0, false);
+    }
+}
+
+// 环境传感器轮询（低频，2秒）
+static void task_env_poll() {
+    EnvData env;
+    if (env_read(&env) && env.valid) {
+        // 转换为int8_t和uint8_t
+        int8_t temp = (int8_t)(env.temperature_c + 0.5f);
+        uint8_t rh = (uint8_t)(env.humidity_rh + 0.5f);
+        system_state_set_env(temp, rh, true);
+    } else {
+        system_state_set_env(0, 0, false);
+    }
+}
+#endif
+
 void scheduler_init() {
     // 初始化心率算法
     hr_algorithm_init();
@@ -25,69 +95,40 @@ void scheduler_init() {
 
     // 初始化系统状态
     system_state_init();
+    
+    uint32_t now = millis();
+    periodic_init(&hr_sample_timer, HR_SAMPLE_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&hr_calc_timer, HR_CALC_INTERVAL_MS, PERIODIC_SKIP, now);
+#ifdef DEVICE_ROLE_DETECTOR
+    periodic_init(&gas_poll_timer, GAS_POLL_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&env_poll_timer, ENV_POLL_INTERVAL_MS, PERIODIC_SKIP, now);
+#endif
+
+    timer_wheel_start_periodic(&hr_sample_wt, "hr_sample", &hr_sample_timer, task_hr_sample);
+    timer_wheel_start_periodic(&hr_calc_wt, "hr_calc", &hr_calc_timer, task_hr_calc);
+#ifdef DEVICE_ROLE_DETECTOR
+    timer_wheel_start_periodic(&gas_poll_wt, "gas_poll", &gas_poll_timer, task_gas_poll);
+    timer_wheel_start_periodic(&env_poll_wt, "env_poll", &env_poll_timer, task_env_poll);
+#endif
 }
 
+// 推进共享时间轮：同时执行其他模块注册的定时器
 void scheduler_run() {
-    unsigned long now = millis();
-
-    // ─── 心率采样（高频，10ms） ──────────────────────────────
-    static unsigned long last_hr_update = 0;
-    if (now - last_hr_update >= HR_SAMPLE_INTERVAL_MS) {
-        int update_status = hr_algorithm_update();
-        last_hr_update = now;
-        // 更新失败可记录日志，但不阻塞
-    }
+    timer_wheel_advance(millis());
+}
 
-    // ─── 心率计算（中频，2秒） ──────────────────────────────
-    static unsigned long last_hr_calc = 0;
-    if (now - last_hr_calc >= HR_CALC_INTERVAL_MS) {
-        int calc_status;
-        uint8_t bpm = hr_calculate_bpm(&calc_status);
-        uint8_t snr_x10 = hr_get_signal_quality();
-        
-#ifdef DEVICE_ROLE_WRIST
-        // 腕带模式：同时计算 SpO2
-        uint8_t spo2 = hr_calculate_spo2(&calc_status);
-        uint8_t correlation = hr_get_correlation_quality();
-        system_state_set_hr_spo2(bpm, spo2, snr_x10, correlation, (int8_t)calc_status);
-#else
-        // 检测模块模式：只设置心率
-        system_state_set_hr(bpm, snr_x10, (int8_t)calc_status);
-#endif
-        
-        last_hr_calc = now;
-    }
+uint32_t scheduler_time_to_next_ms() {
+    return timer_wheel_time_to_next_ms();
+}
 
+void scheduler_get_stats(SchedulerTaskId task, PeriodicStats* stats) {
+    switch (task) {
+        case SCHED_TASK_HR_SAMPLE: periodic_get_stats(&hr_sample_timer, stats); break;
+        case SCHED_TASK_HR_CALC:   periodic_get_stats(&hr_calc_timer, stats); break;
 #ifdef DEVICE_ROLE_DETECTOR
-    // ─── 气体传感器轮询（低频，1秒） ──────────────────────────────
-    static unsigned long last_gas_poll = 0;
-    if (now - last_gas_poll >= GAS_POLL_INTERVAL_MS) {
-        float voltage_mv, conc_ppm;
-        if (gas_read(&voltage_mv, &conc_ppm)) {
-            // 只有有效数据才更新状态（转换为uint16_t）
-            uint16_t v_mv = (uint16_t)(voltage_mv + 0.5f);  // 四舍五入
-            uint16_t c_ppm_x10 = (uint16_t)(conc_ppm * 10.0f + 0.5f);  // ppm*10存储
-            system_state_set_gas(v_mv, c_ppm_x10, true);
-        } else {
-            // 预热中或无呼吸触发，标记无效但不更新数值
-            system_state_set_gas(0, 0, false);
-        }
-        last_gas_poll = now;
-    }
-
-    // ─── 环境传感器轮询（低频，2秒） ──────────────────────────────
-    static unsigned long last_env_poll = 0;
-    if (now - last_env_poll >= ENV_POLL_INTERVAL_MS) {
-        EnvData env;
-        if (env_read(&env) && env.valid) {
-            // 转换为int8_t和uint8_t
-            int8_t temp = (int8_t)(env.temperature_c + 0.5f);
-            uint8_t rh = (uint8_t)(env.humidity_rh + 0.5f);
-            system_state_set_env(temp, rh, true);
-        } else {
-            system_state_set_env(0, 0, false);
-        }
-        last_env_poll = now;
-    }
+        case SCHED_TASK_GAS_POLL:  periodic_get_stats(&gas_poll_timer, stats); break;
+        case SCHED_TASK_ENV_POLL:  periodic_get_stats(&env_poll_timer, stats); break;
 #endif
+        default: if (stats) memset(stats, 0, sizeof(PeriodicStats)); break;
+    }
 }
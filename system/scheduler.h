@@ -2,10 +2,20 @@
 #define SCHEDULER_H
 
 #include <Arduino.h>
+#include "periodic.h"
+
+typedef enum {
+    SCHED_TASK_HR_SAMPLE = 0,
+    SCHED_TASK_HR_CALC,
+    SCHED_TASK_GAS_POLL,         // 仅检测模块
+    SCHED_TASK_ENV_POLL          // 仅检测模块
+} SchedulerTaskId;
 
 // ──────────────────────────────────────────────
 // 函数声明
 void scheduler_init();    // 初始化所有传感器
-void scheduler_run();      // 主调度循环（非阻塞，需在loop()中持续调用）
+void scheduler_run();      // 主调度循环：推进共享时间轮（非阻塞，需在loop()中持续调用）
+uint32_t scheduler_time_to_next_ms();   // 距时间轮中最早的到期定时器（ms），loop() 据此休眠
+void scheduler_get_stats(SchedulerTaskId task, PeriodicStats* stats);  // 执行时间/跳过/截止时间违约
 
 #endif
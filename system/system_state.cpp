@@ -1,4 +1,5 @@
 #include "system_state.h"
+#include "timebase.h"
 #include <Arduino.h>
 #include <string.h>  // for memset
 #include "../algorithm/hr_algorithm.h"  // for HR_SUCCESS等常量
@@ -24,7 +25,7 @@ void system_state_reset_measurement() {
     g_state.env_temperature_c = 0;
     g_state.env_humidity_rh = 0;
     g_state.env_valid = false;
-    g_state.measurement_start_s = (uint16_t)(millis() / 1000);
+    g_state.measurement_start_s = timebase_now_s();
     g_state.measurement_end_s = 0;
 }
 
@@ -32,7 +33,7 @@ void system_state_set_hr(uint8_t bpm, uint8_t snr_x10, int8_t status) {
     g_state.hr_bpm = bpm;
     g_state.hr_snr_db_x10 = snr_x10;
     g_state.hr_status = status;
-    g_state.hr_timestamp_s = (uint16_t)(millis() / 1000);
+    g_state.hr_timestamp_s = timebase_now_s();
 }
 
 #ifdef DEVICE_ROLE_WRIST
@@ -42,7 +43,7 @@ void system_state_set_hr_spo2(uint8_t bpm, uint8_t spo2, uint8_t snr_x10, uint8_
     g_state.hr_snr_db_x10 = snr_x10;
     g_state.correlation_quality = correlation;
     g_state.hr_status = status;
-    g_state.hr_timestamp_s = (uint16_t)(millis() / 1000);
+    g_state.hr_timestamp_s = timebase_now_s();
 }
 
 uint8_t system_state_get_spo2() {
@@ -58,14 +59,14 @@ void system_state_set_gas(uint16_t voltage_mv, uint16_t conc_ppm_x10, bool valid
     g_state.gas_voltage_mv = voltage_mv;
     g_state.gas_concentration_ppm = conc_ppm_x10;
     g_state.gas_valid = valid;
-    g_state.gas_timestamp_s = (uint16_t)(millis() / 1000);
+    g_state.gas_timestamp_s = timebase_now_s();
 }
 
 void system_state_set_env(int8_t temp_c, uint8_t rh, bool valid) {
     g_state.env_temperature_c = temp_c;
     g_state.env_humidity_rh = rh;
     g_state.env_valid = valid;
-    g_state.env_timestamp_s = (uint16_t)(millis() / 1000);
+    g_state.env_timestamp_s = timebase_now_s();
 }
 
 const SystemState* system_state_get() {
@@ -10,7 +10,7 @@ typedef struct {
     uint8_t hr_bpm;              // 0=无效，40-180=BPM值
     uint8_t hr_snr_db_x10;      // SNR*10（例如15.3dB存储为153）
     int8_t hr_status;            // HR_SUCCESS, HR_POOR_SIGNAL 等（int8_t足够）
-    uint16_t hr_timestamp_s;     // 时间戳（秒，节省2 bytes）
+    uint32_t hr_timestamp_s;     // 时间戳（单调秒，uint16仅18小时即回绕）
 
 #ifdef DEVICE_ROLE_WRIST
     // 腕带模式：SpO2数据
@@ -22,17 +22,17 @@ typedef struct {
     uint16_t gas_voltage_mv;     // 电压（mV，0-5000范围）
     uint16_t gas_concentration_ppm;  // 浓度（ppm，0-1000范围，精度0.1ppm用*10存储）
     bool gas_valid;
-    uint16_t gas_timestamp_s;    // 时间戳（秒）
+    uint32_t gas_timestamp_s;    // 时间戳（秒）
 
     // 环境数据（低RAM优化：int8_t+uint8_t代替float）
     int8_t env_temperature_c;    // 温度（℃，-40~85范围，int8_t足够）
     uint8_t env_humidity_rh;     // 湿度（%，0-100范围）
     bool env_valid;
-    uint16_t env_timestamp_s;    // 时间戳（秒）
+    uint32_t env_timestamp_s;    // 时间戳（秒）
 
     // 测量窗口时间戳（低RAM优化：秒代替毫秒）
-    uint16_t measurement_start_s;
-    uint16_t measurement_end_s;
+    uint32_t measurement_start_s;
+    uint32_t measurement_end_s;
 } SystemState;
 
 // ──────────────────────────────────────────────
@@ -0,0 +1,160 @@
+#include "timebase.h"
+#include <string.h>
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#elif !defined(ARDUINO)
+#include "virtual_clock.h"
+#endif
+
+// ──────────────────────────────────────────────
+// 私有状态
+// ──────────────────────────────────────────────
+
+typedef struct {
+    uint32_t nominal_period_us;
+    uint32_t period_ns;
+    bool has_estimate;
+
+    // 估计窗口锚点
+    bool has_anchor;
+    uint64_t anchor_us;
+    uint32_t anchor_samples;
+
+    // 上一次读取
+    uint64_t last_drain_us;
+    uint64_t last_sample_us;
+
+    TimebaseStats stats;
+} TimebaseState;
+
+static TimebaseState g_tb = {0};
+
+// ──────────────────────────────────────────────
+// 64位单调时间
+// ──────────────────────────────────────────────
+
+uint64_t timebase_now_us() {
+#if defined(ESP32)
+    return (uint64_t)esp_timer_get_time();
+#elif defined(ARDUINO)
+    // micros() 约71分钟回绕一次，只要调用间隔小于回绕周期即可扩展为64位
+    static uint32_t last_us = 0;
+    static uint32_t high = 0;
+    uint32_t now = micros();
+    if (now < last_us) high++;
+    last_us = now;
+    return ((uint64_t)high << 32) | now;
+#else
+    return vclock_now_us();          // 主机构建：与 millis()/micros() 共用虚拟时钟
+#endif
+}
+
+uint32_t timebase_now_s() {
+    return (uint32_t)(timebase_now_us() / 1000000ULL);
+}
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+static int32_t period_to_ppm(uint32_t period_ns) {
+    int64_t nominal_ns = (int64_t)g_tb.nominal_period_us * 1000;
+    return (int32_t)(((int64_t)period_ns - nominal_ns) * 1000000 / nominal_ns);
+}
+
+// 一个估计窗口结束：Δt/Δn 与当前估计做指数平滑
+static void finish_window(uint64_t drain_us) {
+    uint32_t window_ns = (uint32_t)(((drain_us - g_tb.anchor_us) * 1000ULL) / g_tb.anchor_samples);
+    int32_t ppm = period_to_ppm(window_ns);
+
+    if (ppm > TIMEBASE_MAX_DRIFT_PPM || ppm < -TIMEBASE_MAX_DRIFT_PPM) {
+        g_tb.stats.rejected_windows++;
+    } else if (!g_tb.has_estimate) {
+        g_tb.period_ns = window_ns;
+        g_tb.has_estimate = true;
+        g_tb.stats.windows++;
+    } else {
+        int32_t delta = (int32_t)window_ns - (int32_t)g_tb.period_ns;
+        g_tb.period_ns = (uint32_t)((int32_t)g_tb.period_ns + (delta >> TIMEBASE_RATE_SMOOTH_SHIFT));
+        g_tb.stats.windows++;
+    }
+
+    g_tb.stats.period_ns = g_tb.period_ns;
+    g_tb.stats.drift_ppm = period_to_ppm(g_tb.period_ns);
+
+    g_tb.anchor_us = drain_us;
+    g_tb.anchor_samples = 0;
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void timebase_rate_init(uint32_t nominal_period_us) {
+    memset(&g_tb, 0, sizeof(g_tb));
+    g_tb.nominal_period_us = nominal_period_us ? nominal_period_us : 1;
+    g_tb.period_ns = g_tb.nominal_period_us * 1000;
+    g_tb.stats.nominal_period_us = g_tb.nominal_period_us;
+    g_tb.stats.period_ns = g_tb.period_ns;
+}
+
+void timebase_rate_reset() {
+    g_tb.has_anchor = false;
+    g_tb.anchor_samples = 0;
+    g_tb.last_drain_us = 0;
+}
+
+void timebase_on_drain(uint64_t drain_us, uint16_t count, uint64_t* out_us) {
+    if (count == 0) return;
+
+    uint32_t period_ns = g_tb.period_ns;
+
+    // 读取时刻抖动：与"上次读取 + count × 周期"的预测值比较
+    if (g_tb.last_drain_us != 0) {
+        uint64_t predicted = g_tb.last_drain_us + ((uint64_t)count * period_ns) / 1000;
+        uint32_t dev = (uint32_t)((drain_us > predicted) ? (drain_us - predicted) : (predicted - drain_us));
+        int32_t avg = (int32_t)g_tb.stats.jitter_avg_us;
+        g_tb.stats.jitter_avg_us = (uint32_t)(avg + ((int32_t)dev - avg) / 16);
+        if (dev > g_tb.stats.jitter_max_us) g_tb.stats.jitter_max_us = dev;
+    }
+    g_tb.last_drain_us = drain_us;
+
+    // 反推时间戳：最新样本 ≈ 读取时刻，向前每个样本减一个周期；保持严格递增
+    if (out_us != NULL) {
+        for (uint16_t i = 0; i < count; i++) {
+            uint64_t ts = drain_us - ((uint64_t)(count - 1 - i) * period_ns) / 1000;
+            if (ts <= g_tb.last_sample_us) ts = g_tb.last_sample_us + 1;
+            out_us[i] = ts;
+            g_tb.last_sample_us = ts;
+        }
+    }
+
+    g_tb.stats.drains++;
+    g_tb.stats.samples += count;
+
+    // 周期估计
+    if (!g_tb.has_anchor) {
+        g_tb.has_anchor = true;
+        g_tb.anchor_us = drain_us;
+        g_tb.anchor_samples = 0;
+        return;
+    }
+    g_tb.anchor_samples += count;
+    uint32_t window = g_tb.has_estimate ? TIMEBASE_RATE_WINDOW : TIMEBASE_RATE_FIRST_WINDOW;
+    if (g_tb.anchor_samples >= window) {
+        finish_window(drain_us);
+    }
+}
+
+uint32_t timebase_get_period_us() {
+    return (g_tb.period_ns + 500) / 1000;
+}
+
+uint32_t timebase_get_period_ns() {
+    return g_tb.period_ns;
+}
+
+void timebase_get_stats(TimebaseStats* stats) {
+    if (stats) *stats = g_tb.stats;
+}
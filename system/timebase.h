@@ -0,0 +1,53 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <Arduino.h>
+
+// ──────────────────────────────────────────────
+// 时间基准服务
+// ──────────────────────────────────────────────
+// 1. 64位单调微秒时间：ESP32 用 esp_timer_get_time()，其他平台扩展 micros() 回绕，
+//    主机构建使用虚拟时钟（见 virtual_clock）
+// 2. 样本时间戳反推：每次读空FIFO时已知本次读出 k 个样本，
+//    最新样本时间 ≈ 读取时刻，第 i 个样本 = 读取时刻 - (k-1-i) × 实测采样周期
+// 3. 在线估计传感器真实采样周期（传感器晶振相对CPU时钟的偏差）：
+//    以长基线（TIMEBASE_RATE_WINDOW 个样本）计算 Δt/Δn，再做指数平滑，
+//    单次读取的时刻抖动被长基线平均掉
+
+#define TIMEBASE_RATE_WINDOW         2000    // 估计窗口（样本数，≈20秒 @100Hz）
+#define TIMEBASE_RATE_FIRST_WINDOW   300     // 首次估计所需样本数（≈3秒）
+#define TIMEBASE_RATE_SMOOTH_SHIFT   2       // 平滑系数 1/4
+#define TIMEBASE_MAX_DRIFT_PPM       50000   // 超过±5%视为异常窗口（如离腕/FIFO溢出），丢弃
+
+typedef struct {
+    uint32_t nominal_period_us;      // 标称周期（配置的采样率）
+    uint32_t period_ns;              // 实测周期（纳秒，保留亚微秒精度）
+    int32_t drift_ppm;               // 实测相对标称的偏差（+表示传感器偏慢）
+    uint32_t windows;                // 已完成的估计窗口数
+    uint32_t rejected_windows;       // 被丢弃的异常窗口数
+
+    uint32_t drains;                 // 读FIFO次数
+    uint32_t samples;                // 累计样本数
+    uint32_t jitter_avg_us;          // 读取时刻相对预测时刻的平均绝对偏差
+    uint32_t jitter_max_us;          // 最大偏差
+} TimebaseStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+uint64_t timebase_now_us();          // 64位单调微秒时间
+uint32_t timebase_now_s();           // 单调秒（uint32，136年不回绕）
+
+// 采样周期估计器（单一PPG流）
+void timebase_rate_init(uint32_t nominal_period_us);
+void timebase_rate_reset();          // 数据流中断（离腕、重配置）后调用，保留已估计的周期
+
+// 一次FIFO读取：读取时刻 drain_us，读出 count 个样本；
+// 若 out_us 非NULL，输出每个样本的反推时间戳（按时间先后）
+void timebase_on_drain(uint64_t drain_us, uint16_t count, uint64_t* out_us);
+
+uint32_t timebase_get_period_us();   // 实测周期（四舍五入到微秒）
+uint32_t timebase_get_period_ns();
+void timebase_get_stats(TimebaseStats* stats);
+
+#endif // TIMEBASE_H
@@ -0,0 +1,259 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 私有状态
+// ──────────────────────────────────────────────
+
+typedef struct {
+    TimerWheelTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];   // 非空槽位图
+    uint32_t now_tick;
+    uint32_t target_ms;                      // 本次推进的目标时刻（周期定时器据此判断错过的释放）
+    uint8_t initialized;
+    TimerWheelStats stats;
+} TimerWheelState;
+
+static TimerWheelState g_wheel = {{{0}}};
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+static void wheel_ensure_init() {
+    if (g_wheel.initialized) return;
+    g_wheel.now_tick = millis();
+    g_wheel.target_ms = g_wheel.now_tick;
+    g_wheel.initialized = 1;
+}
+
+// 位图循环右移后取最低位：从 from 槽开始（含）第一个非空槽的距离，空返回 TIMER_WHEEL_SLOTS
+static uint8_t next_occupied(uint64_t bits, uint8_t from) {
+    if (bits == 0) return TIMER_WHEEL_SLOTS;
+    uint64_t rotated = from ? ((bits >> from) | (bits << (TIMER_WHEEL_SLOTS - from))) : bits;
+    return (uint8_t)__builtin_ctzll(rotated);
+}
+
+static void slot_link(TimerWheelTimer* t, uint8_t level, uint8_t slot) {
+    TimerWheelTimer* head = g_wheel.slots[level][slot];
+    t->level = level;
+    t->slot = slot;
+    t->prev = NULL;
+    t->next = head;
+    if (head) head->prev = t;
+    g_wheel.slots[level][slot] = t;
+    g_wheel.occupied[level] |= (1ULL << slot);
+}
+
+static void slot_unlink(TimerWheelTimer* t) {
+    if (t->prev) {
+        t->prev->next = t->next;
+    } else {
+        g_wheel.slots[t->level][t->slot] = t->next;
+    }
+    if (t->next) t->next->prev = t->prev;
+    if (g_wheel.slots[t->level][t->slot] == NULL) {
+        g_wheel.occupied[t->level] &= ~(1ULL << t->slot);
+    }
+    t->next = NULL;
+    t->prev = NULL;
+}
+
+// 按距到期的节拍数选层：第 L 层槽号取到期时刻的第 6L~6L+5 位。
+// delta < 64^(L+1) 保证槽号在当前位置之后一圈以内，该槽下一次进位时恰好到达其所在的区间
+static void wheel_place(TimerWheelTimer* t) {
+    uint32_t delta = t->expires_ms - g_wheel.now_tick;
+    uint32_t when = t->expires_ms;
+    uint8_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1UL << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    if (delta > TIMER_WHEEL_MAX_DELAY_MS) {
+        when = g_wheel.now_tick + TIMER_WHEEL_MAX_DELAY_MS;  // 超出范围：先停在最高层，轮转时重放
+    }
+    uint8_t slot = (when >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK;
+    slot_link(t, level, slot);
+}
+
+// 排队：到期时刻不早于下一节拍（当前节拍的槽正在处理或已处理完）
+static void wheel_enqueue(TimerWheelTimer* t, uint32_t expires_ms) {
+    int32_t ahead = (int32_t)(expires_ms - g_wheel.now_tick);
+    t->expires_ms = (ahead >= 1) ? expires_ms : (g_wheel.now_tick + 1);
+    wheel_place(t);
+    t->pending = 1;
+    g_wheel.stats.pending++;
+}
+
+// 第 level 层当前槽整体下移；更高层先进位，使其中的定时器经本层再落到第0层
+static void wheel_cascade(uint8_t level) {
+    uint8_t slot = (g_wheel.now_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK;
+    if (slot == 0 && level < TIMER_WHEEL_LEVELS - 1) {
+        wheel_cascade(level + 1);
+    }
+    TimerWheelTimer* t;
+    while ((t = g_wheel.slots[level][slot]) != NULL) {
+        slot_unlink(t);
+        wheel_place(t);
+        g_wheel.stats.cascaded++;
+    }
+}
+
+static void wheel_fire(TimerWheelTimer* t) {
+    if (t->periodic == NULL) {
+        if (t->callback) t->callback();
+        return;
+    }
+
+    // 周期定时器：释放/跳过由 PeriodicTimer 决定，执行后按新的释放时刻重新排队
+    if (periodic_due(t->periodic, g_wheel.target_ms)) {
+        uint32_t start_us = micros();
+        if (t->callback) t->callback();
+        periodic_complete(t->periodic, micros() - start_us, millis());
+    }
+    if (!t->pending) {
+        wheel_enqueue(t, t->periodic->next_release_ms);
+    }
+}
+
+// 处理当前节拍：进位，然后逐个取出第0层当前槽的定时器执行。
+// 每次从槽头取，回调中取消同槽的其他定时器也是安全的
+static uint32_t wheel_tick() {
+    if ((g_wheel.now_tick & TIMER_WHEEL_SLOT_MASK) == 0) {
+        wheel_cascade(1);
+    }
+
+    uint8_t slot = g_wheel.now_tick & TIMER_WHEEL_SLOT_MASK;
+    uint32_t fired = 0;
+    TimerWheelTimer* t;
+    while ((t = g_wheel.slots[0][slot]) != NULL) {
+        slot_unlink(t);
+        t->pending = 0;
+        g_wheel.stats.pending--;
+        wheel_fire(t);
+        fired++;
+    }
+    g_wheel.stats.slots_visited++;
+    if (fired > g_wheel.stats.max_expired_per_tick) {
+        g_wheel.stats.max_expired_per_tick = (uint16_t)fired;
+    }
+    return fired;
+}
+
+// 距下一个需要处理的节拍：第0层的非空槽，或（高层非空时）下一个进位边界
+static uint32_t ticks_to_next_event() {
+    uint8_t from = (g_wheel.now_tick + 1) & TIMER_WHEEL_SLOT_MASK;
+    uint32_t ticks = (uint32_t)next_occupied(g_wheel.occupied[0], from) + 1;
+    for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (g_wheel.occupied[level]) {
+            uint32_t boundary = TIMER_WHEEL_SLOTS - (g_wheel.now_tick & TIMER_WHEEL_SLOT_MASK);
+            if (boundary < ticks) ticks = boundary;
+            break;
+        }
+    }
+    return ticks;  // 全空时为 65，调用方据此跳到目标时刻
+}
+
+// 槽内最早到期时刻
+static uint32_t slot_earliest(const TimerWheelTimer* t) {
+    uint32_t earliest = t->expires_ms;
+    for (t = t->next; t != NULL; t = t->next) {
+        if ((int32_t)(t->expires_ms - earliest) < 0) earliest = t->expires_ms;
+    }
+    return earliest;
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void timer_wheel_start_oneshot(TimerWheelTimer* t, const char* name, uint32_t delay_ms, void (*callback)(void)) {
+    wheel_ensure_init();
+    if (t->pending) timer_wheel_cancel(t);
+    t->name = name;
+    t->callback = callback;
+    t->periodic = NULL;
+    // 以当前时间为基准：时间轮落后于 millis() 时不提前触发
+    uint32_t now = millis();
+    if ((int32_t)(now - g_wheel.now_tick) < 0) now = g_wheel.now_tick;
+    wheel_enqueue(t, now + (delay_ms ? delay_ms : 1));
+}
+
+void timer_wheel_start_periodic(TimerWheelTimer* t, const char* name, PeriodicTimer* periodic, void (*callback)(void)) {
+    wheel_ensure_init();
+    if (t->pending) timer_wheel_cancel(t);
+    t->name = name;
+    t->callback = callback;
+    t->periodic = periodic;
+    wheel_enqueue(t, periodic->next_release_ms);
+}
+
+void timer_wheel_cancel(TimerWheelTimer* t) {
+    if (!t->pending) return;
+    slot_unlink(t);
+    t->pending = 0;
+    g_wheel.stats.pending--;
+}
+
+uint8_t timer_wheel_pending(const TimerWheelTimer* t) {
+    return t->pending;
+}
+
+uint32_t timer_wheel_advance(uint32_t now_ms) {
+    wheel_ensure_init();
+    g_wheel.target_ms = now_ms;
+
+    uint32_t fired = 0;
+    while ((int32_t)(now_ms - g_wheel.now_tick) > 0) {
+        uint32_t remaining = now_ms - g_wheel.now_tick;
+        uint32_t step = ticks_to_next_event();
+        if (step > remaining) {
+            // 目标时刻之前没有需要处理的节拍
+            g_wheel.stats.ticks_skipped += remaining;
+            g_wheel.now_tick = now_ms;
+            break;
+        }
+        g_wheel.stats.ticks_skipped += step - 1;
+        g_wheel.now_tick += step;
+        fired += wheel_tick();
+    }
+
+    g_wheel.stats.expired += fired;
+    return fired;
+}
+
+uint32_t timer_wheel_time_to_next_ms() {
+    if (!g_wheel.initialized || g_wheel.stats.pending == 0) return 0xFFFFFFFFUL;
+
+    // 每层下一个非空槽中的定时器即为该层最早的（槽按时间顺序轮转），取各层最小值
+    uint32_t earliest = 0;
+    uint8_t found = 0;
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (g_wheel.occupied[level] == 0) continue;
+        uint8_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        uint8_t from = ((g_wheel.now_tick >> shift) + 1) & TIMER_WHEEL_SLOT_MASK;
+        uint8_t slot = (from + next_occupied(g_wheel.occupied[level], from)) & TIMER_WHEEL_SLOT_MASK;
+        uint32_t t = slot_earliest(g_wheel.slots[level][slot]);
+        if (!found || (int32_t)(t - earliest) < 0) {
+            earliest = t;
+            found = 1;
+        }
+    }
+
+    int32_t remaining = (int32_t)(earliest - millis());
+    return (remaining > 0) ? (uint32_t)remaining : 0;
+}
+
+void timer_wheel_get_stats(TimerWheelStats* stats) {
+    if (stats == NULL) return;
+    *stats = g_wheel.stats;
+    stats->now_ms = g_wheel.now_tick;
+}
+
+void timer_wheel_print_stats() {
+#ifdef DEBUG_MODE
+    Serial.printf("[TW] pending:%u expired:%lu cascaded:%lu ticks:%lu skipped:%lu max/tick:%u\n",
+        g_wheel.stats.pending, g_wheel.stats.expired, g_wheel.stats.cascaded,
+        g_wheel.stats.slots_visited, g_wheel.stats.ticks_skipped, g_wheel.stats.max_expired_per_tick);
+#endif
+}
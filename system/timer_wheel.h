@@ -0,0 +1,71 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+#include "periodic.h"
+
+// ──────────────────────────────────────────────
+// 分层时间轮：所有周期/单次定时工作共用的定时器
+// ──────────────────────────────────────────────
+// 节拍 1ms，4 层 × 64 槽（每层覆盖上一层的 64 倍）：
+//   第0层 64ms，第1层 4.1s，第2层 4.4min，第3层 4.7h（更远的定时器停在第3层，轮转时重新放置）
+// - 插入/取消 O(1)：定时器结构体由调用方静态分配（侵入式双向链表，无堆分配）
+// - 推进时只处理有定时器的槽和进位边界，空槽按位图一次跳过，
+//   长时间休眠后推进的开销与经过的毫秒数无关，只与到期的定时器数有关
+// - 高层槽在进位时整体下移（cascade），每个定时器最多下移 3 次
+// - 周期定时器由 PeriodicTimer 负责释放时刻、跳过/补跑策略和执行时间统计，
+//   时间轮只按其 next_release_ms 排队；单次定时器到期后自动移出
+// - 最早到期时刻由各层位图直接求出，可作为 idle 的截止时刻来源
+// 时间轮不加锁：启动/取消/推进必须在同一个任务上下文中调用
+
+#define TIMER_WHEEL_LEVELS       4
+#define TIMER_WHEEL_SLOT_BITS    6
+#define TIMER_WHEEL_SLOTS        (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK    (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELAY_MS ((1UL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+typedef struct TimerWheelTimer {
+    struct TimerWheelTimer* next;    // 槽内链表（时间轮内部使用）
+    struct TimerWheelTimer* prev;
+    uint32_t expires_ms;
+    void (*callback)(void);
+    PeriodicTimer* periodic;         // 周期定时器的释放时刻与统计；NULL 为单次定时器
+    const char* name;
+    uint8_t level;
+    uint8_t slot;
+    uint8_t pending;                 // 已排队等待到期
+} TimerWheelTimer;
+
+typedef struct {
+    uint32_t now_ms;                 // 时间轮已推进到的时刻
+    uint16_t pending;                // 当前排队的定时器数
+    uint32_t expired;                // 已执行的回调数
+    uint32_t cascaded;               // 高层槽下移的定时器数
+    uint32_t slots_visited;          // 推进时实际处理的节拍数
+    uint32_t ticks_skipped;          // 按位图跳过的空节拍数
+    uint16_t max_expired_per_tick;   // 同一节拍到期的最多定时器数
+} TimerWheelStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+// 单次定时器：delay_ms 后执行一次（至少1ms）。已在排队的定时器重新计时
+void timer_wheel_start_oneshot(TimerWheelTimer* t, const char* name, uint32_t delay_ms, void (*callback)(void));
+
+// 周期定时器：按 periodic->next_release_ms 排队，到期执行 callback 并记入 periodic 的统计
+// （periodic 需先 periodic_init）
+void timer_wheel_start_periodic(TimerWheelTimer* t, const char* name, PeriodicTimer* periodic, void (*callback)(void));
+
+void timer_wheel_cancel(TimerWheelTimer* t);
+uint8_t timer_wheel_pending(const TimerWheelTimer* t);
+
+// 推进到 now_ms 并执行其间到期的回调，返回执行的回调数
+uint32_t timer_wheel_advance(uint32_t now_ms);
+
+// 距最早到期定时器的毫秒数（已到期返回0，没有定时器返回 IDLE_NO_DEADLINE 同值 0xFFFFFFFF）
+uint32_t timer_wheel_time_to_next_ms();
+
+void timer_wheel_get_stats(TimerWheelStats* stats);
+void timer_wheel_print_stats();
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,107 @@
+#include "virtual_clock.h"
+
+#if !defined(ARDUINO)
+
+#include <string.h>
+
+// ──────────────────────────────────────────────
+// 私有状态
+// ──────────────────────────────────────────────
+
+typedef struct {
+    VirtualClockStats stats;
+    uint64_t irq_at[VCLOCK_MAX_PENDING_IRQ];
+    uint8_t irq_count;
+} VirtualClockState;
+
+static VirtualClockState g_vclock = {{0}};
+
+// ──────────────────────────────────────────────
+// 私有函数
+// ──────────────────────────────────────────────
+
+// 取出最早的中断时刻（没有返回 UINT64_MAX）
+static uint64_t earliest_irq(uint8_t* index) {
+    uint64_t earliest = UINT64_MAX;
+    for (uint8_t i = 0; i < g_vclock.irq_count; i++) {
+        if (g_vclock.irq_at[i] < earliest) {
+            earliest = g_vclock.irq_at[i];
+            *index = i;
+        }
+    }
+    return earliest;
+}
+
+static void remove_irq(uint8_t index) {
+    g_vclock.irq_at[index] = g_vclock.irq_at[--g_vclock.irq_count];
+}
+
+// ──────────────────────────────────────────────
+// 公共函数
+// ──────────────────────────────────────────────
+
+void vclock_reset(uint64_t start_us) {
+    memset(&g_vclock, 0, sizeof(g_vclock));
+    g_vclock.stats.now_us = start_us;
+}
+
+uint64_t vclock_now_us() {
+    return g_vclock.stats.now_us;
+}
+
+void vclock_advance_us(uint64_t us) {
+    g_vclock.stats.now_us += us;
+}
+
+uint8_t vclock_schedule_interrupt_us(uint64_t at_us) {
+    if (g_vclock.irq_count >= VCLOCK_MAX_PENDING_IRQ) return 0;
+    g_vclock.irq_at[g_vclock.irq_count++] = at_us;
+    return 1;
+}
+
+uint8_t vclock_sleep_until_us(uint64_t deadline_us) {
+    uint64_t start = g_vclock.stats.now_us;
+    uint8_t index = 0;
+    uint64_t irq = earliest_irq(&index);
+    uint8_t woken = 0;
+
+    uint64_t wake = deadline_us;
+    if (irq < wake) {
+        wake = irq;
+        woken = 1;
+        remove_irq(index);
+        g_vclock.stats.irq_wakeups++;
+    }
+    if (wake > start) {
+        g_vclock.stats.now_us = wake;
+        g_vclock.stats.slept_us += wake - start;
+    }
+    g_vclock.stats.sleeps++;
+    return woken;
+}
+
+void vclock_get_stats(VirtualClockStats* stats) {
+    if (stats) *stats = g_vclock.stats;
+}
+
+// ──────────────────────────────────────────────
+// Arduino 计时接口（主机构建）
+// ──────────────────────────────────────────────
+
+unsigned long millis() {
+    return (unsigned long)(g_vclock.stats.now_us / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)g_vclock.stats.now_us;
+}
+
+void delay(unsigned long ms) {
+    vclock_sleep_until_us(g_vclock.stats.now_us + (uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    vclock_sleep_until_us(g_vclock.stats.now_us + us);
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,40 @@
+#ifndef VIRTUAL_CLOCK_H
+#define VIRTUAL_CLOCK_H
+
+#include <stdint.h>
+
+// ──────────────────────────────────────────────
+// 主机端虚拟时钟（仅非 Arduino 构建）
+// ──────────────────────────────────────────────
+// 在PC上编译固件逻辑时提供 millis()/micros()/delay()/delayMicroseconds()：
+// 时间只在"休眠"时前进，不依赖真实时间，调度与休眠行为可以逐微秒复现。
+// - delay()/vclock_sleep_until_us() 把时钟直接推进到截止时刻
+// - vclock_schedule_interrupt_us() 模拟外部中断（传感器INT、按键），
+//   休眠在中断时刻提前结束
+// - 统计累计休眠时间与被中断唤醒次数，用于验证"空闲时间都转成了休眠"
+
+#define VCLOCK_MAX_PENDING_IRQ   8
+
+typedef struct {
+    uint64_t now_us;
+    uint64_t slept_us;               // 累计休眠时间
+    uint32_t sleeps;                 // 休眠次数
+    uint32_t irq_wakeups;            // 被模拟中断提前唤醒次数
+} VirtualClockStats;
+
+// ──────────────────────────────────────────────
+// 函数声明
+
+void vclock_reset(uint64_t start_us);
+uint64_t vclock_now_us();
+void vclock_advance_us(uint64_t us);             // 模拟代码执行耗时（不计入休眠）
+
+// 在绝对时刻 at_us 触发一次模拟中断，满则返回0
+uint8_t vclock_schedule_interrupt_us(uint64_t at_us);
+
+// 休眠到 deadline_us 或最早的待触发中断；被中断唤醒返回1
+uint8_t vclock_sleep_until_us(uint64_t deadline_us);
+
+void vclock_get_stats(VirtualClockStats* stats);
+
+#endif // VIRTUAL_CLOCK_H
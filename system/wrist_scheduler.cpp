@@ -2,6 +2,8 @@
 #include "../algorithm/hr_algorithm.h"
 #include "sno2_driver.h"
 #include "system_state.h"
+#include "periodic.h"
+#include "timer_wheel.h"
 
 // ──────────────────────────────────────────────
 // 私有变量（低RAM优化）
@@ -9,13 +11,18 @@
 
 static SchedulerState current_state = SCHEDULER_STATE_INIT;
 static TaskFlags task_flags = {0, 0, 0, 0, 0};
-static SchedulerStats stats = {0, 0, 0, 0, 0, 0};
-
-// 时间戳记录
-static uint32_t last_hr_sample_time = 0;
-static uint32_t last_hr_calc_time = 0;
-static uint32_t last_sno2_sample_time = 0;
-static uint32_t last_sno2_calc_time = 0;
+static SchedulerStats stats = {0, 0, 0, 0, 0, 0, 0};
+
+// 周期定时器（释放时刻按周期累加，不随检查时刻漂移；落后时跳过错过的释放）
+// 由共享时间轮在释放时刻回调置标志
+static PeriodicTimer hr_sample_timer;
+static PeriodicTimer hr_calc_timer;
+static PeriodicTimer sno2_sample_timer;
+static PeriodicTimer sno2_calc_timer;
+static TimerWheelTimer hr_sample_wt;
+static TimerWheelTimer hr_calc_wt;
+static TimerWheelTimer sno2_sample_wt;
+static TimerWheelTimer sno2_calc_wt;
 
 // 初始化标志
 static uint8_t initialized = 0;
@@ -24,10 +31,10 @@ static uint8_t initialized = 0;
 // 私有函数声明
 // ──────────────────────────────────────────────
 
-static void check_hr_sample_timing(uint32_t now);
-static void check_hr_calc_timing(uint32_t now);
-static void check_sno2_sample_timing(uint32_t now);
-static void check_sno2_calc_timing(uint32_t now);
+static void on_hr_sample_due();
+static void on_hr_calc_due();
+static void on_sno2_sample_due();
+static void on_sno2_calc_due();
 static void update_stats();
 
 // ──────────────────────────────────────────────
@@ -48,12 +55,16 @@ void wrist_scheduler_init() {
     // 初始化系统状态
     system_state_init();
     
-    // 记录初始时间
+    // 首次释放在一个周期之后
     uint32_t now = millis();
-    last_hr_sample_time = now;
-    last_hr_calc_time = now;
-    last_sno2_sample_time = now;
-    last_sno2_calc_time = now;
+    periodic_init(&hr_sample_timer, HR_SAMPLE_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&hr_calc_timer, HR_CALC_PERIOD_MS, PERIODIC_SKIP, now);
+    periodic_init(&sno2_sample_timer, SNO2_SAMPLE_INTERVAL_MS, PERIODIC_SKIP, now);
+    periodic_init(&sno2_calc_timer, SNO2_CALC_PERIOD_MS, PERIODIC_SKIP, now);
+    timer_wheel_start_periodic(&hr_sample_wt, "hr_sample", &hr_sample_timer, on_hr_sample_due);
+    timer_wheel_start_periodic(&hr_calc_wt, "hr_calc", &hr_calc_timer, on_hr_calc_due);
+    timer_wheel_start_periodic(&sno2_sample_wt, "sno2_sample", &sno2_sample_timer, on_sno2_sample_due);
+    timer_wheel_start_periodic(&sno2_calc_wt, "sno2_calc", &sno2_calc_timer, on_sno2_calc_due);
     
     // 设置初始状态
     current_state = SCHEDULER_STATE_RUNNING;
@@ -66,6 +77,7 @@ void wrist_scheduler_init() {
     stats.sno2_calcs = 0;
     stats.last_hr_bpm = 0;
     stats.last_sno2_ppm = 0;
+    stats.skipped_releases = 0;
 }
 
 void wrist_scheduler_update() {
@@ -73,13 +85,8 @@ void wrist_scheduler_update() {
         return;
     }
     
-    uint32_t now = millis();
-    
-    // 检查各个任务的定时
-    check_hr_sample_timing(now);
-    check_hr_calc_timing(now);
-    check_sno2_sample_timing(now);
-    check_sno2_calc_timing(now);
+    // 推进时间轮：到期的定时器回调设置任务标志
+    timer_wheel_advance(millis());
     
     // 更新统计
     update_stats();
@@ -106,98 +113,57 @@ SchedulerStats wrist_scheduler_get_stats() {
 }
 
 uint32_t wrist_scheduler_get_hr_sample_remaining() {
-    uint32_t now = millis();
-    uint32_t elapsed = now - last_hr_sample_time;
-    
-    if (elapsed >= HR_SAMPLE_INTERVAL_MS) {
-        return 0;
-    }
-    
-    return HR_SAMPLE_INTERVAL_MS - elapsed;
+    return periodic_time_to_release(&hr_sample_timer, millis());
 }
 
 uint32_t wrist_scheduler_get_sno2_sample_remaining() {
-    uint32_t now = millis();
-    uint32_t elapsed = now - last_sno2_sample_time;
-    
-    if (elapsed >= SNO2_SAMPLE_INTERVAL_MS) {
-        return 0;
-    }
-    
-    return SNO2_SAMPLE_INTERVAL_MS - elapsed;
+    return periodic_time_to_release(&sno2_sample_timer, millis());
 }
 
 uint32_t wrist_scheduler_get_hr_calc_remaining() {
-    uint32_t now = millis();
-    uint32_t elapsed = now - last_hr_calc_time;
-    
-    if (elapsed >= HR_CALC_PERIOD_MS) {
-        return 0;
-    }
-    
-    return HR_CALC_PERIOD_MS - elapsed;
+    return periodic_time_to_release(&hr_calc_timer, millis());
 }
 
 uint32_t wrist_scheduler_get_sno2_calc_remaining() {
-    uint32_t now = millis();
-    uint32_t elapsed = now - last_sno2_calc_time;
-    
-    if (elapsed >= SNO2_CALC_PERIOD_MS) {
-        return 0;
-    }
-    
-    return SNO2_CALC_PERIOD_MS - elapsed;
+    return periodic_time_to_release(&sno2_calc_timer, millis());
+}
+
+uint32_t wrist_scheduler_time_to_next_ms() {
+    return timer_wheel_time_to_next_ms();
 }
 
 // ──────────────────────────────────────────────
 // 私有函数实现
 // ──────────────────────────────────────────────
 
-static void check_hr_sample_timing(uint32_t now) {
-    uint32_t elapsed = now - last_hr_sample_time;
-    
-    if (elapsed >= HR_SAMPLE_INTERVAL_MS) {
-        // 设置MAX30102采样标志
-        task_flags.hr_sample_due = 1;
-        last_hr_sample_time = now;
-        stats.hr_samples++;
-    }
+static void on_hr_sample_due() {
+    // 设置MAX30102采样标志
+    task_flags.hr_sample_due = 1;
+    stats.hr_samples++;
 }
 
-static void check_hr_calc_timing(uint32_t now) {
-    uint32_t elapsed = now - last_hr_calc_time;
-    
-    if (elapsed >= HR_CALC_PERIOD_MS) {
-        // 设置心率计算标志
-        task_flags.hr_calc_due = 1;
-        last_hr_calc_time = now;
-        stats.hr_calcs++;
-    }
+static void on_hr_calc_due() {
+    // 设置心率计算标志
+    task_flags.hr_calc_due = 1;
+    stats.hr_calcs++;
 }
 
-static void check_sno2_sample_timing(uint32_t now) {
-    uint32_t elapsed = now - last_sno2_sample_time;
-    
-    if (elapsed >= SNO2_SAMPLE_INTERVAL_MS) {
-        // 设置SnO₂采样标志
-        task_flags.sno2_sample_due = 1;
-        last_sno2_sample_time = now;
-        stats.sno2_samples++;
-    }
+static void on_sno2_sample_due() {
+    // 设置SnO₂采样标志
+    task_flags.sno2_sample_due = 1;
+    stats.sno2_samples++;
 }
 
-static void check_sno2_calc_timing(uint32_t now) {
-    uint32_t elapsed = now - last_sno2_calc_time;
-    
-    if (elapsed >= SNO2_CALC_PERIOD_MS) {
-        // 设置SnO₂计算标志
-        task_flags.sno2_calc_due = 1;
-        last_sno2_calc_time = now;
-        stats.sno2_calcs++;
-    }
+static void on_sno2_calc_due() {
+    // 设置SnO₂计算标志
+    task_flags.sno2_calc_due = 1;
+    stats.sno2_calcs++;
 }
 
 static void update_stats() {
+    stats.skipped_releases = hr_sample_timer.skipped + hr_calc_timer.skipped +
+                             sno2_sample_timer.skipped + sno2_calc_timer.skipped;
+    
     // 更新最后一次心率值
     uint8_t bpm = hr_get_latest_bpm();
     if (bpm > 0) {
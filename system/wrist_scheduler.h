@@ -39,6 +39,7 @@ typedef struct {
     uint32_t sno2_calcs;           // SnO₂计算次数
     uint32_t last_hr_bpm;          // 最后一次心率（BPM）
     uint32_t last_sno2_ppm;        // 最后一次丙酮浓度（ppm）
+    uint32_t skipped_releases;     // 调用不及时而跳过的释放次数（各任务合计）
 } SchedulerStats;
 
 // ──────────────────────────────────────────────
@@ -75,4 +76,7 @@ uint32_t wrist_scheduler_get_hr_calc_remaining();
 // 获取下一次SnO₂计算剩余时间（ms）
 uint32_t wrist_scheduler_get_sno2_calc_remaining();
 
+// 距最早的下一次任务释放（ms），loop() 据此休眠而不是空转
+uint32_t wrist_scheduler_time_to_next_ms();
+
 #endif // WRIST_SCHEDULER_H
\ No newline at end of file
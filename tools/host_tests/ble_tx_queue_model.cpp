@@ -0,0 +1,249 @@
+/*
+ * ble_tx_queue_model.cpp - ble_tx_queue_final 与参考模型的随机对照
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -Itools/host_tests/stub -Isrc -Isystem \
+ *       tools/host_tests/ble_tx_queue_model.cpp src/ble_tx_queue_final.cpp system/virtual_clock.cpp \
+ *       -o ble_tx_queue_model
+ *   ./ble_tx_queue_model [操作数] [随机种子]
+ *
+ * 发送函数模拟协议栈缓冲：每个被接受的块占用一个 mbuf，控制器随机释放；空闲数低于
+ * BLE_TX_MIN_FREE_MBUFS 时返回 BLE_TX_SEND_BUSY（与 ble_peripheral_final 的发送函数相同），
+ * 另按分段的链路质量拒绝（ENOMEM 等，0%/3%/60%，后者使重试耗尽）。
+ * 随机操作：入队（随机长度/切块）、pump、断开（reset）。
+ * 参考模型按负载列表独立实现同样的语义，逐步比对：
+ *   - 交给协议栈的块序列（内容与边界）、入队接受/拒绝、排队字节数
+ *   - 重试耗尽只丢弃该负载的剩余块，其后的负载完整
+ *   - 统计：入队、拒绝、丢弃、重试、缓冲等待、发送块数/字节数
+ * 写入位置为 uint16 自由递增，20万次操作中多次回绕。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+#include "ble_tx_queue_final.h"
+
+#define MODEL_DEFAULT_OPS      200000
+#define MODEL_MBUF_POOL        12
+#define MODEL_PHASE_OPS        1000        // 每段操作的链路质量（拒绝概率）相同
+#define MODEL_HEADER_LEN       2
+
+typedef std::vector<uint8_t> Bytes;
+
+static uint32_t g_rng = 1;
+
+static uint32_t rng_next() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+// ──────────────────────────────────────────────
+// 模拟协议栈：mbuf 池 + 随机拒绝；记录被接受的块
+
+static int g_free_mbufs = MODEL_MBUF_POOL;
+static uint32_t g_fail_percent = 0;
+static std::vector<Bytes> g_wire;          // 本次 pump 被接受的块
+static std::vector<int> g_outcomes;        // 本次 pump 每次调用的结果（供模型重放）
+
+static int stack_send(const uint8_t* data, uint16_t len) {
+    int rc;
+    if (g_free_mbufs < BLE_TX_MIN_FREE_MBUFS) {
+        rc = BLE_TX_SEND_BUSY;
+    } else if (rng_next() % 100 < g_fail_percent) {
+        rc = -6;                           // BLE_HS_ENOMEM
+    } else {
+        g_free_mbufs--;
+        g_wire.push_back(Bytes(data, data + len));
+        rc = 0;
+    }
+    g_outcomes.push_back(rc);
+    return rc;
+}
+
+// ──────────────────────────────────────────────
+// 参考模型：负载列表，每条负载是块列表
+
+typedef struct {
+    std::deque<std::deque<Bytes> > payloads;
+    uint16_t used;                         // 含块头
+    uint8_t head_retries;
+    uint32_t retry_drops;                  // 重试耗尽丢弃（不含断开）
+    BleTxStats stats;
+} Model;
+
+static void model_drop_head_payload(Model* m) {
+    for (const Bytes& c : m->payloads.front()) m->used -= (uint16_t)(c.size() + MODEL_HEADER_LEN);
+    m->payloads.pop_front();
+    m->head_retries = 0;
+    m->stats.payloads_dropped++;
+}
+
+static uint8_t model_enqueue(Model* m, const Bytes& data, uint16_t chunk_len) {
+    if (data.empty()) return 1;
+    if (chunk_len == 0 || chunk_len > BLE_TX_MAX_CHUNK) chunk_len = BLE_TX_MAX_CHUNK;
+    std::deque<Bytes> chunks;
+    uint16_t needed = 0;
+    for (size_t off = 0; off < data.size(); off += chunk_len) {
+        size_t n = (data.size() - off > chunk_len) ? chunk_len : data.size() - off;
+        chunks.push_back(Bytes(data.begin() + off, data.begin() + off + n));
+        needed += (uint16_t)(n + MODEL_HEADER_LEN);
+    }
+    if (needed > BLE_TX_QUEUE_BYTES - m->used) {
+        m->stats.payloads_rejected++;
+        return 0;
+    }
+    m->payloads.push_back(chunks);
+    m->used += needed;
+    m->stats.payloads_enqueued++;
+    return 1;
+}
+
+// 按实际发送函数返回的结果序列重放一次 pump，得出应被接受的块
+static std::vector<Bytes> model_pump(Model* m, const std::vector<int>& outcomes, int* mismatch) {
+    std::vector<Bytes> sent;
+    size_t k = 0;
+    while (!m->payloads.empty()) {
+        if (k >= outcomes.size()) {            // 队列非空却没有调用发送函数
+            (*mismatch)++;
+            break;
+        }
+        int rc = outcomes[k++];
+        std::deque<Bytes>& head = m->payloads.front();
+        if (rc == 0) {
+            sent.push_back(head.front());
+            m->used -= (uint16_t)(head.front().size() + MODEL_HEADER_LEN);
+            m->stats.chunks_sent++;
+            m->stats.bytes_sent += (uint32_t)head.front().size();
+            head.pop_front();
+            if (head.empty()) m->payloads.pop_front();
+            m->head_retries = 0;
+            continue;
+        }
+        if (rc == BLE_TX_SEND_BUSY) {
+            m->stats.mbuf_stalls++;
+        } else {
+            m->stats.retries++;
+            if (++m->head_retries > BLE_TX_MAX_RETRIES) {
+                model_drop_head_payload(m);
+                m->retry_drops++;
+            }
+        }
+        break;
+    }
+    if (k != outcomes.size()) (*mismatch)++;   // 发送函数被多调用
+    return sent;
+}
+
+static void model_reset(Model* m) {
+    while (!m->payloads.empty()) model_drop_head_payload(m);
+    m->used = 0;
+    m->head_retries = 0;
+}
+
+// ──────────────────────────────────────────────
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int stats_equal(const BleTxStats* a, const BleTxStats* b) {
+    return a->payloads_enqueued == b->payloads_enqueued &&
+           a->payloads_rejected == b->payloads_rejected &&
+           a->payloads_dropped == b->payloads_dropped &&
+           a->chunks_sent == b->chunks_sent &&
+           a->bytes_sent == b->bytes_sent &&
+           a->retries == b->retries &&
+           a->mbuf_stalls == b->mbuf_stalls;
+}
+
+int main(int argc, char** argv) {
+    uint32_t ops = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : MODEL_DEFAULT_OPS;
+    if (ops == 0) ops = MODEL_DEFAULT_OPS;
+    g_rng = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+    if (g_rng == 0) g_rng = 1;
+
+    static BleTxQueue q;
+    static Model m;
+    ble_tx_init(&q, stack_send);
+
+    uint32_t wire_mismatch = 0, accept_mismatch = 0, used_mismatch = 0, call_mismatch = 0;
+    uint32_t stats_mismatch = 0, resets = 0, pumps = 0;
+    uint32_t wraps = 0;
+    uint16_t last_write = 0;
+    uint8_t seq = 0;
+    uint32_t now_ms = 0;
+
+    printf("ble_tx_queue 随机对照（%u 次操作）\n", ops);
+    for (uint32_t i = 0; i < ops; i++) {
+        now_ms += rng_next() % 20;
+        if (i % MODEL_PHASE_OPS == 0) {
+            static const uint32_t k_fail[] = {0, 3, 3, 60};
+            g_fail_percent = k_fail[rng_next() % 4];
+        }
+        // 控制器发出数据包，释放 mbuf
+        g_free_mbufs += (int)(rng_next() % 3);
+        if (g_free_mbufs > MODEL_MBUF_POOL) g_free_mbufs = MODEL_MBUF_POOL;
+
+        // 断开少见（约每2000次一次），写位置在两次断开之间能走完 uint16 一圈
+        uint32_t op = rng_next() % 10000;
+        if (op < 5500) {
+            // 入队：负载内容为递增序号，便于定位错位
+            uint16_t len = (uint16_t)(1 + rng_next() % 600);
+            uint16_t chunk_len = (uint16_t)(rng_next() % 8 == 0 ? 0 : 20 + rng_next() % 240);
+            Bytes data(len);
+            for (uint16_t j = 0; j < len; j++) data[j] = seq++;
+            uint8_t got = ble_tx_enqueue(&q, data.data(), len, chunk_len);
+            uint8_t want = model_enqueue(&m, data, chunk_len);
+            if (got != want) accept_mismatch++;
+        } else if (op < 9995) {
+            g_wire.clear();
+            g_outcomes.clear();
+            ble_tx_pump(&q, now_ms);
+            int mismatch = 0;
+            std::vector<Bytes> want = model_pump(&m, g_outcomes, &mismatch);
+            call_mismatch += (uint32_t)mismatch;
+            if (want != g_wire) wire_mismatch++;
+            pumps++;
+        } else {
+            ble_tx_reset(&q);
+            model_reset(&m);
+            resets++;
+            last_write = 0;                    // reset 把读写位置归零，不算回绕
+        }
+
+        if (q.write_pos < last_write) wraps++;
+        last_write = q.write_pos;
+
+        BleTxStats st;
+        ble_tx_get_stats(&q, &st);
+        if (st.queued_bytes != m.used || ble_tx_free_bytes(&q) != BLE_TX_QUEUE_BYTES - m.used ||
+            ble_tx_idle(&q) != (m.used == 0)) {
+            used_mismatch++;
+        }
+        if (!stats_equal(&st, &m.stats)) stats_mismatch++;
+    }
+
+    BleTxStats st;
+    ble_tx_get_stats(&q, &st);
+    printf("  pump %u 次，断开 %u 次，写位置回绕 %u 次，重试耗尽丢弃 %u\n", pumps, resets, wraps, m.retry_drops);
+    printf("  入队 %u，拒绝 %u，丢弃 %u，发送 %u 块/%u 字节，重试 %u，缓冲等待 %u，峰值 %u 字节\n",
+           st.payloads_enqueued, st.payloads_rejected, st.payloads_dropped, st.chunks_sent,
+           st.bytes_sent, st.retries, st.mbuf_stalls, st.queued_bytes_max);
+
+    int failures = 0;
+    failures += check(wire_mismatch == 0 && call_mismatch == 0, "交给协议栈的块序列与模型一致");
+    failures += check(accept_mismatch == 0, "入队接受/拒绝与模型一致");
+    failures += check(used_mismatch == 0, "排队字节、空闲字节、空闲判断与模型一致");
+    failures += check(stats_mismatch == 0, "统计与模型一致");
+    failures += check(wraps > 0 && st.payloads_rejected > 0 && m.retry_drops > 0 &&
+                      st.mbuf_stalls > 0 && st.retries > 0,
+                      "覆盖回绕、背压、丢弃、缓冲等待、重试");
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
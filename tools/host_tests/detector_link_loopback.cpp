@@ -0,0 +1,217 @@
+/*
+ * detector_link_loopback.cpp - 检测模块链路（回环传输）→ 算法管理器 合并规则回归
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -DRT_COOPERATIVE -DMCU_ESP32_S3 -DDEVICE_ROLE_WRIST \
+ *       -Itools/host_tests/stub -Isrc -Isystem -Idrivers -Ialgorithm -Iutils -Iconfig \
+ *       tools/host_tests/detector_link_loopback.cpp src/detector_link_final.cpp \
+ *       src/algorithm_manager_final.cpp src/task_runtime_final.cpp system/timebase.cpp \
+ *       system/idle.cpp system/virtual_clock.cpp -o detector_link_loopback
+ *   ./detector_link_loopback
+ *
+ * detector_link_init(loopback_detector_transport_get())，测试代码扮演检测模块（注入特征值、出现/离开），
+ * 按固件顺序在虚拟时钟上调用 detector_link_poll() 与 algorithm_manager_update()。
+ * PPG算法、重采样、样本总线、SnO2交接、佩戴检测在本文件中替换为可控的桩，检查：
+ *   - 未连接时不采用检测模块读数；连接后心率/血氧/丙酮并入结果，参与风险评估
+ *   - 本机有心率结果时优先本机，检测模块只补缺（血氧、丙酮）
+ *   - 检测模块报 SnO2 错误码时作废其丙酮、回到本机读数；错误清除后恢复
+ *   - 离腕时采用检测模块心率；读数超过 ALG_EXTERNAL_MAX_AGE_MS 未更新则全部作废
+ *   - 长度不符的特征值计入 malformed 并丢弃；0xFF 表示无，只作废该项
+ *   - 断开后链路状态与统计（连接、断开、malformed）
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "detector_link_final.h"
+#include "algorithm_manager_final.h"
+#include "hr_algorithm.h"
+#include "motion_correction.h"
+#include "wear_detect.h"
+#include "resampler.h"
+#include "hr_driver.h"
+#include "sensor_collector_final.h"
+#include "sample_bus_final.h"
+#include "virtual_clock.h"
+
+#define LOCAL_SNO2_MV        330     // 本机 SnO2 读数 → 10.0 ppm
+#define LOCAL_ACETONE_PPM    10.0f
+#define STEP_MS              600     // 大于 ALG_ANALYSIS_HOP_MS，每步都分析一次
+
+// ──────────────────────────────────────────────
+// 桩：本机PPG链与SnO2交接，由测试直接控制
+
+static uint8_t g_local_bpm = 0;      // hr_calculate_bpm 的结果（0=无结果）
+static uint8_t g_on_wrist = 1;
+static uint8_t g_have_sample = 0;    // 总线上有一个新样本（触发HR分析）
+static uint32_t g_sno2_ts = 1;       // 改变即交出一个新的 SnO2 读数
+static uint32_t g_sno2_popped = 0;
+
+void hr_algorithm_init() {}
+int hr_algorithm_push_sample(int32_t, int32_t) { return 0; }
+void hr_algorithm_reset_baseline() {}
+void hr_algorithm_set_sample_period_us(uint32_t) {}
+uint8_t hr_calculate_bpm(int*) { return g_local_bpm; }
+uint8_t hr_calculate_spo2(int*) { return 0; }
+uint8_t hr_get_correlation_quality() { return 0; }
+uint8_t hr_get_signal_quality() { return 80; }
+void hr_set_agc_callback(void (*)()) {}
+
+// 运动校正透传（Q8），校正值等于本机心率
+void kalman_init(KalmanState*, int16_t) {}
+int16_t kalman_update(KalmanState*, int16_t v) { return (int16_t)(v * 256); }
+void tssd_init(TssdState*) {}
+int16_t tssd_update(TssdState*, int16_t v) { return v; }
+
+uint32_t resampler_get_period_us(const ResamplerState*) { return HR_SAMPLE_INTERVAL_MS * 1000UL; }
+void resampler_init(ResamplerState*, uint32_t, ResamplerMode) {}
+void resampler_reset(ResamplerState*) {}
+uint8_t resampler_push(ResamplerState*, uint64_t t, int32_t red, int32_t ir,
+                       ResampledSample* out, uint8_t, uint8_t*) {
+    out[0].timestamp_us = t;
+    out[0].red = red;
+    out[0].ir = ir;
+    return 1;
+}
+
+uint8_t sample_bus_subscribe(const char*) { return 0; }
+uint16_t sample_bus_consume(uint8_t, uint16_t) { g_have_sample = 0; return 0; }
+void sample_bus_skip(uint8_t) { g_have_sample = 0; }
+uint16_t sample_bus_peek(uint8_t, PpgSpan* span) {
+    static uint64_t ts[1];
+    static int32_t v[1];
+    if (!g_have_sample) return 0;
+    ts[0] = vclock_now_us();
+    span->timestamp_us = ts;
+    span->red = v;
+    span->ir = v;
+    return 1;
+}
+
+uint16_t sensor_collector_pop_sno2(Sno2Reading* out, uint16_t) {
+    if (g_sno2_ts == g_sno2_popped) return 0;
+    g_sno2_popped = g_sno2_ts;
+    out->timestamp_ms = g_sno2_ts;
+    out->voltage_mv = LOCAL_SNO2_MV;
+    out->heater_on = 1;
+    return 1;
+}
+
+void wear_detect_init() {}
+void wear_detect_feed_sqi(uint8_t, uint8_t) {}
+uint8_t wear_detect_is_on_wrist() { return g_on_wrist; }
+
+// ──────────────────────────────────────────────
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// 通信任务 poll 链路，DSP任务随后更新
+static void step(uint32_t ms) {
+    vclock_advance_us((uint64_t)ms * 1000);
+    detector_link_poll(millis());
+    algorithm_manager_update();
+}
+
+static void notify_u8(DetectorValue which, uint8_t v) {
+    detector_loopback_notify(which, &v, 1);
+}
+
+static void notify_ppm(float ppm) {
+    uint8_t le[4];
+    memcpy(le, &ppm, sizeof(le));    // 主机与检测模块同为小端
+    detector_loopback_notify(DETECTOR_VALUE_ACETONE, le, sizeof(le));
+}
+
+int main() {
+    AlgorithmResult r;
+    RiskAssessment risk;
+    DetectorLinkStats st;
+    int failures = 0;
+
+    vclock_reset(1000000);
+    algorithm_manager_init();
+    printf("检测模块回环链路 × 算法管理器\n");
+    failures += check(detector_link_init(loopback_detector_transport_get()), "回环链路启动");
+
+    // 检测模块尚未出现：注入的值不应被采用
+    notify_u8(DETECTOR_VALUE_HR, 80);
+    notify_u8(DETECTOR_VALUE_SPO2, 97);
+    notify_ppm(7.5f);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(r.bpm == 0 && r.external == 0 && r.acetone_ppm == LOCAL_ACETONE_PPM,
+                      "未连接：只用本机读数");
+
+    // 出现：连接后送出当前值，全部并入
+    detector_loopback_set_present(1);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    algorithm_manager_get_risk_assessment(&risk);
+    failures += check(detector_link_is_connected() && r.bpm == 80 && r.corrected_bpm == 80 &&
+                      r.spo2 == 97 && r.acetone_ppm == 7.5f &&
+                      r.external == (ALG_EXT_HR | ALG_EXT_SPO2 | ALG_EXT_ACETONE) && risk.risk_level == 2,
+                      "连接：心率/血氧/丙酮并入并参与风险评估");
+
+    // 本机算出心率后取代检测模块心率，之后检测模块心率通知不再覆盖
+    g_local_bpm = 72;
+    g_have_sample = 1;
+    step(STEP_MS);
+    notify_u8(DETECTOR_VALUE_HR, 85);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(r.bpm == 72 && r.corrected_bpm == 72 && r.spo2 == 97 &&
+                      r.external == (ALG_EXT_SPO2 | ALG_EXT_ACETONE),
+                      "本机心率优先，检测模块补血氧/丙酮");
+
+    // SnO2 错误码作废检测模块的丙酮，回到本机读数；清除后恢复
+    notify_u8(DETECTOR_VALUE_ERROR, DETECTOR_ERR_SNO2);
+    g_sno2_ts++;
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    uint8_t voided = (r.acetone_ppm == LOCAL_ACETONE_PPM && !(r.external & ALG_EXT_ACETONE));
+    notify_u8(DETECTOR_VALUE_ERROR, DETECTOR_ERR_NONE);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(voided && r.acetone_ppm == 7.5f && (r.external & ALG_EXT_ACETONE),
+                      "SnO2 错误码作废丙酮，清除后恢复");
+
+    // 离腕：本机心率暂停，采用检测模块心率
+    g_on_wrist = 0;
+    notify_u8(DETECTOR_VALUE_HR, 90);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(r.bpm == 90 && (r.external & ALG_EXT_HR), "离腕：采用检测模块心率");
+
+    // 超过最大时效没有新通知：检测模块读数全部作废，丙酮回到本机
+    vclock_advance_us((uint64_t)ALG_EXTERNAL_MAX_AGE_MS * 1000);
+    g_sno2_ts++;
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(r.bpm == 0 && r.spo2 == 0 && r.acetone_ppm == LOCAL_ACETONE_PPM && r.external == 0,
+                      "读数过期后全部作废");
+
+    // 长度不符丢弃（丙酮保持上次的有效值）；0xFF 只作废心率，新通知使血氧/丙酮重新有效
+    uint8_t bad[3] = {1, 2, 3};
+    detector_loopback_notify(DETECTOR_VALUE_ACETONE, bad, sizeof(bad));
+    notify_u8(DETECTOR_VALUE_HR, 0xFF);
+    step(STEP_MS);
+    algorithm_manager_get_result(&r);
+    failures += check(r.bpm == 0 && r.spo2 == 97 && r.acetone_ppm == 7.5f &&
+                      r.external == (ALG_EXT_SPO2 | ALG_EXT_ACETONE),
+                      "畸形特征值丢弃，0xFF 只作废该项");
+
+    // 离开：断开，统计
+    detector_loopback_set_present(0);
+    step(10);
+    detector_link_get_stats(&st);
+    printf("  连接 %u，断开 %u，畸形 %u，投递 %u，心率通知 %u\n", st.connects, st.disconnects,
+           st.malformed, st.submitted, st.values[DETECTOR_VALUE_HR]);
+    failures += check(!detector_link_is_connected() && st.state == DETECTOR_LINK_IDLE && st.connects == 1 &&
+                      st.disconnects == 1 && st.malformed == 1,
+                      "断开后链路状态与统计");
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
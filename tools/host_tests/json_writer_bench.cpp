@@ -0,0 +1,238 @@
+/*
+ * json_writer_bench.cpp - json_writer.h 的正确性检查与序列化耗时对比
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -Isrc tools/host_tests/json_writer_bench.cpp -o json_writer_bench
+ *   ./json_writer_bench [每种实现的序列化次数]
+ *
+ * 对比 ArduinoJson（原 ble_build_json 的 StaticJsonDocument<256> 写法）时加上它的头文件目录，
+ * 例如 PlatformIO 下载到的 lib_deps（版本见 platformio.ini）：
+ *   g++ ... -I.pio/libdeps/esp32s3_final/ArduinoJson/src ...
+ * 找不到 ArduinoJson.h 时跳过这一项。
+ *
+ * 负载与腕带 JSON 兼容模式相同（ble_build_json 的7个字段）。检查：
+ *   - 与 snprintf 按同一格式写出的结果逐字节一致（随机取值）
+ *   - 缓冲比结果小任意字节都返回0，且不留下被截断的JSON；恰好够用时返回完整长度
+ *   - 引号、反斜杠、控制字符转义，UTF-8 原样输出；负定点数与 INT32_MIN
+ * 基准：json_writer、snprintf、std::string 拼接（旧 String 写法）、ArduinoJson。
+ */
+
+#if defined(__has_include)
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define BENCH_HAVE_ARDUINOJSON 1
+#endif
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "json_writer.h"
+#include "telemetry_packet.h"
+
+#define JSON_BUF_LEN         192     // 与 BLE_JSON_BUF_LEN 相同
+#define RANDOM_CASES         20000
+
+typedef struct {
+    uint8_t hr;
+    uint8_t spo2;
+    float acetone_ppm;
+    uint8_t battery;
+    uint8_t snr;
+    uint32_t timestamp;
+    const char* risk;
+} Payload;
+
+static uint32_t g_rng = 7;
+
+static uint32_t rng_next() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static const char* const RISKS[] = {"正常", "低风险", "中风险", "高风险"};
+
+static Payload random_payload() {
+    Payload p;
+    p.hr = (uint8_t)rng_next();
+    p.spo2 = (uint8_t)(rng_next() % 101);
+    p.acetone_ppm = (float)(rng_next() % 20000) / 100.0f - 10.0f;
+    p.battery = (uint8_t)(rng_next() % 101);
+    p.snr = (uint8_t)rng_next();
+    p.timestamp = rng_next();
+    p.risk = RISKS[rng_next() % 4];
+    return p;
+}
+
+// ──────────────────────────────────────────────
+// 各实现（字段顺序与 ble_build_json 一致）
+
+static uint16_t build_writer(const Payload* p, char* out, uint16_t capacity) {
+    JsonWriter w;
+    json_begin(&w, out, capacity);
+    json_key(&w, JSON_KEY("hr"));         json_uint(&w, p->hr);
+    json_key(&w, JSON_KEY("spo2"));       json_uint(&w, p->spo2);
+    json_key(&w, JSON_KEY("acetone"));    json_fixed(&w, telemetry_scale_acetone(p->acetone_ppm), 1);
+    json_key(&w, JSON_KEY("battery"));    json_uint(&w, p->battery);
+    json_key(&w, JSON_KEY("snr"));        json_uint(&w, p->snr);
+    json_key(&w, JSON_KEY("timestamp"));  json_uint(&w, p->timestamp);
+    json_key(&w, JSON_KEY("risk_level")); json_string(&w, p->risk);
+    return json_end(&w);
+}
+
+// 丙酮按定点整数打印，结果应与 json_writer 逐字节一致
+static uint16_t build_snprintf(const Payload* p, char* out, uint16_t capacity) {
+    uint16_t a = telemetry_scale_acetone(p->acetone_ppm);
+    int n = snprintf(out, capacity,
+        "{\"hr\":%u,\"spo2\":%u,\"acetone\":%u.%u,\"battery\":%u,\"snr\":%u,\"timestamp\":%u,\"risk_level\":\"%s\"}",
+        p->hr, p->spo2, a / 10, a % 10, p->battery, p->snr, p->timestamp, p->risk);
+    return (n > 0 && n < capacity) ? (uint16_t)n : 0;
+}
+
+static size_t build_string(const Payload* p) {
+    uint16_t a = telemetry_scale_acetone(p->acetone_ppm);
+    std::string j = "{\"hr\":";
+    j += std::to_string(p->hr);
+    j += ",\"spo2\":";
+    j += std::to_string(p->spo2);
+    j += ",\"acetone\":";
+    j += std::to_string(a / 10);
+    j += ".";
+    j += std::to_string(a % 10);
+    j += ",\"battery\":";
+    j += std::to_string(p->battery);
+    j += ",\"snr\":";
+    j += std::to_string(p->snr);
+    j += ",\"timestamp\":";
+    j += std::to_string(p->timestamp);
+    j += ",\"risk_level\":\"";
+    j += p->risk;
+    j += "\"}";
+    return j.size();
+}
+
+#ifdef BENCH_HAVE_ARDUINOJSON
+static uint16_t build_arduinojson(const Payload* p, char* out, uint16_t capacity) {
+    StaticJsonDocument<256> doc;
+    doc["hr"] = p->hr;
+    doc["spo2"] = p->spo2;
+    doc["acetone"] = p->acetone_ppm;
+    doc["battery"] = p->battery;
+    doc["snr"] = p->snr;
+    doc["timestamp"] = p->timestamp;
+    doc["risk_level"] = p->risk;
+    return (uint16_t)serializeJson(doc, out, capacity);
+}
+#endif
+
+// ──────────────────────────────────────────────
+// 正确性
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int check_random() {
+    char a[JSON_BUF_LEN], b[JSON_BUF_LEN];
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < RANDOM_CASES; i++) {
+        Payload p = random_payload();
+        uint16_t la = build_writer(&p, a, sizeof(a));
+        uint16_t lb = build_snprintf(&p, b, sizeof(b));
+        if (la == 0 || la != lb || memcmp(a, b, la) != 0) {
+            if (mismatches++ < 3) printf("  不一致：\n    %s\n    %s\n", a, b);
+        }
+    }
+    return check(mismatches == 0, "随机负载与 snprintf 逐字节一致");
+}
+
+static int check_overflow() {
+    Payload p = {255, 100, 199.9f, 100, 255, 0xFFFFFFFFUL, "高风险"};
+    char full[JSON_BUF_LEN];
+    uint16_t n = build_writer(&p, full, sizeof(full));
+    uint32_t bad = 0;
+    for (uint16_t cap = 0; cap <= n; cap++) {
+        char buf[JSON_BUF_LEN];
+        memset(buf, 'x', sizeof(buf));
+        uint16_t len = build_writer(&p, buf, cap);
+        if (len != 0 || (cap > 0 && buf[0] != '\0') || buf[cap] != 'x') bad++;  // 不得越过容量
+    }
+    char exact[JSON_BUF_LEN];
+    uint16_t len = build_writer(&p, exact, n + 1);
+    return check(n > 0 && bad == 0 && len == n && strcmp(exact, full) == 0,
+                 "缓冲不足返回0、不越界，恰好够用时完整");
+}
+
+static int check_escape() {
+    char buf[64];
+    JsonWriter w;
+    json_begin(&w, buf, sizeof(buf));
+    json_key(&w, JSON_KEY("s")); json_string(&w, "a\"b\\c\n中");
+    json_end(&w);
+    int failures = check(strcmp(buf, "{\"s\":\"a\\\"b\\\\c\\u000a中\"}") == 0, "转义与 UTF-8");
+
+    json_begin(&w, buf, sizeof(buf));
+    json_key(&w, JSON_KEY("f")); json_fixed(&w, -5, 2);
+    json_key(&w, JSON_KEY("i")); json_int(&w, -2147483647 - 1);
+    json_key(&w, JSON_KEY("n")); json_null(&w);
+    json_end(&w);
+    failures += check(strcmp(buf, "{\"f\":-0.05,\"i\":-2147483648,\"n\":null}") == 0, "负定点数、INT32_MIN、null");
+    return failures;
+}
+
+// ──────────────────────────────────────────────
+// 基准
+
+typedef std::chrono::steady_clock BenchClock;
+
+static void report(const char* name, uint32_t n, BenchClock::time_point t0, uint32_t sink) {
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count() / n;
+    printf("  bench  %-24s %6.0f ns/负载  (校验和 %u)\n", name, ns, sink);
+}
+
+int main(int argc, char** argv) {
+    uint32_t n = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+    if (n == 0) n = 1000000;
+
+    printf("json_writer 正确性\n");
+    int failures = check_random() + check_overflow() + check_escape();
+
+    // 预先生成负载，计时只含序列化
+    static Payload payloads[1024];
+    for (uint32_t i = 0; i < 1024; i++) payloads[i] = random_payload();
+    char buf[JSON_BUF_LEN];
+    uint32_t sink;
+
+    printf("序列化耗时（%u 次，腕带 JSON 兼容负载）\n", n);
+    BenchClock::time_point t0 = BenchClock::now();
+    sink = 0;
+    for (uint32_t i = 0; i < n; i++) sink += build_writer(&payloads[i & 1023], buf, sizeof(buf));
+    report("json_writer", n, t0, sink);
+
+    t0 = BenchClock::now();
+    sink = 0;
+    for (uint32_t i = 0; i < n; i++) sink += build_snprintf(&payloads[i & 1023], buf, sizeof(buf));
+    report("snprintf", n, t0, sink);
+
+    t0 = BenchClock::now();
+    sink = 0;
+    for (uint32_t i = 0; i < n; i++) sink += (uint32_t)build_string(&payloads[i & 1023]);
+    report("std::string 拼接", n, t0, sink);
+
+#ifdef BENCH_HAVE_ARDUINOJSON
+    t0 = BenchClock::now();
+    sink = 0;
+    for (uint32_t i = 0; i < n; i++) sink += build_arduinojson(&payloads[i & 1023], buf, sizeof(buf));
+    report("ArduinoJson Static<256>", n, t0, sink);
+#else
+    printf("  bench  ArduinoJson              跳过（未找到 ArduinoJson.h，见文件头）\n");
+#endif
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
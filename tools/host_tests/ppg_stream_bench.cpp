@@ -0,0 +1,254 @@
+/*
+ * ppg_stream_bench.cpp - ppg_stream_packet.h 的正确性检查、压缩率与编解码耗时
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -DMCU_ESP32_S3 -DDEVICE_ROLE_WRIST -Itools/host_tests/stub -Isrc -Idrivers -Iconfig \
+ *       tools/host_tests/ppg_stream_bench.cpp drivers/sensor_source_synthetic.cpp -o ppg_stream_bench
+ *   ./ppg_stream_bench [编解码基准的批数]
+ *
+ * 检查：
+ *   - 随机 int32 输入（含 INT32_MIN/MAX 与符号交替）按各种批长/缓冲容量无损往返，首序号一致
+ *   - 帧内任意一位翻转都被拒绝（版本字节为 ERR_VERSION，其余为 ERR_CRC）；截断、容量不足、
+ *     样本数与数据不符（重算CRC后）返回对应错误码
+ *   - 合成脉搏波（drivers/sensor_source 合成数据源，10LSB 噪声）按固件的批长（20~50样本，
+ *     BLE_PPG_MIN/MAX_BATCH_MS @100Hz）编码，字节/对低于3；报告 10/20/50 样本批与噪声的影响
+ * 基准：每批50样本的编码、解码耗时。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "ppg_stream_packet.h"
+#include "sensor_source.h"
+
+#define FRAME_CAPACITY       244     // MTU 247 - 3（与 BLE_TX_MAX_CHUNK 相同）
+#define RANDOM_BATCHES       20000
+#define RATE_SAMPLES         30000   // 5分钟 @100Hz
+#define RATE_TARGET_X100     300     // 目标：低于3字节/对
+
+static uint32_t g_rng = 11;
+
+static uint32_t rng_next() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// 随机 int32：均匀、极值、小幅随机游走、大斜率斜坡（回绕，使编码器选二阶预测）四种分布混合
+static void random_samples(int32_t* red, int32_t* ir, uint16_t n) {
+    uint32_t kind = rng_next() % 4;
+    int32_t r = (int32_t)rng_next(), i = (int32_t)rng_next();
+    uint32_t dr = rng_next(), di = rng_next();
+    for (uint16_t k = 0; k < n; k++) {
+        if (kind == 0) {
+            r = (int32_t)rng_next();
+            i = (int32_t)rng_next();
+        } else if (kind == 1) {
+            static const int32_t k_edge[] = {INT32_MIN, INT32_MAX, 0, -1, 1, INT32_MIN + 1};
+            r = k_edge[rng_next() % 6];
+            i = k_edge[rng_next() % 6];
+        } else if (kind == 2) {
+            r = (int32_t)((uint32_t)r + (rng_next() % 64) - 32);
+            i = (int32_t)((uint32_t)i + (rng_next() % 64) - 32);
+        } else {
+            r = (int32_t)((uint32_t)r + dr + rng_next() % 4);
+            i = (int32_t)((uint32_t)i + di + rng_next() % 4);
+        }
+        red[k] = r;
+        ir[k] = i;
+    }
+}
+
+// 编码一批（从 *pos 开始尽量放入，最多 batch 个），返回帧长并推进 *pos
+static uint8_t encode_batch(PpgStreamEncoder* e, uint8_t* frame, uint8_t capacity,
+                            const int32_t* red, const int32_t* ir, uint32_t n, uint32_t* pos, uint16_t batch) {
+    ppg_stream_begin(e, frame, capacity, (uint16_t)*pos);
+    uint16_t k = 0;
+    while (*pos + k < n && k < batch && ppg_stream_add(e, red[*pos + k], ir[*pos + k])) k++;
+    *pos += k;
+    return ppg_stream_finish(e);
+}
+
+// ──────────────────────────────────────────────
+// 正确性
+
+static int check_random_roundtrip() {
+    PpgStreamEncoder e;
+    memset(&e, 0, sizeof(e));
+    uint32_t bad = 0, frames = 0, order2 = 0;
+    for (uint32_t b = 0; b < RANDOM_BATCHES; b++) {
+        int32_t red[PPG_STREAM_MAX_SAMPLES], ir[PPG_STREAM_MAX_SAMPLES];
+        uint16_t n = (uint16_t)(1 + rng_next() % PPG_STREAM_MAX_SAMPLES);
+        uint8_t capacity = (uint8_t)(PPG_STREAM_HEADER_LEN + PPG_STREAM_CRC_LEN + 10 + rng_next() % 239);
+        random_samples(red, ir, n);
+
+        uint32_t pos = 0;
+        while (pos < n) {
+            uint8_t frame[255];
+            uint32_t start = pos;
+            uint8_t len = encode_batch(&e, frame, capacity, red, ir, n, &pos, n);
+            if (len == 0 || len > capacity || pos == start) {
+                bad++;
+                break;
+            }
+            frames++;
+            if (e.flags & PPG_STREAM_FLAG_ORDER2) order2++;
+
+            PpgStreamHeader hdr;
+            int32_t r[PPG_STREAM_MAX_SAMPLES], i[PPG_STREAM_MAX_SAMPLES];
+            int16_t count = ppg_stream_decode(frame, len, &hdr, r, i, PPG_STREAM_MAX_SAMPLES);
+            if (count != (int16_t)(pos - start) || hdr.seq != (uint16_t)start) {
+                bad++;
+                continue;
+            }
+            for (int16_t k = 0; k < count; k++) {
+                if (r[k] != red[start + k] || i[k] != ir[start + k]) {
+                    bad++;
+                    break;
+                }
+            }
+        }
+    }
+    printf("  %u 帧（二阶预测 %u）\n", frames, order2);
+    return check(bad == 0 && order2 > 0 && order2 < frames, "随机 int32 无损往返（一阶/二阶）");
+}
+
+static int check_rejection() {
+    PpgStreamEncoder e;
+    memset(&e, 0, sizeof(e));
+    int32_t red[40], ir[40];
+    random_samples(red, ir, 40);
+    uint8_t frame[FRAME_CAPACITY];
+    uint32_t pos = 0;
+    uint8_t len = encode_batch(&e, frame, FRAME_CAPACITY, red, ir, 40, &pos, 40);
+
+    PpgStreamHeader hdr;
+    int32_t r[PPG_STREAM_MAX_SAMPLES], i[PPG_STREAM_MAX_SAMPLES];
+    uint32_t missed = 0;
+    for (uint16_t bit = 0; bit < len * 8u; bit++) {
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        int16_t rc = ppg_stream_decode(frame, len, &hdr, r, i, PPG_STREAM_MAX_SAMPLES);
+        int16_t want = (bit < 8) ? PPG_STREAM_ERR_VERSION : PPG_STREAM_ERR_CRC;
+        if (rc != want) missed++;
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+    }
+    int failures = check(missed == 0, "任意单比特翻转被拒绝");
+
+    uint32_t bad = 0;
+    for (uint8_t cut = 0; cut < len; cut++) {
+        if (ppg_stream_decode(frame, cut, &hdr, r, i, PPG_STREAM_MAX_SAMPLES) >= 0) bad++;
+    }
+    uint8_t count = frame[2];                // 随机数据未必放得下全部40个样本
+    if (ppg_stream_decode(frame, len, &hdr, r, i, count - 1) != PPG_STREAM_ERR_CAPACITY) bad++;
+
+    // 样本数与数据不符：改写计数并重算CRC，应判为格式错误
+    frame[2] = count + 1;
+    uint16_t crc = telemetry_crc16(frame, len - PPG_STREAM_CRC_LEN);
+    frame[len - 2] = (uint8_t)crc;
+    frame[len - 1] = (uint8_t)(crc >> 8);
+    if (ppg_stream_decode(frame, len, &hdr, r, i, PPG_STREAM_MAX_SAMPLES) != PPG_STREAM_ERR_FORMAT) bad++;
+    failures += check(bad == 0, "截断、容量不足、样本数不符");
+    return failures;
+}
+
+// ──────────────────────────────────────────────
+// 压缩率：合成脉搏波按固件批长编码
+
+static uint32_t rate_x100(float noise_rms, uint16_t batch, uint32_t* order2_frames, uint32_t* frames) {
+    static int32_t red[RATE_SAMPLES], ir[RATE_SAMPLES];
+    SyntheticSourceConfig config;
+    synthetic_source_default_config(&config);
+    config.noise_rms = noise_rms;
+    const SensorSource* source = synthetic_source_create(&config);
+    for (uint32_t n = 0; n < RATE_SAMPLES; n++) source->ppg_read(&red[n], &ir[n]);
+
+    PpgStreamEncoder e;
+    memset(&e, 0, sizeof(e));
+    uint32_t pos = 0, bytes = 0;
+    *order2_frames = 0;
+    *frames = 0;
+    while (pos < RATE_SAMPLES) {
+        uint8_t frame[FRAME_CAPACITY];
+        bytes += encode_batch(&e, frame, FRAME_CAPACITY, red, ir, RATE_SAMPLES, &pos, batch);
+        if (e.flags & PPG_STREAM_FLAG_ORDER2) (*order2_frames)++;
+        (*frames)++;
+    }
+    return (uint32_t)((uint64_t)bytes * 100 / RATE_SAMPLES);
+}
+
+static int check_rate() {
+    static const uint16_t k_batches[] = {10, 20, 50};
+    static const float k_noise[] = {3.0f, 10.0f, 30.0f};
+    int failures = 0;
+    printf("  字节/对（合成脉搏波 72bpm，IR 直流 100000，%u 样本）\n", RATE_SAMPLES);
+    for (uint8_t ni = 0; ni < 3; ni++) {
+        for (uint8_t bi = 0; bi < 3; bi++) {
+            uint32_t order2, frames;
+            uint32_t x100 = rate_x100(k_noise[ni], k_batches[bi], &order2, &frames);
+            printf("    噪声 %4.0f LSB  每批 %2u 样本：%u.%02u 字节/对（二阶预测 %u/%u 批）\n",
+                   k_noise[ni], k_batches[bi], x100 / 100, x100 % 100, order2, frames);
+            // 目标针对固件的批长与文档中的噪声水平
+            if (k_noise[ni] == 10.0f && k_batches[bi] >= 20 && x100 >= RATE_TARGET_X100) failures++;
+        }
+    }
+    return failures + check(failures == 0, "10LSB 噪声、20~50 样本批低于3字节/对");
+}
+
+// ──────────────────────────────────────────────
+// 基准
+
+typedef std::chrono::steady_clock BenchClock;
+
+int main(int argc, char** argv) {
+    uint32_t n = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+    if (n == 0) n = 200000;
+
+    printf("ppg_stream_packet 正确性\n");
+    int failures = check_random_roundtrip() + check_rejection();
+    printf("压缩率\n");
+    failures += check_rate();
+
+    // 预先生成一批50样本的脉搏波，计时只含编解码
+    SyntheticSourceConfig config;
+    synthetic_source_default_config(&config);
+    const SensorSource* source = synthetic_source_create(&config);
+    int32_t red[50], ir[50];
+    for (uint8_t k = 0; k < 50; k++) source->ppg_read(&red[k], &ir[k]);
+    PpgStreamEncoder e;
+    memset(&e, 0, sizeof(e));
+    uint8_t frame[FRAME_CAPACITY];
+    uint32_t sink = 0;
+
+    printf("编解码耗时（%u 批 × 50 样本）\n", n);
+    BenchClock::time_point t0 = BenchClock::now();
+    uint8_t len = 0;
+    for (uint32_t b = 0; b < n; b++) {
+        uint32_t pos = 0;
+        red[b % 50] ^= 1;                    // 每批略有不同，避免被优化掉
+        len = encode_batch(&e, frame, FRAME_CAPACITY, red, ir, 50, &pos, 50);
+        sink += len;
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count() / n;
+    printf("  bench  编码  %6.0f ns/批  %5.1f ns/样本  (校验和 %u)\n", ns, ns / 50, sink);
+
+    PpgStreamHeader hdr;
+    int32_t r[PPG_STREAM_MAX_SAMPLES], i[PPG_STREAM_MAX_SAMPLES];
+    t0 = BenchClock::now();
+    sink = 0;
+    for (uint32_t b = 0; b < n; b++) {
+        sink += (uint32_t)ppg_stream_decode(frame, len, &hdr, r, i, PPG_STREAM_MAX_SAMPLES) + (uint32_t)r[b % 50];
+    }
+    ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count() / n;
+    printf("  bench  解码  %6.0f ns/批  %5.1f ns/样本  (校验和 %u)\n", ns, ns / 50, sink);
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
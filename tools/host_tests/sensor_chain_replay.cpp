@@ -0,0 +1,270 @@
+/*
+ * sensor_chain_replay.cpp - 合成/回放数据源 → 采集器 → 样本总线 → 算法管理器 全链路回归
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -DRT_COOPERATIVE -DMCU_ESP32_S3 -DDEVICE_ROLE_WRIST \
+ *       -Itools/host_tests/stub -Isrc -Isystem -Idrivers -Ialgorithm -Iutils -Iconfig \
+ *       tools/host_tests/sensor_chain_replay.cpp src/sensor_collector_final.cpp src/sample_bus_final.cpp \
+ *       src/algorithm_manager_final.cpp src/task_runtime_final.cpp algorithm/hr_algorithm.cpp \
+ *       algorithm/motion_correction.cpp algorithm/resampler.cpp algorithm/wear_detect.cpp \
+ *       drivers/sensor_source.cpp drivers/sensor_source_replay.cpp drivers/sensor_source_synthetic.cpp \
+ *       drivers/sno2_driver.cpp drivers/adc_calib.cpp system/timebase.cpp system/idle.cpp \
+ *       system/virtual_clock.cpp -o sensor_chain_replay
+ *   ./sensor_chain_replay [模拟秒数]
+ *
+ * 按固件的调用方式（采集每10ms、算法随后）在虚拟时钟上运行，数据源按采样率限速
+ * （合成/回放数据源本身不限速，一次读空会一次给出 SENSOR_HR_MAX_DRAIN 个样本）。检查：
+ *   - synthetic_source_create() 的默认配置（72bpm/97%）与另两组参数（含45bpm低心率），算法结果与生成参数一致
+ *   - 同一合成序列录成回放文件，经 replay_source_open_file + sensor_source_select 重跑，结果相同
+ *   - 回放文件头损坏时打开失败
+ *   - 离腕（IR直流低于 WEAR_OFF_DC）时SnO2读数照常被算法取走：交接队列不丢弃，丙酮随读数更新
+ * MAX30102 的接近模式/AGC 回调在主机上为空操作（合成信号不会触发离腕）。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sensor_source.h"
+#include "sensor_collector_final.h"
+#include "algorithm_manager_final.h"
+#include "virtual_clock.h"
+#include "wear_detect.h"
+
+#define CHAIN_TICK_US          10000UL     // 采集周期（与 sensor_collect_hr 一致）
+#define CHAIN_DEFAULT_SEC      30
+#define CHAIN_SETTLE_SEC       15          // 之后的结果参与比较
+#define CHAIN_BPM_TOL          3
+#define CHAIN_SPO2_TOL         2
+#define REPLAY_PATH            "/tmp/sensor_chain_replay.bin"
+
+// ──────────────────────────────────────────────
+// hr_driver 中与硬件相关、被 wear_detect/算法管理器引用的部分（主机上为空操作）
+
+void hr_set_agc_callback(void (*callback)()) { (void)callback; }
+void hr_enter_proximity_mode() {}
+void hr_exit_proximity_mode() {}
+bool hr_proximity_triggered() { return false; }
+
+// ──────────────────────────────────────────────
+// 限速包装：按虚拟时钟与采样率放行PPG样本，其余通道原样转发
+
+static const SensorSource* g_inner;
+static uint16_t g_paced_rate;
+static uint32_t g_paced_count;
+
+static bool paced_ppg_available() {
+    uint64_t due = vclock_now_us() * g_paced_rate / 1000000ULL;
+    return g_paced_count < due && g_inner->ppg_available();
+}
+
+static bool paced_ppg_read(int32_t* red, int32_t* ir) {
+    if (!g_inner->ppg_read(red, ir)) return false;
+    g_paced_count++;
+    return true;
+}
+
+static bool paced_gas_read_raw(uint16_t* raw) { return g_inner->gas_read_raw(raw); }
+static bool paced_env_read(EnvData* out) { return g_inner->env_read(out); }
+static bool paced_battery_read_raw(uint16_t* raw) { return g_inner->battery_read_raw(raw); }
+
+static const SensorSource g_paced_source = {
+    SENSOR_SOURCE_SYNTHETIC,
+    "paced",
+    paced_ppg_available,
+    paced_ppg_read,
+    paced_gas_read_raw,
+    paced_env_read,
+    paced_battery_read_raw,
+    NULL
+};
+
+// ──────────────────────────────────────────────
+// 运行链路：返回稳定段的平均结果
+
+typedef struct {
+    float bpm;
+    float spo2;
+    uint32_t results;
+    uint32_t samples;
+} ChainResult;
+
+static ChainResult run_chain(const SensorSource* source, uint16_t rate_hz, uint32_t seconds) {
+    g_inner = source;
+    g_paced_rate = rate_hz;
+    g_paced_count = 0;
+    sensor_source_select(&g_paced_source);
+
+    vclock_reset(0);
+    sensor_collector_init();
+    algorithm_manager_init();
+
+    ChainResult r = {0, 0, 0, 0};
+    uint32_t last_ts = 0;
+    uint32_t ticks = seconds * (1000000UL / CHAIN_TICK_US);
+    for (uint32_t i = 0; i < ticks; i++) {
+        vclock_advance_us(CHAIN_TICK_US);
+        sensor_collector_update();
+        algorithm_manager_update();
+
+        AlgorithmResult res;
+        algorithm_manager_get_result(&res);
+        if (res.timestamp_ms == last_ts || millis() < CHAIN_SETTLE_SEC * 1000UL) continue;
+        last_ts = res.timestamp_ms;
+        if (res.bpm == 0 || res.spo2 == 0) continue;
+        r.bpm += res.bpm;
+        r.spo2 += res.spo2;
+        r.results++;
+    }
+    if (r.results > 0) {
+        r.bpm /= r.results;
+        r.spo2 /= r.results;
+    }
+    r.samples = g_paced_count;
+    return r;
+}
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int check_result(const char* name, const ChainResult* r, float bpm, float spo2, uint32_t seconds) {
+    printf("  %-10s 样本 %u，结果 %u 次，平均 %.1f bpm / %.1f%%（生成 %.0f bpm / %.0f%%）\n",
+           name, r->samples, r->results, r->bpm, r->spo2, bpm, spo2);
+    char what[96];
+    snprintf(what, sizeof(what), "%s 心率/血氧与生成参数一致", name);
+    int ok = r->results > 0 &&
+             r->samples + 1 >= seconds * 100 &&
+             fabsf(r->bpm - bpm) <= CHAIN_BPM_TOL &&
+             fabsf(r->spo2 - spo2) <= CHAIN_SPO2_TOL;
+    return check(ok, what);
+}
+
+// ──────────────────────────────────────────────
+// 把合成序列录成回放文件（PPG每样本一条，气体每100ms、电池每60s一条）
+
+static int write_replay(const SyntheticSourceConfig* config, uint32_t seconds) {
+    const SensorSource* synth = synthetic_source_create(config);
+    FILE* f = fopen(REPLAY_PATH, "wb");
+    if (f == NULL) return 0;
+
+    uint32_t ppg_count = seconds * config->sample_rate_hz;
+    ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, config->sample_rate_hz, 0, 0};
+    fwrite(&header, sizeof(header), 1, f);
+
+    uint32_t records = 0;
+    for (uint32_t i = 0; i < ppg_count; i++) {
+        ReplayRecord rec = {0};
+        rec.timestamp_ms = i * 1000 / config->sample_rate_hz;
+        rec.type = REPLAY_RECORD_PPG;
+        int32_t red, ir;
+        synth->ppg_read(&red, &ir);
+        rec.b = red;
+        rec.c = ir;
+        fwrite(&rec, sizeof(rec), 1, f);
+        records++;
+
+        if (rec.timestamp_ms % 100 == 0) {
+            ReplayRecord gas = {0};
+            gas.timestamp_ms = rec.timestamp_ms;
+            gas.type = REPLAY_RECORD_GAS;
+            uint16_t raw;
+            synth->gas_read_raw(&raw);
+            gas.a = raw;
+            fwrite(&gas, sizeof(gas), 1, f);
+            records++;
+        }
+        if (rec.timestamp_ms % 60000 == 0) {
+            ReplayRecord bat = {0};
+            bat.timestamp_ms = rec.timestamp_ms;
+            bat.type = REPLAY_RECORD_BATTERY;
+            uint16_t raw;
+            synth->battery_read_raw(&raw);
+            bat.a = raw;
+            fwrite(&bat, sizeof(bat), 1, f);
+            records++;
+        }
+    }
+
+    header.record_count = records;
+    fseek(f, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, f);
+    return fclose(f) == 0;
+}
+
+static int check_off_wrist(uint32_t seconds) {
+    SyntheticSourceConfig config;
+    synthetic_source_default_config(&config);
+    config.ir_dc = WEAR_OFF_DC / 2;
+    config.red_dc = WEAR_OFF_DC / 2;
+    run_chain(synthetic_source_create(&config), config.sample_rate_hz, seconds);
+
+    CollectorStats stats;
+    sensor_collector_get_stats(&stats);
+    AlgorithmResult res;
+    algorithm_manager_get_result(&res);
+    printf("  离腕 %u 秒：SnO2 读数 %u，交接丢弃 %u，丙酮 %.1f ppm\n",
+           seconds, stats.total_sno2_samples, stats.sno2_handoff_drops, res.acetone_ppm);
+    return check(!wear_detect_is_on_wrist() && stats.total_sno2_samples > 0 &&
+                 stats.sno2_handoff_drops == 0 && res.acetone_ppm > 0.0f,
+                 "离腕时SnO2照常取走");
+}
+
+static int check_bad_header() {
+    FILE* f = fopen(REPLAY_PATH, "r+b");
+    if (f == NULL) return check(0, "回放文件头损坏时打开失败");
+    uint32_t bad = 0;
+    fwrite(&bad, sizeof(bad), 1, f);
+    fclose(f);
+    return check(replay_source_open_file(REPLAY_PATH, false) == NULL, "回放文件头损坏时打开失败");
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : CHAIN_DEFAULT_SEC;
+    if (seconds <= CHAIN_SETTLE_SEC + 5) seconds = CHAIN_DEFAULT_SEC;
+    int failures = 0;
+
+    printf("合成数据源 → 采集 → 算法（%u 秒）\n", seconds);
+    SyntheticSourceConfig config;
+    synthetic_source_default_config(&config);
+    ChainResult r = run_chain(synthetic_source_create(&config), config.sample_rate_hz, seconds);
+    failures += check_result("默认配置", &r, config.hr_bpm, config.spo2_pct, seconds);
+
+    SyntheticSourceConfig other = config;
+    other.seed = 12345;
+    other.hr_bpm = 105.0f;
+    other.spo2_pct = 93.0f;
+    r = run_chain(synthetic_source_create(&other), other.sample_rate_hz, seconds);
+    failures += check_result("105/93", &r, other.hr_bpm, other.spo2_pct, seconds);
+
+    // 低心率：窗口内要有3个峰
+    other.seed = 777;
+    other.hr_bpm = 45.0f;
+    other.spo2_pct = 99.0f;
+    r = run_chain(synthetic_source_create(&other), other.sample_rate_hz, seconds);
+    failures += check_result("45/99", &r, other.hr_bpm, other.spo2_pct, seconds);
+
+    printf("回放往返（%s）\n", REPLAY_PATH);
+    failures += check(write_replay(&config, seconds), "写入回放文件");
+    const SensorSource* replay = replay_source_open_file(REPLAY_PATH, false);
+    failures += check(replay != NULL && replay_source_get_sample_rate() == config.sample_rate_hz,
+                      "replay_source_open_file");
+    if (replay != NULL) {
+        ChainResult rr = run_chain(replay, replay_source_get_sample_rate(), seconds);
+        failures += check_result("回放", &rr, config.hr_bpm, config.spo2_pct, seconds);
+        // 合成与回放是同一样本序列，结果应完全相同
+        ChainResult rs = run_chain(synthetic_source_create(&config), config.sample_rate_hz, seconds);
+        failures += check(rr.results == rs.results && rr.bpm == rs.bpm && rr.spo2 == rs.spo2,
+                          "回放结果与直接合成逐次相同");
+        replay_source_close();
+    }
+    failures += check_bad_header();
+    remove(REPLAY_PATH);
+
+    printf("离腕\n");
+    failures += check_off_wrist(seconds);
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
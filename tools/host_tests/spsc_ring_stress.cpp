@@ -0,0 +1,277 @@
+/*
+ * spsc_ring_stress.cpp - SpscRing 主机双线程压力测试与吞吐基准
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -pthread -Iutils tools/host_tests/spsc_ring_stress.cpp -o spsc_ring_stress
+ *   ./spsc_ring_stress [每轮元素数]
+ *
+ * 压力测试：生产者/消费者各一线程，按序号校验每个元素（不丢、不重、不乱序、内容未撕裂），
+ * 覆盖 push/push_bulk/write_span × pop/pop_bulk/read_span 的全部组合，批量大小随序号变化以命中回绕。
+ * 基准：单元素与批量接口的吞吐，对照互斥锁保护的同容量环形缓冲。
+ */
+
+#include "spsc_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// 与样本总线一个样本等大（时间戳 + 红光 + 红外）
+typedef struct {
+    uint32_t seq;
+    uint32_t check;                  // seq 的反码：元素被撕裂时与 seq 不符
+    int32_t red;
+    int32_t ir;
+} Item;
+
+static inline Item make_item(uint32_t seq) {
+    Item it;
+    it.seq = seq;
+    it.check = ~seq;
+    it.red = (int32_t)(seq * 7u);
+    it.ir = -(int32_t)seq;
+    return it;
+}
+
+static inline bool item_ok(const Item& it, uint32_t seq) {
+    return it.seq == seq && it.check == ~seq && it.red == (int32_t)(seq * 7u) && it.ir == -(int32_t)seq;
+}
+
+typedef enum { MODE_SINGLE = 0, MODE_BULK, MODE_SPAN, MODE_COUNT } Mode;
+static const char* const MODE_NAMES[MODE_COUNT] = {"single", "bulk", "span"};
+
+#define RING_SIZE       64               // 小容量：频繁满/空与回绕
+#define MAX_BATCH       48
+
+// 满/空时让出CPU（单核主机上忙等会耗尽整个时间片）
+static inline void backoff() {
+    std::this_thread::yield();
+}
+
+// 批量大小随序号变化（1..MAX_BATCH），两端互不同步
+static inline uint32_t batch_for(uint32_t seq, uint32_t salt) {
+    return 1 + ((seq * 2654435761u + salt) >> 7) % MAX_BATCH;
+}
+
+// ──────────────────────────────────────────────
+// 压力测试
+
+template <uint32_t N>
+static void produce(SpscRing<Item, N>* ring, Mode mode, uint32_t total) {
+    Item buf[MAX_BATCH];
+    uint32_t seq = 0;
+    while (seq < total) {
+        uint32_t n = batch_for(seq, 1);
+        if (n > total - seq) n = total - seq;
+        switch (mode) {
+            case MODE_SINGLE:
+                if (ring->push(make_item(seq))) seq++;
+                else backoff();
+                break;
+            case MODE_BULK:
+                for (uint32_t i = 0; i < n; i++) buf[i] = make_item(seq + i);
+                n = ring->push_bulk(buf, n);
+                if (n == 0) backoff();
+                seq += n;
+                break;
+            case MODE_SPAN: {
+                Item* span;
+                uint32_t avail = ring->write_span(&span);
+                if (n > avail) n = avail;
+                if (n == 0) backoff();
+                for (uint32_t i = 0; i < n; i++) span[i] = make_item(seq + i);
+                ring->commit(n);
+                seq += n;
+                break;
+            }
+            default:
+                return;
+        }
+    }
+}
+
+// 返回第一个错误的序号，全部正确返回 total
+template <uint32_t N>
+static uint32_t consume(SpscRing<Item, N>* ring, Mode mode, uint32_t total) {
+    Item buf[MAX_BATCH];
+    uint32_t seq = 0;
+    while (seq < total) {
+        uint32_t n = batch_for(seq, 2);
+        switch (mode) {
+            case MODE_SINGLE: {
+                Item it;
+                if (!ring->pop(&it)) {
+                    backoff();
+                    break;
+                }
+                if (!item_ok(it, seq)) return seq;
+                seq++;
+                break;
+            }
+            case MODE_BULK:
+                n = ring->pop_bulk(buf, n);
+                if (n == 0) backoff();
+                for (uint32_t i = 0; i < n; i++) {
+                    if (!item_ok(buf[i], seq + i)) return seq + i;
+                }
+                seq += n;
+                break;
+            case MODE_SPAN: {
+                const Item* span;
+                uint32_t avail = ring->read_span(&span);
+                if (n > avail) n = avail;
+                if (n == 0) backoff();
+                for (uint32_t i = 0; i < n; i++) {
+                    if (!item_ok(span[i], seq + i)) return seq + i;
+                }
+                ring->release(n);
+                seq += n;
+                break;
+            }
+            default:
+                return seq;
+        }
+    }
+    return ring->empty() ? total : total + 1;
+}
+
+static int run_stress(uint32_t total) {
+    int failures = 0;
+    for (int pm = 0; pm < MODE_COUNT; pm++) {
+        for (int cm = 0; cm < MODE_COUNT; cm++) {
+            static SpscRing<Item, RING_SIZE> ring;   // 每轮开始与结束时均为空，可复用
+            std::thread producer(produce<RING_SIZE>, &ring, (Mode)pm, total);
+            uint32_t got = consume<RING_SIZE>(&ring, (Mode)cm, total);
+            producer.join();
+
+            uint8_t ok = (got == total);
+            printf("  stress %-6s -> %-6s %s", MODE_NAMES[pm], MODE_NAMES[cm], ok ? "OK" : "FAIL");
+            if (!ok) {
+                printf("（序号 %u）", got);
+                failures++;
+            }
+            printf("\n");
+        }
+    }
+    return failures;
+}
+
+// ──────────────────────────────────────────────
+// 吞吐基准
+
+// 对照：互斥锁保护的同容量环形缓冲
+template <uint32_t N>
+class MutexRing {
+public:
+    MutexRing() : head_(0), tail_(0) {}
+    bool push(const Item& v) {
+        std::lock_guard<std::mutex> lock(m_);
+        if (head_ - tail_ == N) return false;
+        buf_[head_++ & (N - 1)] = v;
+        return true;
+    }
+    bool pop(Item* out) {
+        std::lock_guard<std::mutex> lock(m_);
+        if (head_ == tail_) return false;
+        *out = buf_[tail_++ & (N - 1)];
+        return true;
+    }
+private:
+    std::mutex m_;
+    uint32_t head_, tail_;
+    Item buf_[N];
+};
+
+#define BENCH_RING_SIZE   256            // 与样本总线同容量
+#define BENCH_BATCH       32             // 一次采集排空的最大样本数
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double seconds_since(BenchClock::time_point t0) {
+    return std::chrono::duration<double>(BenchClock::now() - t0).count();
+}
+
+static void report(const char* name, uint32_t total, double sec) {
+    printf("  bench  %-22s %7.1f M元素/s  (%.1f ns/元素)\n", name, total / sec / 1e6, sec * 1e9 / total);
+}
+
+static void bench_single(uint32_t total) {
+    static SpscRing<Item, BENCH_RING_SIZE> ring;
+    BenchClock::time_point t0 = BenchClock::now();
+    std::thread producer([total]() {
+        for (uint32_t seq = 0; seq < total; ) {
+            if (ring.push(make_item(seq))) seq++;
+            else backoff();
+        }
+    });
+    Item it;
+    for (uint32_t seq = 0; seq < total; ) {
+        if (ring.pop(&it)) seq++;
+        else backoff();
+    }
+    producer.join();
+    report("SpscRing push/pop", total, seconds_since(t0));
+}
+
+static void bench_bulk(uint32_t total) {
+    static SpscRing<Item, BENCH_RING_SIZE> ring;
+    BenchClock::time_point t0 = BenchClock::now();
+    std::thread producer([total]() {
+        Item buf[BENCH_BATCH];
+        for (uint32_t seq = 0; seq < total; ) {
+            uint32_t n = (total - seq < BENCH_BATCH) ? total - seq : BENCH_BATCH;
+            for (uint32_t i = 0; i < n; i++) buf[i] = make_item(seq + i);
+            uint32_t done = 0;
+            while (done < n) {
+                uint32_t k = ring.push_bulk(buf + done, n - done);
+                if (k == 0) backoff();
+                done += k;
+            }
+            seq += n;
+        }
+    });
+    Item buf[BENCH_BATCH];
+    for (uint32_t seq = 0; seq < total; ) {
+        uint32_t k = ring.pop_bulk(buf, BENCH_BATCH);
+        if (k == 0) backoff();
+        seq += k;
+    }
+    producer.join();
+    report("SpscRing bulk x32", total, seconds_since(t0));
+}
+
+static void bench_mutex(uint32_t total) {
+    static MutexRing<BENCH_RING_SIZE> ring;
+    BenchClock::time_point t0 = BenchClock::now();
+    std::thread producer([total]() {
+        for (uint32_t seq = 0; seq < total; ) {
+            if (ring.push(make_item(seq))) seq++;
+            else backoff();
+        }
+    });
+    Item it;
+    for (uint32_t seq = 0; seq < total; ) {
+        if (ring.pop(&it)) seq++;
+        else backoff();
+    }
+    producer.join();
+    report("std::mutex push/pop", total, seconds_since(t0));
+}
+
+int main(int argc, char** argv) {
+    uint32_t total = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+    if (total == 0) total = 2000000;
+
+    printf("SpscRing 压力测试（容量 %u，每轮 %u 个元素）\n", RING_SIZE, total);
+    int failures = run_stress(total);
+
+    printf("吞吐基准（容量 %u，%u 个元素）\n", BENCH_RING_SIZE, total);
+    bench_single(total);
+    bench_bulk(total);
+    bench_mutex(total);
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
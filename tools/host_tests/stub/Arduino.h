@@ -0,0 +1,52 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ──────────────────────────────────────────────
+// 主机测试用的最小 Arduino 接口（仅 tools/host_tests）
+// ──────────────────────────────────────────────
+// millis()/micros()/delay() 由 system/virtual_clock.cpp 在非 Arduino 构建中实现；
+// Serial 输出到标准输出；GPIO/ADC 为空操作（主机上传感器数据来自 drivers/sensor_source 的回放/合成数据源）。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+#define LOW                  0
+#define HIGH                 1
+#define INPUT                0x01
+#define OUTPUT               0x03
+
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline void digitalWrite(uint8_t, uint8_t) {}
+static inline int digitalRead(uint8_t) { return LOW; }
+static inline uint16_t analogRead(uint8_t) { return 0; }
+static inline void analogReadResolution(uint8_t) {}
+static inline bool adcAttachPin(uint8_t) { return true; }
+
+struct HostSerial {
+    void begin(unsigned long) {}
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    void print(const char* s) { fputs(s, stdout); }
+    void println(const char* s = "") { puts(s); }
+};
+
+static HostSerial Serial __attribute__((unused));
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,138 @@
+/*
+ * task_runtime_vclock.cpp - 协作式任务运行时在虚拟时钟上的空闲/休眠验证
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -DRT_COOPERATIVE -DDEBUG_MODE -Itools/host_tests/stub -Isrc -Isystem \
+ *       tools/host_tests/task_runtime_vclock.cpp src/task_runtime_final.cpp \
+ *       system/idle.cpp system/timebase.cpp system/virtual_clock.cpp -o task_runtime_vclock
+ *   ./task_runtime_vclock [模拟秒数]
+ *
+ * 按固件的任务布局（main_esp32s3_final.cpp g_rt_layout）注册 ACQ/DSP/COMM，
+ * 各任务以 vclock_advance_us() 模拟执行耗时，另有周期性的模拟 MAX30102 中断提前结束休眠。
+ * 虚拟时间只在执行或休眠时前进，因此：
+ *   - 总时间 = 任务执行时间 + 休眠时间 + 运行时自身开销（应为0）
+ *   - 休眠占比 = 1 - 负载；按下面的耗时模型约 95%
+ * 检查：空闲时间全部转成休眠；各任务运行次数与周期一致；通知任务的唤醒延迟不超过一次执行时间。
+ */
+
+#include <Arduino.h>
+#include "task_runtime_final.h"
+#include "idle.h"
+#include "virtual_clock.h"
+
+// 耗时模型（微秒，按 -Og 调试构建的实测量级取整）
+#define COST_ACQ_US          150     // 读空FIFO（约1~2个样本）+ 发布到样本总线
+#define COST_DSP_US          250     // 重采样 + 滤波；每 ANALYSIS_EVERY 次再做一次完整分析
+#define COST_ANALYSIS_US     3000
+#define ANALYSIS_EVERY       50      // 约1秒一次
+#define COST_COMM_US         20      // 无发送时的轮询
+#define IRQ_PERIOD_US        250000  // 模拟外部中断（按键/传感器INT）
+
+#define ACQ_PERIOD_MS        10
+#define DSP_MAX_WAIT_MS      20
+#define COMM_PERIOD_MS       10
+
+static uint8_t g_dsp_task = RT_INVALID_TASK;
+static uint32_t g_acq_runs, g_dsp_runs, g_comm_runs;
+static uint64_t g_busy_us;
+
+static void busy(uint32_t us) {
+    vclock_advance_us(us);
+    g_busy_us += us;
+}
+
+static void task_acquisition() {
+    g_acq_runs++;
+    busy(COST_ACQ_US);
+    task_runtime_notify(g_dsp_task);
+}
+
+static void task_dsp() {
+    g_dsp_runs++;
+    busy(COST_DSP_US);
+    if (g_dsp_runs % ANALYSIS_EVERY == 0) busy(COST_ANALYSIS_US);
+}
+
+static void task_comm() {
+    g_comm_runs++;
+    busy(COST_COMM_US);
+}
+
+// 未连接：不禁止 light sleep，也没有自己的截止时刻
+static uint32_t ble_time_to_next_ms() {
+    return IDLE_NO_DEADLINE;
+}
+
+static uint8_t ble_blocks_light_sleep() {
+    return 0;
+}
+
+static const RtTaskConfig g_layout[] = {
+    {"ACQ",  task_acquisition, ACQ_PERIOD_MS,   RT_WAKE_PERIODIC, RT_CORE_ACQ,  RT_PRIO_ACQ,  RT_STACK_ACQ},
+    {"DSP",  task_dsp,         DSP_MAX_WAIT_MS, RT_WAKE_NOTIFY,   RT_CORE_DSP,  RT_PRIO_DSP,  RT_STACK_DSP},
+    {"COMM", task_comm,        COMM_PERIOD_MS,  RT_WAKE_PERIODIC, RT_CORE_COMM, RT_PRIO_COMM, RT_STACK_COMM},
+};
+
+static const IdleSource g_ble_source = {"ble", ble_time_to_next_ms, ble_blocks_light_sleep};
+
+static int check(int ok, const char* what) {
+    printf("  %s: %s\n", what, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 60;
+    if (seconds == 0) seconds = 60;
+    uint64_t end_us = (uint64_t)seconds * 1000000ULL;
+
+    vclock_reset(0);
+    for (uint8_t i = 0; i < sizeof(g_layout) / sizeof(g_layout[0]); i++) {
+        uint8_t id = task_runtime_add(&g_layout[i]);
+        if (g_layout[i].func == task_dsp) g_dsp_task = id;
+    }
+    idle_register_source(&g_ble_source);
+    task_runtime_start();
+
+    // 模拟中断队列容量有限：边运行边补充
+    uint64_t next_irq_us = IRQ_PERIOD_US / 2;
+    while (vclock_now_us() < end_us) {
+        while (next_irq_us < vclock_now_us() + IRQ_PERIOD_US * (VCLOCK_MAX_PENDING_IRQ - 1)) {
+            if (!vclock_schedule_interrupt_us(next_irq_us)) break;
+            next_irq_us += IRQ_PERIOD_US;
+        }
+        task_runtime_loop();
+    }
+
+    VirtualClockStats clk;
+    vclock_get_stats(&clk);
+    task_runtime_print_stats();
+    idle_print_stats();
+
+    uint64_t overhead_us = clk.now_us - clk.slept_us - g_busy_us;
+    double slept_pct = 100.0 * clk.slept_us / clk.now_us;
+    double busy_pct = 100.0 * g_busy_us / clk.now_us;
+    printf("\n虚拟时间 %.1fs：执行 %.2f%%，休眠 %.2f%%（%u次，中断唤醒 %u次），其余 %lluus\n",
+        clk.now_us / 1e6, busy_pct, slept_pct, clk.sleeps, clk.irq_wakeups,
+        (unsigned long long)overhead_us);
+    printf("运行次数：ACQ %u  DSP %u  COMM %u\n", g_acq_runs, g_dsp_runs, g_comm_runs);
+
+    RtTaskStats dsp;
+    task_runtime_get_stats(g_dsp_task, &dsp);
+
+    uint32_t expected_periodic = (uint32_t)(clk.now_us / (ACQ_PERIOD_MS * 1000ULL));
+    int failures = 0;
+    failures += check(overhead_us == 0, "空闲时间全部转成休眠");
+    failures += check(slept_pct >= 94.0, "休眠占比 >= 94%");
+    failures += check(g_acq_runs + 1 >= expected_periodic && g_acq_runs <= expected_periodic + 1,
+                      "ACQ 按 10ms 周期运行");
+    failures += check(g_comm_runs + 1 >= expected_periodic && g_comm_runs <= expected_periodic + 1,
+                      "COMM 按 10ms 周期运行");
+    failures += check(g_dsp_runs + 1 >= g_acq_runs && g_dsp_runs <= g_acq_runs,
+                      "DSP 每次通知运行一次");
+    failures += check(dsp.latency_max_us <= COST_ACQ_US + COST_DSP_US + COST_ANALYSIS_US,
+                      "DSP 唤醒延迟不超过一轮执行时间");
+    failures += check(clk.irq_wakeups > 0, "模拟中断提前结束休眠");
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * timer_wheel_model.cpp - 分层时间轮与暴力模型的随机对照检查
+ *
+ * 构建与运行（仓库根目录，见 tools/host_tests/README.md）：
+ *   g++ -std=gnu++17 -O2 -Itools/host_tests/stub -Isystem \
+ *       tools/host_tests/timer_wheel_model.cpp system/timer_wheel.cpp system/periodic.cpp \
+ *       system/virtual_clock.cpp -o timer_wheel_model
+ *   ./timer_wheel_model [操作数] [随机种子]
+ *
+ * 模型：每个定时器只记"是否排队 + 绝对到期时刻"，最早到期时刻逐个比较求出。
+ * 随机操作（默认20万次）：启动/重启单次定时器（短延迟为主，含跨越全部层级的长延迟）、取消、
+ * 推进虚拟时钟（多数为几毫秒，偶尔几十分钟的长休眠以覆盖跨层进位与位图跳过）。每步检查：
+ *   - 回调恰好在模型的到期时刻执行，且只执行一次；取消后不执行
+ *   - timer_wheel_time_to_next_ms() 与模型的最早到期时刻一致（含周期定时器）
+ *   - 排队数与模型一致
+ * 另有一个 PERIODIC_SKIP 周期定时器全程运行，检查长休眠后只补一次且保持相位。
+ * 默认参数下虚拟时间约1700小时（70天），毫秒计数越过 2^32 回绕。
+ */
+
+#include <Arduino.h>
+#include <utility>
+#include "timer_wheel.h"
+#include "virtual_clock.h"
+
+#define MODEL_TIMERS         64
+#define PERIODIC_MS          10
+#define MAX_REPORTS          10
+
+typedef struct {
+    uint8_t armed;
+    uint32_t expires_ms;
+} ModelTimer;
+
+static TimerWheelTimer g_wheel_timers[MODEL_TIMERS];
+static ModelTimer g_model[MODEL_TIMERS];
+static uint32_t g_fires;
+static uint32_t g_errors;
+
+static TimerWheelTimer g_periodic_wheel_timer;
+static PeriodicTimer g_periodic;
+static uint32_t g_periodic_fires;
+static uint32_t g_periodic_errors;
+
+static uint32_t g_rng = 1;
+
+static uint32_t rng_next() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static uint32_t wheel_now_ms() {
+    TimerWheelStats stats;
+    timer_wheel_get_stats(&stats);
+    return stats.now_ms;
+}
+
+static void report(const char* what, int index, uint32_t now, uint32_t expected) {
+    g_errors++;
+    if (g_errors <= MAX_REPORTS) {
+        printf("  错误：%s 定时器%d now=%u 期望=%u\n", what, index, now, expected);
+    }
+}
+
+// 每个定时器一个回调（回调没有参数，用模板实例区分）
+template <int I>
+static void on_expire() {
+    uint32_t now = wheel_now_ms();
+    g_fires++;
+    if (!g_model[I].armed) {
+        report("未排队却执行", I, now, 0);
+    } else if (now != g_model[I].expires_ms) {
+        report("到期时刻不符", I, now, g_model[I].expires_ms);
+    }
+    g_model[I].armed = 0;
+}
+
+typedef void (*Callback)(void);
+
+template <int... I>
+static const Callback* callback_table(std::integer_sequence<int, I...>) {
+    static const Callback table[] = {on_expire<I>...};
+    return table;
+}
+
+// 周期定时器（SKIP）：本次释放与上次相差整数个周期（保持相位），
+// 且是推进目标时刻之前最近的一次释放（错过的释放全部丢弃，只补一次）
+static uint32_t g_last_release_ms;
+
+static void on_periodic() {
+    uint32_t release = g_periodic.current_release_ms;
+    uint32_t target = (uint32_t)millis();
+    g_periodic_fires++;
+    if ((release - g_last_release_ms) % PERIODIC_MS != 0 || target - release >= PERIODIC_MS) {
+        g_periodic_errors++;
+    }
+    g_last_release_ms = release;
+}
+
+static uint32_t model_time_to_next_ms(uint32_t now) {
+    uint32_t best = 0xFFFFFFFFUL;
+    for (int i = 0; i < MODEL_TIMERS; i++) {
+        if (g_model[i].armed && g_model[i].expires_ms - now < best) best = g_model[i].expires_ms - now;
+    }
+    uint32_t p = periodic_time_to_release(&g_periodic, now);
+    return (p < best) ? p : best;
+}
+
+static uint16_t model_pending() {
+    uint16_t n = 1;                  // 周期定时器始终排队
+    for (int i = 0; i < MODEL_TIMERS; i++) n += g_model[i].armed;
+    return n;
+}
+
+int main(int argc, char** argv) {
+    uint32_t ops = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+    g_rng = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 7;
+    if (ops == 0) ops = 200000;
+    if (g_rng == 0) g_rng = 7;
+
+    const Callback* callbacks = callback_table(std::make_integer_sequence<int, MODEL_TIMERS>());
+
+    // 从非0时刻开始，覆盖 now_ms 的低位进位
+    vclock_reset(5000ULL * 1000);
+    timer_wheel_advance(millis());
+    g_last_release_ms = millis();
+    periodic_init(&g_periodic, PERIODIC_MS, PERIODIC_SKIP, millis());
+    timer_wheel_start_periodic(&g_periodic_wheel_timer, "periodic", &g_periodic, on_periodic);
+
+    uint32_t tte_errors = 0;
+    uint32_t pending_errors = 0;
+    uint32_t long_sleeps = 0;
+
+    for (uint32_t op = 0; op < ops; op++) {
+        int i = rng_next() % MODEL_TIMERS;
+        uint32_t r = rng_next() % 10;
+        uint32_t now = millis();
+
+        if (r < 3) {
+            // 1/4 为长延迟（最长 TIMER_WHEEL_MAX_DELAY_MS 附近，跨越全部层级）
+            uint32_t delay_ms = (rng_next() % 4 == 0) ? 1 + rng_next() % TIMER_WHEEL_MAX_DELAY_MS
+                                                      : 1 + rng_next() % 5000;
+            timer_wheel_start_oneshot(&g_wheel_timers[i], "oneshot", delay_ms, callbacks[i]);
+            g_model[i].armed = 1;
+            g_model[i].expires_ms = now + delay_ms;
+        } else if (r < 4) {
+            timer_wheel_cancel(&g_wheel_timers[i]);
+            g_model[i].armed = 0;
+        }
+
+        uint32_t got = timer_wheel_time_to_next_ms();
+        uint32_t want = model_time_to_next_ms(now);
+        if (got != want) {
+            tte_errors++;
+            if (tte_errors <= MAX_REPORTS) printf("  错误：最早到期 %u，模型 %u（now=%u）\n", got, want, now);
+        }
+
+        TimerWheelStats stats;
+        timer_wheel_get_stats(&stats);
+        if (stats.pending != model_pending()) pending_errors++;
+
+        // 推进：多数几毫秒，2% 为最长约50分钟的长休眠
+        uint32_t step_ms = (rng_next() % 50 == 0) ? rng_next() % 3000000 : rng_next() % 30;
+        if (step_ms >= 60000) long_sleeps++;
+        vclock_advance_us((uint64_t)step_ms * 1000);
+        timer_wheel_advance(millis());
+    }
+
+    // 模型中仍排队的定时器不能已过期
+    uint32_t now = millis();
+    uint32_t overdue = 0;
+    for (int i = 0; i < MODEL_TIMERS; i++) {
+        if (g_model[i].armed && (int32_t)(g_model[i].expires_ms - now) <= 0) overdue++;
+    }
+
+    TimerWheelStats stats;
+    timer_wheel_get_stats(&stats);
+    PeriodicStats pstats;
+    periodic_get_stats(&g_periodic, &pstats);
+    timer_wheel_print_stats();
+
+    printf("操作 %u 次，虚拟时间 %.1f 小时（毫秒计数经过32位回绕），长休眠 %u 次\n",
+        ops, vclock_now_us() / 3600e6, long_sleeps);
+    printf("单次定时器执行 %u 次；周期定时器执行 %u 次、跳过 %u 次；下移 %u，跳过空节拍 %u\n",
+        g_fires, (unsigned)pstats.runs, (unsigned)pstats.skipped,
+        (unsigned)stats.cascaded, (unsigned)stats.ticks_skipped);
+
+    uint32_t failures = g_errors + tte_errors + pending_errors + overdue + g_periodic_errors;
+    printf("到期错误 %u，最早到期不符 %u，排队数不符 %u，逾期未执行 %u，周期相位错误 %u\n",
+        g_errors, tte_errors, pending_errors, overdue, g_periodic_errors);
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
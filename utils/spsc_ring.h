@@ -0,0 +1,152 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// ──────────────────────────────────────────────
+// 无锁单生产者/单消费者环形缓冲（仅头文件）
+// ──────────────────────────────────────────────
+// - 容量 N 必须为2的幂，可存放 N 个元素（下标为自由递增的32位计数，差值即元素数）
+// - head 只由生产者写，tail 只由消费者写，分处不同缓存行避免伪共享
+// - 生产者发布数据用 release 写 head，消费者用 acquire 读 head（反之亦然），
+//   因此生产者与消费者可以分别运行在 ESP32-S3 的两个核上，无需临界区
+// - 各自缓存对方的下标，只有看起来满/空时才重新读取对方的原子变量
+// - 批量接口按连续片段拷贝（最多两段 memcpy），T 必须可平凡拷贝
+//
+// 用法：
+//   static SpscRing<PpgSample, 64> g_ring;
+//   生产者：g_ring.push(s) / g_ring.push_bulk(buf, n)
+//   消费者：g_ring.pop(&s) / g_ring.pop_bulk(buf, n) / read_span + release（零拷贝）
+
+#ifndef SPSC_CACHE_LINE
+#define SPSC_CACHE_LINE          64
+#endif
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {}
+
+    static uint32_t capacity() { return N; }
+
+    // ── 生产者 ──
+
+    bool push(const T& value) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == N) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == N) return false;  // 满
+        }
+        buf_[head & MASK] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 最多写入 n 个，返回实际写入数
+    uint32_t push_bulk(const T* src, uint32_t n) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t free_slots = N - (head - cached_tail_);
+        if (free_slots < n) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            free_slots = N - (head - cached_tail_);
+        }
+        if (n > free_slots) n = free_slots;
+        if (n == 0) return 0;
+
+        uint32_t idx = head & MASK;
+        uint32_t first = (n < N - idx) ? n : (N - idx);
+        memcpy(&buf_[idx], src, first * sizeof(T));
+        memcpy(&buf_[0], src + first, (n - first) * sizeof(T));
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // 零拷贝写：取得可写连续片段，直接填充后 commit
+    uint32_t write_span(T** span) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        uint32_t free_slots = N - (head - cached_tail_);
+        uint32_t idx = head & MASK;
+        uint32_t contiguous = N - idx;
+        *span = &buf_[idx];
+        return (free_slots < contiguous) ? free_slots : contiguous;
+    }
+
+    void commit(uint32_t n) {
+        head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // ── 消费者 ──
+
+    bool pop(T* out) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) return false;  // 空
+        }
+        *out = buf_[tail & MASK];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 最多读出 n 个，返回实际读出数
+    uint32_t pop_bulk(T* dst, uint32_t n) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t avail = cached_head_ - tail;
+        if (avail < n) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            avail = cached_head_ - tail;
+        }
+        if (n > avail) n = avail;
+        if (n == 0) return 0;
+
+        uint32_t idx = tail & MASK;
+        uint32_t first = (n < N - idx) ? n : (N - idx);
+        memcpy(dst, &buf_[idx], first * sizeof(T));
+        memcpy(dst + first, &buf_[0], (n - first) * sizeof(T));
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // 零拷贝读：取得可读连续片段，处理完后 release
+    uint32_t read_span(const T** span) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        cached_head_ = head_.load(std::memory_order_acquire);
+        uint32_t avail = cached_head_ - tail;
+        uint32_t idx = tail & MASK;
+        uint32_t contiguous = N - idx;
+        *span = &buf_[idx];
+        return (avail < contiguous) ? avail : contiguous;
+    }
+
+    void release(uint32_t n) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // ── 任一侧均可调用（结果为瞬时近似值） ──
+
+    uint32_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static const uint32_t MASK = N - 1;
+
+    // 生产者侧
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> head_;
+    uint32_t cached_tail_;
+
+    // 消费者侧
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> tail_;
+    uint32_t cached_head_;
+
+    alignas(SPSC_CACHE_LINE) T buf_[N];
+};
+
+#endif // SPSC_RING_H